@@ -80,9 +80,11 @@ class KnobsAndButtonsController : public EntityState
         , m_controller_entity( m_adp_manager, &m_registered_controllers_storage, this )
         , m_update_rate_in_millis( 50 )
         , m_last_update_time( 0 )
-        , m_knobs_sender( m_controller_entity, target_entity_id, target_mac_address, 0x0000, REFRESH_TIME, &m_knobs_storage )
-        , m_buttons_sender( m_controller_entity, target_entity_id, target_mac_address, 0x0001, REFRESH_TIME, &m_buttons_storage )
+        , m_control_senders( m_controller_entity, REFRESH_TIME )
     {
+        m_control_senders.add( target_entity_id, target_mac_address, 0x0000, &m_knobs_storage );
+        m_control_senders.add( target_entity_id, target_mac_address, 0x0001, &m_buttons_storage );
+
         // Set up the I/O pins for 3 knobs, 5 buttons, and 2 LED's
         pinMode( 9, OUTPUT );
         pinMode( 2, INPUT_PULLUP );
@@ -97,8 +99,7 @@ class KnobsAndButtonsController : public EntityState
     virtual void addToHandlerGroup( HandlerGroup &group ) override
     {
         group.add( &m_adp_manager );
-        group.add( &m_knobs_sender );
-        group.add( &m_buttons_sender );
+        group.add( &m_control_senders );
         group.add( &m_controller_entity );
         group.add( this );
     }
@@ -621,13 +622,14 @@ class KnobsAndButtonsController : public EntityState
     /// CONTROL_KNOBS_VALUE_DESCRIPTOR.
     /// 6 byte payload, one doublet each
     ControlValueHolderWithStorage<uint16_t, 3> m_knobs_storage;
-    ControlSender m_knobs_sender;
 
     /// The mapping of Button 1 to control descriptor
     /// CONTROL_BUTTONS_VALUE_DESCRIPTOR.
     /// 5 byte payload, one octet each
     ControlValueHolderWithStorage<uint8_t, 5> m_buttons_storage;
-    ControlSender m_buttons_sender;
+
+    /// Sends the newest knob and button values to the target entity
+    ControlSenderGroupWithSize<2> m_control_senders;
 };
 
 KnobsAndButtonsController my_entity_state( my_entity_id, my_entity_model_id );
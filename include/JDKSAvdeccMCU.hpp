@@ -30,17 +30,25 @@
 */
 #pragma once
 #include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ADPScheduler.hpp"
 #include "JDKSAvdeccMCU/ADPManager.hpp"
+#include "JDKSAvdeccMCU/ADPDiscovery.hpp"
 #include "JDKSAvdeccMCU/ControlDescription.hpp"
 #include "JDKSAvdeccMCU/ControlReceiver.hpp"
 #include "JDKSAvdeccMCU/ControlSender.hpp"
+#include "JDKSAvdeccMCU/ControlSenderGroup.hpp"
 #include "JDKSAvdeccMCU/ControlValueHolder.hpp"
+#include "JDKSAvdeccMCU/ControllerCommandQueue.hpp"
 #include "JDKSAvdeccMCU/ControllerEntity.hpp"
 #include "JDKSAvdeccMCU/EEPromStorage.hpp"
 #include "JDKSAvdeccMCU/Entity.hpp"
+#include "JDKSAvdeccMCU/EntityEnumerator.hpp"
+#include "JDKSAvdeccMCU/EuiFlatMap.hpp"
 #include "JDKSAvdeccMCU/Frame.hpp"
 #include "JDKSAvdeccMCU/Handler.hpp"
 #include "JDKSAvdeccMCU/HandlerGroup.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+#include "JDKSAvdeccMCU/UnsolicitedCoalescer.hpp"
 #include "JDKSAvdeccMCU/Helpers.hpp"
 #include "JDKSAvdeccMCU/RangedValue.hpp"
 #include "JDKSAvdeccMCU/PcapFile.hpp"
@@ -49,7 +57,16 @@
 #include "JDKSAvdeccMCU/RawSocket.hpp"
 #include "JDKSAvdeccMCU/RawSocketRunner.hpp"
 #include "JDKSAvdeccMCU/RawSocketPcapFile.hpp"
+#include "JDKSAvdeccMCU/RawSocketLinux.hpp"
+#include "JDKSAvdeccMCU/RawSocketLinuxRing.hpp"
+#include "JDKSAvdeccMCU/RawSocketMulti.hpp"
+#include "JDKSAvdeccMCU/FramePool.hpp"
+#include "JDKSAvdeccMCU/FrameRing.hpp"
+#include "JDKSAvdeccMCU/RawSocketRingPair.hpp"
+#include "JDKSAvdeccMCU/RawSocketThreaded.hpp"
+#include "JDKSAvdeccMCU/ShardedEntityHost.hpp"
 #include "JDKSAvdeccMCU/RawSocketWizNet.hpp"
+#include "JDKSAvdeccMCU/TimerWheel.hpp"
 #include "JDKSAvdeccMCU/MDNSRegister.hpp"
 #include "JDKSAvdeccMCU/Http.hpp"
 #include "JDKSAvdeccMCU/AppMessage.hpp"
@@ -57,3 +74,4 @@
 #include "JDKSAvdeccMCU/AppMessageHandler.hpp"
 #include "JDKSAvdeccMCU/Apc.hpp"
 #include "JDKSAvdeccMCU/Aps.hpp"
+#include "JDKSAvdeccMCU/ApsServerLinux.hpp"
@@ -0,0 +1,321 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ADPManager.hpp"
+#include "JDKSAvdeccMCU/EuiFlatMap.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+class ADPDiscovery;
+
+///
+/// \brief The DiscoveredEntity struct
+///
+/// What is known about an entity from its ENTITY_AVAILABLE messages -
+/// See IEEE Std 1722.1-2013 Clause 6.2.6.1
+///
+struct DiscoveredEntity
+{
+    DiscoveredEntity()
+        : m_port( 0 )
+        , m_entity_capabilities( 0 )
+        , m_talker_stream_sources( 0 )
+        , m_talker_capabilities( 0 )
+        , m_listener_stream_sinks( 0 )
+        , m_listener_capabilities( 0 )
+        , m_controller_capabilities( 0 )
+        , m_available_index( 0 )
+        , m_valid_time_in_seconds( 0 )
+        , m_last_seen_time( 0 )
+    {
+    }
+
+    Eui64 m_entity_id;
+    Eui64 m_entity_model_id;
+
+    /// The MAC address and network port that the last ENTITY_AVAILABLE came
+    /// from
+    Eui48 m_mac_address;
+    uint16_t m_port;
+
+    uint32_t m_entity_capabilities;
+    uint16_t m_talker_stream_sources;
+    uint16_t m_talker_capabilities;
+    uint16_t m_listener_stream_sinks;
+    uint16_t m_listener_capabilities;
+    uint32_t m_controller_capabilities;
+    uint32_t m_available_index;
+    Eui64 m_gptp_grandmaster_id;
+    uint16_t m_valid_time_in_seconds;
+
+    /// The time that the last ENTITY_AVAILABLE was received
+    jdksavdecc_timestamp_in_milliseconds m_last_seen_time;
+};
+
+class ADPDiscoveryEvents
+{
+  public:
+    virtual ~ADPDiscoveryEvents() {}
+
+    ///
+    /// \brief entityDiscovered
+    ///
+    /// Notification that an entity that was not in the table was added
+    ///
+    /// \param discovery
+    /// \param entity
+    ///
+    virtual void entityDiscovered( ADPDiscovery *discovery, DiscoveredEntity const &entity ) = 0;
+
+    ///
+    /// \brief entityChanged
+    ///
+    /// Notification that an entity in the table really changed: its
+    /// available_index did not simply count up, its gPTP grandmaster
+    /// changed or its capabilities changed
+    ///
+    /// \param discovery
+    /// \param entity The entity with the new information
+    /// \param changes The ADPDiscovery::CHANGED_* bits
+    ///
+    virtual void entityChanged( ADPDiscovery *discovery, DiscoveredEntity const &entity, uint16_t changes ) = 0;
+
+    ///
+    /// \brief entityGone
+    ///
+    /// Notification that an entity is about to be removed from the table
+    ///
+    /// \param discovery
+    /// \param entity
+    /// \param departed true if it sent ENTITY_DEPARTING, false if it timed
+    /// out
+    ///
+    virtual void entityGone( ADPDiscovery *discovery, DiscoveredEntity const &entity, bool departed ) = 0;
+};
+
+///
+/// \brief The ADPDiscoverySlot class
+///
+/// Holds one DiscoveredEntity of an ADPDiscovery along with the timer
+/// that expires it. Slots never move, the timers are linked by pointer
+///
+class ADPDiscoverySlot : public Handler
+{
+  public:
+    ADPDiscoverySlot() : m_discovery( 0 ), m_timer( this ) {}
+
+    ///
+    /// \brief tick is called by the expiry wheel of the ADPDiscovery when
+    /// the entity may have timed out
+    ///
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
+
+    ///
+    /// \brief getExpiryTime Get the time that the entity times out
+    ///
+    jdksavdecc_timestamp_in_milliseconds getExpiryTime() const
+    {
+        return m_entity.m_last_seen_time + m_entity.m_valid_time_in_seconds * 1000;
+    }
+
+    DiscoveredEntity m_entity;
+    ADPDiscovery *m_discovery;
+    Timer m_timer;
+
+  private:
+    ADPDiscoverySlot( ADPDiscoverySlot const & );
+    ADPDiscoverySlot const &operator=( ADPDiscoverySlot const & );
+};
+
+///
+/// \brief The ADPDiscovery class
+///
+/// ADPManager that also implements the Discovery State Machine as defined
+/// in IEEE Std 1722.1-2013 Clause 6.2.6, keeping a fixed capacity table of
+/// the entities that are available.
+///
+/// Entities are found by entity_id through an EuiFlatMap. Each one has a
+/// Timer on a TimerWheel owned by the ADPDiscovery, so the periodic
+/// ENTITY_AVAILABLE from an entity that did not change only costs a lookup,
+/// a few compares and rescheduling its timer.
+///
+/// It does not contain the storage of the table
+///
+class ADPDiscovery : public ADPManager
+{
+  public:
+    enum
+    {
+        /// The available_index went backwards or skipped, the entity may
+        /// have rebooted or changed state while its messages were lost
+        CHANGED_AVAILABLE_INDEX = 0x01,
+
+        /// The gptp_grandmaster_id changed
+        CHANGED_GRANDMASTER = 0x02,
+
+        /// The entity_model_id or any of the capabilities, sources or
+        /// sinks fields changed
+        CHANGED_CAPABILITIES = 0x04
+    };
+
+    ///
+    /// \brief ADPDiscovery constructor
+    ///
+    /// \param net The RawSocket to use
+    /// \param entity_id The Entity's entity_id
+    /// \param adp_info The core ADP information
+    /// \param events The object to notify of changes to the table, may be 0
+    /// \param slot_storage pointer to array of max_entities slots
+    /// \param free_storage pointer to array of max_entities slot numbers
+    /// \param index The map of entity_id to slot number, with a capacity of
+    /// at least max_entities
+    /// \param max_entities maximum number of entities in the table
+    ///
+    ADPDiscovery( RawSocket &net,
+                  Eui64 const &entity_id,
+                  ADPCoreInfo const &adp_info,
+                  ADPDiscoveryEvents *events,
+                  ADPDiscoverySlot *slot_storage,
+                  uint16_t *free_storage,
+                  EuiFlatMapBase<Eui64, uint16_t> &index,
+                  uint16_t max_entities );
+
+    ///
+    /// \brief tick sends ADP when necessary and removes the entities that
+    /// timed out
+    ///
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
+
+    ///
+    /// \brief receivedEntityAvailable adds or updates the entity
+    ///
+    virtual void receivedEntityAvailable( jdksavdecc_adpdu_common_control_header const &header, Frame &frame ) override;
+
+    ///
+    /// \brief receivedEntityDeparting removes the entity
+    ///
+    virtual void receivedEntityDeparting( jdksavdecc_adpdu_common_control_header const &header, Frame &frame ) override;
+
+    ///
+    /// \brief setEvents Set the object to notify of changes to the table
+    ///
+    void setEvents( ADPDiscoveryEvents *events ) { m_events = events; }
+
+    ///
+    /// \brief find Find an entity in the table
+    /// \return pointer to the entity or 0 if it is not there
+    ///
+    DiscoveredEntity const *find( Eui64 const &entity_id ) const;
+
+    ///
+    /// \brief getCount Get the number of entities in the table
+    ///
+    uint16_t getCount() const { return m_index.getCount(); }
+
+    ///
+    /// \brief getEntity Get the entity at position i, 0 <= i < getCount().
+    /// Positions change when an entity is removed
+    ///
+    DiscoveredEntity const &getEntity( uint16_t i ) const { return m_slot[m_index.getValue( i )].m_entity; }
+
+    ///
+    /// \brief getDroppedCount Get the number of new entities that were not
+    /// added because the table was full
+    ///
+    uint32_t getDroppedCount() const { return m_dropped_count; }
+
+    ///
+    /// \brief clear Remove all entities without notification
+    ///
+    void clear();
+
+  protected:
+    friend class ADPDiscoverySlot;
+
+    ///
+    /// \brief initialize Set up the slots, called by the owner of the
+    /// storage once it is constructed
+    ///
+    void initialize();
+
+    ///
+    /// \brief expire Remove the entity of a slot if it timed out, otherwise
+    /// schedule its timer again
+    ///
+    void expire( ADPDiscoverySlot *slot, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    ///
+    /// \brief remove Notify and remove the entity of a slot
+    ///
+    void remove( ADPDiscoverySlot *slot, bool departed );
+
+    ///
+    /// \brief readEntity Read all of the fields of an ENTITY_AVAILABLE
+    ///
+    static void readEntity( DiscoveredEntity &entity,
+                            jdksavdecc_adpdu_common_control_header const &header,
+                            Frame const &frame,
+                            jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    ADPDiscoveryEvents *m_events;
+    ADPDiscoverySlot *m_slot;
+    uint16_t *m_free;
+    uint16_t m_num_free;
+    EuiFlatMapBase<Eui64, uint16_t> &m_index;
+    uint16_t m_max_entities;
+    uint32_t m_dropped_count;
+    TimerWheel m_expiry_wheel;
+};
+
+///
+/// \brief The ADPDiscoveryWithSize class
+///
+/// ADPDiscovery that contains the storage for MaxEntities entities
+///
+template <uint16_t MaxEntities>
+class ADPDiscoveryWithSize : public ADPDiscovery
+{
+  public:
+    ADPDiscoveryWithSize( RawSocket &net, Eui64 const &entity_id, ADPCoreInfo const &adp_info, ADPDiscoveryEvents *events = 0 )
+        : ADPDiscovery( net, entity_id, adp_info, events, m_slot_storage, m_free_storage, m_index_storage, MaxEntities )
+    {
+        initialize();
+    }
+
+  private:
+    ADPDiscoverySlot m_slot_storage[MaxEntities];
+    uint16_t m_free_storage[MaxEntities];
+    EuiFlatMap<Eui64, uint16_t, MaxEntities> m_index_storage;
+};
+}
@@ -36,6 +36,8 @@
 #include "JDKSAvdeccMCU/Frame.hpp"
 
 #include "JDKSAvdeccMCU/Handler.hpp"
+#include "JDKSAvdeccMCU/TimerWheel.hpp"
+#include "JDKSAvdeccMCU/ADPScheduler.hpp"
 
 namespace JDKSAvdeccMCU
 {
@@ -163,6 +165,16 @@ class ADPManager : public Handler
      */
     virtual bool receivedPDU( RawSocket *incomng_socket, Frame &frame ) override;
 
+    /**
+     * @brief getDispatchKeys asks for ADPDU's only
+     */
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
+    /**
+     * @brief getTimer tick() only needs to run when the next ADPDU is due
+     */
+    virtual Timer *getTimer() override { return &m_timer; }
+
     /**
      * @brief receivedEntityAvailable is called when any ENTITY_AVAILABLE ADP
      * message is received. The default implementation does nothing.
@@ -188,11 +200,20 @@ class ADPManager : public Handler
     }
 
     /**
-     * @brief sendADP Formulates the next ADPDU ENTITY_AVAILABLE message and
-     * sends it
+     * @brief sendADP Sends the next ADPDU ENTITY_AVAILABLE message out of
+     * each network port of the RawSocket, with the port number as the
+     * interface_index. The message is formulated once into a template and
+     * only the available_index, gptp_grandmaster_id, interface_index and
+     * source address are patched in for each send
      */
     void sendADP();
 
+    /**
+     * @brief invalidateADPTemplate is called after the ADPCoreInfo was
+     * changed so that the next sendADP() formulates the ADPDU again
+     */
+    void invalidateADPTemplate() { m_adp_template_valid = false; }
+
     /**
      * @brief getRawSocket gets the raw socket which is used
      * @return Reference to the RawSocket
@@ -255,14 +276,39 @@ class ADPManager : public Handler
      */
     void setGPTPGrandMasterID( Eui64 const &new_gm );
 
+    /**
+     * @brief setScheduler Share an ADPScheduler with the other ADPManagers
+     * in the process. Responses to ENTITY_DISCOVER and the first
+     * announcement are then delayed by a random time of up to 1/5 of
+     * valid_time, and every send waits for a token from the scheduler.
+     * Call it before the first tick()
+     *
+     * @param scheduler The scheduler, or 0 to send right away
+     */
+    void setScheduler( ADPScheduler *scheduler );
+
   protected:
+    /**
+     * @brief buildADPTemplate Formulates the parts of the ENTITY_AVAILABLE
+     * message that do not change from one send to the next
+     */
+    void buildADPTemplate();
+
     RawSocket &m_net;
     Eui64 m_entity_id;
     uint32_t m_available_index;
     jdksavdecc_timestamp_in_milliseconds m_last_send_time_in_millis;
     jdksavdecc_timestamp_in_milliseconds m_trigger_send_time;
     bool m_trigger_send;
+    jdksavdecc_timestamp_in_milliseconds m_delayed_send_time;
+    bool m_delayed_send;
+    ADPScheduler *m_scheduler;
     Eui64 m_gptp_grandmaster_id;
     ADPCoreInfo const &m_adp_info;
+    Timer m_timer;
+
+    // DA, SA, EtherType, ADPDU = 82 bytes
+    FrameWithSize<JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_LEN> m_adp_template;
+    bool m_adp_template_valid;
 };
 }
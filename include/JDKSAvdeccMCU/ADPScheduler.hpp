@@ -0,0 +1,119 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+#ifndef JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS
+#define JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS ( 4 )
+#endif
+
+///
+/// \brief The ADPScheduler class
+///
+/// Shared by all of the ADPManagers in a process to keep a large number of
+/// entities from sending their ADPDUs in bursts.
+///
+/// It gives out random delays so that responses to ENTITY_DISCOVER and the
+/// first announcements are spread over the window allowed by IEEE Std
+/// 1722.1-2013 Clause 6.2.4.1.1, and it keeps a token bucket per network
+/// port that limits the rate of ADPDUs sent by all of them together.
+/// Ports at or above JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS share the last
+/// bucket, which is charged once for each of them
+///
+class ADPScheduler
+{
+  public:
+    ///
+    /// \brief ADPScheduler constructor
+    /// \param frames_per_second The sustained number of ADPDUs per port
+    /// \param burst The number of ADPDUs per port that may be sent back to
+    /// back
+    /// \param seed The seed for the random delays
+    ///
+    ADPScheduler( uint32_t frames_per_second = 200, uint16_t burst = 20, uint32_t seed = 0x2545f491 );
+
+    ///
+    /// \brief getJitter Get a random delay
+    /// \param max_delay The longest delay in milliseconds
+    /// \return The delay in milliseconds, 0 to max_delay
+    ///
+    uint32_t getJitter( uint32_t max_delay );
+
+    ///
+    /// \brief acquire Take a token for one ADPDU out of the buckets of
+    /// network ports 0 to num_ports-1. Either all of them or none are taken
+    /// \param num_ports The number of ports the ADPDU is sent on
+    /// \param time_in_millis The current time
+    /// \return true if the ADPDU may be sent now
+    ///
+    bool acquire( uint16_t num_ports, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    ///
+    /// \brief getRetryTime Get when to try again after acquire() failed
+    ///
+    jdksavdecc_timestamp_in_milliseconds getRetryTime( jdksavdecc_timestamp_in_milliseconds time_in_millis ) const
+    {
+        return time_in_millis + ( 1000 + m_frames_per_second - 1 ) / m_frames_per_second;
+    }
+
+    ///
+    /// \brief getDeferredCount Get the number of times acquire() failed
+    ///
+    uint32_t getDeferredCount() const
+    {
+#if JDKSAVDECCMCU_ENABLE_THREADS
+        std::lock_guard<std::mutex> lock( m_mutex );
+#endif
+        return m_deferred_count;
+    }
+
+  private:
+    /// Add the tokens earned since the bucket was last filled
+    void refill( uint16_t bucket, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    uint32_t m_frames_per_second;
+
+    /// Tokens are counted in thousandths of an ADPDU
+    uint32_t m_max_tokens;
+    uint32_t m_tokens[JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS];
+    jdksavdecc_timestamp_in_milliseconds m_fill_time[JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS];
+    bool m_started;
+    uint32_t m_random;
+    uint32_t m_deferred_count;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    mutable std::mutex m_mutex;
+#endif
+};
+}
@@ -793,7 +793,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppNop( AppMessage const &msg );
+    virtual void onAppNop( AppMessageView const &msg );
 
     ///
     /// \brief onAppEntityIdRequest
@@ -802,7 +802,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppEntityIdRequest( AppMessage const &msg );
+    virtual void onAppEntityIdRequest( AppMessageView const &msg );
 
     ///
     /// \brief onAppEntityIdResponse
@@ -811,7 +811,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppEntityIdResponse( AppMessage const &msg );
+    virtual void onAppEntityIdResponse( AppMessageView const &msg );
 
     ///
     /// \brief onAppLinkUp
@@ -820,7 +820,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppLinkUp( AppMessage const &msg );
+    virtual void onAppLinkUp( AppMessageView const &msg );
 
     ///
     /// \brief onAppLinkDown
@@ -829,7 +829,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppLinkDown( AppMessage const &msg );
+    virtual void onAppLinkDown( AppMessageView const &msg );
 
     ///
     /// \brief onAppAvdeccFromAps
@@ -838,7 +838,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppAvdeccFromAps( AppMessage const &msg );
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg );
 
     ///
     /// \brief onAppAvdeccFromApc
@@ -847,7 +847,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppAvdeccFromApc( AppMessage const &msg );
+    virtual void onAppAvdeccFromApc( AppMessageView const &msg );
 
     ///
     /// \brief onAppVendor
@@ -856,7 +856,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppVendor( AppMessage const &msg );
+    virtual void onAppVendor( AppMessageView const &msg );
 
     ///
     /// \brief onUnknown
@@ -865,7 +865,7 @@ class ApcStateEvents : public AppMessageHandler, public HttpClientHandler
     ///
     /// \param msg
     ///
-    virtual void onAppUnknown( AppMessage const &msg );
+    virtual void onAppUnknown( AppMessageView const &msg );
 
   protected:
     ApcStateMachine *m_owner;
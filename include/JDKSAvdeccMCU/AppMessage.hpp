@@ -37,6 +37,8 @@
 namespace JDKSAvdeccMCU
 {
 
+class AppMessageView;
+
 ///
 /// \brief The AppMessage AVDECC Proxy Protocol Message
 ///
@@ -76,9 +78,13 @@ struct AppMessage
 
     ///
     /// \brief AppMessage Copy Constructor
+    ///
+    /// The payload is copied into this AppMessage's own buffer, even if the
+    /// other AppMessage's payload points into a receive buffer
+    ///
     /// \param other the AppMessage to copy
     ///
-    AppMessage( const AppMessage &other ) : m_appdu( other.m_appdu ) { m_appdu.base.payload = m_appdu.payload_buffer; }
+    AppMessage( const AppMessage &other ) { copyFrom( other ); }
 
     ///
     /// \brief operator =
@@ -88,11 +94,31 @@ struct AppMessage
     ///
     const AppMessage &operator=( const AppMessage &other )
     {
-        m_appdu = other.m_appdu;
-        m_appdu.base.payload = m_appdu.payload_buffer;
+        if ( this != &other )
+        {
+            copyFrom( other );
+        }
         return *this;
     }
 
+    ///
+    /// \brief AppMessage Constructor
+    ///
+    /// Materializes an AppMessageView, copying its payload into this
+    /// AppMessage's own buffer so that it can be kept
+    ///
+    /// \param view the AppMessageView to copy
+    ///
+    explicit AppMessage( const AppMessageView &view );
+
+    ///
+    /// \brief operator =
+    /// Materializes an AppMessageView into this AppMessage
+    /// \param view the AppMessageView to copy
+    /// \return *this
+    ///
+    const AppMessage &operator=( const AppMessageView &view );
+
     ///
     /// \brief clear
     ///
@@ -205,7 +231,7 @@ struct AppMessage
     ///
     /// \return uint8_t const pointer to payload
     ///
-    uint8_t const *getPayload() const { return m_appdu.payload_buffer; }
+    uint8_t const *getPayload() const { return m_appdu.base.payload; }
 
     ///
     /// \brief getPayload
@@ -214,7 +240,7 @@ struct AppMessage
     ///
     /// \return uint8_t pointer to the payload
     ///
-    uint8_t *getPayload() { return m_appdu.payload_buffer; }
+    uint8_t *getPayload() { return m_appdu.base.payload; }
 
     ///
     /// \brief getAddress
@@ -265,7 +291,7 @@ struct AppMessage
         Eui64 r;
         if ( getMessageType() == ENTITY_ID_REQUEST && getPayloadLength() == 8 )
         {
-            r = Eui64( m_appdu.payload_buffer );
+            r = Eui64( m_appdu.base.payload );
         }
         return r;
     }
@@ -283,7 +309,7 @@ struct AppMessage
         Eui64 r;
         if ( getMessageType() == ENTITY_ID_RESPONSE && getPayloadLength() == 8 )
         {
-            r = Eui64( m_appdu.payload_buffer );
+            r = Eui64( m_appdu.base.payload );
         }
         return r;
     }
@@ -312,5 +338,201 @@ struct AppMessage
     /// The parsed header and additional payload storage
     ///
     jdksavdecc_fullappdu m_appdu;
+
+  private:
+    void copyFrom( const AppMessage &other )
+    {
+        m_appdu.base = other.m_appdu.base;
+        m_appdu.base.payload = m_appdu.payload_buffer;
+        if ( other.m_appdu.base.payload_length > 0 )
+        {
+            memcpy( m_appdu.payload_buffer, other.m_appdu.base.payload, other.m_appdu.base.payload_length );
+        }
+    }
+};
+
+///
+/// \brief The AppMessageView class
+///
+/// A read only AVDECC Proxy Protocol Message that refers to a payload held
+/// elsewhere, such as the buffer that a TCP read went into, or an AVDECC
+/// Frame received from the network. It is what AppMessageParser dispatches to
+/// an AppMessageHandler.
+///
+/// The payload is only valid while the buffer that it refers to is; a
+/// handler that needs to keep the message materializes it into an
+/// AppMessage
+///
+class AppMessageView
+{
+  public:
+    ///
+    /// \brief AppMessageView Constructor
+    ///
+    /// Creates a view of a NOP
+    ///
+    AppMessageView()
+    {
+        jdksavdecc_appdu_init( &m_appdu );
+        m_appdu.version = JDKSAVDECC_APPDU_VERSION;
+    }
+
+    ///
+    /// \brief AppMessageView Constructor
+    ///
+    /// \param header The parsed APPDU header fields
+    /// \param payload The payload_length octets of payload
+    ///
+    AppMessageView( const jdksavdecc_appdu &header, uint8_t const *payload ) : m_appdu( header )
+    {
+        m_appdu.payload = const_cast<uint8_t *>( payload );
+    }
+
+    ///
+    /// \brief AppMessageView Constructor
+    ///
+    /// A view of an AppMessage, valid while the AppMessage is
+    ///
+    /// \param msg The AppMessage
+    ///
+    AppMessageView( const AppMessage &msg ) : m_appdu( msg.m_appdu.base ) {}
+
+    ///
+    /// \brief setAvdeccFromAps
+    ///
+    /// View the frame as an AVDECC_FROM_APS message without copying its
+    /// payload.
+    /// See IEEE Std 1722.1-2013 Annex C.5.1.6
+    ///
+    /// \param frame The AVDECC message from the network
+    ///
+    void setAvdeccFromAps( const Frame &frame )
+    {
+        m_appdu.version = JDKSAVDECC_APPDU_VERSION;
+        m_appdu.message_type = JDKSAVDECC_APPDU_MESSAGE_TYPE_AVDECC_FROM_APS;
+        m_appdu.payload_length = frame.getPayloadLength();
+        m_appdu.address = frame.getSA();
+        m_appdu.reserved = 0;
+        m_appdu.payload = const_cast<uint8_t *>( frame.getPayload() );
+    }
+
+    ///
+    /// \brief getPayload
+    ///
+    /// Get a const pointer to the payload
+    ///
+    /// \return uint8_t const pointer to payload
+    ///
+    uint8_t const *getPayload() const { return m_appdu.payload; }
+
+    ///
+    /// \brief getAddress
+    ///
+    /// Get the address field from the APPDU
+    ///
+    /// \return Eui48
+    ///
+    Eui48 getAddress() const { return Eui48( m_appdu.address ); }
+
+    ///
+    /// \brief getPayloadLength
+    ///
+    /// Get the payload_length field from the APPDU
+    ///
+    /// \return uint16_t payload_length
+    ///
+    uint16_t getPayloadLength() const { return m_appdu.payload_length; }
+
+    ///
+    /// \brief getVersion
+    ///
+    /// Get the APPDU protocol version from the APPDU
+    ///
+    /// \return the uint8_t version
+    ///
+    uint8_t getVersion() const { return m_appdu.version; }
+
+    ///
+    /// \brief getMessageType
+    ///
+    /// Get the message_type field from the APPDU
+    ///
+    /// \return MessageType
+    ///
+    AppMessage::MessageType getMessageType() const { return AppMessage::MessageType( m_appdu.message_type ); }
+
+    ///
+    /// \brief getEntityIdRequestEntityId
+    ///
+    /// Get the entity_id value from the payload if the APPDU
+    /// is a ENTITY_ID_REQUEST message
+    ///
+    /// \return The Eui64 entity_id
+    ///
+    Eui64 getEntityIdRequestEntityId() const
+    {
+        Eui64 r;
+        if ( getMessageType() == AppMessage::ENTITY_ID_REQUEST && getPayloadLength() == 8 )
+        {
+            r = Eui64( m_appdu.payload );
+        }
+        return r;
+    }
+
+    ///
+    /// \brief getEntityIdResponseEntityId
+    ///
+    /// Get the entity_id value from the payload if the APPDU
+    /// is a ENTITY_ID_RESPONSE message
+    ///
+    /// \return The Eui64 entity_id
+    ///
+    Eui64 getEntityIdResponseEntityId() const
+    {
+        Eui64 r;
+        if ( getMessageType() == AppMessage::ENTITY_ID_RESPONSE && getPayloadLength() == 8 )
+        {
+            r = Eui64( m_appdu.payload );
+        }
+        return r;
+    }
+
+    ///
+    /// \brief store the APPDU into the destination FixedBuffer
+    /// \param dest Destination FixedBuffer to store to
+    /// \param offset Offset within FixedBuffer to store to
+    ///
+    /// \return true if the APPDU fit in the FixedBuffer
+    ///
+    bool store( FixedBuffer *dest, uint16_t offset = 0 ) const
+    {
+        ssize_t r;
+        dest->clear();
+        r = jdksavdecc_appdu_write( &m_appdu, dest->getBuf(), offset, dest->getMaxLength() );
+        if ( r > 0 )
+        {
+            dest->setLength( uint16_t( r ) );
+        }
+        return r > 0;
+    }
+
+    ///
+    /// \brief m_appdu
+    /// The header fields, with payload pointing at the viewed octets
+    ///
+    jdksavdecc_appdu m_appdu;
 };
+
+inline AppMessage::AppMessage( const AppMessageView &view ) { *this = view; }
+
+inline const AppMessage &AppMessage::operator=( const AppMessageView &view )
+{
+    m_appdu.base = view.m_appdu;
+    m_appdu.base.payload = m_appdu.payload_buffer;
+    if ( view.m_appdu.payload_length > 0 && view.m_appdu.payload != m_appdu.payload_buffer )
+    {
+        memmove( m_appdu.payload_buffer, view.m_appdu.payload, view.m_appdu.payload_length );
+    }
+    return *this;
+}
 }
@@ -40,7 +40,11 @@ namespace JDKSAvdeccMCU
 /// \brief The AppMessageHandler class
 ///
 /// Dispatch received AppMessages to an appropriate
-/// handler
+/// handler.
+///
+/// Each message is given as an AppMessageView that may refer to the
+/// receive buffer. A handler that keeps the message past the call copies
+/// it into an AppMessage
 ///
 class AppMessageHandler
 {
@@ -53,80 +57,80 @@ class AppMessageHandler
     ///
     /// Called when the APPDU is NOP
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppNop( AppMessage const &msg ) = 0;
+    virtual void onAppNop( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppEntityIdRequest
     ///
     /// Called when the APPDU is ENTITY_ID_REQUEST
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppEntityIdRequest( AppMessage const &msg ) = 0;
+    virtual void onAppEntityIdRequest( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppEntityIdResponse
     ///
     /// Called when the APPDU is ENTITY_ID_RESPONSE
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppEntityIdResponse( AppMessage const &msg ) = 0;
+    virtual void onAppEntityIdResponse( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppLinkUp
     ///
     /// Called when the APPDU is LINK_UP
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppLinkUp( AppMessage const &msg ) = 0;
+    virtual void onAppLinkUp( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppLinkDown
     ///
     /// Called when the APPDU is LINK_DOWN
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppLinkDown( AppMessage const &msg ) = 0;
+    virtual void onAppLinkDown( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppAvdeccFromAps
     ///
     /// Called when the APPDU is AVDECC_FROM_APS
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppAvdeccFromAps( AppMessage const &msg ) = 0;
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppAvdeccFromApc
     ///
     /// Called when the APPDU is AVDECC_TO_APC
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppAvdeccFromApc( AppMessage const &msg ) = 0;
+    virtual void onAppAvdeccFromApc( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onAppVendor
     ///
     /// Called when the APPDU is VENDOR
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppVendor( AppMessage const &msg ) = 0;
+    virtual void onAppVendor( AppMessageView const &msg ) = 0;
 
     ///
     /// \brief onUnknown
     ///
     /// Called when the APPDU message type or version is unknown
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView, valid only during the call
     ///
-    virtual void onAppUnknown( AppMessage const &msg ) = 0;
+    virtual void onAppUnknown( AppMessageView const &msg ) = 0;
 };
 }
@@ -40,7 +40,7 @@ namespace JDKSAvdeccMCU
 ///
 /// \brief The AppMessageParser class
 ///
-/// Consumes bytes one at a time and parses
+/// Consumes bytes one at a time or a buffer at a time and parses
 /// AppMessages from the byte stream
 ///
 class AppMessageParser
@@ -74,6 +74,21 @@ class AppMessageParser
     ///
     int parse( uint8_t octet );
 
+    ///
+    /// \brief parse parses a whole buffer read from a TCP stream
+    /// and dispatches each message in it to an AppMessageHandler.
+    ///
+    /// Messages that are entirely inside the buffer are dispatched as an
+    /// AppMessageView of the buffer, without copying the payload. Only
+    /// messages that are split across buffers are reassembled.
+    ///
+    /// \param data The incoming octets
+    /// \param len The number of octets
+    ///
+    /// \return len on success, -1 on error
+    ///
+    ssize_t parse( uint8_t const *data, ssize_t len );
+
     ///
     /// \brief getErrorCount get the current error count
     /// \return error count
@@ -90,13 +105,13 @@ class AppMessageParser
     ///
     /// \brief dispatchMsg
     ///
-    /// Dispatch the AppMessage to the AppMessageHandler
+    /// Dispatch a view of the message to the AppMessageHandler
     ///
-    /// \param msg The AppMessage
+    /// \param msg The AppMessageView
     ///
     /// \return 0 on success, <0 on error
     ///
-    int dispatchMsg( AppMessage const &msg );
+    int dispatchMsg( AppMessageView const &msg );
 
     ///
     /// \brief parseHeader
@@ -105,12 +120,25 @@ class AppMessageParser
     ///
     AppMessage *parseHeader( uint8_t octet );
 
+    ///
+    /// \brief readHeader
+    /// Read the APPDU header fields into m_current_message
+    /// \param header pointer to JDKSAVDECC_APPDU_HEADER_LEN octets
+    ///
+    void readHeader( uint8_t const *header );
+
     ///
     /// \brief validateHeader
     /// \return
     ///
     AppMessage *validateHeader();
 
+    ///
+    /// \brief completeIfEmpty
+    /// \return the current message if it has no payload to read
+    ///
+    AppMessage *completeIfEmpty();
+
     ///
     /// \brief parsePayload
     /// \param octet
@@ -1207,7 +1207,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppNop( AppMessage const &msg );
+    virtual void onAppNop( AppMessageView const &msg );
 
     ///
     /// \brief onAppEntityIdRequest
@@ -1216,7 +1216,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppEntityIdRequest( AppMessage const &msg );
+    virtual void onAppEntityIdRequest( AppMessageView const &msg );
 
     ///
     /// \brief onAppEntityIdResponse
@@ -1225,7 +1225,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppEntityIdResponse( AppMessage const &msg );
+    virtual void onAppEntityIdResponse( AppMessageView const &msg );
 
     ///
     /// \brief onAppLinkUp
@@ -1234,7 +1234,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppLinkUp( AppMessage const &msg );
+    virtual void onAppLinkUp( AppMessageView const &msg );
 
     ///
     /// \brief onAppLinkDown
@@ -1243,7 +1243,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppLinkDown( AppMessage const &msg );
+    virtual void onAppLinkDown( AppMessageView const &msg );
 
     ///
     /// \brief onAppAvdeccFromAps
@@ -1252,7 +1252,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppAvdeccFromAps( AppMessage const &msg );
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg );
 
     ///
     /// \brief onAppAvdeccFromApc
@@ -1261,7 +1261,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppAvdeccFromApc( AppMessage const &msg );
+    virtual void onAppAvdeccFromApc( AppMessageView const &msg );
 
     ///
     /// \brief onAppVendor
@@ -1270,7 +1270,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppVendor( AppMessage const &msg );
+    virtual void onAppVendor( AppMessageView const &msg );
 
     ///
     /// \brief onUnknown
@@ -1279,7 +1279,7 @@ class ApsStateEvents : public AppMessageHandler, public HttpServerHandler
     ///
     /// \param msg
     ///
-    virtual void onAppUnknown( AppMessage const &msg );
+    virtual void onAppUnknown( AppMessageView const &msg );
 
   protected:
     ApsStateMachine *m_owner;
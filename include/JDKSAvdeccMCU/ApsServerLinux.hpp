@@ -0,0 +1,411 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Aps.hpp"
+#include "JDKSAvdeccMCU/RawSocket.hpp"
+
+#if defined( __linux__ )
+#include <unordered_map>
+
+namespace JDKSAvdeccMCU
+{
+
+#ifndef JDKSAVDECCMCU_APSSERVER_MAX_CONNECTIONS
+#define JDKSAVDECCMCU_APSSERVER_MAX_CONNECTIONS ( 256 )
+#endif
+
+#ifndef JDKSAVDECCMCU_APSSERVER_TX_BACKLOG
+#define JDKSAVDECCMCU_APSSERVER_TX_BACKLOG ( 65536 )
+#endif
+
+/// Above this many waiting octets, ADP messages to the APC are dropped and
+/// nothing more is read from the APC until it catches up
+#ifndef JDKSAVDECCMCU_APSSERVER_TX_HIGH_WATER
+#define JDKSAVDECCMCU_APSSERVER_TX_HIGH_WATER ( JDKSAVDECCMCU_APSSERVER_TX_BACKLOG * 3 / 4 )
+#endif
+
+#ifndef JDKSAVDECCMCU_APSSERVER_READ_SIZE
+#define JDKSAVDECCMCU_APSSERVER_READ_SIZE ( 65536 )
+#endif
+
+#ifndef JDKSAVDECCMCU_APSSERVER_MAX_FILTER_TARGETS
+#define JDKSAVDECCMCU_APSSERVER_MAX_FILTER_TARGETS ( 8 )
+#endif
+
+class ApsServerLinux;
+
+///
+/// \brief The ApsConnectionFilter struct
+///
+/// Chooses which AVDECC frames from the network are sent to an APC.
+///
+/// Frames of the subtypes in m_all_subtypes are always sent. Frames of the
+/// subtypes in m_matched_subtypes are only sent when one of the entity ids
+/// in them is the entity_id assigned to the APC or one of m_targets:
+/// the entity_id of ADP, the target and controller entity ids of AECP and
+/// the controller, talker and listener entity ids of ACMP.
+///
+/// The default sends everything, like a single connection APS
+///
+struct ApsConnectionFilter
+{
+    enum
+    {
+        ADP = 0x01,
+        AECP = 0x02,
+        ACMP = 0x04,
+        OTHER = 0x08,
+        ALL = 0x0f
+    };
+
+    ApsConnectionFilter()
+        : m_all_subtypes( ALL ), m_matched_subtypes( 0 ), m_multicast( true ), m_unicast( true ), m_num_targets( 0 )
+    {
+    }
+
+    ///
+    /// \brief addTarget Also send the matched subtypes about this entity
+    /// \return false if there are already
+    /// JDKSAVDECCMCU_APSSERVER_MAX_FILTER_TARGETS targets
+    ///
+    bool addTarget( Eui64 const &entity_id )
+    {
+        bool r = false;
+        if ( m_num_targets < JDKSAVDECCMCU_APSSERVER_MAX_FILTER_TARGETS )
+        {
+            m_targets[m_num_targets++] = entity_id;
+            r = true;
+        }
+        return r;
+    }
+
+    uint8_t m_all_subtypes;
+    uint8_t m_matched_subtypes;
+
+    /// Send frames with a multicast destination address
+    bool m_multicast;
+
+    /// Send frames with a unicast destination address
+    bool m_unicast;
+
+    uint16_t m_num_targets;
+    Eui64 m_targets[JDKSAVDECCMCU_APSSERVER_MAX_FILTER_TARGETS];
+};
+
+///
+/// \brief The ApsServerConnection class
+///
+/// The ApsStateMachine for one APC connected to an ApsServerLinux, along
+/// with the objects that it uses and the TCP data that is waiting to be
+/// sent to the APC.
+///
+/// Messages to the APC are collected in a ring of
+/// JDKSAVDECCMCU_APSSERVER_TX_BACKLOG octets and written with one writev()
+/// when the server's loop has handled all of its events. Past
+/// JDKSAVDECCMCU_APSSERVER_TX_HIGH_WATER octets, ADP messages are dropped
+/// first and the APC is not read from. An APC that still does not keep up
+/// is disconnected rather than growing the ring
+///
+class ApsServerConnection : public ApsStateMachine
+{
+  public:
+    ApsServerConnection( ApsServerLinux &server, int fd, std::string const &path );
+
+    virtual ~ApsServerConnection();
+
+    ///
+    /// \brief sendTcpData queues data for the APC, to be written when the
+    /// server flushes the connection
+    ///
+    virtual void sendTcpData( uint8_t const *data, ssize_t len ) override;
+
+    ///
+    /// \brief sendAvdeccToL2 sends the frame via the server's RawSocket
+    ///
+    virtual void sendAvdeccToL2( Frame const &frame ) override;
+
+    ///
+    /// \brief closeTcpConnection marks the connection to be closed by the
+    /// server once the current event is handled
+    ///
+    virtual void closeTcpConnection() override;
+
+    ///
+    /// \brief assignEntityId assigns the entity_id and remembers it for
+    /// the filter
+    ///
+    virtual Eui64 assignEntityId( Eui48 server_link_mac, Eui48 apc_link_mac, Eui64 requested_entity_id ) override;
+
+    ///
+    /// \brief setFilter Choose which frames from the network are sent to
+    /// the APC
+    ///
+    void setFilter( ApsConnectionFilter const &filter );
+
+    ///
+    /// \brief getFilter get the filter
+    ///
+    ApsConnectionFilter const &getFilter() const { return m_filter; }
+
+    ///
+    /// \brief getAssignedEntityId get the entity_id assigned to the APC,
+    /// if it asked for one
+    ///
+    Eui64 const &getAssignedEntityId() const { return m_assigned_entity_id; }
+
+    ///
+    /// \brief flush write as much of the waiting data as the socket takes
+    /// \return false if the connection failed
+    ///
+    bool flush();
+
+    ///
+    /// \brief isBacklogged test if the waiting data is past the high water
+    /// mark
+    ///
+    bool isBacklogged() const { return m_tx_len > JDKSAVDECCMCU_APSSERVER_TX_HIGH_WATER; }
+
+    ///
+    /// \brief isClosing test if the connection is to be closed
+    ///
+    bool isClosing() const { return m_closing; }
+
+    ///
+    /// \brief isTransferring test if the HTTP request was accepted and
+    /// AVDECC messages are exchanged
+    ///
+    bool isTransferring() const { return !m_closing && getVariables()->m_requestValid == 200; }
+
+    ///
+    /// \brief getFd get the socket
+    ///
+    int getFd() const { return m_fd; }
+
+    ///
+    /// \brief getTxPending get the number of octets waiting to be sent
+    ///
+    size_t getTxPending() const { return m_tx_len; }
+
+  protected:
+    friend class ApsServerLinux;
+
+    /// Send an APPDU that was made once for all matching connections
+    void sendFanout( FixedBuffer const &appdu );
+
+    ApsServerLinux &m_server;
+    int m_fd;
+    bool m_closing;
+    bool m_flush_pending;
+    uint32_t m_epoll_events;
+    uint16_t m_index;
+    ApsConnectionFilter m_filter;
+    bool m_has_entity_id;
+    Eui64 m_assigned_entity_id;
+
+    /// The frame that this connection was last matched for
+    uint32_t m_match_stamp;
+
+    ApsStateVariables m_aps_variables;
+    ApsStateActions m_aps_actions;
+    HttpRequest m_http_request;
+    HttpServerParserSimple m_http_parser;
+    ApsStateEvents m_aps_events;
+    ApsStates m_aps_states;
+
+    /// Octets waiting to be sent start at m_tx_buf + m_tx_pos and wrap
+    /// around the end of m_tx_buf
+    size_t m_tx_pos;
+    size_t m_tx_len;
+    uint8_t m_tx_buf[JDKSAVDECCMCU_APSSERVER_TX_BACKLOG];
+
+  private:
+    ApsServerConnection( ApsServerConnection const & );
+    ApsServerConnection const &operator=( ApsServerConnection const & );
+};
+
+///
+/// \brief The ApsServerLinux class
+///
+/// An AVDECC Proxy Server as defined in IEEE Std 1722.1-2013 Annex C that
+/// accepts many APC connections. The listening socket, every APC connection
+/// and the RawSocket are handled by one epoll loop, driven by calling
+/// poll().
+///
+/// Each APC gets its own ApsServerConnection. An AVDECC frame received
+/// from the RawSocket is matched against a table compiled from the
+/// ApsConnectionFilter of every connection, and is made into an APPDU once
+/// for all of the APCs that it is sent to. Frames from any APC are sent via
+/// the RawSocket
+///
+class ApsServerLinux
+{
+  public:
+    ///
+    /// \brief ApsServerLinux constructor
+    /// \param net The RawSocket to the AVDECC network
+    /// \param path The HTTP path that APCs connect to
+    /// \param max_connections The number of APCs that may be connected
+    ///
+    ApsServerLinux( RawSocket &net, std::string const &path = "/", uint16_t max_connections = JDKSAVDECCMCU_APSSERVER_MAX_CONNECTIONS );
+
+    ~ApsServerLinux();
+
+    ///
+    /// \brief open Start listening for APC connections
+    /// \param tcp_port The TCP port to listen on, 0 for any
+    /// \param bind_address The numeric address to listen on, 0 for all
+    /// \return true on success
+    ///
+    bool open( uint16_t tcp_port, char const *bind_address = 0 );
+
+    ///
+    /// \brief close Close all connections and stop listening
+    ///
+    void close();
+
+    ///
+    /// \brief isOpen test if the server is listening
+    ///
+    bool isOpen() const { return m_listen_fd >= 0; }
+
+    ///
+    /// \brief getListenPort get the TCP port that the server listens on
+    ///
+    uint16_t getListenPort() const { return m_listen_port; }
+
+    ///
+    /// \brief poll Wait for activity and handle it
+    /// \param timeout_ms the longest time to wait
+    /// \return the number of events handled, or -1 on error
+    ///
+    int poll( int timeout_ms );
+
+    ///
+    /// \brief sendAvdeccToL2 send a frame from an APC to the network
+    ///
+    void sendAvdeccToL2( Frame const &frame ) { m_net.sendFrame( frame ); }
+
+    ///
+    /// \brief getConnectionCount get the number of APCs connected
+    ///
+    uint16_t getConnectionCount() const { return uint16_t( m_connections.size() ); }
+
+    ///
+    /// \brief getConnection get the i'th connection
+    ///
+    ApsServerConnection *getConnection( uint16_t i ) { return m_connections[i]; }
+
+    ///
+    /// \brief getRejectedCount get the number of APCs that were turned
+    /// away because max_connections were connected
+    ///
+    uint32_t getRejectedCount() const { return m_rejected_count; }
+
+    ///
+    /// \brief getOverflowCount get the number of APCs that were
+    /// disconnected because they did not keep up
+    ///
+    uint32_t getOverflowCount() const { return m_overflow_count; }
+
+    ///
+    /// \brief getDroppedCount get the number of ADP messages that were not
+    /// sent to a backlogged APC
+    ///
+    uint32_t getDroppedCount() const { return m_dropped_count; }
+
+    ///
+    /// \brief getWriteCount get the number of writes to APCs
+    ///
+    uint32_t getWriteCount() const { return m_write_count; }
+
+    ///
+    /// \brief getFilteredCount get the number of frames from the network
+    /// that no APC wanted
+    ///
+    uint32_t getFilteredCount() const { return m_filtered_count; }
+
+  protected:
+    friend class ApsServerConnection;
+
+    void acceptConnections();
+    void handleConnection( ApsServerConnection *connection, uint32_t events );
+    void receiveFromL2();
+    void updateEvents( ApsServerConnection *connection );
+    void flushConnections();
+    void closeConnections();
+    void destroy( ApsServerConnection *connection );
+    void compileFilters();
+    void addMatches( std::vector<ApsServerConnection *> const &connections, bool multicast );
+    void addMatch( ApsServerConnection *connection, bool multicast );
+    void addEntityMatches( Frame const &frame, uint16_t offset, uint8_t subtype_bit, bool multicast );
+
+    /// A connection that wants some subtypes of the frames about an entity
+    struct FilterEntry
+    {
+        ApsServerConnection *m_connection;
+        uint8_t m_subtypes;
+    };
+
+    RawSocket &m_net;
+    std::string m_path;
+    uint16_t m_max_connections;
+    int m_listen_fd;
+    int m_epoll_fd;
+    uint16_t m_listen_port;
+    std::vector<ApsServerConnection *> m_connections;
+    uint16_t m_active_entity_id_count;
+    ApsStateMachine::active_connections_type m_active_connections;
+    uint32_t m_rejected_count;
+    uint32_t m_overflow_count;
+    uint32_t m_dropped_count;
+    uint32_t m_write_count;
+    uint32_t m_filtered_count;
+
+    /// The connections with data queued since they were last flushed
+    std::vector<ApsServerConnection *> m_flush_list;
+
+    /// The compiled filters, by subtype and by entity id
+    bool m_filters_dirty;
+    std::vector<ApsServerConnection *> m_all_by_subtype[4];
+    std::unordered_map<Eui64, std::vector<FilterEntry> > m_by_entity;
+    uint32_t m_match_stamp;
+    std::vector<ApsServerConnection *> m_matches;
+    AppMessageView m_fanout_msg;
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> m_fanout_buf;
+
+    FrameWithMTU m_rx_frame;
+    std::vector<uint8_t> m_read_buf;
+};
+}
+
+#endif
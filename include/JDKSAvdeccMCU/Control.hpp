@@ -64,6 +64,9 @@ class Control : public Handler
 
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
 
+    /// Ask for SET_CONTROL and GET_CONTROL commands for this descriptor only
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
     virtual uint8_t formControlValueMetaData( Frame &pdu );
 
     virtual uint8_t formControlPayload( Frame &pdu );
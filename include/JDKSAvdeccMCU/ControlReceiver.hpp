@@ -157,6 +157,27 @@ class ControlReceiver : public Handler
         return r;
     }
 
+    /// Ask for the AEM commands that are handled
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override
+    {
+        static const uint16_t command_types[] = {JDKSAVDECC_AEM_COMMAND_GET_CONTROL,
+                                                 JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                                                 JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR};
+        uint16_t const num_command_types = sizeof( command_types ) / sizeof( command_types[0] );
+        uint16_t r = 0;
+        // A partial key set would hide the other commands, so ask for every
+        // frame when they do not all fit
+        for ( uint16_t i = 0; i < num_command_types && max_keys >= num_command_types; ++i )
+        {
+            keys[r++] = HandlerDispatchKey( HandlerDispatchKey::COMMAND_TYPE,
+                                            JDKSAVDECC_AVTP_ETHERTYPE,
+                                            JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                            JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND,
+                                            command_types[i] );
+        }
+        return r;
+    }
+
     /// Get the enitity ID that we are handling
     Eui64 const &getEntityID() const { return m_entity_id; }
 
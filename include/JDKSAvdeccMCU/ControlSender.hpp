@@ -59,6 +59,9 @@ class ControlSender : public Handler
     /// Handle incoming PDU
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
 
+    /// Only needs tick(), never offered any PDU's
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
     /// Formulate the AECPU set control for and send it. Returns true if the
     /// message was
     /// actually sent.
@@ -0,0 +1,231 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocket.hpp"
+#include "JDKSAvdeccMCU/Frame.hpp"
+#include "JDKSAvdeccMCU/Handler.hpp"
+#include "JDKSAvdeccMCU/Helpers.hpp"
+#include "JDKSAvdeccMCU/ControllerEntity.hpp"
+#include "JDKSAvdeccMCU/ControlValueHolder.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+
+/// The shortest time between two SET_CONTROL commands for one control
+#ifndef JDKSAVDECCMCU_CONTROLSENDERGROUP_MIN_INTERVAL_MS
+#define JDKSAVDECCMCU_CONTROLSENDERGROUP_MIN_INTERVAL_MS ( 10 )
+#endif
+
+/// The longest that the measured response latency can stretch the time
+/// between two SET_CONTROL commands for one control
+#ifndef JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS
+#define JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS ( 250 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The ControlSenderItem struct
+///
+/// One control on a target entity that a ControlSenderGroup keeps up to
+/// date
+///
+struct ControlSenderItem
+{
+    /// The entity id of the target entity
+    Eui64 m_target_entity_id;
+
+    /// The MAC address of the target entity
+    Eui48 m_target_mac_address;
+
+    /// The CONTROL descriptor index on the target entity
+    uint16_t m_target_descriptor_index;
+
+    /// The holder of the newest value
+    ControlValueHolder *m_holder;
+
+    /// When the value was last sent
+    jdksavdecc_timestamp_in_milliseconds m_last_send_time;
+
+    /// A SET_CONTROL for it is waiting for its response
+    bool m_in_flight;
+
+    /// The sequence_id of the SET_CONTROL that is waiting for its response
+    uint16_t m_sequence_id;
+};
+
+///
+/// \brief The ControlSenderGroup class
+///
+/// Keeps many controls on other entities up to date with their
+/// ControlValueHolders, like a ControlSender for each of them, but only
+/// ever sends the newest value of each control. While a SET_CONTROL for a
+/// control waits for its response, later changes only mark the holder
+/// dirty, and the value that the holder has when the response arrives is
+/// the one that is sent next. The intermediate values of a quickly spun
+/// knob are never put on the wire.
+///
+/// The shortest time between two SET_CONTROL commands for one control
+/// follows the smoothed response latency, so a slow target is sent fewer
+/// updates. All of the controls that are due for one target entity are sent
+/// back to back.
+///
+/// Without an InflightCommands table the ControllerEntity tracks only one
+/// command at a time, so the controls are then sent one at a time, each
+/// after the response to the one before. It does not contain the storage
+/// of the items
+///
+class ControlSenderGroup : public Handler, public InflightCommandNotification
+{
+  public:
+    ///
+    /// \brief ControlSenderGroup construct a ControlSenderGroup object
+    /// \param controller_entity The ControllerEntity to send the commands with
+    /// \param item_storage pointer to array of ControlSenderItem objects
+    /// \param max_items maximum number of items that the array can hold
+    /// \param update_rate_in_millis how often an unchanged value is sent
+    /// again anyway
+    /// \param min_interval_in_millis the shortest time between two commands
+    /// for one control
+    ///
+    ControlSenderGroup( ControllerEntity &controller_entity,
+                        ControlSenderItem *item_storage,
+                        uint16_t max_items,
+                        jdksavdecc_timestamp_in_milliseconds update_rate_in_millis,
+                        jdksavdecc_timestamp_in_milliseconds min_interval_in_millis
+                        = JDKSAVDECCMCU_CONTROLSENDERGROUP_MIN_INTERVAL_MS );
+
+    ///
+    /// \brief add Start keeping a control on a target entity up to date
+    /// \param target_entity_id The target entity id
+    /// \param target_mac_address The target MAC address
+    /// \param target_descriptor_index The CONTROL descriptor index
+    /// \param holder The holder of the value
+    /// \return false if there is no room for another control
+    ///
+    bool add( Eui64 const &target_entity_id,
+              Eui48 const &target_mac_address,
+              uint16_t target_descriptor_index,
+              ControlValueHolder *holder );
+
+    /// Send the SET_CONTROL messages that are due
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
+
+    /// Handle incoming PDU
+    virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
+
+    /// Only needs tick(), never offered any PDU's
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
+    /// A SET_CONTROL was answered, measure how long it took (from
+    /// InflightCommandNotification)
+    virtual void inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu ) override;
+
+    /// A SET_CONTROL was not answered, back off (from
+    /// InflightCommandNotification)
+    virtual void inflightCommandTimedOut( InflightCommand const &cmd ) override;
+
+    ControllerEntity &getControllerEntity() { return m_controller_entity; }
+
+    ///
+    /// \brief getCount Get the number of controls
+    ///
+    uint16_t getCount() const { return m_num_items; }
+
+    ///
+    /// \brief getItem Get the control at position i
+    ///
+    ControlSenderItem *getItem( uint16_t i ) { return &m_item[i]; }
+
+    ///
+    /// \brief getSendInterval Get the current shortest time between two
+    /// commands for one control
+    ///
+    jdksavdecc_timestamp_in_milliseconds getSendInterval() const
+    {
+        return m_smoothed_latency_in_millis > m_min_interval_in_millis ? m_smoothed_latency_in_millis : m_min_interval_in_millis;
+    }
+
+    ///
+    /// \brief getSmoothedLatency Get the smoothed response latency
+    ///
+    jdksavdecc_timestamp_in_milliseconds getSmoothedLatency() const { return m_smoothed_latency_in_millis; }
+
+    ///
+    /// \brief getSentCount Get the number of SET_CONTROL commands sent
+    ///
+    uint32_t getSentCount() const { return m_sent_count; }
+
+  protected:
+    /// Is it time to send the value of the item
+    bool isDue( ControlSenderItem const *item, jdksavdecc_timestamp_in_milliseconds time_in_millis ) const;
+
+    /// Send the value of the item, returns false if it could not be sent
+    bool send( ControlSenderItem *item, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    /// Find the item that a tracked command was sent for
+    ControlSenderItem *findInFlight( InflightCommand const &cmd );
+
+    ControllerEntity &m_controller_entity;
+    uint16_t m_num_items;
+    uint16_t m_max_items;
+    ControlSenderItem *m_item;
+
+    /// The item that could not be sent last time, which is tried first
+    uint16_t m_first_item;
+    jdksavdecc_timestamp_in_milliseconds m_update_rate_in_millis;
+    jdksavdecc_timestamp_in_milliseconds m_min_interval_in_millis;
+    jdksavdecc_timestamp_in_milliseconds m_smoothed_latency_in_millis;
+    uint32_t m_sent_count;
+};
+
+///
+/// \brief The ControlSenderGroupWithSize class
+///
+/// ControlSenderGroup that contains the storage for MaxItems controls
+///
+template <uint16_t MaxItems>
+class ControlSenderGroupWithSize : public ControlSenderGroup
+{
+  private:
+    ControlSenderItem m_item_storage[MaxItems];
+
+  public:
+    ControlSenderGroupWithSize( ControllerEntity &controller_entity,
+                                jdksavdecc_timestamp_in_milliseconds update_rate_in_millis,
+                                jdksavdecc_timestamp_in_milliseconds min_interval_in_millis
+                                = JDKSAVDECCMCU_CONTROLSENDERGROUP_MIN_INTERVAL_MS )
+        : ControlSenderGroup( controller_entity, m_item_storage, MaxItems, update_rate_in_millis, min_interval_in_millis )
+    {
+    }
+};
+}
@@ -51,6 +51,7 @@ class ControlValueHolder : public FixedBuffer
 
     bool isDirty() const { return m_dirty; }
     void clearDirty() { m_dirty = false; }
+    void setDirty() { m_dirty = true; }
 
     uint16_t getValueLength() const { return m_value_length; }
 
@@ -0,0 +1,251 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Helpers.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+
+/// The largest command payload (the octets following the AEM command_type)
+/// that can be queued
+#ifndef JDKSAVDECCMCU_COMMAND_QUEUE_MAX_PAYLOAD_LENGTH
+#define JDKSAVDECCMCU_COMMAND_QUEUE_MAX_PAYLOAD_LENGTH ( 64 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The QueuedCommand struct
+///
+/// An AEM command waiting for its target's window to open
+///
+struct QueuedCommand
+{
+    /// The AEM command_type
+    uint16_t m_command_type;
+
+    /// The object to notify of the outcome once it is sent, may be 0
+    InflightCommandNotification *m_notification;
+
+    /// The length of the payload
+    uint16_t m_payload_length;
+
+    /// The command specific payload following the command_type
+    uint8_t m_payload[JDKSAVDECCMCU_COMMAND_QUEUE_MAX_PAYLOAD_LENGTH];
+};
+
+///
+/// \brief The CommandQueueTarget struct
+///
+/// The pending commands, window and statistics for one target entity
+///
+struct CommandQueueTarget
+{
+    /// The target entity id, or FF:FF:FF:FF:FF:FF:FF:FF if the slot is not in
+    /// use
+    Eui64 m_target_entity_id;
+
+    /// The target's MAC address
+    Eui48 m_target_mac_address;
+
+    /// The maximum number of commands in flight to this target
+    uint16_t m_window;
+
+    /// The position of the oldest pending command in the target's ring
+    uint16_t m_head;
+
+    /// The number of pending commands
+    uint16_t m_depth;
+
+    /// The highest number of pending commands seen
+    uint16_t m_max_depth;
+
+    /// The number of commands sent from the queue
+    uint32_t m_sent_count;
+
+    /// The number of commands that received a response
+    uint32_t m_completed_count;
+
+    /// The number of commands that timed out
+    uint32_t m_timed_out_count;
+
+    /// Round trip times of completed commands
+    jdksavdecc_timestamp_in_milliseconds m_last_round_trip_in_ms;
+    jdksavdecc_timestamp_in_milliseconds m_min_round_trip_in_ms;
+    jdksavdecc_timestamp_in_milliseconds m_max_round_trip_in_ms;
+    jdksavdecc_timestamp_in_milliseconds m_total_round_trip_in_ms;
+
+    /// Get the mean round trip time of completed commands
+    jdksavdecc_timestamp_in_milliseconds getAverageRoundTrip() const
+    {
+        return m_completed_count ? m_total_round_trip_in_ms / m_completed_count : 0;
+    }
+};
+
+///
+/// \brief The ControllerCommandQueue class
+///
+/// Holds AEM commands per target entity so that a ControllerEntity can
+/// limit the number of commands in flight to each target while keeping
+/// all targets busy at the same time.
+/// It does not contain the storage of the targets or the pending commands
+///
+class ControllerCommandQueue
+{
+  public:
+    ///
+    /// \brief ControllerCommandQueue construct a ControllerCommandQueue
+    /// \param target_storage pointer to array of max_targets targets
+    /// \param command_storage pointer to array of max_targets *
+    /// max_pending_per_target commands
+    /// \param max_targets the number of targets that can be queued for
+    /// \param max_pending_per_target the number of commands that can wait for
+    /// each target
+    /// \param default_window the number of commands allowed in flight to a
+    /// target until setWindow() is called for it
+    ///
+    ControllerCommandQueue( CommandQueueTarget *target_storage,
+                            QueuedCommand *command_storage,
+                            uint16_t max_targets,
+                            uint16_t max_pending_per_target,
+                            uint16_t default_window = 1 );
+
+    ///
+    /// \brief findTarget Find the queue of a target entity
+    /// \return pointer to the target or 0 if it has never been queued for
+    ///
+    CommandQueueTarget *findTarget( Eui64 const &target_entity_id );
+    CommandQueueTarget const *findTarget( Eui64 const &target_entity_id ) const;
+
+    ///
+    /// \brief findOrAddTarget Find the queue of a target entity, allocating
+    /// a slot for it if needed
+    /// \return pointer to the target or 0 if there is no room
+    ///
+    CommandQueueTarget *findOrAddTarget( Eui64 const &target_entity_id, Eui48 const &target_mac_address );
+
+    ///
+    /// \brief removeTarget Drop all pending commands to a target and free its
+    /// slot
+    ///
+    void removeTarget( Eui64 const &target_entity_id );
+
+    ///
+    /// \brief setWindow Set the number of commands allowed in flight to a
+    /// target
+    /// \return false if there is no room for the target
+    ///
+    bool setWindow( Eui64 const &target_entity_id, Eui48 const &target_mac_address, uint16_t window );
+
+    ///
+    /// \brief enqueue Add a command to the end of a target's queue
+    /// \return false if the target's queue is full or the payload is too big
+    ///
+    bool enqueue( Eui64 const &target_entity_id,
+                  Eui48 const &target_mac_address,
+                  uint16_t command_type,
+                  uint8_t const *payload1,
+                  uint16_t payload_length1,
+                  uint8_t const *payload2 = 0,
+                  uint16_t payload_length2 = 0,
+                  InflightCommandNotification *notification = 0 );
+
+    ///
+    /// \brief front Get the oldest pending command of a target
+    /// \return pointer to the command or 0 if there are none
+    ///
+    QueuedCommand *front( CommandQueueTarget *target );
+
+    ///
+    /// \brief pop Remove the oldest pending command of a target, counting it
+    /// as sent
+    ///
+    void pop( CommandQueueTarget *target );
+
+    ///
+    /// \brief commandCompleted Account for a response to a command
+    /// \param cmd the completed inflight command
+    /// \param time_in_millis the time the response arrived
+    ///
+    void commandCompleted( InflightCommand const &cmd, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    ///
+    /// \brief commandTimedOut Account for a command that timed out
+    ///
+    void commandTimedOut( Eui64 const &target_entity_id );
+
+    /// Get the number of target slots
+    uint16_t getMaxTargets() const { return m_max_targets; }
+
+    /// Get a target slot
+    CommandQueueTarget *getTarget( uint16_t i ) { return &m_targets[i]; }
+    CommandQueueTarget const *getTarget( uint16_t i ) const { return &m_targets[i]; }
+
+    /// Get the number of pending commands for one target
+    uint16_t getQueueDepth( Eui64 const &target_entity_id ) const;
+
+    /// Get the number of pending commands for all targets
+    uint32_t getTotalQueueDepth() const;
+
+    /// Get the number of commands that were refused because a queue was
+    /// full
+    uint32_t getDroppedCount() const { return m_dropped_count; }
+
+  protected:
+    CommandQueueTarget *m_targets;
+    QueuedCommand *m_commands;
+    uint16_t m_max_targets;
+    uint16_t m_max_pending_per_target;
+    uint16_t m_default_window;
+    uint32_t m_dropped_count;
+};
+
+///
+/// \brief The ControllerCommandQueueWithSize class
+///
+/// ControllerCommandQueue that contains the storage for MaxTargets targets
+/// with up to MaxPendingPerTarget commands waiting for each
+///
+template <uint16_t MaxTargets, uint16_t MaxPendingPerTarget>
+class ControllerCommandQueueWithSize : public ControllerCommandQueue
+{
+  private:
+    CommandQueueTarget m_target_storage[MaxTargets];
+    QueuedCommand m_command_storage[MaxTargets * MaxPendingPerTarget];
+
+  public:
+    ControllerCommandQueueWithSize( uint16_t default_window = 1 )
+        : ControllerCommandQueue( m_target_storage, m_command_storage, MaxTargets, MaxPendingPerTarget, default_window )
+    {
+    }
+};
+}
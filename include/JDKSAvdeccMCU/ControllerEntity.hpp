@@ -38,6 +38,7 @@
 #include "JDKSAvdeccMCU/ADPManager.hpp"
 #include "JDKSAvdeccMCU/Entity.hpp"
 #include "JDKSAvdeccMCU/EntityState.hpp"
+#include "JDKSAvdeccMCU/ControllerCommandQueue.hpp"
 
 namespace JDKSAvdeccMCU
 {
@@ -45,14 +46,46 @@ namespace JDKSAvdeccMCU
 class ControllerEntity : public Entity
 {
   public:
-    ControllerEntity( ADPManager &adp_manager, RegisteredControllers *registered_controllers, EntityState *entity_state )
-        : Entity( adp_manager, registered_controllers, entity_state )
+    ControllerEntity( ADPManager &adp_manager,
+                      RegisteredControllers *registered_controllers,
+                      EntityState *entity_state,
+                      InflightCommands *inflight_commands = 0,
+                      ControllerCommandQueue *command_queue = 0 )
+        : Entity( adp_manager, registered_controllers, entity_state, 0, 0, 0, inflight_commands )
+        , m_command_queue( command_queue )
     {
     }
 
+    /// Run periodic state machines and send queued commands (from Handler)
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
+
+    /// Notification that a command to a target entity timed out
+    virtual void commandTimedOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id ) override;
+
+    /// Get the per target command queue, if any
+    ControllerCommandQueue *getCommandQueue() { return m_command_queue; }
+
+    /// Send a tracked command through the per target command queue if there
+    /// is one, otherwise send it immediately. Returns false if the command
+    /// could neither be queued nor sent
+    bool queueCommand( Eui64 const &target_entity_id,
+                       Eui48 const &target_mac_address,
+                       uint16_t aem_command_type,
+                       uint8_t const *additional_data1 = 0,
+                       uint16_t additional_data_length1 = 0,
+                       uint8_t const *additional_data2 = 0,
+                       uint16_t additional_data_length2 = 0,
+                       InflightCommandNotification *notification = 0 );
+
+    /// Send as many queued commands as the windows allow, for all targets
+    void drainCommandQueue();
+
     /// Handle incoming commands and responses
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
 
+    /// Also ask for AEM and AA responses
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
     virtual bool receivedAAResponse( jdksavdecc_aecp_aa const &aa, Frame &pdu );
 
     bool receivedAEMResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
@@ -73,11 +106,12 @@ class ControllerEntity : public Entity
     virtual bool receiveEntityAvailableResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
     // Formulate and send a READ_DESCRIPTOR command to a target entity
-    void sendReadDescriptor( Eui64 const &target_entity_id,
+    bool sendReadDescriptor( Eui64 const &target_entity_id,
                              Eui48 const &target_mac_address,
                              uint16_t configuration_index,
                              uint16_t descriptor_type,
-                             uint16_t descriptor_index );
+                             uint16_t descriptor_index,
+                             InflightCommandNotification *notification = 0 );
 
     virtual bool receiveReadDescriptorResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
@@ -113,12 +147,13 @@ class ControllerEntity : public Entity
     virtual bool receiveGetNameResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
     // Formulate and send a SET_CONTROL command to a target entity
-    void sendSetControl( Eui64 const &target_entity_id,
+    bool sendSetControl( Eui64 const &target_entity_id,
                          Eui48 const &target_mac_address,
                          uint16_t target_descriptor_index,
                          uint8_t *control_value,
                          uint16_t control_value_len,
-                         bool track_for_ack );
+                         bool track_for_ack,
+                         InflightCommandNotification *notification = 0 );
 
     virtual bool receiveSetControlResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
@@ -143,10 +178,18 @@ class ControllerEntity : public Entity
                                          uint16_t control_value_len );
 
     // Formulate and send a GET_CONTROL command to a target entity
-    void sendGetControl( Eui64 const &target_entity_id, Eui48 const &target_mac_address, uint16_t target_descriptor_index );
+    bool sendGetControl( Eui64 const &target_entity_id,
+                         Eui48 const &target_mac_address,
+                         uint16_t target_descriptor_index,
+                         InflightCommandNotification *notification = 0 );
 
     virtual bool receiveGetControlResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
   protected:
+    /// Send as many queued commands to one target as its window allows
+    void drainCommandQueue( CommandQueueTarget *target );
+
+    /// The per target command queue, if any
+    ControllerCommandQueue *m_command_queue;
 };
 }
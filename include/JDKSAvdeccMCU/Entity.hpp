@@ -41,6 +41,20 @@
 #include "JDKSAvdeccMCU/ACMPController.hpp"
 #include "JDKSAvdeccMCU/RegisteredController.hpp"
 #include "JDKSAvdeccMCU/EntityState.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+#include "JDKSAvdeccMCU/TimerWheel.hpp"
+#include "JDKSAvdeccMCU/UnsolicitedCoalescer.hpp"
+
+/// The number of fragments that an EntityState can add to one response
+#ifndef JDKSAVDECCMCU_ENTITY_MAX_RESPONSE_FRAGMENTS
+#define JDKSAVDECCMCU_ENTITY_MAX_RESPONSE_FRAGMENTS ( 4 )
+#endif
+
+/// The number of per-controller copies of an unsolicited response that
+/// are handed to the RawSocket in one batch
+#ifndef JDKSAVDECCMCU_ENTITY_UNSOLICITED_BATCH
+#define JDKSAVDECCMCU_ENTITY_UNSOLICITED_BATCH ( 16 )
+#endif
 
 namespace JDKSAvdeccMCU
 {
@@ -59,7 +73,9 @@ class Entity : public Handler
             EntityState *entity_state,
             ACMPControllerGroupHandlerBase *acmp_controller_group_handler = 0,
             ACMPTalkerGroupHandlerBase *acmp_talker_group_handler = 0,
-            ACMPListenerGroupHandlerBase *acmp_listener_group_handler = 0 );
+            ACMPListenerGroupHandlerBase *acmp_listener_group_handler = 0,
+            InflightCommands *inflight_commands = 0,
+            UnsolicitedCoalescer *unsolicited_coalescer = 0 );
 
     /// Run periodic state machines (from Handler)
     virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
@@ -67,6 +83,13 @@ class Entity : public Handler
     /// Handle received AECPDU's (from Handler)
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
 
+    /// Ask for AEM and AA commands and ACMP messages (from Handler)
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
+    /// tick() only needs to run for lock and command time outs, unless
+    /// there are ACMP state machines to run (from Handler)
+    virtual Timer *getTimer() override;
+
     /// Notification that a command to a target entity timed out
     virtual void commandTimedOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id );
 
@@ -79,6 +102,9 @@ class Entity : public Handler
     /// Get the Entity ID
     Eui64 const &getEntityID() const { return m_adp_manager.getEntityID(); }
 
+    /// Get the sequence_id of the last command that was sent
+    uint16_t getOutgoingSequenceID() const { return m_outgoing_sequence_id; }
+
     /// Check to make sure the command is allowed or disallowed due to acquire
     /// or locking
     uint8_t validatePermissions( jdksavdecc_aecpdu_aem const &aem );
@@ -95,23 +121,67 @@ class Entity : public Handler
 
     virtual uint8_t receivedACMPMessage( RawSocket *incoming_socket, jdksavdecc_acmpdu const &acmpdu, Frame &pdu );
 
-    /// Can we send a command now? i.e. are there no in-flight commands waiting
-    /// to be acknowledged?
+    /// Can we send a command now? i.e. is there room to track another
+    /// in-flight command waiting to be acknowledged?
     bool canSendCommand() const
     {
+        if ( m_inflight_commands )
+        {
+            return !m_inflight_commands->isFull();
+        }
         // last sent command type is set to JDKSAVDECC_AEM_COMMAND_EXPANSION
         // when there is no command in flight
-        return m_last_sent_command_type != JDKSAVDECC_AEM_COMMAND_EXPANSION;
+        return m_last_sent_command_type == JDKSAVDECC_AEM_COMMAND_EXPANSION;
     }
 
-    void sendCommand( Eui64 const &target_entity_id,
+    /// Get the in-flight command table, if any
+    InflightCommands *getInflightCommands() { return m_inflight_commands; }
+
+    /// Get the unsolicited response coalescer, if any
+    UnsolicitedCoalescer *getUnsolicitedCoalescer() { return m_unsolicited_coalescer; }
+
+    /// Formulate and send an AEM command to a target entity, with the
+    /// fragments as the command specific data.
+    /// If track_for_ack is set and there is an in-flight command table then
+    /// the command is tracked there and the optional notification is told of
+    /// the outcome. Without a table it replaces the one tracked command, and
+    /// the notification of the replaced command is told that it timed out.
+    /// Returns false if the command could not be tracked and was not sent.
+    bool sendCommandFragments( Eui64 const &target_entity_id,
+                               Eui48 const &target_mac_address,
+                               uint16_t aem_command_type,
+                               bool track_for_ack,
+                               FrameFragment const *fragments,
+                               uint16_t num_fragments,
+                               InflightCommandNotification *notification = 0 );
+
+    /// Formulate and send an AEM command to a target entity, with up to two
+    /// additional data areas. See sendCommandFragments()
+    bool sendCommand( Eui64 const &target_entity_id,
                       Eui48 const &target_mac_address,
                       uint16_t aem_command_type,
                       bool track_for_ack = true,
                       uint8_t const *additional_data1 = 0,
                       uint16_t additional_data_length1 = 0,
                       uint8_t const *additional_data2 = 0,
-                      uint16_t additional_data_length2 = 0 );
+                      uint16_t additional_data_length2 = 0,
+                      InflightCommandNotification *notification = 0 )
+    {
+        FrameFragment fragments[2]
+            = {FrameFragment( additional_data1, additional_data_length1 ), FrameFragment( additional_data2, additional_data_length2 )};
+        return sendCommandFragments(
+            target_entity_id, target_mac_address, aem_command_type, track_for_ack, fragments, 2, notification );
+    }
+
+    /// Send a direct response to the target entity id, and unsolicited
+    /// responses to all other subscribed controllers. The fragments follow
+    /// the pdu on the wire without being copied into it
+    void sendResponseFragments( bool internally_generated,
+                                bool send_to_registered_controllers,
+                                uint8_t aecp_status_code,
+                                Frame &pdu,
+                                FrameFragment const *fragments,
+                                uint16_t num_fragments );
 
     /// Send a direct response to the target entity id, and unsolicited
     /// responses to all other subscribed controllers
@@ -122,7 +192,16 @@ class Entity : public Handler
                         uint8_t const *additional_data1 = 0,
                         uint16_t additional_data_length1 = 0,
                         uint8_t const *additional_data2 = 0,
-                        uint16_t additional_data_length2 = 0 );
+                        uint16_t additional_data_length2 = 0 )
+    {
+        FrameFragment fragments[2]
+            = {FrameFragment( additional_data1, additional_data_length1 ), FrameFragment( additional_data2, additional_data_length2 )};
+        sendResponseFragments( internally_generated, send_to_registered_controllers, aecp_status_code, pdu, fragments, 2 );
+    }
+
+    /// Formulate an AEM Unsolicited response of specified command_type with the
+    /// fragments as payload, and send it to all interested controllers
+    void sendUnsolicitedResponseFragments( uint16_t aem_command_type, FrameFragment const *fragments, uint16_t num_fragments );
 
     /// Formulate an AEM Unsolicited response of specified command_type with the
     /// specified additional data as payload, and send it to all interested
@@ -131,7 +210,18 @@ class Entity : public Handler
                                    uint8_t const *additional_data1 = 0,
                                    uint16_t additional_data_length1 = 0,
                                    uint8_t const *additional_data2 = 0,
-                                   uint16_t additional_data_length2 = 0 );
+                                   uint16_t additional_data_length2 = 0 )
+    {
+        FrameFragment fragments[2]
+            = {FrameFragment( additional_data1, additional_data_length1 ), FrameFragment( additional_data2, additional_data_length2 )};
+        sendUnsolicitedResponseFragments( aem_command_type, fragments, 2 );
+    }
+
+    /// While an EntityState handles a command, add payload that follows the
+    /// response pdu on the wire, such as a descriptor or a control value.
+    /// The data is not copied and must stay valid until the command handler
+    /// returns. Returns false if there is no room for another fragment
+    bool addResponseFragment( uint8_t const *data, uint16_t length );
 
     /// The pdu contains a valid Acquire Entity command.
     /// Fill in the response in place in the pdu and return an AECP AEM status
@@ -186,6 +276,26 @@ class Entity : public Handler
     uint8_t receiveDeRegisterUnsolicitedNotificationCommand( jdksavdecc_aecpdu_aem const &aem, Frame &pdu );
 
   protected:
+    /// Retransmit or expire the commands in the in-flight command table
+    void tickInflightCommands( jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    /// Schedule the next tick() for the earliest pending time out
+    void scheduleNextTick();
+
+    /// Describe the one command tracked without an in-flight table
+    void getLastSentCommand( InflightCommand *cmd, uint16_t sequence_id ) const;
+
+    /// A tracked command was not answered in time
+    void handleCommandTimeOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id );
+
+    /// Send one copy of an unsolicited response to each registered
+    /// controller, and to the acquiring controller if it was internally
+    /// generated. The copies are handed to the RawSocket in batches
+    void sendToRegisteredControllers( bool internally_generated,
+                                      Frame const &pdu,
+                                      FrameFragment const *fragments,
+                                      uint16_t num_fragments );
+
     /// The advertising manager, also contains capabilities, entity_id, and
     /// entity_model_id
     ADPManager &m_adp_manager;
@@ -234,9 +344,26 @@ class Entity : public Handler
     /// entity
     uint16_t m_last_sent_command_type;
 
+    /// The object to notify when the last command that we sent is answered
+    /// or times out, may be 0
+    InflightCommandNotification *m_last_sent_command_notification;
+
+    /// The table of commands in flight, if any. When there is no table
+    /// then only one command at a time is tracked with the
+    /// m_last_sent_command_* members
+    InflightCommands *m_inflight_commands;
+
+    /// Holds back unsolicited responses that come too soon after the last
+    /// one about the same descriptor, if any
+    UnsolicitedCoalescer *m_unsolicited_coalescer;
+
     /// The entity state object, if any
     EntityState *m_entity_state;
 
+    /// The payload that the entity state added to the current response
+    FrameFragment m_response_fragment[JDKSAVDECCMCU_ENTITY_MAX_RESPONSE_FRAGMENTS];
+    uint16_t m_num_response_fragments;
+
     /// The ACMP Controller state machines (if any)
     ACMPControllerGroupHandlerBase *m_acmp_controller_group_handler;
 
@@ -245,5 +372,8 @@ class Entity : public Handler
 
     /// The ACMP Listener state machines (if any)
     ACMPListenerGroupHandlerBase *m_acmp_listener_group_handler;
+
+    /// When tick() next has work to do
+    Timer m_timer;
 };
 }
@@ -0,0 +1,347 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Handler.hpp"
+#include "JDKSAvdeccMCU/Helpers.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+#include "JDKSAvdeccMCU/ControllerEntity.hpp"
+
+/// The number of descriptors per entity that can be waiting to be read
+/// again after a time out
+#ifndef JDKSAVDECCMCU_ENTITY_ENUMERATOR_MAX_RETRIES
+#define JDKSAVDECCMCU_ENTITY_ENUMERATOR_MAX_RETRIES ( 8 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The DescriptorStore class
+///
+/// Keeps the raw descriptors of one entity packed back to back in a fixed
+/// buffer. Each record is a two octet length followed by the descriptor as
+/// it was received, which starts with its descriptor_type and
+/// descriptor_index.
+/// It does not contain the storage of the records
+///
+class DescriptorStore
+{
+  public:
+    DescriptorStore() : m_buf( 0 ), m_max_length( 0 ), m_length( 0 ), m_count( 0 ) {}
+
+    DescriptorStore( uint8_t *buf, uint32_t max_length ) : m_buf( buf ), m_max_length( max_length ), m_length( 0 ), m_count( 0 ) {}
+
+    ///
+    /// \brief setStorage Use a new buffer, forgetting all descriptors
+    ///
+    void setStorage( uint8_t *buf, uint32_t max_length )
+    {
+        m_buf = buf;
+        m_max_length = max_length;
+        clear();
+    }
+
+    ///
+    /// \brief clear Forget all descriptors
+    ///
+    void clear()
+    {
+        m_length = 0;
+        m_count = 0;
+    }
+
+    ///
+    /// \brief add Append a descriptor
+    /// \param descriptor pointer to the descriptor, starting at
+    /// descriptor_type
+    /// \param descriptor_length length of the descriptor in octets
+    /// \return false if there is no room
+    ///
+    bool add( uint8_t const *descriptor, uint16_t descriptor_length );
+
+    ///
+    /// \brief find Find a descriptor by type and index
+    /// \param descriptor_type the descriptor type
+    /// \param descriptor_index the descriptor index
+    /// \param descriptor_length filled in with the length if found
+    /// \return pointer to the descriptor or 0 if not found
+    ///
+    uint8_t const *find( uint16_t descriptor_type, uint16_t descriptor_index, uint16_t *descriptor_length ) const;
+
+    ///
+    /// \brief getNext Iterate through the descriptors
+    /// \param pos iteration position, start at 0
+    /// \param descriptor_length filled in with the length of the descriptor
+    /// \return pointer to the descriptor or 0 when there are no more
+    ///
+    uint8_t const *getNext( uint32_t *pos, uint16_t *descriptor_length ) const;
+
+    /// Get the number of descriptors held
+    uint16_t getCount() const { return m_count; }
+
+    /// Get the number of octets used
+    uint32_t getLength() const { return m_length; }
+
+    /// Get the size of the buffer
+    uint32_t getMaxLength() const { return m_max_length; }
+
+  protected:
+    uint8_t *m_buf;
+    uint32_t m_max_length;
+    uint32_t m_length;
+    uint16_t m_count;
+};
+
+///
+/// \brief The EnumeratorRetry struct
+///
+/// A descriptor that has to be read again
+///
+struct EnumeratorRetry
+{
+    uint16_t m_descriptor_type;
+    uint16_t m_descriptor_index;
+    uint8_t m_attempts;
+    bool m_in_flight;
+};
+
+///
+/// \brief The EnumeratedEntity struct
+///
+/// The enumeration state and descriptors of one remote entity
+///
+struct EnumeratedEntity
+{
+    enum State
+    {
+        READING_ENTITY,
+        READING_CONFIGURATION,
+        READING_DESCRIPTORS,
+        COMPLETED,
+        FAILED
+    };
+
+    /// The entity id, or FF:FF:FF:FF:FF:FF:FF:FF if the slot is not in use
+    Eui64 m_entity_id;
+
+    /// The entity's MAC address
+    Eui48 m_mac_address;
+
+    /// Where the walk is
+    State m_state;
+
+    /// The current configuration of the entity
+    uint16_t m_configuration_index;
+
+    /// The position in the CONFIGURATION descriptor_counts list
+    uint16_t m_counts_pos;
+
+    /// The next descriptor_index to read within m_counts_pos
+    uint16_t m_next_index;
+
+    /// The number of READ_DESCRIPTOR commands outstanding
+    uint16_t m_outstanding;
+
+    /// enumerate() was called again while commands of the last walk were
+    /// outstanding. The new walk starts when they are all answered or timed
+    /// out
+    bool m_restart_pending;
+
+    /// The number of descriptors that could not be read
+    uint16_t m_missing_count;
+
+    /// Descriptors waiting to be read again
+    uint16_t m_retry_count;
+    EnumeratorRetry m_retry[JDKSAVDECCMCU_ENTITY_ENUMERATOR_MAX_RETRIES];
+
+    /// When the enumeration started and finished
+    jdksavdecc_timestamp_in_milliseconds m_start_time;
+    jdksavdecc_timestamp_in_milliseconds m_end_time;
+
+    /// The descriptors read so far
+    DescriptorStore m_store;
+
+    /// Get the time the enumeration took, or has taken so far
+    jdksavdecc_timestamp_in_milliseconds getEnumerationTime() const { return m_end_time - m_start_time; }
+
+    /// Is the enumeration finished, successfully or not?
+    bool isDone() const { return m_state == COMPLETED || m_state == FAILED; }
+};
+
+///
+/// \brief The EntityEnumerator class
+///
+/// Reads the entity model of remote entities by walking from the ENTITY
+/// descriptor to the current CONFIGURATION descriptor and then to every
+/// descriptor listed in its descriptor_counts. Several READ_DESCRIPTOR
+/// commands are kept outstanding per entity, and many entities can be
+/// enumerated at the same time. Descriptors that time out are read again
+/// without restarting the walk.
+///
+/// The ControllerEntity must have an InflightCommands table, since that is
+/// how the results are delivered. A ControllerCommandQueue is recommended so
+/// that each target is paced by its own window.
+///
+/// It does not contain the storage of the entities or descriptors
+///
+class EntityEnumerator : public Handler, public InflightCommandNotification
+{
+  public:
+    ///
+    /// \brief EntityEnumerator construct an EntityEnumerator
+    /// \param controller_entity the controller to send commands with
+    /// \param entity_storage pointer to array of max_entities entities
+    /// \param store_storage pointer to max_entities * store_length_per_entity
+    /// octets for descriptors
+    /// \param max_entities the number of entities that can be enumerated
+    /// \param store_length_per_entity the descriptor space for each entity
+    /// \param max_outstanding_per_entity READ_DESCRIPTOR commands to keep
+    /// outstanding per entity
+    /// \param max_attempts the number of times a descriptor is requested
+    /// before it is counted as missing
+    ///
+    EntityEnumerator( ControllerEntity &controller_entity,
+                      EnumeratedEntity *entity_storage,
+                      uint8_t *store_storage,
+                      uint16_t max_entities,
+                      uint32_t store_length_per_entity,
+                      uint16_t max_outstanding_per_entity = 4,
+                      uint8_t max_attempts = 3 );
+
+    ///
+    /// \brief enumerate Start reading the entity model of an entity. An
+    /// entity that was already enumerated is read again, as soon as the
+    /// commands of the last walk are answered or timed out
+    /// \return false if there is no room for the entity or the first command
+    /// could not be sent
+    ///
+    bool enumerate( Eui64 const &entity_id, Eui48 const &mac_address );
+
+    ///
+    /// \brief forget Free the slot of an entity
+    ///
+    void forget( Eui64 const &entity_id );
+
+    ///
+    /// \brief findEntity Find the enumeration of an entity
+    /// \return pointer to the entity or 0 if not found
+    ///
+    EnumeratedEntity *findEntity( Eui64 const &entity_id );
+
+    /// Get the number of entity slots
+    uint16_t getMaxEntities() const { return m_max_entities; }
+
+    /// Get an entity slot
+    EnumeratedEntity *getEntity( uint16_t i ) { return &m_entities[i]; }
+
+    /// Keep the pipelines full (from Handler)
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override;
+
+    /// The enumerator gets its responses through the in-flight table, not
+    /// directly (from Handler)
+    virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
+
+    /// Never offered any PDU's (from Handler)
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override;
+
+    /// A READ_DESCRIPTOR response arrived (from InflightCommandNotification)
+    virtual void inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu ) override;
+
+    /// A READ_DESCRIPTOR command timed out (from InflightCommandNotification)
+    virtual void inflightCommandTimedOut( InflightCommand const &cmd ) override;
+
+    /// Notification that an entity has been enumerated. The entity's state
+    /// is COMPLETED or FAILED
+    virtual void enumerationCompleted( EnumeratedEntity const &entity );
+
+  protected:
+    /// Start the walk of an entity from its ENTITY descriptor
+    bool start( EnumeratedEntity *entity );
+
+    /// Account for a READ_DESCRIPTOR command that finished. Returns true if
+    /// it belongs to the current walk of the entity
+    bool commandFinished( EnumeratedEntity *entity );
+
+    /// Send READ_DESCRIPTOR commands until the entity's pipeline is full
+    void issue( EnumeratedEntity *entity );
+
+    /// Send one READ_DESCRIPTOR command for the entity
+    bool sendRead( EnumeratedEntity *entity, uint16_t descriptor_type, uint16_t descriptor_index );
+
+    /// Get the next descriptor from the CONFIGURATION descriptor_counts
+    bool nextDescriptor( EnumeratedEntity *entity, uint16_t *descriptor_type, uint16_t *descriptor_index );
+
+    /// Handle a descriptor that was read
+    void descriptorReceived( EnumeratedEntity *entity, uint8_t const *descriptor, uint16_t descriptor_length );
+
+    /// Handle a descriptor that could not be read
+    void descriptorFailed( EnumeratedEntity *entity, uint16_t descriptor_type, uint16_t descriptor_index, bool can_retry );
+
+    /// Finish the enumeration if there is nothing left to do
+    void checkDone( EnumeratedEntity *entity );
+
+    ControllerEntity &m_controller_entity;
+    EnumeratedEntity *m_entities;
+    uint8_t *m_store_storage;
+    uint16_t m_max_entities;
+    uint32_t m_store_length_per_entity;
+    uint16_t m_max_outstanding_per_entity;
+    uint8_t m_max_attempts;
+};
+
+///
+/// \brief The EntityEnumeratorWithSize class
+///
+/// EntityEnumerator that contains the storage for MaxEntities entities with
+/// StoreLengthPerEntity octets of descriptors each
+///
+template <uint16_t MaxEntities, uint32_t StoreLengthPerEntity>
+class EntityEnumeratorWithSize : public EntityEnumerator
+{
+  private:
+    EnumeratedEntity m_entity_storage[MaxEntities];
+    uint8_t m_store_storage[MaxEntities * StoreLengthPerEntity];
+
+  public:
+    EntityEnumeratorWithSize( ControllerEntity &controller_entity, uint16_t max_outstanding_per_entity = 4, uint8_t max_attempts = 3 )
+        : EntityEnumerator( controller_entity,
+                            m_entity_storage,
+                            m_store_storage,
+                            MaxEntities,
+                            StoreLengthPerEntity,
+                            max_outstanding_per_entity,
+                            max_attempts )
+    {
+    }
+};
+}
@@ -121,6 +121,12 @@ class Eui48 : public jdksavdecc_eui48
     ///
     uint64_t convertToUint64() const { return jdksavdecc_eui48_convert_to_uint64( this ); }
 
+    ///
+    /// \brief hash Get a hash of the EUI48 that is the same on every platform
+    /// \return uint64_t with all bits mixed
+    ///
+    uint64_t hash() const;
+
     ///
     /// \brief store Store octets into buffer
     /// \param p destination buffer pointer
@@ -250,6 +256,12 @@ class Eui64 : public jdksavdecc_eui64
     ///
     uint64_t convertToUint64() const { return jdksavdecc_eui64_convert_to_uint64( this ); }
 
+    ///
+    /// \brief hash Get a hash of the EUI64 that is the same on every platform
+    /// \return uint64_t with all bits mixed
+    ///
+    uint64_t hash() const;
+
     ///
     /// \brief store Store octets into buffer
     /// \param p destination buffer pointer
@@ -285,6 +297,53 @@ class Eui64 : public jdksavdecc_eui64
 
     void clear() { jdksavdecc_eui64_init( this ); }
 };
+
+///
+/// \brief euiHash Mix the bits of an EUI converted to a uint64_t, so that
+/// EUI's that are handed out in sequence spread evenly over a table. This
+/// is the MurmurHash3 finalizer
+/// \param v The EUI as a uint64_t
+/// \return The hash
+///
+inline uint64_t euiHash( uint64_t v )
+{
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    v *= 0xc4ceb9fe1a85ec53ULL;
+    v ^= v >> 33;
+    return v;
+}
+
+inline uint64_t Eui48::hash() const { return euiHash( convertToUint64() ); }
+
+inline uint64_t Eui64::hash() const { return euiHash( convertToUint64() ); }
+
+///
+/// \brief euiEqual Compare two EUI48's with one 32 bit and one 16 bit load
+/// of each and no branches
+///
+inline bool euiEqual( jdksavdecc_eui48 const &lhs, jdksavdecc_eui48 const &rhs )
+{
+    uint32_t lhs_high, rhs_high;
+    uint16_t lhs_low, rhs_low;
+    memcpy( &lhs_high, &lhs.value[0], sizeof( lhs_high ) );
+    memcpy( &rhs_high, &rhs.value[0], sizeof( rhs_high ) );
+    memcpy( &lhs_low, &lhs.value[4], sizeof( lhs_low ) );
+    memcpy( &rhs_low, &rhs.value[4], sizeof( rhs_low ) );
+    return ( ( lhs_high ^ rhs_high ) | static_cast<uint32_t>( lhs_low ^ rhs_low ) ) == 0;
+}
+
+///
+/// \brief euiEqual Compare two EUI64's with one 64 bit load of each
+///
+inline bool euiEqual( jdksavdecc_eui64 const &lhs, jdksavdecc_eui64 const &rhs )
+{
+    uint64_t lhs_value, rhs_value;
+    memcpy( &lhs_value, &lhs.value[0], sizeof( lhs_value ) );
+    memcpy( &rhs_value, &rhs.value[0], sizeof( rhs_value ) );
+    return lhs_value == rhs_value;
+}
 }
 
 inline bool isSet( jdksavdecc_eui48 const &v ) { return jdksavdecc_eui48_is_set( v ) != 0; }
@@ -311,7 +370,7 @@ inline bool operator<=( const jdksavdecc_eui48 &lhs, const jdksavdecc_eui48 &rhs
 
 inline bool operator==( const jdksavdecc_eui48 &lhs, const jdksavdecc_eui48 &rhs )
 {
-    return jdksavdecc_eui48_compare( &lhs, &rhs ) == 0;
+    return JDKSAvdeccMCU::euiEqual( lhs, rhs );
 }
 
 inline bool operator>=( const jdksavdecc_eui48 &lhs, const jdksavdecc_eui48 &rhs )
@@ -326,7 +385,7 @@ inline bool operator>( const jdksavdecc_eui48 &lhs, const jdksavdecc_eui48 &rhs
 
 inline bool operator!=( const jdksavdecc_eui48 &lhs, const jdksavdecc_eui48 &rhs )
 {
-    return jdksavdecc_eui48_compare( &lhs, &rhs ) != 0;
+    return !JDKSAvdeccMCU::euiEqual( lhs, rhs );
 }
 
 inline bool operator<( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs )
@@ -341,7 +400,7 @@ inline bool operator<=( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs
 
 inline bool operator==( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs )
 {
-    return jdksavdecc_eui64_compare( &lhs, &rhs ) == 0;
+    return JDKSAvdeccMCU::euiEqual( lhs, rhs );
 }
 
 inline bool operator>=( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs )
@@ -356,7 +415,7 @@ inline bool operator>( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs
 
 inline bool operator!=( const jdksavdecc_eui64 &lhs, const jdksavdecc_eui64 &rhs )
 {
-    return jdksavdecc_eui64_compare( &lhs, &rhs ) != 0;
+    return !JDKSAvdeccMCU::euiEqual( lhs, rhs );
 }
 
 #if JDKSAVDECCMCU_ENABLE_IOSTREAM
@@ -382,3 +441,25 @@ inline std::ostream &operator<<( std::ostream &o, jdksavdecc_eui64 const &v )
 }
 
 #endif
+
+#if JDKSAVDECCMCU_BARE_METAL == 0
+
+namespace std
+{
+
+/// Lets Eui48 be a key of the std unordered containers
+template <>
+struct hash<JDKSAvdeccMCU::Eui48>
+{
+    size_t operator()( JDKSAvdeccMCU::Eui48 const &v ) const { return static_cast<size_t>( v.hash() ); }
+};
+
+/// Lets Eui64 be a key of the std unordered containers
+template <>
+struct hash<JDKSAvdeccMCU::Eui64>
+{
+    size_t operator()( JDKSAvdeccMCU::Eui64 const &v ) const { return static_cast<size_t>( v.hash() ); }
+};
+}
+
+#endif
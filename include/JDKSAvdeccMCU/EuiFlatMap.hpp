@@ -0,0 +1,307 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief euiFlatMapIndexSize The size of the index of an EuiFlatMap, the
+/// smallest power of two that keeps the index at most half full
+///
+constexpr uint16_t euiFlatMapIndexSize( uint16_t max_items, uint16_t size = 2 )
+{
+    return size >= max_items * 2 ? size : euiFlatMapIndexSize( max_items, size * 2 );
+}
+
+///
+/// \brief The EuiFlatMapSlot struct
+///
+/// One slot of the index of an EuiFlatMap
+///
+struct EuiFlatMapSlot
+{
+    /// The key of the item as a uint64_t
+    uint64_t m_key;
+
+    /// The position of the item plus one, 0 if the slot is empty
+    uint16_t m_item;
+};
+
+///
+/// \brief The EuiFlatMapBase class
+///
+/// A fixed capacity map keyed on an Eui48 or Eui64, without any heap use.
+///
+/// The items are kept packed in arrays so that they can be iterated with
+/// getKey( i ) and getValue( i ). They are found through an open addressing
+/// index that is never more than half full. Each index slot holds the key
+/// as a uint64_t next to the position of its item, so a lookup usually
+/// compares one or two 64 bit words in one cache line and only touches the
+/// item that it finds.
+///
+/// Erasing an item moves the last item into its place, so positions and
+/// pointers to values are only valid until the next erase.
+/// It does not contain the storage of the index or the items
+///
+template <typename KeyT, typename ValueT>
+class EuiFlatMapBase
+{
+  public:
+    ///
+    /// \brief EuiFlatMapBase construct an EuiFlatMapBase object. The
+    /// owner of the storage calls clear() before it is used
+    /// \param index_storage pointer to array of index slots
+    /// \param index_size number of index slots, a power of two at least
+    /// twice max_items
+    /// \param key_storage pointer to array of max_items keys
+    /// \param value_storage pointer to array of max_items values
+    /// \param max_items maximum number of items
+    ///
+    EuiFlatMapBase( EuiFlatMapSlot *index_storage, uint16_t index_size, KeyT *key_storage, ValueT *value_storage, uint16_t max_items )
+        : m_num_items( 0 )
+        , m_max_items( max_items )
+        , m_index_mask( index_size - 1 )
+        , m_index( index_storage )
+        , m_key( key_storage )
+        , m_value( value_storage )
+    {
+    }
+
+    ///
+    /// \brief getCount Get the number of items
+    ///
+    uint16_t getCount() const { return m_num_items; }
+
+    ///
+    /// \brief getMaxCount Get the capacity of the map
+    ///
+    uint16_t getMaxCount() const { return m_max_items; }
+
+    ///
+    /// \brief isFull test if no more items can be added
+    ///
+    bool isFull() const { return m_num_items >= m_max_items; }
+
+    ///
+    /// \brief getKey Get the key of the item at position i
+    ///
+    KeyT const &getKey( uint16_t i ) const { return m_key[i]; }
+
+    ///
+    /// \brief getValue Get the value of the item at position i
+    ///
+    ValueT &getValue( uint16_t i ) { return m_value[i]; }
+    ValueT const &getValue( uint16_t i ) const { return m_value[i]; }
+
+    ///
+    /// \brief find Find the value for a key
+    /// \return pointer to the value or 0 if the key is not there
+    ///
+    ValueT *find( KeyT const &key )
+    {
+        uint16_t pos = lookup( key.convertToUint64() );
+        return pos != NOT_FOUND ? &m_value[m_index[pos].m_item - 1] : 0;
+    }
+
+    ValueT const *find( KeyT const &key ) const
+    {
+        uint16_t pos = lookup( key.convertToUint64() );
+        return pos != NOT_FOUND ? &m_value[m_index[pos].m_item - 1] : 0;
+    }
+
+    ///
+    /// \brief insert Find the value for a key, adding an item for it if it is
+    /// not there. The value of a new item is whatever was left in its place
+    /// \param key The key
+    /// \param inserted set to true if the item was added, may be 0
+    /// \return pointer to the value or 0 if the map is full
+    ///
+    ValueT *insert( KeyT const &key, bool *inserted = 0 )
+    {
+        ValueT *r = 0;
+        uint64_t packed = key.convertToUint64();
+        bool added = false;
+
+        // Find it, or the empty slot where it goes
+        uint16_t pos = getHome( packed );
+        while ( m_index[pos].m_item != 0 && m_index[pos].m_key != packed )
+        {
+            pos = ( pos + 1 ) & m_index_mask;
+        }
+
+        if ( m_index[pos].m_item != 0 )
+        {
+            r = &m_value[m_index[pos].m_item - 1];
+        }
+        else if ( m_num_items < m_max_items )
+        {
+            m_key[m_num_items] = key;
+            r = &m_value[m_num_items];
+            m_index[pos].m_key = packed;
+            m_index[pos].m_item = ++m_num_items;
+            added = true;
+        }
+
+        if ( inserted )
+        {
+            *inserted = added;
+        }
+        return r;
+    }
+
+    ///
+    /// \brief erase Remove the item for a key
+    /// \return false if the key was not there
+    ///
+    bool erase( KeyT const &key )
+    {
+        uint16_t pos = lookup( key.convertToUint64() );
+        if ( pos != NOT_FOUND )
+        {
+            removeAt( pos );
+        }
+        return pos != NOT_FOUND;
+    }
+
+    ///
+    /// \brief eraseAt Remove the item at position i. The last item moves to
+    /// position i, so iterate backwards when erasing while iterating
+    ///
+    void eraseAt( uint16_t i ) { removeAt( lookup( m_key[i].convertToUint64() ) ); }
+
+    ///
+    /// \brief clear Remove all items
+    ///
+    void clear()
+    {
+        m_num_items = 0;
+        for ( uint16_t i = 0; i <= m_index_mask; ++i )
+        {
+            m_index[i].m_item = 0;
+        }
+    }
+
+  private:
+    enum
+    {
+        NOT_FOUND = 0xffff
+    };
+
+    /// The slot where the search for a key starts
+    uint16_t getHome( uint64_t packed ) const { return static_cast<uint16_t>( euiHash( packed ) >> 48 ) & m_index_mask; }
+
+    /// Find the slot of a key, or NOT_FOUND if it is not there
+    uint16_t lookup( uint64_t packed ) const
+    {
+        uint16_t pos = getHome( packed );
+        while ( m_index[pos].m_item != 0 )
+        {
+            if ( m_index[pos].m_key == packed )
+            {
+                return pos;
+            }
+            pos = ( pos + 1 ) & m_index_mask;
+        }
+        return NOT_FOUND;
+    }
+
+    /// Remove the item of a slot
+    void removeAt( uint16_t pos )
+    {
+        uint16_t i = m_index[pos].m_item - 1;
+
+        // Close the gap by moving back the entries after it that would not be
+        // found past an empty slot
+        uint16_t hole = pos;
+        m_index[hole].m_item = 0;
+        for ( uint16_t k = ( pos + 1 ) & m_index_mask; m_index[k].m_item != 0; k = ( k + 1 ) & m_index_mask )
+        {
+            uint16_t home = getHome( m_index[k].m_key );
+            if ( ( ( k - home ) & m_index_mask ) >= ( ( k - hole ) & m_index_mask ) )
+            {
+                m_index[hole] = m_index[k];
+                m_index[k].m_item = 0;
+                hole = k;
+            }
+        }
+
+        // Keep the items packed by moving the last one into its place
+        --m_num_items;
+        if ( i != m_num_items )
+        {
+            m_key[i] = m_key[m_num_items];
+            m_value[i] = m_value[m_num_items];
+            m_index[lookup( m_key[i].convertToUint64() )].m_item = i + 1;
+        }
+    }
+
+    uint16_t m_num_items;
+    uint16_t m_max_items;
+    uint16_t m_index_mask;
+    EuiFlatMapSlot *m_index;
+    KeyT *m_key;
+    ValueT *m_value;
+
+    // Not copyable, it points into its owner's storage
+    EuiFlatMapBase( EuiFlatMapBase const & );
+    EuiFlatMapBase const &operator=( EuiFlatMapBase const & );
+};
+
+///
+/// \brief The EuiFlatMap class
+///
+/// EuiFlatMapBase that contains the storage for MaxItems items
+///
+template <typename KeyT, typename ValueT, uint16_t MaxItems>
+class EuiFlatMap : public EuiFlatMapBase<KeyT, ValueT>
+{
+  public:
+    static_assert( MaxItems > 0 && MaxItems <= 16384, "EuiFlatMap holds 1 to 16384 items" );
+
+    enum
+    {
+        IndexSize = euiFlatMapIndexSize( MaxItems )
+    };
+
+    EuiFlatMap() : EuiFlatMapBase<KeyT, ValueT>( m_index_storage, IndexSize, m_key_storage, m_value_storage, MaxItems )
+    {
+        this->clear();
+    }
+
+  private:
+    EuiFlatMapSlot m_index_storage[IndexSize];
+    KeyT m_key_storage[MaxItems];
+    ValueT m_value_storage[MaxItems];
+};
+}
@@ -34,6 +34,14 @@
 #include "JDKSAvdeccMCU/FixedBuffer.hpp"
 #include "JDKSAvdeccMCU/Frame.hpp"
 
+/// The port number of a frame that is not tied to one network port
+#define JDKSAVDECCMCU_FRAME_ANY_PORT ( 0xffff )
+
+/// The alignment that keeps data written by different threads apart
+#ifndef JDKSAVDECCMCU_CACHE_LINE_SIZE
+#define JDKSAVDECCMCU_CACHE_LINE_SIZE ( 64 )
+#endif
+
 namespace JDKSAvdeccMCU
 {
 
@@ -51,6 +59,12 @@ class Frame : public FixedBuffer
     ///
     jdksavdecc_timestamp_in_milliseconds m_time_in_ms;
 
+    ///
+    /// \brief m_port The network port that the frame arrived on or is to
+    /// be sent from, or JDKSAVDECCMCU_FRAME_ANY_PORT
+    ///
+    uint16_t m_port;
+
   public:
     ///
     /// \brief Frame Constructor of a Frame
@@ -67,7 +81,7 @@ class Frame : public FixedBuffer
            Eui48 const &dest_mac,
            Eui48 const &src_mac,
            uint16_t ethertype )
-        : FixedBuffer( buf, len ), m_time_in_ms( time_in_ms )
+        : FixedBuffer( buf, len ), m_time_in_ms( time_in_ms ), m_port( JDKSAVDECCMCU_FRAME_ANY_PORT )
     {
         putEUI48( dest_mac );
         putEUI48( src_mac );
@@ -81,8 +95,24 @@ class Frame : public FixedBuffer
     /// \param len The buffer storage area length
     ///
     Frame( jdksavdecc_timestamp_in_milliseconds time_in_ms, uint8_t *buf, uint16_t len )
-        : FixedBuffer( buf, len ), m_time_in_ms( time_in_ms )
+        : FixedBuffer( buf, len ), m_time_in_ms( time_in_ms ), m_port( JDKSAVDECCMCU_FRAME_ANY_PORT )
+    {
+    }
+
+    ///
+    /// \brief wrap Point the Frame at a received frame that is held in
+    /// storage owned by someone else, without copying it
+    /// \param time_in_ms The time in milliseconds
+    /// \param buf The received frame
+    /// \param len The length of the received frame
+    ///
+    void wrap( jdksavdecc_timestamp_in_milliseconds time_in_ms, uint8_t *buf, uint16_t len )
     {
+        m_buf = buf;
+        m_length = len;
+        m_max_length = len;
+        m_time_in_ms = time_in_ms;
+        m_port = JDKSAVDECCMCU_FRAME_ANY_PORT;
     }
 
     ///
@@ -165,6 +195,34 @@ class Frame : public FixedBuffer
     /// \param v The timestamp
     ///
     void setTimeInMilliseconds( jdksavdecc_timestamp_in_milliseconds v ) { m_time_in_ms = v; }
+
+    ///
+    /// \brief getPort Get the network port that the frame arrived on
+    /// \return The port number or JDKSAVDECCMCU_FRAME_ANY_PORT
+    ///
+    uint16_t getPort() const { return m_port; }
+
+    ///
+    /// \brief setPort Set the network port that the frame arrived on or
+    /// is to be sent from
+    /// \param port The port number or JDKSAVDECCMCU_FRAME_ANY_PORT
+    ///
+    void setPort( uint16_t port ) { m_port = port; }
+};
+
+///
+/// \brief The FrameFragment struct
+///
+/// Points at a piece of payload that follows a Frame's contents on the
+/// wire, so that it can be sent from where it is without first being
+/// copied into the Frame
+///
+struct FrameFragment
+{
+    FrameFragment( uint8_t const *data = 0, uint16_t length = 0 ) : m_data( data ), m_length( length ) {}
+
+    uint8_t const *m_data;
+    uint16_t m_length;
 };
 
 ///
@@ -0,0 +1,279 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Frame.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+class FramePool;
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+typedef std::atomic<uint32_t> FramePoolCounter;
+#else
+typedef uint32_t FramePoolCounter;
+#endif
+
+///
+/// \brief The FramePoolSlot struct
+///
+/// One frame of a FramePool with its reference count. Each slot starts on
+/// its own cache line so that threads using neighbouring frames do not
+/// slow each other down.
+///
+struct alignas( JDKSAVDECCMCU_CACHE_LINE_SIZE ) FramePoolSlot
+{
+    FramePoolSlot() : m_use_count( 0 ), m_next_free( 0 ) {}
+
+    FrameWithMTU m_frame;
+    FramePoolCounter m_use_count;
+
+    /// The index + 1 of the next free slot, or 0 at the end of the list.
+    /// Another thread may read it while a stale pop() loses its swap
+    FramePoolCounter m_next_free;
+};
+
+///
+/// \brief The FrameRef class
+///
+/// A reference counted handle to a Frame from a FramePool. Copies of the
+/// handle share the frame, so one frame can sit in a send queue, wait to be
+/// retransmitted and be handed to another thread at the same time without
+/// being copied. The frame goes back to the pool when the last handle
+/// lets go of it.
+///
+class FrameRef
+{
+  public:
+    FrameRef() : m_pool( 0 ), m_slot( 0 ) {}
+
+    FrameRef( FrameRef const &other );
+
+    FrameRef( FrameRef &&other ) : m_pool( other.m_pool ), m_slot( other.m_slot )
+    {
+        other.m_pool = 0;
+        other.m_slot = 0;
+    }
+
+    ~FrameRef() { reset(); }
+
+    FrameRef &operator=( FrameRef const &other );
+
+    FrameRef &operator=( FrameRef &&other );
+
+    /// Let go of the frame
+    void reset();
+
+    /// Does the handle refer to a frame
+    bool isValid() const { return m_slot != 0; }
+
+    Frame *get() const { return m_slot ? &m_slot->m_frame : 0; }
+
+    Frame &operator*() const { return m_slot->m_frame; }
+
+    Frame *operator->() const { return &m_slot->m_frame; }
+
+    /// The number of handles that refer to the frame
+    uint32_t getUseCount() const { return m_slot ? static_cast<uint32_t>( m_slot->m_use_count ) : 0; }
+
+    /// Is this the only handle to the frame, so that it can be changed
+    bool isUnique() const { return getUseCount() == 1; }
+
+    FramePool *getPool() const { return m_pool; }
+
+  private:
+    friend class FramePool;
+    friend class FramePoolCache;
+
+    /// Adopt a slot that was just taken from the pool
+    FrameRef( FramePool *pool, FramePoolSlot *slot ) : m_pool( pool ), m_slot( slot ) {}
+
+    FramePool *m_pool;
+    FramePoolSlot *m_slot;
+};
+
+///
+/// \brief The FramePool class
+///
+/// A fixed number of frames that are handed out as FrameRef handles, so
+/// that frames can be kept and passed around without heap allocation or
+/// MTU sized frames on the stack.
+///
+/// With JDKSAVDECCMCU_ENABLE_THREADS the free list and the reference counts
+/// are lock-free and frames may be allocated and released on any thread.
+/// Without it the pool is for one thread only and needs nothing but the
+/// static storage of a FramePoolWithSize.
+///
+class FramePool
+{
+  public:
+    ///
+    /// \brief FramePool constructor
+    /// \param slots The frame storage
+    /// \param num_slots The number of frames
+    ///
+    /// The pool is empty until initialize() chains the constructed slots
+    ///
+    FramePool( FramePoolSlot *slots, uint32_t num_slots );
+
+    ///
+    /// \brief allocate Take an empty frame from the pool
+    /// \param time_in_ms The timestamp to give the frame
+    /// \return the frame, or an invalid FrameRef if the pool is empty
+    ///
+    FrameRef allocate( jdksavdecc_timestamp_in_milliseconds time_in_ms = 0 );
+
+    /// The number of frames in the pool
+    uint32_t getCapacity() const { return m_num_slots; }
+
+    /// The number of frames that are not in use
+    uint32_t getAvailableCount() const { return m_available; }
+
+    /// The fewest frames that were ever available
+    uint32_t getLowWaterMark() const { return m_low_water; }
+
+    /// The number of times allocate() found the pool empty
+    uint32_t getFailureCount() const { return m_failure_count; }
+
+  protected:
+    /// Put every slot on the free list. Only while no frame is in use
+    void initialize();
+
+  private:
+    FramePool( FramePool const & );
+    FramePool const &operator=( FramePool const & );
+
+    friend class FrameRef;
+    friend class FramePoolCache;
+
+    /// Take a slot off the free list, or 0 if there are none
+    FramePoolSlot *pop();
+
+    /// Put a slot back on the free list
+    void push( FramePoolSlot *slot );
+
+    /// Make a handle for a slot that was taken from the free list
+    FrameRef adopt( FramePoolSlot *slot, jdksavdecc_timestamp_in_milliseconds time_in_ms );
+
+    /// Drop a reference to a slot, freeing it with the last one
+    void release( FramePoolSlot *slot );
+
+    FramePoolSlot *m_slots;
+    uint32_t m_num_slots;
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    /// The index + 1 of the first free slot in the low half and a count of
+    /// changes in the high half, so that a slot that is freed and taken
+    /// again between the read and the swap is noticed
+    std::atomic<uint64_t> m_free_head;
+#else
+    uint32_t m_free_head;
+#endif
+    FramePoolCounter m_available;
+    FramePoolCounter m_low_water;
+    FramePoolCounter m_failure_count;
+};
+
+///
+/// \brief The FramePoolWithSize class
+///
+/// A FramePool that owns storage for NumSlots frames. Give it static
+/// storage duration to keep it aligned.
+///
+template <uint32_t NumSlots>
+class FramePoolWithSize : public FramePool
+{
+  public:
+    FramePoolWithSize() : FramePool( m_slot_storage, NumSlots )
+    {
+        // The slots are only constructed after the base class
+        initialize();
+    }
+
+  private:
+    FramePoolSlot m_slot_storage[NumSlots];
+};
+
+///
+/// \brief The FramePoolCache class
+///
+/// A small stack of free frames that one thread keeps for itself. Frames
+/// that the thread gives back with recycle() are allocated again from the
+/// cache without touching the shared free list.
+///
+class FramePoolCache
+{
+  public:
+    FramePoolCache( FramePool *pool, FramePoolSlot **storage, uint16_t max_slots );
+
+    /// Gives the cached frames back to the pool
+    ~FramePoolCache();
+
+    /// Take an empty frame, from the cache if it has one
+    FrameRef allocate( jdksavdecc_timestamp_in_milliseconds time_in_ms = 0 );
+
+    /// Let go of a frame. If it was the last handle, the frame is kept in
+    /// the cache when there is room
+    void recycle( FrameRef &ref );
+
+    /// Give all of the cached frames back to the pool
+    void flush();
+
+    /// The number of frames in the cache
+    uint16_t getCount() const { return m_count; }
+
+  private:
+    FramePoolCache( FramePoolCache const & );
+    FramePoolCache const &operator=( FramePoolCache const & );
+
+    FramePool *m_pool;
+    FramePoolSlot **m_slot;
+    uint16_t m_max_slots;
+    uint16_t m_count;
+};
+
+///
+/// \brief The FramePoolCacheWithSize class
+///
+/// A FramePoolCache that owns room for MaxSlots frames
+///
+template <uint16_t MaxSlots>
+class FramePoolCacheWithSize : public FramePoolCache
+{
+  public:
+    FramePoolCacheWithSize( FramePool *pool ) : FramePoolCache( pool, m_slot_storage, MaxSlots ) {}
+
+  private:
+    FramePoolSlot *m_slot_storage[MaxSlots];
+};
+}
@@ -0,0 +1,147 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Frame.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The FrameRing class
+///
+/// A lock-free ring of pre-allocated frames that hands frames from exactly
+/// one producer thread to exactly one consumer thread.
+///
+/// The producer fills the slot from getWriteSlot() in place and publishes
+/// it with commitWrite(); the consumer uses the slot from getReadSlot() in
+/// place and gives it back with commitRead(). No frame is copied by the
+/// ring itself.
+///
+class FrameRing
+{
+  public:
+    ///
+    /// \brief FrameRing constructor
+    /// \param slots The frame storage, a power of two number of frames
+    /// \param num_slots The number of frames
+    ///
+    FrameRing( FrameWithMTU *slots, uint32_t num_slots )
+        : m_slots( slots ), m_mask( num_slots - 1 ), m_high_water( 0 ), m_read_pos( 0 ), m_write_pos( 0 )
+    {
+    }
+
+    /// Producer: the next free slot, or 0 if the ring is full
+    Frame *getWriteSlot()
+    {
+        uint32_t write_pos = m_write_pos.load( std::memory_order_relaxed );
+        if ( write_pos - m_read_pos.load( std::memory_order_acquire ) > m_mask )
+        {
+            return 0;
+        }
+        return &m_slots[write_pos & m_mask];
+    }
+
+    /// Producer: publish the slot from getWriteSlot() to the consumer
+    void commitWrite()
+    {
+        uint32_t write_pos = m_write_pos.load( std::memory_order_relaxed ) + 1;
+        m_write_pos.store( write_pos, std::memory_order_release );
+
+        uint32_t count = write_pos - m_read_pos.load( std::memory_order_relaxed );
+        if ( count > m_high_water.load( std::memory_order_relaxed ) )
+        {
+            m_high_water.store( count, std::memory_order_relaxed );
+        }
+    }
+
+    /// Consumer: the oldest published slot, or 0 if the ring is empty
+    Frame *getReadSlot()
+    {
+        uint32_t read_pos = m_read_pos.load( std::memory_order_relaxed );
+        if ( read_pos == m_write_pos.load( std::memory_order_acquire ) )
+        {
+            return 0;
+        }
+        return &m_slots[read_pos & m_mask];
+    }
+
+    /// Consumer: give the slot from getReadSlot() back to the producer
+    void commitRead() { m_read_pos.store( m_read_pos.load( std::memory_order_relaxed ) + 1, std::memory_order_release ); }
+
+    /// The number of frames waiting for the consumer
+    uint32_t getCount() const
+    {
+        return m_write_pos.load( std::memory_order_acquire ) - m_read_pos.load( std::memory_order_acquire );
+    }
+
+    /// The number of frames that the ring can hold
+    uint32_t getCapacity() const { return m_mask + 1; }
+
+    /// The largest number of frames that were ever waiting at once
+    uint32_t getHighWaterMark() const { return m_high_water.load( std::memory_order_relaxed ); }
+
+  private:
+    FrameRing( FrameRing const & );
+    FrameRing const &operator=( FrameRing const & );
+
+    FrameWithMTU *m_slots;
+    uint32_t m_mask;
+    std::atomic<uint32_t> m_high_water;
+
+    /// Written by the consumer only, kept apart from the producer's index
+    alignas( JDKSAVDECCMCU_CACHE_LINE_SIZE ) std::atomic<uint32_t> m_read_pos;
+
+    /// Written by the producer only
+    alignas( JDKSAVDECCMCU_CACHE_LINE_SIZE ) std::atomic<uint32_t> m_write_pos;
+};
+
+///
+/// \brief The FrameRingWithSize class
+///
+/// A FrameRing that owns storage for NumSlots frames
+///
+template <uint32_t NumSlots>
+class FrameRingWithSize : public FrameRing
+{
+    static_assert( NumSlots > 0 && ( NumSlots & ( NumSlots - 1 ) ) == 0, "NumSlots must be a power of two" );
+
+  public:
+    FrameRingWithSize() : FrameRing( m_slot_storage, NumSlots ) {}
+
+  private:
+    FrameWithMTU m_slot_storage[NumSlots];
+};
+}
+#endif
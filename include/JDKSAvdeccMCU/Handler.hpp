@@ -37,6 +37,87 @@ namespace JDKSAvdeccMCU
 {
 
 class HandlerGroup;
+class Timer;
+
+///
+/// \brief The HandlerDispatchKey struct
+///
+/// Describes a class of received frames that a Handler wants to be offered.
+/// Only the fields up to and including m_level are significant, the rest
+/// are zero.
+///
+struct HandlerDispatchKey
+{
+    enum Level
+    {
+        /// The handler receives no frames at all
+        NONE = 0,
+        /// Match on ethertype
+        ETHERTYPE = 1,
+        /// Match on ethertype and AVTP subtype
+        SUBTYPE = 2,
+        /// Match on ethertype, AVTP subtype and message_type
+        MESSAGE_TYPE = 3,
+        /// Also match on the AEM command_type, without the unsolicited bit
+        COMMAND_TYPE = 4,
+        /// Also match on the descriptor_type and descriptor_index that the
+        /// AEM command addresses
+        DESCRIPTOR = 5
+    };
+
+    uint8_t m_level;
+    uint8_t m_subtype;
+    uint8_t m_message_type;
+    uint16_t m_ethertype;
+    uint16_t m_command_type;
+    uint16_t m_descriptor_type;
+    uint16_t m_descriptor_index;
+
+    HandlerDispatchKey( uint8_t level = NONE,
+                        uint16_t ethertype = 0,
+                        uint8_t subtype = 0,
+                        uint8_t message_type = 0,
+                        uint16_t command_type = 0,
+                        uint16_t descriptor_type = 0,
+                        uint16_t descriptor_index = 0 )
+        : m_level( level )
+        , m_subtype( level >= SUBTYPE ? subtype : 0 )
+        , m_message_type( level >= MESSAGE_TYPE ? message_type : 0 )
+        , m_ethertype( level >= ETHERTYPE ? ethertype : 0 )
+        , m_command_type( level >= COMMAND_TYPE ? command_type : 0 )
+        , m_descriptor_type( level >= DESCRIPTOR ? descriptor_type : 0 )
+        , m_descriptor_index( level >= DESCRIPTOR ? descriptor_index : 0 )
+    {
+    }
+
+    ///
+    /// \brief fromFrame Make the most specific key that describes a frame
+    ///
+    static HandlerDispatchKey fromFrame( Frame const &frame );
+
+    ///
+    /// \brief truncate Make a less specific version of this key
+    ///
+    HandlerDispatchKey truncate( uint8_t level ) const
+    {
+        return HandlerDispatchKey(
+            level, m_ethertype, m_subtype, m_message_type, m_command_type, m_descriptor_type, m_descriptor_index );
+    }
+
+    ///
+    /// \brief hash Get a hash of the significant fields
+    ///
+    uint32_t hash() const;
+
+    bool operator==( HandlerDispatchKey const &other ) const
+    {
+        return m_level == other.m_level && m_ethertype == other.m_ethertype && m_subtype == other.m_subtype
+               && m_message_type == other.m_message_type && m_command_type == other.m_command_type
+               && m_descriptor_type == other.m_descriptor_type && m_descriptor_index == other.m_descriptor_index;
+    }
+
+    bool operator!=( HandlerDispatchKey const &other ) const { return !( *this == other ); }
+};
 
 ///
 /// \brief The Handler class
@@ -66,6 +147,25 @@ class Handler
     ///
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame );
 
+    ///
+    /// \brief getDispatchKeys Describe the frames that this handler wants
+    /// to be offered by a HandlerGroup, so that the group does not have to
+    /// offer it every frame
+    /// \param keys array to fill in
+    /// \param max_keys the size of the array
+    /// \return the number of keys filled in. 0 means that the handler is
+    /// offered every frame, a single key at level NONE means that it is
+    /// offered none
+    ///
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const;
+
+    ///
+    /// \brief getTimer Get the Timer that decides when this handler is
+    /// ticked by a HandlerGroup that has a TimerWheel
+    /// \return the Timer, or 0 to be ticked on every loop
+    ///
+    virtual Timer *getTimer();
+
     ///
     /// \brief addToHandlerGroup Register with HandlerGroup
     /// \param group HandlerGroup to add to
@@ -33,10 +33,35 @@
 #include "JDKSAvdeccMCU/World.hpp"
 #include "JDKSAvdeccMCU/RawSocket.hpp"
 #include "JDKSAvdeccMCU/Handler.hpp"
+#include "JDKSAvdeccMCU/TimerWheel.hpp"
+
+#ifndef JDKSAVDECCMCU_HANDLER_MAX_DISPATCH_KEYS
+#define JDKSAVDECCMCU_HANDLER_MAX_DISPATCH_KEYS ( 8 )
+#endif
+
+#ifndef JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH
+#define JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH ( 32 )
+#endif
 
 namespace JDKSAvdeccMCU
 {
 
+///
+/// \brief The HandlerDispatchEntry struct
+///
+/// One slot of the HandlerGroup dispatch index. A slot with an m_item_pos
+/// of 0xffff is empty.
+///
+struct HandlerDispatchEntry
+{
+    HandlerDispatchKey m_key;
+    uint16_t m_item_pos;
+
+    HandlerDispatchEntry() : m_key(), m_item_pos( 0xffff ) {}
+
+    bool isEmpty() const { return m_item_pos == 0xffff; }
+};
+
 ///
 /// \brief The HandlerGroup class
 ///
@@ -45,6 +70,11 @@ namespace JDKSAvdeccMCU
 /// It does not contain the storage of the handlers
 /// No bounds checking is done
 ///
+/// When given storage for a dispatch index, received PDU's are only offered
+/// to the handlers whose dispatch keys match the frame, most specific keys
+/// first, followed by the handlers that did not supply any dispatch keys in
+/// the order that they were added.
+///
 class HandlerGroup : public Handler
 {
   protected:
@@ -55,21 +85,114 @@ class HandlerGroup : public Handler
     uint32_t m_handled_count;
     Frame *m_frame;
 
+    /// Points at frames that a RawSocket lends out with acquireFrame()
+    Frame m_ring_frame;
+
+    uint16_t m_num_wildcards;
+    uint16_t *m_wildcard;
+    uint16_t m_num_dispatch_entries;
+    uint16_t m_max_dispatch_entries;
+    HandlerDispatchEntry *m_dispatch;
+    uint8_t m_dispatch_levels;
+    uint32_t m_invocation_count;
+    uint32_t m_linear_invocation_count;
+
+    uint16_t m_num_rawsockets;
+    RawSocket *m_rawsocket[JDKSAVDECCMCU_MAX_RAWSOCKETS];
+    bool m_rawsocket_ready[JDKSAVDECCMCU_MAX_RAWSOCKETS];
+    uint16_t m_num_unwaitable_rawsockets;
+    bool m_waited;
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    int m_epoll_fd;
+#endif
+    bool m_frames_pending;
+    uint16_t m_last_batch;
+    uint16_t m_largest_batch;
+    uint32_t m_loop_count;
+    uint32_t m_idle_time_in_ms;
+    uint32_t m_busy_time_in_ms;
+    uint32_t m_last_loop_latency_in_ms;
+    uint32_t m_max_loop_latency_in_ms;
+
+    TimerWheel *m_timer_wheel;
+    uint32_t m_handler_tick_count;
+
   public:
     ///
-    /// \brief HandlerGroup construct a HandlerGroup object
+    /// \brief HandlerGroup construct a HandlerGroup object without a
+    /// dispatch index. Every received PDU is offered to each handler in turn.
     /// \param item_storage pointer to array of pointers to Handler objects
     /// \param max_items maximum number of pointers that the array can hold
     ///
     HandlerGroup( Frame *frame, Handler **item_storage, uint16_t max_items );
 
+    ///
+    /// \brief HandlerGroup construct a HandlerGroup object with a dispatch
+    /// index
+    /// \param item_storage pointer to array of pointers to Handler objects
+    /// \param max_items maximum number of pointers that the array can hold
+    /// \param wildcard_storage pointer to array of max_items positions
+    /// \param dispatch_storage pointer to array of dispatch index slots
+    /// \param max_dispatch_entries the number of dispatch index slots
+    ///
+    HandlerGroup( Frame *frame,
+                  Handler **item_storage,
+                  uint16_t max_items,
+                  uint16_t *wildcard_storage,
+                  HandlerDispatchEntry *dispatch_storage,
+                  uint16_t max_dispatch_entries );
+
+    virtual ~HandlerGroup();
+
     ///
     /// \brief add Add a handler to the list
+    ///
+    /// The handler's dispatch keys are entered into the dispatch index.
+    /// If the index does not have room for them the handler is offered
+    /// every frame instead.
+    ///
     /// \param v pointer to a Handler object
     /// \return true on success, false if there is no room
     ///
     bool add( Handler *v );
 
+    ///
+    /// \brief addRawSocket Add a network port for tick() to poll
+    /// \param s pointer to the RawSocket
+    /// \return true on success, false if there is no room
+    ///
+    bool addRawSocket( RawSocket *s );
+
+    ///
+    /// \brief getRawSocketCount get the number of network ports polled
+    ///
+    uint16_t getRawSocketCount() const { return m_num_rawsockets; }
+
+    ///
+    /// \brief getRawSocket get a network port that is polled
+    ///
+    RawSocket *getRawSocket( uint16_t n ) const { return m_rawsocket[n]; }
+
+    ///
+    /// \brief setTimerWheel Use a TimerWheel to decide when to tick the
+    /// handlers that have a Timer. Handlers without one are still ticked on
+    /// every loop.
+    /// \param wheel pointer to the TimerWheel, or 0 to tick every handler on
+    /// every loop
+    ///
+    void setTimerWheel( TimerWheel *wheel );
+
+    ///
+    /// \brief getTimerWheel get the TimerWheel in use
+    ///
+    TimerWheel *getTimerWheel() const { return m_timer_wheel; }
+
+    ///
+    /// \brief getHandlerTickCount get the count of calls made to the
+    /// tick() methods of the handlers
+    ///
+    uint32_t getHandlerTickCount() const { return m_handler_tick_count; }
+
     ///
     /// \brief isFull test if the handler list is full or would be given
     /// additional items
@@ -97,10 +220,111 @@ class HandlerGroup : public Handler
     ///
     uint32_t getHandledCount() const { return m_handled_count; }
 
+    ///
+    /// \brief getInvocationCount get the count of calls made to the
+    /// receivedPDU() methods of the handlers
+    /// \return count
+    ///
+    uint32_t getInvocationCount() const { return m_invocation_count; }
+
+    ///
+    /// \brief getLinearInvocationCount get the count of calls that a linear
+    /// scan of the handlers in order would have made for the same PDU's
+    /// \return count
+    ///
+    uint32_t getLinearInvocationCount() const { return m_linear_invocation_count; }
+
+    ///
+    /// \brief getSavedInvocationCount get the count of handler calls that
+    /// the dispatch index avoided
+    /// \return count
+    ///
+    uint32_t getSavedInvocationCount() const
+    {
+        return m_linear_invocation_count > m_invocation_count ? m_linear_invocation_count - m_invocation_count : 0;
+    }
+
+    ///
+    /// \brief getWildcardCount get the number of handlers that are offered
+    /// every PDU
+    /// \return count
+    ///
+    uint16_t getWildcardCount() const { return m_wildcard ? m_num_wildcards : m_num_items; }
+
+    ///
+    /// \brief getLoopCount get the number of iterations of run()
+    ///
+    uint32_t getLoopCount() const { return m_loop_count; }
+
+    ///
+    /// \brief getIdleTimeInMilliseconds get the total time that run() spent
+    /// waiting for frames
+    ///
+    uint32_t getIdleTimeInMilliseconds() const { return m_idle_time_in_ms; }
+
+    ///
+    /// \brief getBusyTimeInMilliseconds get the total time that run() spent
+    /// dispatching frames and running the handlers' tick()
+    ///
+    uint32_t getBusyTimeInMilliseconds() const { return m_busy_time_in_ms; }
+
+    ///
+    /// \brief getLastLoopLatencyInMilliseconds get the time between run()
+    /// waking up and finishing its work, for the last iteration
+    ///
+    uint32_t getLastLoopLatencyInMilliseconds() const { return m_last_loop_latency_in_ms; }
+
+    ///
+    /// \brief getMaxLoopLatencyInMilliseconds get the largest loop latency
+    /// seen by run()
+    ///
+    uint32_t getMaxLoopLatencyInMilliseconds() const { return m_max_loop_latency_in_ms; }
+
+    ///
+    /// \brief getLastBatchSize get the number of frames dispatched by the
+    /// last tick()
+    ///
+    uint16_t getLastBatchSize() const { return m_last_batch; }
+
+    ///
+    /// \brief getLargestBatchSize get the largest number of frames
+    /// dispatched by one tick()
+    ///
+    uint16_t getLargestBatchSize() const { return m_largest_batch; }
+
+    ///
+    /// \brief clearLoopStatistics reset the run() timing statistics
+    ///
+    void clearLoopStatistics();
+
+    ///
+    /// \brief pollRawSockets Receive all frames that are waiting on the
+    /// network ports into the group's Frame and dispatch each of them.
+    /// When called from run() only the ports that were reported readable
+    /// are read.
+    /// \param max_frames_per_socket the largest batch to take from one port
+    /// \return the number of frames dispatched
+    ///
+    uint16_t pollRawSockets( uint16_t max_frames_per_socket = JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH );
+
+    ///
+    /// \brief run Wait for frames on the network ports for up to
+    /// timeout_ms, then tick() with the time from the first port.
+    /// With a TimerWheel the wait also ends at the next deadline.
+    ///
+    /// Calling run() in a loop is all an application needs to do. The
+    /// timeout bounds how late a handler's tick() can be, since it is also
+    /// called when no frames arrive.
+    ///
+    /// \param timeout_ms the longest time to wait for frames
+    /// \return false if there are no network ports to run
+    ///
+    bool run( int32_t timeout_ms );
+
     ///
     /// \brief tick
-    /// Send Tick() messages to all encapsulated Handlers
-    /// and poll incoming network for PDU's and dispatch them
+    /// Poll incoming network for PDU's and dispatch them,
+    /// then send Tick() messages to all encapsulated Handlers
     /// \param timestamp
     ///
     virtual void tick( jdksavdecc_timestamp_in_milliseconds timestamp ) override;
@@ -113,6 +337,24 @@ class HandlerGroup : public Handler
     /// \return true if the message was handled
     ///
     virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override;
+
+  protected:
+    ///
+    /// \brief waitForFrames Wait for any network port to become readable
+    ///
+    void waitForFrames( int32_t timeout_ms );
+
+    ///
+    /// \brief insertDispatchKey Put a key into the dispatch index
+    ///
+    void insertDispatchKey( HandlerDispatchKey const &key, uint16_t item_pos );
+
+    ///
+    /// \brief dispatchToKey Offer the frame to each handler registered with
+    /// the key until one accepts it
+    /// \return the position of the handler that accepted it, or 0xffff
+    ///
+    uint16_t dispatchToKey( HandlerDispatchKey const &key, RawSocket *incoming_socket, Frame &frame );
 };
 
 ///
@@ -120,15 +362,21 @@ class HandlerGroup : public Handler
 ///
 /// HandlerGroup is a HandlerGroupBase and contains
 /// the storage of the contained Handler pointers.
-/// The HandlerGroup is templatelized by the MaxItem count.
+/// The HandlerGroup is templatelized by the MaxItem count and the
+/// number of slots in the dispatch index.
 ///
-template <uint16_t MaxItems>
+template <uint16_t MaxItems, uint16_t MaxDispatchEntries = MaxItems * 4>
 class HandlerGroupWithSize : public HandlerGroup
 {
   private:
     Handler *m_item_storage[MaxItems];
+    uint16_t m_wildcard_storage[MaxItems];
+    HandlerDispatchEntry m_dispatch_storage[MaxDispatchEntries];
 
   public:
-    HandlerGroupWithSize( Frame *frame ) : HandlerGroup( frame, m_item_storage, MaxItems ) {}
+    HandlerGroupWithSize( Frame *frame )
+        : HandlerGroup( frame, m_item_storage, MaxItems, m_wildcard_storage, m_dispatch_storage, MaxDispatchEntries )
+    {
+    }
 };
 }
@@ -0,0 +1,258 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Helpers.hpp"
+#include "JDKSAvdeccMCU/Frame.hpp"
+
+/// The largest outgoing command PDU (including ethernet header) that is
+/// kept in an inflight slot so that it can be retransmitted on time out.
+/// Commands larger than this are still tracked but are not retried.
+#ifndef JDKSAVDECCMCU_INFLIGHT_COMMAND_MAX_PDU_LENGTH
+#define JDKSAVDECCMCU_INFLIGHT_COMMAND_MAX_PDU_LENGTH ( 128 )
+#endif
+
+/// The default number of retransmissions of a timed out command
+#ifndef JDKSAVDECCMCU_INFLIGHT_COMMAND_DEFAULT_RETRIES
+#define JDKSAVDECCMCU_INFLIGHT_COMMAND_DEFAULT_RETRIES ( 1 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+struct InflightCommand;
+
+///
+/// \brief The InflightCommandNotification class
+///
+/// Receives the outcome of a command that was tracked in an
+/// InflightCommands table
+///
+class InflightCommandNotification
+{
+  public:
+    virtual ~InflightCommandNotification() {}
+
+    ///
+    /// \brief inflightCommandCompleted A response matching the command was
+    /// received
+    /// \param cmd The inflight command, which is removed after this returns
+    /// \param aem The parsed response
+    /// \param pdu The response frame
+    ///
+    virtual void inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu ) = 0;
+
+    ///
+    /// \brief inflightCommandTimedOut The command was not answered after all
+    /// retries were used
+    /// \param cmd The inflight command, which is removed after this returns
+    ///
+    virtual void inflightCommandTimedOut( InflightCommand const &cmd ) = 0;
+};
+
+///
+/// \brief The InflightCommand struct
+///
+/// One outstanding AECP AEM command, keyed by target entity id and
+/// sequence id
+///
+struct InflightCommand
+{
+    /// The entity id of the target of the command
+    Eui64 m_target_entity_id;
+
+    /// The MAC address of the target of the command
+    Eui48 m_target_mac_address;
+
+    /// The sequence id that was used for the command
+    uint16_t m_sequence_id;
+
+    /// The AEM command_type that was sent
+    uint16_t m_command_type;
+
+    /// The timestamp of the last transmission of the command
+    jdksavdecc_timestamp_in_milliseconds m_sent_time;
+
+    /// The time out for each transmission of the command
+    jdksavdecc_timestamp_in_milliseconds m_timeout_in_ms;
+
+    /// The number of retransmissions remaining
+    uint8_t m_retries_left;
+
+    /// The object to notify on completion or time out, may be 0
+    InflightCommandNotification *m_notification;
+
+    /// The length of the stored pdu, or 0 if it was too large to be kept
+    uint16_t m_pdu_length;
+
+    /// A copy of the command pdu used for retransmission
+    uint8_t m_pdu[JDKSAVDECCMCU_INFLIGHT_COMMAND_MAX_PDU_LENGTH];
+};
+
+///
+/// \brief The InflightCommands class
+///
+/// Maintains a fixed capacity table of outstanding AECP AEM commands so that
+/// an entity can have commands in flight to many targets at once.
+/// It does not contain the storage of the table entries
+///
+class InflightCommands
+{
+  public:
+    ///
+    /// \brief InflightCommands construct an InflightCommands object
+    /// \param item_storage pointer to array of InflightCommand objects
+    /// \param max_items maximum number of items that the array can hold
+    /// \param timeout_in_ms time out for each transmission of a command
+    /// \param retries number of retransmissions before giving up
+    ///
+    InflightCommands( InflightCommand *item_storage,
+                      uint16_t max_items,
+                      jdksavdecc_timestamp_in_milliseconds timeout_in_ms = JDKSAVDECC_AEM_TIMEOUT_IN_MS,
+                      uint8_t retries = JDKSAVDECCMCU_INFLIGHT_COMMAND_DEFAULT_RETRIES );
+
+    ///
+    /// \brief getCount Get the number of commands in flight
+    ///
+    uint16_t getCount() const { return m_num_items; }
+
+    ///
+    /// \brief getMaxCount Get the capacity of the table
+    ///
+    uint16_t getMaxCount() const { return m_max_items; }
+
+    ///
+    /// \brief isFull test if no more commands can be tracked
+    ///
+    bool isFull() const { return m_num_items >= m_max_items; }
+
+    ///
+    /// \brief getItem Get the inflight command at position i
+    ///
+    InflightCommand *getItem( uint16_t i ) { return &m_item[i]; }
+    InflightCommand const *getItem( uint16_t i ) const { return &m_item[i]; }
+
+    ///
+    /// \brief getCountForTarget Get the number of commands in flight to one
+    /// target entity
+    ///
+    uint16_t getCountForTarget( Eui64 const &target_entity_id ) const;
+
+    ///
+    /// \brief add Track a newly sent command
+    /// \param target_entity_id The target entity id
+    /// \param target_mac_address The target MAC address
+    /// \param sequence_id The sequence id used
+    /// \param command_type The AEM command_type
+    /// \param sent_time The time the command was sent
+    /// \param notification The object to notify of the outcome, may be 0
+    /// \return pointer to the new entry or 0 if the table is full
+    ///
+    InflightCommand *add( Eui64 const &target_entity_id,
+                          Eui48 const &target_mac_address,
+                          uint16_t sequence_id,
+                          uint16_t command_type,
+                          jdksavdecc_timestamp_in_milliseconds sent_time,
+                          InflightCommandNotification *notification = 0 );
+
+    ///
+    /// \brief storePdu Keep a copy of the command pdu in the entry for
+    /// retransmission. The pdu is given as a header followed by fragments,
+    /// the same way as RawSocket::sendFrameFragments()
+    /// \return true if the pdu fit in the entry
+    ///
+    bool storePdu( InflightCommand *cmd, FixedBuffer const &header, FrameFragment const *fragments, uint16_t num_fragments );
+
+    ///
+    /// \brief storePdu Keep a copy of the command pdu in the entry for
+    /// retransmission. The pdu is given as a header plus two optional
+    /// additional data areas, the same way as RawSocket::sendFrame()
+    /// \return true if the pdu fit in the entry
+    ///
+    bool storePdu( InflightCommand *cmd,
+                   FixedBuffer const &header,
+                   uint8_t const *data1 = 0,
+                   uint16_t len1 = 0,
+                   uint8_t const *data2 = 0,
+                   uint16_t len2 = 0 )
+    {
+        FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+        return storePdu( cmd, header, fragments, 2 );
+    }
+
+    ///
+    /// \brief find Find the command matching a received response
+    /// \param target_entity_id The target entity id from the response
+    /// \param sequence_id The sequence id from the response
+    /// \return pointer to the entry or 0 if not found
+    ///
+    InflightCommand *find( Eui64 const &target_entity_id, uint16_t sequence_id );
+
+    ///
+    /// \brief remove Remove an entry from the table. The last entry is
+    /// moved into its place
+    /// \param cmd pointer to the entry to remove
+    ///
+    void remove( InflightCommand *cmd );
+
+    ///
+    /// \brief clear Forget all inflight commands
+    ///
+    void clear() { m_num_items = 0; }
+
+  protected:
+    uint16_t m_num_items;
+    uint16_t m_max_items;
+    InflightCommand *m_item;
+    jdksavdecc_timestamp_in_milliseconds m_timeout_in_ms;
+    uint8_t m_retries;
+};
+
+///
+/// \brief The InflightCommandsWithSize class
+///
+/// InflightCommands that contains the storage for MaxItems entries
+///
+template <uint16_t MaxItems>
+class InflightCommandsWithSize : public InflightCommands
+{
+  private:
+    InflightCommand m_item_storage[MaxItems];
+
+  public:
+    InflightCommandsWithSize( jdksavdecc_timestamp_in_milliseconds timeout_in_ms = JDKSAVDECC_AEM_TIMEOUT_IN_MS,
+                              uint8_t retries = JDKSAVDECCMCU_INFLIGHT_COMMAND_DEFAULT_RETRIES )
+        : InflightCommands( m_item_storage, MaxItems, timeout_in_ms, retries )
+    {
+    }
+};
+}
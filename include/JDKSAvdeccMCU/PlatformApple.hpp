@@ -72,6 +72,15 @@
 #ifndef JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE
 #define JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE 1
 #endif
+#ifndef JDKSAVDECCMCU_ENABLE_POLL
+#define JDKSAVDECCMCU_ENABLE_POLL 1
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_EPOLL
+#define JDKSAVDECCMCU_ENABLE_EPOLL 0
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_THREADS
+#define JDKSAVDECCMCU_ENABLE_THREADS 1
+#endif
 #ifndef JDKSAVDECCMCU_MAX_RAWSOCKETS
 #define JDKSAVDECCMCU_MAX_RAWSOCKETS 32
 #endif
@@ -91,6 +100,14 @@
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <sys/poll.h>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#if JDKSAVDECCMCU_ENABLE_THREADS
+#include <thread>
+#include <atomic>
+#include <mutex>
+#endif
 #include <netdb.h>
 
 #include <memory>
@@ -102,6 +119,7 @@
 #include <string>
 #include <stdexcept>
 #include <utility>
+#include <functional>
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -75,6 +75,15 @@
 #ifndef JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE
 #define JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE 0
 #endif
+#ifndef JDKSAVDECCMCU_ENABLE_POLL
+#define JDKSAVDECCMCU_ENABLE_POLL 0
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_EPOLL
+#define JDKSAVDECCMCU_ENABLE_EPOLL 0
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_THREADS
+#define JDKSAVDECCMCU_ENABLE_THREADS 0
+#endif
 #ifndef JDKSAVDECCMCU_MAX_RAWSOCKETS
 #define JDKSAVDECCMCU_MAX_RAWSOCKETS 2
 #endif
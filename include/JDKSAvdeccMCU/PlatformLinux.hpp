@@ -33,6 +33,8 @@
 #include "JDKSAvdeccMCU/PlatformOptions.hpp"
 
 #if defined( __linux__ )
+#define JDKSAVDECCMCU_BARE_METAL 0
+
 #ifndef JDKSAVDECCMCU_ARDUINO
 #define JDKSAVDECCMCU_ARDUINO 0
 #endif
@@ -60,6 +62,15 @@
 #ifndef JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE
 #define JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE 1
 #endif
+#ifndef JDKSAVDECCMCU_ENABLE_POLL
+#define JDKSAVDECCMCU_ENABLE_POLL 1
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_EPOLL
+#define JDKSAVDECCMCU_ENABLE_EPOLL 1
+#endif
+#ifndef JDKSAVDECCMCU_ENABLE_THREADS
+#define JDKSAVDECCMCU_ENABLE_THREADS 1
+#endif
 #ifndef JDKSAVDECCMCU_MAX_RAWSOCKETS
 #define JDKSAVDECCMCU_MAX_RAWSOCKETS 32
 #endif
@@ -78,6 +89,17 @@
 #include <sys/socket.h>
 #include <sys/select.h>
 #include <sys/poll.h>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+#include <sys/epoll.h>
+#endif
+#if JDKSAVDECCMCU_ENABLE_THREADS
+#include <thread>
+#include <atomic>
+#include <mutex>
+#endif
 #include <netdb.h>
 
 #include <memory>
@@ -89,6 +111,7 @@
 #include <string>
 #include <stdexcept>
 #include <utility>
+#include <functional>
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
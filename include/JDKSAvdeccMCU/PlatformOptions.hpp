@@ -46,7 +46,15 @@
 #define JDKSAVDECCMCU_ENABLE_PCAPFILE 0
 #define JDKSAVDECCMCU_ENABLE_RAWSOCKETPCAPFILE 0
 #define JDKSAVDECCMCU_MAX_RAWSOCKETS 1
+#define JDKSAVDECCMCU_ENABLE_POLL 0
+#define JDKSAVDECCMCU_ENABLE_EPOLL 0
+#define JDKSAVDECCMCU_ENABLE_THREADS 0
 #define JDKSAVDECCMCU_ENABLE_MDNSREGISTER 0
 #define JDKSAVDECCMCU_ENABLE_HTTP 0
 #define JDKSAVDECCMCU_ENABLE_RAWSOCKETLIBUV 0
+#define JDKSAVDECCMCU_INFLIGHT_COMMAND_MAX_PDU_LENGTH 64
+#define JDKSAVDECCMCU_HANDLER_MAX_DISPATCH_KEYS 4
+#define JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH 4
+#define JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS 4
+#define JDKSAVDECCMCU_TIMERWHEEL_LEVELS 3
 #endif
@@ -36,6 +36,11 @@
 #define JDKSAVDECCMCU_RAWSOCKET_MIN_PAYLOAD_LENGTH ( 64 )
 #define JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH ( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECCMCU_RAWSOCKET_MIN_PAYLOAD_LENGTH )
 
+/// The largest number of FrameFragments that one frame can be sent with
+#ifndef JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS
+#define JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS ( 8 )
+#endif
+
 namespace JDKSAvdeccMCU
 {
 class HandlerGroup;
@@ -61,6 +66,31 @@ class RawSocket
         sendReplyFrame( Frame &frame, uint8_t const *data1 = 0, uint16_t len1 = 0, uint8_t const *data2 = 0, uint16_t len2 = 0 )
         = 0;
 
+    /**
+     * Send the frame followed by the fragments. The default gathers them into
+     * one frame and calls sendFrame(); sockets that can hand a list of
+     * buffers to the network stack override it to avoid the copy
+     */
+    virtual bool sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments );
+
+    /**
+     * Send the frame followed by the fragments back to the source of the
+     * frame, the way sendReplyFrame() does
+     */
+    virtual bool sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments );
+
+    /**
+     * Send several frames that each end with the same fragments, such as
+     * one copy of a response for each controller. The default sends them
+     * one at a time; sockets that can hand many frames to the network stack
+     * at once override it to send them together.
+     * Returns false if any of them could not be sent
+     */
+    virtual bool sendFrameFragmentsBatch( Frame const *const *frames,
+                                          uint16_t num_frames,
+                                          FrameFragment const *fragments,
+                                          uint16_t num_fragments );
+
     /**
     * Attempt to join an additional multicast mac address group
     */
@@ -70,5 +100,57 @@ class RawSocket
      * Get the MAC address of the ethernet port
      */
     virtual Eui48 const &getMACAddress() const = 0;
+
+    /**
+     * Get the number of network ports that the socket sends and receives on
+     */
+    virtual uint16_t getPortCount() const { return 1; }
+
+    /**
+     * Get the MAC address of one of the network ports
+     */
+    virtual Eui48 const &getPortMACAddress( uint16_t port ) const
+    {
+        (void)port;
+        return getMACAddress();
+    }
+
+    /**
+     * Get the file descriptor that becomes readable when frames are waiting,
+     * or -1 if the socket can not be waited on
+     */
+    virtual int getFd() const { return -1; }
+
+    /**
+     * Send any frames that the socket is holding back to send in one batch.
+     * Returns false if any of them could not be sent
+     */
+    virtual bool flush() { return true; }
+
+    /**
+     * Point the frame at the next received frame where it lies in the
+     * socket's own receive memory, without copying it. The frame must be
+     * given back with releaseFrame() before the next call.
+     * Returns false if no frame is waiting or if the socket can only
+     * receive with recvFrame()
+     */
+    virtual bool acquireFrame( Frame *frame )
+    {
+        (void)frame;
+        return false;
+    }
+
+    /**
+     * Give a frame from acquireFrame() back to the socket
+     */
+    virtual void releaseFrame( Frame *frame ) { (void)frame; }
 };
+
+/**
+ * Wait until at least one of the sockets has a frame waiting or the
+ * timeout expires. Sockets without a file descriptor are never waited for,
+ * so any of them in the list makes this return immediately.
+ * Returns true if a socket is readable or may be readable
+ */
+bool waitForRawSockets( RawSocket *const *sockets, uint16_t num_sockets, int32_t timeout_ms );
 }
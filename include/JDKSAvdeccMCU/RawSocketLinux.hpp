@@ -0,0 +1,192 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocket.hpp"
+
+#if defined( __linux__ ) && JDKSAVDECCMCU_ENABLE_RAWSOCKETLINUX
+
+/// The number of frames moved by one recvmmsg() or sendmmsg() call
+#ifndef JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH
+#define JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH ( 32 )
+#endif
+
+/// The number of multicast addresses that the kernel filter accepts
+#ifndef JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_MULTICAST
+#define JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_MULTICAST ( 8 )
+#endif
+
+/// The largest ethernet frame that is sent or received, without FCS
+#define JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH ( 1514 )
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The RawSocketLinux class
+///
+/// A RawSocket on a Linux AF_PACKET socket bound to one network port.
+///
+/// A kernel BPF filter only lets frames with the ethertype through, and
+/// only if they are addressed to the port's MAC address or to one of the
+/// joined multicast addresses. Received frames are read in batches with
+/// recvmmsg(). Sent frames go straight to the kernel with sendmsg(), with the
+/// header, the frame and each fragment in its own iovec so that payloads are
+/// not copied on the way. With transmit batching enabled they are instead
+/// copied into a batch and sent with sendmmsg(); HandlerGroup::tick()
+/// flushes the batch once per loop.
+///
+class RawSocketLinux : public RawSocket
+{
+  public:
+    /**
+     * Open a raw socket connected to the specified interface name and join
+     * the specified multicast address
+     */
+    RawSocketLinux( const char *device,
+                    uint16_t ethertype = JDKSAVDECC_AVTP_ETHERTYPE,
+                    Eui48 const &multicast_to_join = Eui48( JDKSAVDECC_MULTICAST_ADP_ACMP_MAC ),
+                    uint16_t batch_size = JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH );
+
+    virtual ~RawSocketLinux();
+
+    /// Returns true if the socket was opened and bound to the device
+    bool isOpen() const { return m_fd >= 0; }
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override { m_handler_group = handler_group; }
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override
+    {
+        return JDKSAvdeccMCU::getTimeInMilliseconds();
+    }
+
+    virtual bool recvFrame( Frame *frame ) override;
+
+    virtual bool sendFrame( Frame const &frame,
+                            uint8_t const *data1 = 0,
+                            uint16_t len1 = 0,
+                            uint8_t const *data2 = 0,
+                            uint16_t len2 = 0 ) override;
+
+    virtual bool sendReplyFrame( Frame &frame,
+                                 uint8_t const *data1 = 0,
+                                 uint16_t len1 = 0,
+                                 uint8_t const *data2 = 0,
+                                 uint16_t len2 = 0 ) override;
+
+    virtual bool sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    virtual bool sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    /// Sends the frames with as few sendmmsg() calls as the batch size
+    /// allows, even when transmit batching is off
+    virtual bool sendFrameFragmentsBatch( Frame const *const *frames,
+                                          uint16_t num_frames,
+                                          FrameFragment const *fragments,
+                                          uint16_t num_fragments ) override;
+
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override;
+
+    virtual Eui48 const &getMACAddress() const override { return m_mac_address; }
+
+    virtual int getFd() const override { return m_fd; }
+
+    virtual bool flush() override;
+
+    /// Hold sent frames back until flush() or until a batch is full
+    void setTransmitBatching( bool enable );
+
+    const char *getDeviceName() const { return m_device; }
+
+    /// The number of recvmmsg() calls that returned frames
+    uint32_t getRxSyscallCount() const { return m_rx_syscall_count; }
+
+    /// The number of frames received
+    uint32_t getRxFrameCount() const { return m_rx_frame_count; }
+
+    /// The number of sendmsg() and sendmmsg() calls
+    uint32_t getTxSyscallCount() const { return m_tx_syscall_count; }
+
+    /// The number of frames sent
+    uint32_t getTxFrameCount() const { return m_tx_frame_count; }
+
+    /// The number of frames that could not be sent
+    uint32_t getTxDroppedCount() const { return m_tx_dropped_count; }
+
+  protected:
+    /// Load the kernel filter for the current set of addresses
+    bool attachFilter();
+
+    /// Read the next batch of frames from the kernel
+    bool fillReceiveBatch();
+
+    /// Compose a complete ethernet frame in the next transmit slot
+    uint16_t composeFrame( uint8_t *buffer, Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments );
+
+    /// Fill in the ethernet header that the frame is sent with
+    void composeHeader( uint8_t *header, Frame const &frame );
+
+  private:
+    RawSocketLinux( RawSocketLinux const & );
+    RawSocketLinux const &operator=( RawSocketLinux const & );
+
+  protected:
+    int m_fd;
+    const char *m_device;
+    int m_interface_id;
+    Eui48 m_mac_address;
+    Eui48 m_default_dest_mac_address;
+    uint16_t m_ethertype;
+    HandlerGroup *m_handler_group;
+
+    uint16_t m_num_multicast;
+    Eui48 m_multicast[JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_MULTICAST];
+
+    uint16_t m_batch_size;
+    std::vector<uint8_t> m_rx_buffers;
+    std::vector<uint16_t> m_rx_lengths;
+    uint16_t m_rx_count;
+    uint16_t m_rx_pos;
+
+    bool m_tx_batching;
+    std::vector<uint8_t> m_tx_buffers;
+    std::vector<uint16_t> m_tx_lengths;
+    uint16_t m_tx_count;
+
+    uint32_t m_rx_syscall_count;
+    uint32_t m_rx_frame_count;
+    uint32_t m_tx_syscall_count;
+    uint32_t m_tx_frame_count;
+    uint32_t m_tx_dropped_count;
+};
+}
+#endif
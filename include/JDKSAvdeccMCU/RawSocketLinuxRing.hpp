@@ -0,0 +1,114 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketLinux.hpp"
+
+#if defined( __linux__ ) && JDKSAVDECCMCU_ENABLE_RAWSOCKETLINUX
+
+/// The size of one block of the receive ring, a multiple of the page size
+#ifndef JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_SIZE
+#define JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_SIZE ( 1 << 16 )
+#endif
+
+/// The number of blocks in the receive ring
+#ifndef JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_COUNT
+#define JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_COUNT ( 64 )
+#endif
+
+/// The time in milliseconds after which the kernel hands over a block
+/// that is not full
+#ifndef JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_TIMEOUT
+#define JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_TIMEOUT ( 4 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The RawSocketLinuxRing class
+///
+/// A RawSocketLinux that receives through a PACKET_MMAP TPACKET_V3 ring
+/// shared with the kernel. The kernel fills whole blocks of frames;
+/// acquireFrame() points a Frame directly at each frame in the current
+/// block and releaseFrame() moves on, handing the block back to the
+/// kernel once every frame in it has been released. HandlerGroup releases
+/// each frame as soon as receivedPDU() returns, so a handler must not keep
+/// a reference to the frame.
+///
+/// recvFrame() still works and copies out of the ring. Sending is
+/// unchanged. If the kernel refuses the ring, the socket falls back to
+/// the recvmmsg() path of RawSocketLinux.
+///
+class RawSocketLinuxRing : public RawSocketLinux
+{
+  public:
+    RawSocketLinuxRing( const char *device,
+                        uint16_t ethertype = JDKSAVDECC_AVTP_ETHERTYPE,
+                        Eui48 const &multicast_to_join = Eui48( JDKSAVDECC_MULTICAST_ADP_ACMP_MAC ),
+                        uint32_t block_size = JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_SIZE,
+                        uint32_t block_count = JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_COUNT );
+
+    virtual ~RawSocketLinuxRing();
+
+    /// Returns true if the receive ring is mapped
+    bool hasRing() const { return m_ring != 0; }
+
+    virtual bool recvFrame( Frame *frame ) override;
+
+    virtual bool acquireFrame( Frame *frame ) override;
+
+    virtual void releaseFrame( Frame *frame ) override;
+
+    /// The number of blocks received from the kernel
+    uint32_t getRxBlockCount() const { return m_rx_block_count; }
+
+  protected:
+    /// Start on the next block if the kernel has handed it over
+    bool openBlock();
+
+    /// Hand the current block back to the kernel
+    void closeBlock();
+
+  private:
+    uint8_t *m_ring;
+    uint32_t m_ring_size;
+    uint32_t m_block_size;
+    uint32_t m_block_count;
+    uint32_t m_block_pos;
+    uint32_t m_frames_left_in_block;
+    uint8_t *m_packet;
+    jdksavdecc_timestamp_in_milliseconds m_block_time;
+    uint32_t m_rx_block_count;
+};
+}
+#endif
@@ -0,0 +1,133 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocket.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The RawSocketMulti class
+///
+/// A RawSocket that serves several network ports as one, so that one
+/// HandlerGroup and one set of handlers can serve redundant networks from a
+/// single loop.
+///
+/// Each received Frame is tagged with the number of the port that it
+/// arrived on. sendReplyFrame() sends back out of that port, and
+/// sendFrame() sends out of the port that the frame is tagged with, or out
+/// of every port if it is not tagged. The ports are polled round robin so
+/// that a busy port can not starve the others.
+///
+/// With epoll the ports are gathered behind one file descriptor so that
+/// HandlerGroup::run() can sleep until any of them has a frame.
+///
+class RawSocketMulti : public RawSocket
+{
+  public:
+    RawSocketMulti();
+
+    virtual ~RawSocketMulti();
+
+    /// Add a network port. Its port number is the number of ports added
+    /// before it. Returns false if there is no room
+    bool addPort( RawSocket *port );
+
+    /// Get one of the network ports
+    RawSocket *getPort( uint16_t port ) const { return port < m_num_ports ? m_port[port] : 0; }
+
+    virtual uint16_t getPortCount() const override { return m_num_ports; }
+
+    virtual Eui48 const &getPortMACAddress( uint16_t port ) const override;
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override;
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override;
+
+    virtual bool recvFrame( Frame *frame ) override;
+
+    virtual bool acquireFrame( Frame *frame ) override;
+
+    virtual void releaseFrame( Frame *frame ) override;
+
+    virtual bool sendFrame( Frame const &frame,
+                            uint8_t const *data1 = 0,
+                            uint16_t len1 = 0,
+                            uint8_t const *data2 = 0,
+                            uint16_t len2 = 0 ) override;
+
+    virtual bool sendReplyFrame( Frame &frame,
+                                 uint8_t const *data1 = 0,
+                                 uint16_t len1 = 0,
+                                 uint8_t const *data2 = 0,
+                                 uint16_t len2 = 0 ) override;
+
+    virtual bool sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    virtual bool sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    virtual bool sendFrameFragmentsBatch( Frame const *const *frames,
+                                          uint16_t num_frames,
+                                          FrameFragment const *fragments,
+                                          uint16_t num_fragments ) override;
+
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override;
+
+    /// The MAC address of the first port
+    virtual Eui48 const &getMACAddress() const override;
+
+    virtual int getFd() const override;
+
+    virtual bool flush() override;
+
+  private:
+    RawSocketMulti( RawSocketMulti const & );
+    RawSocketMulti const &operator=( RawSocketMulti const & );
+
+    uint16_t m_num_ports;
+    RawSocket *m_port[JDKSAVDECCMCU_MAX_RAWSOCKETS];
+
+    /// The port to try first on the next receive
+    uint16_t m_next_port;
+
+    /// The port that lent out the current acquired frame
+    uint16_t m_acquired_port;
+
+    /// The number of ports without a file descriptor
+    uint16_t m_num_unwaitable_ports;
+
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    int m_epoll_fd;
+#endif
+};
+}
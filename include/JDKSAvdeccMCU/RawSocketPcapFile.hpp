@@ -46,6 +46,10 @@ class RawSocketPcapFile : public RawSocket
     jdksavdecc_timestamp_in_milliseconds m_time_granularity_in_ms;
     FrameWithSize<1500> m_next_incoming_frame;
 
+    /// Reused for every packet read or written, so that it only allocates
+    /// until it has grown to the largest packet
+    PcapFilePacket m_packet;
+
     RawSocketPcapFile( RawSocketPcapFile const &other );
 
   public:
@@ -73,6 +77,10 @@ class RawSocketPcapFile : public RawSocket
 
     virtual bool sendReplyFrame( Frame &frame, uint8_t const *data1, uint16_t len1, uint8_t const *data2, uint16_t len2 ) override;
 
+    virtual bool sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    virtual bool sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
     virtual bool joinMulticast( const Eui48 &multicast_mac ) override;
 
     virtual const Eui48 &getMACAddress() const override;
@@ -0,0 +1,199 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocket.hpp"
+#include "JDKSAvdeccMCU/FrameRing.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The RawSocketRingPair class
+///
+/// A RawSocket whose frames come from and go to a pair of FrameRings that
+/// another thread serves, so that a HandlerGroup can run on a thread of
+/// its own without any locks.
+///
+/// The thread that owns the RawSocketRingPair (the consumer) uses it like
+/// any other RawSocket: received frames are borrowed from the RX ring with
+/// acquireFrame(), and sent frames are put into the TX ring and announced
+/// to the serving thread at flush(), which HandlerGroup calls once per
+/// loop. The serving thread (the producer) fills the RX ring with
+/// getReceiveSlot() or deliver() and empties the TX ring with
+/// sendQueued().
+///
+/// Each direction has a wake pipe so that both threads can sleep in
+/// poll() until the other has something for them.
+///
+class RawSocketRingPair : public RawSocket
+{
+  public:
+    RawSocketRingPair( FrameRing *rx_ring, FrameRing *tx_ring );
+
+    virtual ~RawSocketRingPair();
+
+    /// Were the wake pipes opened
+    bool isValid() const { return m_rx_wake[0] >= 0 && m_tx_wake[0] >= 0; }
+
+    virtual bool recvFrame( Frame *frame ) override;
+
+    virtual bool acquireFrame( Frame *frame ) override;
+
+    virtual void releaseFrame( Frame *frame ) override;
+
+    virtual bool sendFrame( Frame const &frame,
+                            uint8_t const *data1 = 0,
+                            uint16_t len1 = 0,
+                            uint8_t const *data2 = 0,
+                            uint16_t len2 = 0 ) override;
+
+    virtual bool sendReplyFrame( Frame &frame,
+                                 uint8_t const *data1 = 0,
+                                 uint16_t len1 = 0,
+                                 uint8_t const *data2 = 0,
+                                 uint16_t len2 = 0 ) override;
+
+    virtual bool sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    virtual bool sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments ) override;
+
+    /// Readable when the serving thread has put frames into the RX ring
+    virtual int getFd() const override { return m_rx_wake[0]; }
+
+    /// Hand the frames that were sent since the last flush to the serving
+    /// thread
+    virtual bool flush() override;
+
+    /// Producer: the next free RX slot, or 0 if the RX ring is full
+    Frame *getReceiveSlot() { return m_rx_ring->getWriteSlot(); }
+
+    /// Producer: publish the slot from getReceiveSlot()
+    void commitReceived()
+    {
+        m_rx_ring->commitWrite();
+        ++m_rx_unsignalled;
+    }
+
+    /// Producer: copy a frame into the RX ring. Returns false and counts it
+    /// as dropped if the ring is full
+    bool deliver( Frame const &frame );
+
+    /// Producer: count frames that were dropped because the RX ring was full
+    void countDropped( uint32_t dropped );
+
+    /// Producer: wake the consumer if frames were put into the RX ring since
+    /// the last call
+    void signalReceived();
+
+    /// Producer: send everything in the TX ring with the network socket,
+    /// returns the number of frames that were taken from the ring
+    uint32_t sendQueued( RawSocket *net );
+
+    /// Producer: readable when the consumer has flushed frames into the TX
+    /// ring
+    int getTxFd() const { return m_tx_wake[0]; }
+
+    /// Producer: empty the TX wake pipe once it has been seen readable
+    void clearTxFd() { drain( m_tx_wake[0] ); }
+
+    /// The number of frames put into the RX ring
+    uint32_t getRxFrameCount() const { return m_rx_frame_count.load( std::memory_order_relaxed ); }
+
+    /// The number of received frames dropped because the RX ring was full
+    uint32_t getRxDroppedCount() const { return m_rx_dropped_count.load( std::memory_order_relaxed ); }
+
+    /// The number of times that frames had to be dropped because the RX ring
+    /// was full
+    uint32_t getRxBackpressureCount() const { return m_rx_backpressure_count.load( std::memory_order_relaxed ); }
+
+    /// The most frames that were ever waiting in the RX ring
+    uint32_t getRxHighWaterMark() const { return m_rx_ring->getHighWaterMark(); }
+
+    /// The number of frames sent from the TX ring
+    uint32_t getTxFrameCount() const { return m_tx_frame_count.load( std::memory_order_relaxed ); }
+
+    /// The number of sends that failed because the TX ring was full or the
+    /// frame did not fit into a slot
+    uint32_t getTxDroppedCount() const { return m_tx_dropped_count.load( std::memory_order_relaxed ); }
+
+    /// The number of sends that the network socket refused
+    uint32_t getTxErrorCount() const { return m_tx_error_count.load( std::memory_order_relaxed ); }
+
+    /// The most frames that were ever waiting in the TX ring
+    uint32_t getTxHighWaterMark() const { return m_tx_ring->getHighWaterMark(); }
+
+  protected:
+    /// Wake the consumer even if no frames arrived, to stop its thread
+    void wakeReceiver() { wake( m_rx_wake[1] ); }
+
+    /// Wake the producer even if no frames were sent, to stop its thread
+    void wakeSender() { wake( m_tx_wake[1] ); }
+
+    /// Write a byte to a wake pipe
+    static void wake( int fd );
+
+    /// Read all of the bytes in a wake pipe
+    static void drain( int fd );
+
+    FrameRing *m_rx_ring;
+    FrameRing *m_tx_ring;
+
+  private:
+    RawSocketRingPair( RawSocketRingPair const & );
+    RawSocketRingPair const &operator=( RawSocketRingPair const & );
+
+    /// Written by the producer when it fills the RX ring
+    int m_rx_wake[2];
+
+    /// Written by the consumer at flush()
+    int m_tx_wake[2];
+
+    /// Frames went into the RX ring since the last signalReceived(), only
+    /// touched by the producer
+    uint32_t m_rx_unsignalled;
+
+    /// Frames went into the TX ring since the last flush(), only touched by
+    /// the consumer
+    bool m_tx_pending;
+
+    std::atomic<uint32_t> m_rx_frame_count;
+    std::atomic<uint32_t> m_rx_dropped_count;
+    std::atomic<uint32_t> m_rx_backpressure_count;
+    std::atomic<uint32_t> m_tx_frame_count;
+    std::atomic<uint32_t> m_tx_dropped_count;
+    std::atomic<uint32_t> m_tx_error_count;
+};
+}
+#endif
@@ -82,14 +82,13 @@ class SimpleRawSocketRunner : public RawSocketRunner
         }
     }
 
-    virtual bool run( int timeout_ms )
-    {
-        // TODO: poll socket and dispatch
-        return false;
-    }
+    /// Wait up to timeout_ms for frames and pass all waiting frames to the
+    /// target. Returns false if there is no socket to run
+    virtual bool run( int timeout_ms );
 
   private:
     RawSocket *m_the_socket;
     RawSocketRunnerNotification *m_notification_target;
+    FrameWithMTU m_frame;
 };
 }
@@ -0,0 +1,135 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketRingPair.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+/// How long the IO thread sleeps at most when the wrapped socket has no
+/// file descriptor to wait on
+#ifndef JDKSAVDECCMCU_RAWSOCKETTHREADED_POLL_INTERVAL_MS
+#define JDKSAVDECCMCU_RAWSOCKETTHREADED_POLL_INTERVAL_MS ( 1 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The RawSocketThreaded class
+///
+/// A RawSocket that moves the network IO of another RawSocket onto its own
+/// thread, so that the thread running the HandlerGroup only ever deals with
+/// frames that have already arrived.
+///
+/// The IO thread receives straight into the slots of the RX ring and the
+/// protocol thread borrows them with acquireFrame() without copying. Frames
+/// that are sent are put into the TX ring and are sent by the IO thread
+/// after flush(). Neither direction takes a lock.
+///
+/// When the RX ring is full the IO thread keeps reading and drops the new
+/// frames so that the protocol thread never sees stale ones; when the TX
+/// ring is full sends fail. Both are counted.
+///
+/// The wrapped socket belongs to the IO thread between start() and stop(),
+/// so join multicast groups before start().
+///
+class RawSocketThreaded : public RawSocketRingPair
+{
+  public:
+    RawSocketThreaded( RawSocket *inner, FrameRing *rx_ring, FrameRing *tx_ring );
+
+    virtual ~RawSocketThreaded();
+
+    /// Start the IO thread. Returns false if it could not be started
+    bool start();
+
+    /// Stop the IO thread and wait for it to finish
+    void stop();
+
+    bool isRunning() const { return m_running.load( std::memory_order_acquire ); }
+
+    /// The socket that the IO thread serves
+    RawSocket *getInner() const { return m_inner; }
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override;
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override;
+
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override;
+
+    virtual Eui48 const &getMACAddress() const override;
+
+    virtual uint16_t getPortCount() const override;
+
+    virtual Eui48 const &getPortMACAddress( uint16_t port ) const override;
+
+  private:
+    RawSocketThreaded( RawSocketThreaded const & );
+    RawSocketThreaded const &operator=( RawSocketThreaded const & );
+
+    /// The body of the IO thread
+    void run();
+
+    /// Receive from the wrapped socket into the RX ring, returns the number
+    /// of frames that were read
+    uint32_t receiveAvailable();
+
+    RawSocket *m_inner;
+
+    /// Frames that arrive while the RX ring is full are read into here
+    FrameWithMTU m_rx_scratch;
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+};
+
+///
+/// \brief The RawSocketThreadedWithSize class
+///
+/// A RawSocketThreaded that owns its RX and TX rings
+///
+template <uint32_t RxSlots, uint32_t TxSlots>
+class RawSocketThreadedWithSize : public RawSocketThreaded
+{
+  public:
+    RawSocketThreadedWithSize( RawSocket *inner ) : RawSocketThreaded( inner, &m_rx_ring_storage, &m_tx_ring_storage ) {}
+
+    /// The IO thread must stop before the rings go away
+    virtual ~RawSocketThreadedWithSize() { stop(); }
+
+  private:
+    FrameRingWithSize<RxSlots> m_rx_ring_storage;
+    FrameRingWithSize<TxSlots> m_tx_ring_storage;
+};
+}
+#endif
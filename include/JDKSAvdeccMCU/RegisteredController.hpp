@@ -33,6 +33,15 @@
 #include "JDKSAvdeccMCU/World.hpp"
 #include "JDKSAvdeccMCU/Helpers.hpp"
 #include "JDKSAvdeccMCU/Frame.hpp"
+#include "JDKSAvdeccMCU/EuiFlatMap.hpp"
+
+/// The default time after which a registered controller that has not been
+/// heard from is forgotten. Only AEM commands count as hearing from it, so
+/// the default of 0 keeps a controller that only listens until it
+/// deregisters
+#ifndef JDKSAVDECCMCU_REGISTERED_CONTROLLER_TIMEOUT_MS
+#define JDKSAVDECCMCU_REGISTERED_CONTROLLER_TIMEOUT_MS ( 0 )
+#endif
 
 namespace JDKSAvdeccMCU
 {
@@ -46,6 +55,9 @@ struct RegisteredController
 
     /// Controller's MAC address
     Eui48 m_mac_address;
+
+    /// When the controller was last heard from
+    jdksavdecc_timestamp_in_milliseconds m_last_seen_time;
 };
 
 class RegisteredControllers
@@ -57,6 +69,18 @@ class RegisteredControllers
     virtual bool findController( Eui64 entity_id ) const = 0;
     virtual bool addController( Eui64 entity_id, Eui48 mac_address ) = 0;
     virtual void removeController( Eui64 entity_id ) = 0;
+
+    /// Note that a controller was heard from. Does nothing unless the
+    /// storage expires controllers
+    virtual void refreshController( Eui64 entity_id, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+    {
+        (void)entity_id;
+        (void)time_in_millis;
+    }
+
+    /// Forget the controllers that have not been heard from for too long.
+    /// Does nothing unless the storage expires controllers
+    virtual void expireControllers( jdksavdecc_timestamp_in_milliseconds time_in_millis ) { (void)time_in_millis; }
 };
 
 template <uint16_t MaxControllers>
@@ -98,6 +122,8 @@ class RegisteredControllersStorage : public RegisteredControllers
             {
                 m_controller[m_num_controllers].m_entity_id = entity_id;
                 m_controller[m_num_controllers].m_mac_address = mac_address;
+                m_controller[m_num_controllers].m_last_seen_time = 0;
+                ++m_num_controllers;
                 r = true;
             }
         }
@@ -133,4 +159,95 @@ class RegisteredControllersStorage : public RegisteredControllers
     uint16_t m_num_controllers;
     RegisteredController m_controller[MaxControllers];
 };
+
+///
+/// \brief The RegisteredControllersHashed class
+///
+/// RegisteredControllers kept in an EuiFlatMap on the controller's
+/// entity_id, so that finding, adding and removing a controller takes the
+/// same time no matter how many are registered.
+///
+/// Controllers that leave without deregistering are forgotten when they
+/// have not sent an AEM command for the timeout. A timeout of 0, the
+/// default, keeps them until they deregister. Only set one when the
+/// controllers are known to send commands more often than that
+///
+template <uint16_t MaxControllers>
+class RegisteredControllersHashed : public RegisteredControllers
+{
+  public:
+    RegisteredControllersHashed( jdksavdecc_timestamp_in_milliseconds timeout_in_millis = JDKSAVDECCMCU_REGISTERED_CONTROLLER_TIMEOUT_MS )
+        : m_timeout_in_millis( timeout_in_millis ), m_current_time( 0 )
+    {
+    }
+
+    virtual uint16_t getControllerCount() const override { return m_controllers.getCount(); }
+
+    virtual RegisteredController *getController( uint16_t i ) override { return &m_controllers.getValue( i ); }
+    virtual RegisteredController const *getController( uint16_t i ) const override { return &m_controllers.getValue( i ); }
+    virtual bool findController( Eui64 entity_id ) const override { return m_controllers.find( entity_id ) != 0; }
+
+    virtual bool addController( Eui64 entity_id, Eui48 mac_address ) override
+    {
+        if ( m_controllers.isFull() && !m_controllers.find( entity_id ) )
+        {
+            // Make room by forgetting the ones that have gone away
+            expireControllers( m_current_time );
+        }
+
+        bool inserted;
+        RegisteredController *c = m_controllers.insert( entity_id, &inserted );
+        if ( c )
+        {
+            if ( inserted )
+            {
+                c->m_entity_id = entity_id;
+                c->m_last_seen_time = m_current_time;
+            }
+            // It may have moved to another port
+            c->m_mac_address = mac_address;
+        }
+        return c != 0;
+    }
+
+    virtual void removeController( Eui64 entity_id ) override { m_controllers.erase( entity_id ); }
+
+    virtual void refreshController( Eui64 entity_id, jdksavdecc_timestamp_in_milliseconds time_in_millis ) override
+    {
+        m_current_time = time_in_millis;
+        RegisteredController *c = m_controllers.find( entity_id );
+        if ( c )
+        {
+            c->m_last_seen_time = time_in_millis;
+        }
+    }
+
+    virtual void expireControllers( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override
+    {
+        m_current_time = time_in_millis;
+        if ( m_timeout_in_millis > 0 )
+        {
+            // Going backwards, the controller that is moved into a removed
+            // one's place has already been looked at
+            for ( uint16_t i = m_controllers.getCount(); i > 0; --i )
+            {
+                if ( wasTimeOutHit( time_in_millis, m_controllers.getValue( i - 1 ).m_last_seen_time, m_timeout_in_millis ) )
+                {
+                    m_controllers.eraseAt( i - 1 );
+                }
+            }
+        }
+    }
+
+    /// Get the time after which a silent controller is forgotten
+    jdksavdecc_timestamp_in_milliseconds getTimeout() const { return m_timeout_in_millis; }
+
+    /// Set the time after which a silent controller is forgotten
+    void setTimeout( jdksavdecc_timestamp_in_milliseconds timeout_in_millis ) { m_timeout_in_millis = timeout_in_millis; }
+
+  private:
+    jdksavdecc_timestamp_in_milliseconds m_timeout_in_millis;
+    jdksavdecc_timestamp_in_milliseconds m_current_time;
+    EuiFlatMap<Eui64, RegisteredController, MaxControllers> m_controllers;
+};
 }
@@ -0,0 +1,250 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketRingPair.hpp"
+#include "JDKSAvdeccMCU/HandlerGroup.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+/// The largest number of shards that one ShardedEntityHost can run
+#ifndef JDKSAVDECCMCU_MAX_ENTITY_SHARDS
+#define JDKSAVDECCMCU_MAX_ENTITY_SHARDS ( 64 )
+#endif
+
+/// How long a shard's thread waits for frames before it ticks its handlers
+#ifndef JDKSAVDECCMCU_ENTITYSHARD_RUN_TIMEOUT_MS
+#define JDKSAVDECCMCU_ENTITYSHARD_RUN_TIMEOUT_MS ( 10 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The EntityShard class
+///
+/// One worker thread of a ShardedEntityHost. It runs a HandlerGroup of its
+/// own, holding the ADPManager, Entity and other handlers of the entities
+/// placed on it, and is the RawSocket that those handlers are given.
+///
+/// Frames reach it through its RX ring from the host's thread, and the
+/// frames that its handlers send go back through its TX ring to be sent
+/// by the host. The shards share nothing with each other, so they do not
+/// wait for each other.
+///
+class EntityShard : public RawSocketRingPair
+{
+  public:
+    EntityShard( HandlerGroup *group, FrameRing *rx_ring, FrameRing *tx_ring );
+
+    virtual ~EntityShard();
+
+    /// Add a handler to the shard's HandlerGroup. Only before start()
+    bool add( Handler *h ) { return m_group->add( h ); }
+
+    HandlerGroup *getHandlerGroup() const { return m_group; }
+
+    /// The socket of the host, for the time and the MAC addresses
+    void setNetwork( RawSocket *net ) { m_net = net; }
+
+    RawSocket *getNetwork() const { return m_net; }
+
+    /// Start the shard's thread. Returns false if it could not be started
+    bool start();
+
+    /// Stop the shard's thread and wait for it to finish
+    void stop();
+
+    bool isRunning() const { return m_running.load( std::memory_order_acquire ); }
+
+    /// Count an entity that was placed on the shard
+    void countEntity() { ++m_entity_count; }
+
+    /// The number of entities placed on the shard
+    uint16_t getEntityCount() const { return m_entity_count; }
+
+    /// The number of iterations of the shard's HandlerGroup::run()
+    uint32_t getLoopCount() const { return m_loop_count.load( std::memory_order_relaxed ); }
+
+    /// The time the shard spent handling frames and ticking its handlers
+    uint32_t getBusyTimeInMilliseconds() const { return m_busy_time_in_ms.load( std::memory_order_relaxed ); }
+
+    /// The time the shard spent waiting for frames
+    uint32_t getIdleTimeInMilliseconds() const { return m_idle_time_in_ms.load( std::memory_order_relaxed ); }
+
+    /// The largest time that one iteration of the shard's loop took
+    uint32_t getMaxLoopLatencyInMilliseconds() const { return m_max_loop_latency_in_ms.load( std::memory_order_relaxed ); }
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override;
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override;
+
+    /// Joins on the host's socket, so only before the host runs
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override;
+
+    virtual Eui48 const &getMACAddress() const override;
+
+    virtual uint16_t getPortCount() const override;
+
+    virtual Eui48 const &getPortMACAddress( uint16_t port ) const override;
+
+  private:
+    EntityShard( EntityShard const & );
+    EntityShard const &operator=( EntityShard const & );
+
+    /// The body of the shard's thread
+    void run();
+
+    HandlerGroup *m_group;
+    RawSocket *m_net;
+    uint16_t m_entity_count;
+
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+
+    /// Copied from the HandlerGroup by the shard's thread so that other
+    /// threads can read them
+    std::atomic<uint32_t> m_loop_count;
+    std::atomic<uint32_t> m_busy_time_in_ms;
+    std::atomic<uint32_t> m_idle_time_in_ms;
+    std::atomic<uint32_t> m_max_loop_latency_in_ms;
+};
+
+///
+/// \brief The EntityShardWithSize class
+///
+/// An EntityShard that owns its HandlerGroup and its rings
+///
+template <uint16_t MaxHandlers, uint32_t RxSlots = 64, uint32_t TxSlots = 64>
+class EntityShardWithSize : public EntityShard
+{
+  public:
+    EntityShardWithSize()
+        : EntityShard( &m_group_storage, &m_rx_ring_storage, &m_tx_ring_storage ), m_group_storage( &m_frame_storage )
+    {
+        m_group_storage.addRawSocket( this );
+    }
+
+    /// The shard's thread must stop before its storage goes away
+    virtual ~EntityShardWithSize() { stop(); }
+
+  private:
+    FrameWithMTU m_frame_storage;
+    HandlerGroupWithSize<MaxHandlers> m_group_storage;
+    FrameRingWithSize<RxSlots> m_rx_ring_storage;
+    FrameRingWithSize<TxSlots> m_tx_ring_storage;
+};
+
+///
+/// \brief The ShardedEntityHost class
+///
+/// Hosts many entities on one network socket by spreading them over
+/// several EntityShards, each with its own thread.
+///
+/// An entity is placed on a shard by a hash of its entity_id. The host's
+/// thread receives from the network socket and routes each frame: AECP
+/// frames go only to the shard of the entity that they are addressed to,
+/// and ADP, ACMP and all other frames go to every shard. It also sends the
+/// frames that the shards queue up.
+///
+/// Frames sent by one shard are not seen by the others.
+///
+class ShardedEntityHost
+{
+  public:
+    ShardedEntityHost( RawSocket *net );
+
+    ~ShardedEntityHost();
+
+    /// Add a shard. Returns false if there is no room
+    bool addShard( EntityShard *shard );
+
+    uint16_t getShardCount() const { return m_num_shards; }
+
+    EntityShard *getShard( uint16_t n ) const { return m_shard[n]; }
+
+    /// The shard that owns the entity_id
+    uint16_t getShardIndex( Eui64 const &entity_id ) const;
+
+    /// The shard that owns the entity_id, counting it as placed there
+    EntityShard *assignEntity( Eui64 const &entity_id );
+
+    /// Start the threads of all of the shards
+    bool start();
+
+    /// Stop the threads of all of the shards
+    void stop();
+
+    ///
+    /// \brief pollNetwork Receive the frames waiting on the network socket
+    /// and route them to the shards
+    /// \param max_frames the largest batch to take
+    /// \return the number of frames received
+    ///
+    uint16_t pollNetwork( uint16_t max_frames = JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH );
+
+    ///
+    /// \brief sendQueued Send the frames that the shards queued up
+    /// \return the number of frames sent
+    ///
+    uint32_t sendQueued();
+
+    ///
+    /// \brief run Wait for up to timeout_ms for frames from the network or
+    /// from the shards, then route and send them. Call it in a loop.
+    /// \return false if there are no shards
+    ///
+    bool run( int32_t timeout_ms );
+
+    /// Give a frame to the shards that it is for
+    void route( Frame const &frame );
+
+    /// The number of frames that were routed to one shard
+    uint32_t getUnicastCount() const { return m_unicast_count; }
+
+    /// The number of frames that were routed to every shard
+    uint32_t getMulticastCount() const { return m_multicast_count; }
+
+  private:
+    ShardedEntityHost( ShardedEntityHost const & );
+    ShardedEntityHost const &operator=( ShardedEntityHost const & );
+
+    RawSocket *m_net;
+    uint16_t m_num_shards;
+    EntityShard *m_shard[JDKSAVDECCMCU_MAX_ENTITY_SHARDS];
+    FrameWithMTU m_frame;
+    Frame m_ring_frame;
+    uint32_t m_unicast_count;
+    uint32_t m_multicast_count;
+};
+}
+#endif
@@ -0,0 +1,193 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Handler.hpp"
+
+/// The number of bits of time that each level of the wheel covers. Each
+/// level has 2^bits slots.
+#ifndef JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS
+#define JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS ( 6 )
+#endif
+
+/// The number of levels in the wheel. Deadlines further away than
+/// 2^(bits*levels) milliseconds are parked in the top level and cascaded
+/// down again when it turns.
+#ifndef JDKSAVDECCMCU_TIMERWHEEL_LEVELS
+#define JDKSAVDECCMCU_TIMERWHEEL_LEVELS ( 4 )
+#endif
+
+#define JDKSAVDECCMCU_TIMERWHEEL_SLOTS ( 1 << JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS )
+
+namespace JDKSAvdeccMCU
+{
+
+class TimerWheel;
+
+///
+/// \brief The Timer class
+///
+/// A deadline for a Handler. A Handler that owns a Timer and returns it
+/// from getTimer() is only ticked by a HandlerGroup with a TimerWheel when
+/// its deadline expires. The Handler must schedule its next deadline from
+/// its tick() and whenever an event needs it to be ticked sooner.
+///
+/// Until the Timer is attached to a TimerWheel the schedule calls do
+/// nothing and the owner is ticked on every loop as before.
+///
+class Timer
+{
+  public:
+    Timer( Handler *owner = 0 )
+        : m_wheel( 0 ), m_owner( owner ), m_next( 0 ), m_prev( 0 ), m_list( 0 ), m_deadline( 0 )
+    {
+    }
+
+    ~Timer();
+
+    void setOwner( Handler *owner ) { m_owner = owner; }
+
+    Handler *getOwner() const { return m_owner; }
+
+    TimerWheel *getTimerWheel() const { return m_wheel; }
+
+    bool isScheduled() const { return m_list != 0; }
+
+    jdksavdecc_timestamp_in_milliseconds getDeadline() const { return m_deadline; }
+
+    ///
+    /// \brief scheduleAt Ask for the owner to be ticked at the deadline,
+    /// replacing any earlier schedule
+    /// \return false if the timer is not attached to a TimerWheel
+    ///
+    bool scheduleAt( jdksavdecc_timestamp_in_milliseconds deadline );
+
+    ///
+    /// \brief scheduleNoLaterThan Ask for the owner to be ticked at the
+    /// deadline unless it is already scheduled to be ticked sooner
+    /// \return false if the timer is not attached to a TimerWheel
+    ///
+    bool scheduleNoLaterThan( jdksavdecc_timestamp_in_milliseconds deadline );
+
+    ///
+    /// \brief cancel Remove the timer from the wheel
+    ///
+    void cancel();
+
+  private:
+    friend class TimerWheel;
+
+    TimerWheel *m_wheel;
+    Handler *m_owner;
+    Timer *m_next;
+    Timer *m_prev;
+    Timer **m_list;
+    jdksavdecc_timestamp_in_milliseconds m_deadline;
+};
+
+///
+/// \brief The TimerWheel class
+///
+/// A hierarchical timing wheel with one millisecond resolution.
+/// Scheduling and cancelling are O(1), and advancing only touches the
+/// slots that the time passes through.
+///
+class TimerWheel
+{
+  public:
+    TimerWheel();
+
+    ~TimerWheel();
+
+    ///
+    /// \brief attach Associate a timer with this wheel and make it due
+    ///
+    void attach( Timer *t );
+
+    ///
+    /// \brief detach Remove a timer from this wheel
+    ///
+    void detach( Timer *t );
+
+    ///
+    /// \brief schedule Put an attached timer on the wheel
+    ///
+    void schedule( Timer *t, jdksavdecc_timestamp_in_milliseconds deadline );
+
+    ///
+    /// \brief cancel Take a timer off the wheel
+    ///
+    void cancel( Timer *t );
+
+    ///
+    /// \brief advance Move the wheel to the current time and tick the
+    /// owners of all the timers that expired
+    /// \param time_in_millis the current time
+    /// \return the number of handlers ticked
+    ///
+    uint16_t advance( jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    ///
+    /// \brief getTimeUntilNextDeadline Get how long the caller may sleep
+    /// before the wheel needs to be advanced again
+    /// \param time_in_millis the current time
+    /// \param max_wait the longest time to return
+    /// \return the time in milliseconds, at most max_wait
+    ///
+    int32_t getTimeUntilNextDeadline( jdksavdecc_timestamp_in_milliseconds time_in_millis, int32_t max_wait ) const;
+
+    ///
+    /// \brief getScheduledCount get the number of timers on the wheel
+    ///
+    uint16_t getScheduledCount() const { return m_scheduled_count; }
+
+    ///
+    /// \brief getExpiredCount get the number of timers that expired since
+    /// construction
+    ///
+    uint32_t getExpiredCount() const { return m_expired_count; }
+
+  private:
+    void insert( Timer *t, bool cascading = false );
+    void link( Timer **list, Timer *t );
+    void unlink( Timer *t );
+    void cascade( uint8_t level );
+    uint16_t expireList( Timer **list, jdksavdecc_timestamp_in_milliseconds time_in_millis );
+
+    Timer *m_slot[JDKSAVDECCMCU_TIMERWHEEL_LEVELS][JDKSAVDECCMCU_TIMERWHEEL_SLOTS];
+    Timer *m_due;
+    jdksavdecc_timestamp_in_milliseconds m_current_time;
+    bool m_started;
+    uint16_t m_scheduled_count;
+    uint32_t m_expired_count;
+};
+}
@@ -0,0 +1,201 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/Helpers.hpp"
+#include "JDKSAvdeccMCU/Frame.hpp"
+#include "JDKSAvdeccMCU/Handler.hpp"
+
+/// The largest unsolicited response PDU (including ethernet header) that
+/// can be held back. Larger ones are always sent straight away.
+#ifndef JDKSAVDECCMCU_UNSOLICITED_MAX_PDU_LENGTH
+#define JDKSAVDECCMCU_UNSOLICITED_MAX_PDU_LENGTH ( 128 )
+#endif
+
+/// The default shortest time between two unsolicited responses about the
+/// same descriptor
+#ifndef JDKSAVDECCMCU_UNSOLICITED_DEFAULT_WINDOW_MS
+#define JDKSAVDECCMCU_UNSOLICITED_DEFAULT_WINDOW_MS ( 20 )
+#endif
+
+namespace JDKSAvdeccMCU
+{
+
+///
+/// \brief The UnsolicitedResponse struct
+///
+/// The state of the unsolicited responses about one command and
+/// descriptor, such as the SET_CONTROL responses for one control
+///
+struct UnsolicitedResponse
+{
+    /// The command_type and the descriptor that the responses are about
+    HandlerDispatchKey m_key;
+
+    /// The other fields that say what the responses are about, such as the
+    /// name_index and configuration_index of SET_NAME
+    uint32_t m_addressed;
+
+    /// When a response about it was last sent to the controllers
+    jdksavdecc_timestamp_in_milliseconds m_sent_time;
+
+    /// A newer response is being held back until the window has passed
+    bool m_pending;
+
+    /// The held back response was generated by the entity itself
+    bool m_internally_generated;
+
+    /// The length of the held back response
+    uint16_t m_pdu_length;
+
+    /// The latest held back response
+    uint8_t m_pdu[JDKSAVDECCMCU_UNSOLICITED_MAX_PDU_LENGTH];
+};
+
+///
+/// \brief The UnsolicitedCoalescer class
+///
+/// Limits the unsolicited responses that an Entity sends to its registered
+/// controllers to one per command and descriptor in each window. Responses
+/// that come sooner are held back, each replacing the one before it, and
+/// only the latest one is sent when the window has passed. A fader sweep
+/// that changes a control hundreds of times a second then costs each
+/// controller one response per window instead of hundreds.
+///
+/// Responses only replace each other when every field that addresses what
+/// they are about matches. Responses that do not address a descriptor, or
+/// that are too long to be held back, are never delayed. It does not
+/// contain the storage of the table entries
+///
+class UnsolicitedCoalescer
+{
+  public:
+    ///
+    /// \brief UnsolicitedCoalescer construct an UnsolicitedCoalescer object
+    /// \param item_storage pointer to array of UnsolicitedResponse objects
+    /// \param max_items maximum number of items that the array can hold
+    /// \param window_in_ms the shortest time between two responses about
+    /// the same descriptor
+    ///
+    UnsolicitedCoalescer( UnsolicitedResponse *item_storage,
+                          uint16_t max_items,
+                          jdksavdecc_timestamp_in_milliseconds window_in_ms = JDKSAVDECCMCU_UNSOLICITED_DEFAULT_WINDOW_MS );
+
+    ///
+    /// \brief offer Offer an unsolicited response that is about to be sent
+    /// to the controllers
+    /// \param pdu The response header
+    /// \param fragments The fragments that follow the header
+    /// \param num_fragments The number of fragments
+    /// \param internally_generated The response was generated by the entity
+    /// \param time_in_ms The current time
+    /// \return true if it is to be sent now, false if it was held back
+    ///
+    bool offer( Frame const &pdu,
+                FrameFragment const *fragments,
+                uint16_t num_fragments,
+                bool internally_generated,
+                jdksavdecc_timestamp_in_milliseconds time_in_ms );
+
+    ///
+    /// \brief getDue Get a held back response whose window has passed. It
+    /// counts as sent, so send it before calling again
+    /// \param time_in_ms The current time
+    /// \return pointer to the entry or 0 if none is due
+    ///
+    UnsolicitedResponse *getDue( jdksavdecc_timestamp_in_milliseconds time_in_ms );
+
+    ///
+    /// \brief getNextDeadline Get when the next held back response is due
+    /// \param deadline Where to store the time
+    /// \return false if no response is held back
+    ///
+    bool getNextDeadline( jdksavdecc_timestamp_in_milliseconds *deadline ) const;
+
+    ///
+    /// \brief getWindow Get the shortest time between two responses about
+    /// the same descriptor
+    ///
+    jdksavdecc_timestamp_in_milliseconds getWindow() const { return m_window_in_ms; }
+
+    ///
+    /// \brief setWindow Set the shortest time between two responses about
+    /// the same descriptor. 0 sends every response straight away
+    ///
+    void setWindow( jdksavdecc_timestamp_in_milliseconds window_in_ms ) { m_window_in_ms = window_in_ms; }
+
+    ///
+    /// \brief getCount Get the number of descriptors being tracked
+    ///
+    uint16_t getCount() const { return m_num_items; }
+
+    ///
+    /// \brief getReplacedCount Get the number of held back responses that
+    /// were replaced by a newer one and never sent
+    ///
+    uint32_t getReplacedCount() const { return m_replaced_count; }
+
+    ///
+    /// \brief clear Forget all tracked descriptors and held back responses
+    ///
+    void clear() { m_num_items = 0; }
+
+  protected:
+    /// Find the entry for a key and addressed fields, or make room for it
+    UnsolicitedResponse *
+        findOrAdd( HandlerDispatchKey const &key, uint32_t addressed, jdksavdecc_timestamp_in_milliseconds time_in_ms );
+
+    uint16_t m_num_items;
+    uint16_t m_max_items;
+    UnsolicitedResponse *m_item;
+    jdksavdecc_timestamp_in_milliseconds m_window_in_ms;
+    uint32_t m_replaced_count;
+};
+
+///
+/// \brief The UnsolicitedCoalescerWithSize class
+///
+/// UnsolicitedCoalescer that contains the storage for MaxItems entries
+///
+template <uint16_t MaxItems>
+class UnsolicitedCoalescerWithSize : public UnsolicitedCoalescer
+{
+  private:
+    UnsolicitedResponse m_item_storage[MaxItems];
+
+  public:
+    UnsolicitedCoalescerWithSize( jdksavdecc_timestamp_in_milliseconds window_in_ms = JDKSAVDECCMCU_UNSOLICITED_DEFAULT_WINDOW_MS )
+        : UnsolicitedCoalescer( m_item_storage, MaxItems, window_in_ms )
+    {
+    }
+};
+}
@@ -0,0 +1,259 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ADPDiscovery.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+void ADPDiscoverySlot::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    if ( m_discovery )
+    {
+        m_discovery->expire( this, time_in_millis );
+    }
+}
+
+ADPDiscovery::ADPDiscovery( RawSocket &net,
+                            Eui64 const &entity_id,
+                            ADPCoreInfo const &adp_info,
+                            ADPDiscoveryEvents *events,
+                            ADPDiscoverySlot *slot_storage,
+                            uint16_t *free_storage,
+                            EuiFlatMapBase<Eui64, uint16_t> &index,
+                            uint16_t max_entities )
+    : ADPManager( net, entity_id, adp_info )
+    , m_events( events )
+    , m_slot( slot_storage )
+    , m_free( free_storage )
+    , m_num_free( 0 )
+    , m_index( index )
+    , m_max_entities( max_entities )
+    , m_dropped_count( 0 )
+{
+}
+
+void ADPDiscovery::initialize()
+{
+    for ( uint16_t i = 0; i < m_max_entities; ++i )
+    {
+        m_slot[i].m_discovery = this;
+
+        // Timers are only scheduled while their slot holds an entity
+        m_expiry_wheel.attach( &m_slot[i].m_timer );
+        m_slot[i].m_timer.cancel();
+    }
+    clear();
+}
+
+void ADPDiscovery::clear()
+{
+    m_index.clear();
+    m_num_free = 0;
+
+    // Hand out the low slots first
+    for ( uint16_t i = m_max_entities; i > 0; --i )
+    {
+        m_slot[i - 1].m_timer.cancel();
+        m_slot[i - 1].m_entity = DiscoveredEntity();
+        m_free[m_num_free++] = i - 1;
+    }
+}
+
+void ADPDiscovery::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    ADPManager::tick( time_in_millis );
+
+    m_expiry_wheel.advance( time_in_millis );
+
+    // Be ticked again when the next entity may time out. The longest
+    // valid_time is 62 seconds
+    if ( m_expiry_wheel.getScheduledCount() > 0 )
+    {
+        m_timer.scheduleNoLaterThan( time_in_millis + m_expiry_wheel.getTimeUntilNextDeadline( time_in_millis, 62000 ) );
+    }
+}
+
+void ADPDiscovery::receivedEntityAvailable( jdksavdecc_adpdu_common_control_header const &header, Frame &frame )
+{
+    Eui64 entity_id( header.entity_id );
+
+    if ( frame.getLength() < JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_LEN || entity_id == m_entity_id )
+    {
+        return;
+    }
+
+    jdksavdecc_timestamp_in_milliseconds now = m_net.getTimeInMilliseconds();
+    uint16_t *slot_num = m_index.find( entity_id );
+
+    if ( slot_num )
+    {
+        ADPDiscoverySlot &slot = m_slot[*slot_num];
+        DiscoveredEntity &entity = slot.m_entity;
+        uint8_t const *p = frame.getBuf();
+        ssize_t pos = JDKSAVDECC_FRAME_HEADER_LEN;
+        uint16_t changes = 0;
+
+        // Counting up by one is normal, and an entity on several networks
+        // sends the same available_index on each of them
+        uint32_t available_index = jdksavdecc_adpdu_get_available_index( p, pos );
+        if ( available_index != entity.m_available_index && available_index != entity.m_available_index + 1 )
+        {
+            changes |= CHANGED_AVAILABLE_INDEX;
+        }
+
+        if ( Eui64( jdksavdecc_adpdu_get_gptp_grandmaster_id( p, pos ) ) != entity.m_gptp_grandmaster_id )
+        {
+            changes |= CHANGED_GRANDMASTER;
+        }
+
+        if ( Eui64( jdksavdecc_adpdu_get_entity_model_id( p, pos ) ) != entity.m_entity_model_id
+             || jdksavdecc_adpdu_get_entity_capabilities( p, pos ) != entity.m_entity_capabilities
+             || jdksavdecc_adpdu_get_talker_stream_sources( p, pos ) != entity.m_talker_stream_sources
+             || jdksavdecc_adpdu_get_talker_capabilities( p, pos ) != entity.m_talker_capabilities
+             || jdksavdecc_adpdu_get_listener_stream_sinks( p, pos ) != entity.m_listener_stream_sinks
+             || jdksavdecc_adpdu_get_listener_capabilities( p, pos ) != entity.m_listener_capabilities
+             || jdksavdecc_adpdu_get_controller_capabilities( p, pos ) != entity.m_controller_capabilities )
+        {
+            changes |= CHANGED_CAPABILITIES;
+        }
+
+        if ( changes )
+        {
+            readEntity( entity, header, frame, now );
+        }
+        else
+        {
+            entity.m_available_index = available_index;
+            entity.m_valid_time_in_seconds = header.valid_time * 2;
+            entity.m_last_seen_time = now;
+            entity.m_port = frame.getPort();
+            entity.m_mac_address = frame.getSA();
+        }
+
+        slot.m_timer.scheduleAt( slot.getExpiryTime() );
+        m_timer.scheduleNoLaterThan( slot.getExpiryTime() );
+
+        if ( changes && m_events )
+        {
+            m_events->entityChanged( this, entity, changes );
+        }
+    }
+    else if ( m_num_free > 0 )
+    {
+        uint16_t n = m_free[--m_num_free];
+        ADPDiscoverySlot &slot = m_slot[n];
+
+        *m_index.insert( entity_id ) = n;
+        readEntity( slot.m_entity, header, frame, now );
+
+        slot.m_timer.scheduleAt( slot.getExpiryTime() );
+        m_timer.scheduleNoLaterThan( slot.getExpiryTime() );
+
+        if ( m_events )
+        {
+            m_events->entityDiscovered( this, slot.m_entity );
+        }
+    }
+    else
+    {
+        ++m_dropped_count;
+    }
+}
+
+void ADPDiscovery::receivedEntityDeparting( jdksavdecc_adpdu_common_control_header const &header, Frame &frame )
+{
+    (void)frame;
+    uint16_t *slot_num = m_index.find( Eui64( header.entity_id ) );
+
+    if ( slot_num )
+    {
+        remove( &m_slot[*slot_num], true );
+    }
+}
+
+DiscoveredEntity const *ADPDiscovery::find( Eui64 const &entity_id ) const
+{
+    uint16_t const *slot_num = m_index.find( entity_id );
+    return slot_num ? &m_slot[*slot_num].m_entity : 0;
+}
+
+void ADPDiscovery::expire( ADPDiscoverySlot *slot, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    // The expiry wheel ticks everything that was scheduled before it first
+    // advanced, so check the real time out
+    if ( time_in_millis < slot->getExpiryTime() )
+    {
+        slot->m_timer.scheduleAt( slot->getExpiryTime() );
+    }
+    else
+    {
+        remove( slot, false );
+    }
+}
+
+void ADPDiscovery::remove( ADPDiscoverySlot *slot, bool departed )
+{
+    if ( m_events )
+    {
+        m_events->entityGone( this, slot->m_entity, departed );
+    }
+    slot->m_timer.cancel();
+    m_index.erase( slot->m_entity.m_entity_id );
+    slot->m_entity = DiscoveredEntity();
+    m_free[m_num_free++] = static_cast<uint16_t>( slot - m_slot );
+}
+
+void ADPDiscovery::readEntity( DiscoveredEntity &entity,
+                               jdksavdecc_adpdu_common_control_header const &header,
+                               Frame const &frame,
+                               jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    uint8_t const *p = frame.getBuf();
+    ssize_t pos = JDKSAVDECC_FRAME_HEADER_LEN;
+
+    entity.m_entity_id = header.entity_id;
+    entity.m_entity_model_id = jdksavdecc_adpdu_get_entity_model_id( p, pos );
+    entity.m_mac_address = frame.getSA();
+    entity.m_port = frame.getPort();
+    entity.m_entity_capabilities = jdksavdecc_adpdu_get_entity_capabilities( p, pos );
+    entity.m_talker_stream_sources = jdksavdecc_adpdu_get_talker_stream_sources( p, pos );
+    entity.m_talker_capabilities = jdksavdecc_adpdu_get_talker_capabilities( p, pos );
+    entity.m_listener_stream_sinks = jdksavdecc_adpdu_get_listener_stream_sinks( p, pos );
+    entity.m_listener_capabilities = jdksavdecc_adpdu_get_listener_capabilities( p, pos );
+    entity.m_controller_capabilities = jdksavdecc_adpdu_get_controller_capabilities( p, pos );
+    entity.m_available_index = jdksavdecc_adpdu_get_available_index( p, pos );
+    entity.m_gptp_grandmaster_id = jdksavdecc_adpdu_get_gptp_grandmaster_id( p, pos );
+    entity.m_valid_time_in_seconds = header.valid_time * 2;
+    entity.m_last_seen_time = time_in_millis;
+}
+}
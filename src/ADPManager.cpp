@@ -43,8 +43,13 @@ ADPManager::ADPManager( RawSocket &net, Eui64 const &entity_id, ADPCoreInfo cons
     , m_last_send_time_in_millis( 0 )
     , m_trigger_send_time( 0 )
     , m_trigger_send( false )
+    , m_delayed_send_time( 0 )
+    , m_delayed_send( false )
+    , m_scheduler( 0 )
     , m_gptp_grandmaster_id()
     , m_adp_info( adp_info )
+    , m_timer( this )
+    , m_adp_template_valid( false )
 {
 }
 
@@ -56,57 +61,102 @@ void ADPManager::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
     // figure out if we were triggered to send
     bool triggered = m_trigger_send && wasTimeOutHit( time_in_millis, m_trigger_send_time, 1000 );
 
-    if ( triggered || timeouthit )
+    // figure out if a randomly delayed send is due
+    bool delayed = m_delayed_send && time_in_millis >= m_delayed_send_time;
+
+    if ( triggered || timeouthit || delayed )
     {
+        if ( m_scheduler && !m_scheduler->acquire( m_net.getPortCount(), time_in_millis ) )
+        {
+            // Too many ADPDUs are going out, try again when there is room
+            m_timer.scheduleAt( m_scheduler->getRetryTime( time_in_millis ) );
+            return;
+        }
         m_trigger_send = false;
+        m_delayed_send = false;
         sendADP();
         m_last_send_time_in_millis = time_in_millis;
     }
+
+    // Be ticked again when the next send is due
+    jdksavdecc_timestamp_in_milliseconds next_time = m_last_send_time_in_millis + getValidTimeInSeconds() * ( 1000 / 4 ) + 1;
+    if ( m_trigger_send && m_trigger_send_time + 1000 + 1 < next_time )
+    {
+        next_time = m_trigger_send_time + 1000 + 1;
+    }
+    if ( m_delayed_send && m_delayed_send_time < next_time )
+    {
+        next_time = m_delayed_send_time;
+    }
+    m_timer.scheduleAt( next_time );
 }
 
 void ADPManager::sendADP()
+{
+    if ( !m_adp_template_valid )
+    {
+        buildADPTemplate();
+    }
+
+    m_adp_template.setQuadlet( m_available_index, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_OFFSET_AVAILABLE_INDEX );
+    m_adp_template.setEUI64( m_gptp_grandmaster_id, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_OFFSET_GPTP_GRANDMASTER_ID );
+
+    // One ADPDU goes out of each network port, from that port's MAC
+    // address and with its interface_index
+    for ( uint16_t port = 0; port < m_net.getPortCount(); ++port )
+    {
+        m_adp_template.setSA( m_net.getPortMACAddress( port ) );
+        m_adp_template.setDoublet( port, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_OFFSET_INTERFACE_INDEX );
+        m_adp_template.setPort( port );
+        m_net.sendFrame( m_adp_template );
+    }
+    m_available_index++;
+}
+
+void ADPManager::buildADPTemplate()
 {
     Eui48 adp_multicast_addr = JDKSAVDECC_MULTICAST_ADP_ACMP_MAC;
 
-    // DA, SA, EtherType, ADPDU = 82 bytes
-    FrameWithSize<82> adp( 0, adp_multicast_addr, m_net.getMACAddress(), JDKSAVDECC_AVTP_ETHERTYPE );
+    m_adp_template.clear();
+    m_adp_template.putEUI48( adp_multicast_addr );
+    m_adp_template.putEUI48( m_net.getMACAddress() );
+    m_adp_template.putDoublet( JDKSAVDECC_AVTP_ETHERTYPE );
 
     // avtpdu common control header
     // cd=1, subtype=0x7a (ADP)
-    adp.putOctet( 0x80 + JDKSAVDECC_SUBTYPE_ADP );
+    m_adp_template.putOctet( 0x80 + JDKSAVDECC_SUBTYPE_ADP );
 
     // sv=0, version=0, message_type = ENTITY_AVAILABLE
-    adp.putOctet( 0x00 + JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_AVAILABLE );
+    m_adp_template.putOctet( 0x00 + JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_AVAILABLE );
 
     // valid_time is in 2 second steps. top 3 bits of control_data_length is 0
-    adp.putOctet( ( getValidTimeInSeconds() / 2 ) << 3 );
+    m_adp_template.putOctet( ( getValidTimeInSeconds() / 2 ) << 3 );
 
     // control_data_length field is 56 - See 1722.1 Clause 6.2.1.7
-    adp.putOctet( JDKSAVDECC_ADPDU_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN );
+    m_adp_template.putOctet( JDKSAVDECC_ADPDU_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN );
 
-    adp.putEUI64( getEntityID() );
-    adp.putEUI64( getEntityModelID() );
-    adp.putQuadlet( getEntityCapabilities() );
+    m_adp_template.putEUI64( getEntityID() );
+    m_adp_template.putEUI64( getEntityModelID() );
+    m_adp_template.putQuadlet( getEntityCapabilities() );
 
-    adp.putDoublet( m_adp_info.m_talker_stream_sources );
-    adp.putDoublet( m_adp_info.m_talker_capabilities );
+    m_adp_template.putDoublet( m_adp_info.m_talker_stream_sources );
+    m_adp_template.putDoublet( m_adp_info.m_talker_capabilities );
 
-    adp.putDoublet( m_adp_info.m_listener_stream_sinks );
-    adp.putDoublet( m_adp_info.m_listener_capabilities );
+    m_adp_template.putDoublet( m_adp_info.m_listener_stream_sinks );
+    m_adp_template.putDoublet( m_adp_info.m_listener_capabilities );
 
-    adp.putQuadlet( m_adp_info.m_controller_capabilities );
+    m_adp_template.putQuadlet( m_adp_info.m_controller_capabilities );
 
-    adp.putQuadlet( m_available_index );
-
-    adp.putEUI64( m_gptp_grandmaster_id );
+    // available_index and gptp_grandmaster_id are patched in by sendADP()
+    m_adp_template.putQuadlet( m_available_index );
+    m_adp_template.putEUI64( m_gptp_grandmaster_id );
 
     // gptp_domain_number reserved0, identify_control_index, interface_index
     // association_id, reserved1
     // 20 octets total, all 0
-    adp.putZeros( 20 );
+    m_adp_template.putZeros( 20 );
 
-    m_net.sendFrame( adp );
-    m_available_index++;
+    m_adp_template_valid = true;
 }
 
 void ADPManager::triggerSend()
@@ -123,6 +173,22 @@ void ADPManager::triggerSend()
         // No, schedule a send in one second
         m_trigger_send = true;
         m_trigger_send_time = t;
+        m_timer.scheduleNoLaterThan( t + 1000 + 1 );
+    }
+}
+
+void ADPManager::setScheduler( ADPScheduler *scheduler )
+{
+    m_scheduler = scheduler;
+    m_delayed_send = false;
+    if ( m_scheduler )
+    {
+        // Spread the first announcements of all of the entities
+        jdksavdecc_timestamp_in_milliseconds t = m_net.getTimeInMilliseconds();
+        m_last_send_time_in_millis = t;
+        m_delayed_send = true;
+        m_delayed_send_time = t + m_scheduler->getJitter( getValidTimeInSeconds() * ( 1000 / 5 ) );
+        m_timer.scheduleNoLaterThan( m_delayed_send_time );
     }
 }
 
@@ -140,14 +206,32 @@ bool ADPManager::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     bool r = false;
     uint8_t *p = frame.getBuf();
     jdksavdecc_adpdu_common_control_header header;
-    if ( jdksavdecc_adpdu_common_control_header_read( &header, p, JDKSAVDECC_FRAME_HEADER_LEN, frame.getLength() ) > 0 )
+    if ( frame.getOctet( JDKSAVDECC_FRAME_HEADER_LEN ) == JDKSAVDECC_1722A_SUBTYPE_ADP
+         && jdksavdecc_adpdu_common_control_header_read( &header, p, JDKSAVDECC_FRAME_HEADER_LEN, frame.getLength() ) > 0 )
     {
         r = true;
         if ( header.message_type == JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_DISCOVER )
         {
             if ( header.entity_id == m_entity_id || isUnset( header.entity_id ) || isZero( header.entity_id ) )
             {
-                m_last_send_time_in_millis -= ( getValidTimeInSeconds() * ( 1000 / 4 ) );
+                if ( m_scheduler )
+                {
+                    // Respond after a random delay so that all of the
+                    // entities do not respond at once
+                    jdksavdecc_timestamp_in_milliseconds t = m_net.getTimeInMilliseconds()
+                                                             + m_scheduler->getJitter( getValidTimeInSeconds() * ( 1000 / 5 ) );
+                    if ( !m_delayed_send || t < m_delayed_send_time )
+                    {
+                        m_delayed_send = true;
+                        m_delayed_send_time = t;
+                    }
+                    m_timer.scheduleNoLaterThan( m_delayed_send_time );
+                }
+                else
+                {
+                    m_last_send_time_in_millis -= ( getValidTimeInSeconds() * ( 1000 / 4 ) );
+                    m_timer.scheduleNoLaterThan( m_net.getTimeInMilliseconds() );
+                }
             }
         }
         else if ( header.message_type == JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_AVAILABLE )
@@ -161,4 +245,14 @@ bool ADPManager::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     }
     return r;
 }
+
+uint16_t ADPManager::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 1 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::SUBTYPE, JDKSAVDECC_AVTP_ETHERTYPE, JDKSAVDECC_1722A_SUBTYPE_ADP );
+    }
+    return r;
+}
 }
@@ -0,0 +1,123 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ADPScheduler.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+ADPScheduler::ADPScheduler( uint32_t frames_per_second, uint16_t burst, uint32_t seed )
+    : m_frames_per_second( frames_per_second > 0 ? frames_per_second : 1 )
+    , m_max_tokens( ( burst > 0 ? burst : 1 ) * 1000 )
+    , m_started( false )
+    , m_random( seed != 0 ? seed : 1 )
+    , m_deferred_count( 0 )
+{
+    for ( uint16_t i = 0; i < JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS; ++i )
+    {
+        m_tokens[i] = m_max_tokens;
+        m_fill_time[i] = 0;
+    }
+}
+
+uint32_t ADPScheduler::getJitter( uint32_t max_delay )
+{
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    std::lock_guard<std::mutex> lock( m_mutex );
+#endif
+    // xorshift32
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random % ( max_delay + 1 );
+}
+
+void ADPScheduler::refill( uint16_t bucket, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    if ( time_in_millis > m_fill_time[bucket] )
+    {
+        // One thousandth of a token per millisecond for each frame per second
+        jdksavdecc_timestamp_in_milliseconds earned = ( time_in_millis - m_fill_time[bucket] ) * m_frames_per_second;
+        m_tokens[bucket] = earned >= m_max_tokens - m_tokens[bucket] ? m_max_tokens : m_tokens[bucket] + uint32_t( earned );
+        m_fill_time[bucket] = time_in_millis;
+    }
+}
+
+bool ADPScheduler::acquire( uint16_t num_ports, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    std::lock_guard<std::mutex> lock( m_mutex );
+#endif
+    bool r = true;
+    uint16_t num_buckets = num_ports < JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS ? num_ports : JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS;
+
+    if ( !m_started )
+    {
+        // The buckets start out full
+        for ( uint16_t i = 0; i < JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS; ++i )
+        {
+            m_fill_time[i] = time_in_millis;
+        }
+        m_started = true;
+    }
+
+    // The last bucket pays for itself and for each of the ports above it,
+    // but never more than it can hold
+    uint32_t last_cost = ( num_ports - num_buckets + 1 ) * 1000;
+    if ( last_cost > m_max_tokens )
+    {
+        last_cost = m_max_tokens;
+    }
+
+    for ( uint16_t i = 0; i < num_buckets; ++i )
+    {
+        refill( i, time_in_millis );
+        if ( m_tokens[i] < ( i + 1 == num_buckets ? last_cost : 1000 ) )
+        {
+            r = false;
+        }
+    }
+
+    if ( r )
+    {
+        for ( uint16_t i = 0; i < num_buckets; ++i )
+        {
+            m_tokens[i] -= ( i + 1 == num_buckets ? last_cost : 1000 );
+        }
+    }
+    else
+    {
+        ++m_deferred_count;
+    }
+    return r;
+}
+}
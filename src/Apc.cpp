@@ -182,61 +182,54 @@ bool ApcStateEvents::onIncomingHttpResponse( const HttpResponse &request )
 
 ssize_t ApcStateEvents::onIncomingTcpAppData( const uint8_t *data, ssize_t len )
 {
-    ssize_t r = 0;
-
-    for ( ssize_t r = 0; r < len; ++r )
-    {
-        m_app_parser.parse( data[r] );
-    }
-
-    return r;
+    return m_app_parser.parse( data, len );
 }
 
-void ApcStateEvents::onAppNop( const AppMessage &msg )
+void ApcStateEvents::onAppNop( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApcStateEvents::onAppEntityIdRequest( const AppMessage &msg )
+void ApcStateEvents::onAppEntityIdRequest( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApcStateEvents::onAppEntityIdResponse( const AppMessage &msg )
+void ApcStateEvents::onAppEntityIdResponse( const AppMessageView &msg )
 {
     getVariables()->m_newId = msg.getEntityIdResponseEntityId();
     getVariables()->m_idAssigned = true;
 }
 
-void ApcStateEvents::onAppLinkUp( const AppMessage &msg )
+void ApcStateEvents::onAppLinkUp( const AppMessageView &msg )
 {
     getVariables()->m_linkMsg = msg;
     getVariables()->m_linkStatusMsg = true;
 }
 
-void ApcStateEvents::onAppLinkDown( const AppMessage &msg )
+void ApcStateEvents::onAppLinkDown( const AppMessageView &msg )
 {
     getVariables()->m_linkMsg = msg;
     getVariables()->m_linkStatusMsg = true;
 }
 
-void ApcStateEvents::onAppAvdeccFromAps( const AppMessage &msg )
+void ApcStateEvents::onAppAvdeccFromAps( const AppMessageView &msg )
 {
     getVariables()->m_apsMsg = msg;
     getVariables()->m_apsMsgIn = true;
 }
 
-void ApcStateEvents::onAppAvdeccFromApc( const AppMessage &msg )
+void ApcStateEvents::onAppAvdeccFromApc( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApcStateEvents::onAppVendor( const AppMessage &msg )
+void ApcStateEvents::onAppVendor( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApcStateEvents::onAppUnknown( const AppMessage &msg )
+void ApcStateEvents::onAppUnknown( const AppMessageView &msg )
 {
     // Do nothing
 }
@@ -292,7 +285,7 @@ void ApcStateActions::sendHttpRequest( const HttpRequest &request )
 
 void ApcStateActions::sendMsgToAps( const AppMessage &apcMsg )
 {
-    FixedBufferWithSize<1500> msg_as_octets;
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> msg_as_octets;
     if ( apcMsg.store( &msg_as_octets ) )
     {
         getEvents()->sendTcpData( msg_as_octets.getBuf(), msg_as_octets.getLength() );
@@ -35,10 +35,10 @@
 namespace JDKSAvdeccMCU
 {
 
-int AppMessageParser::dispatchMsg( const AppMessage &msg )
+int AppMessageParser::dispatchMsg( const AppMessageView &msg )
 {
     int r = 0;
-    switch ( msg.m_appdu.base.message_type )
+    switch ( msg.m_appdu.message_type )
     {
     case AppMessage::NOP:
         m_handler.onAppNop( msg );
@@ -106,6 +106,95 @@ int AppMessageParser::parse( uint8_t octet )
     return r;
 }
 
+ssize_t AppMessageParser::parse( uint8_t const *data, ssize_t len )
+{
+    jdksavdecc_appdu *p = &m_current_message.m_appdu.base;
+    ssize_t pos = 0;
+
+    while ( pos < len && m_error_count == 0 )
+    {
+        ssize_t avail = len - pos;
+
+        if ( m_header_buffer.getLength() == 0 && avail >= JDKSAVDECC_APPDU_HEADER_LEN )
+        {
+            // At the start of a message with the whole header in the
+            // buffer, parse it in place
+            readHeader( data + pos );
+            pos += JDKSAVDECC_APPDU_HEADER_LEN;
+
+            AppMessage *msg = validateHeader();
+            if ( msg )
+            {
+                dispatchMsg( *msg );
+            }
+            else if ( m_octets_left_in_payload > 0 )
+            {
+                if ( static_cast<size_t>( len - pos ) >= m_octets_left_in_payload )
+                {
+                    // The payload is all here, dispatch a view of it where it is
+                    AppMessageView view( *p, data + pos );
+                    view.m_appdu.payload_length = static_cast<uint16_t>( m_octets_left_in_payload );
+                    pos += m_octets_left_in_payload;
+                    m_octets_left_in_payload = 0;
+                    dispatchMsg( view );
+                }
+                else
+                {
+                    // The rest of it comes in a later buffer
+                    m_header_buffer.putBuf( data + pos - JDKSAVDECC_APPDU_HEADER_LEN, JDKSAVDECC_APPDU_HEADER_LEN );
+                }
+            }
+        }
+        else if ( m_header_buffer.canPut() )
+        {
+            // Reassemble a header that is split across buffers
+            ssize_t n = JDKSAVDECC_APPDU_HEADER_LEN - m_header_buffer.getLength();
+            if ( n > avail )
+            {
+                n = avail;
+            }
+            m_header_buffer.putBuf( data + pos, static_cast<uint16_t>( n ) );
+            pos += n;
+
+            if ( m_header_buffer.isFull() )
+            {
+                readHeader( m_header_buffer.getBuf() );
+                AppMessage *msg = validateHeader();
+                if ( msg )
+                {
+                    dispatchMsg( *msg );
+                }
+            }
+        }
+        else if ( m_octets_left_in_payload > 0 )
+        {
+            // Reassemble a payload that is split across buffers
+            size_t n = m_octets_left_in_payload;
+            if ( n > static_cast<size_t>( avail ) )
+            {
+                n = static_cast<size_t>( avail );
+            }
+            memcpy( p->payload + p->payload_length, data + pos, n );
+            p->payload_length += static_cast<uint16_t>( n );
+            m_octets_left_in_payload -= n;
+            pos += n;
+
+            if ( m_octets_left_in_payload == 0 )
+            {
+                m_header_buffer.clear();
+                dispatchMsg( m_current_message );
+            }
+        }
+        else
+        {
+            // Nothing more can be parsed until clear()
+            break;
+        }
+    }
+
+    return m_error_count > 0 ? -1 : len;
+}
+
 AppMessage *AppMessageParser::parseHeader( uint8_t octet )
 {
     AppMessage *msg = 0;
@@ -117,24 +206,28 @@ AppMessage *AppMessageParser::parseHeader( uint8_t octet )
     if ( m_header_buffer.isFull() )
     {
         // yes, try parse the header
+        readHeader( m_header_buffer.getBuf() );
 
-        jdksavdecc_appdu *p = &m_current_message.m_appdu.base;
+        // and validate the header
+        msg = validateHeader();
+    }
 
-        p->version = m_header_buffer.getOctet( JDKSAVDECC_APPDU_OFFSET_VERSION );
+    return msg;
+}
 
-        p->message_type = m_header_buffer.getOctet( JDKSAVDECC_APPDU_OFFSET_MESSAGE_TYPE );
+void AppMessageParser::readHeader( uint8_t const *header )
+{
+    jdksavdecc_appdu *p = &m_current_message.m_appdu.base;
 
-        p->payload_length = m_header_buffer.getDoublet( JDKSAVDECC_APPDU_OFFSET_PAYLOAD_LENGTH );
+    p->version = header[JDKSAVDECC_APPDU_OFFSET_VERSION];
 
-        p->address = m_header_buffer.getEUI48( JDKSAVDECC_APPDU_OFFSET_ADDRESS );
+    p->message_type = header[JDKSAVDECC_APPDU_OFFSET_MESSAGE_TYPE];
 
-        p->reserved = m_header_buffer.getDoublet( JDKSAVDECC_APPDU_OFFSET_RESERVED );
+    p->payload_length = jdksavdecc_uint16_get( header, JDKSAVDECC_APPDU_OFFSET_PAYLOAD_LENGTH );
 
-        // and validate the header
-        msg = validateHeader();
-    }
+    p->address = jdksavdecc_eui48_get( header, JDKSAVDECC_APPDU_OFFSET_ADDRESS );
 
-    return msg;
+    p->reserved = jdksavdecc_uint16_get( header, JDKSAVDECC_APPDU_OFFSET_RESERVED );
 }
 
 AppMessage *AppMessageParser::validateHeader()
@@ -225,6 +318,7 @@ AppMessage *AppMessageParser::validateHeader()
                 m_octets_left_in_payload = p->payload_length;
                 // use p->payload_length as payload octet counter
                 p->payload_length = 0;
+                msg = completeIfEmpty();
             }
             else
             {
@@ -239,6 +333,7 @@ AppMessage *AppMessageParser::validateHeader()
                 m_octets_left_in_payload = p->payload_length;
                 // use p->payload_length as payload octet counter
                 p->payload_length = 0;
+                msg = completeIfEmpty();
             }
             else
             {
@@ -253,6 +348,7 @@ AppMessage *AppMessageParser::validateHeader()
                 m_octets_left_in_payload = p->payload_length;
                 // use p->payload_length as payload octet counter
                 p->payload_length = 0;
+                msg = completeIfEmpty();
             }
             else
             {
@@ -273,6 +369,19 @@ AppMessage *AppMessageParser::validateHeader()
     return msg;
 }
 
+AppMessage *AppMessageParser::completeIfEmpty()
+{
+    AppMessage *msg = 0;
+
+    // A message with an empty payload is complete with its header
+    if ( m_octets_left_in_payload == 0 )
+    {
+        msg = &m_current_message;
+        m_header_buffer.clear();
+    }
+    return msg;
+}
+
 AppMessage *AppMessageParser::parsePayload( uint8_t octet )
 {
     AppMessage *msg = 0;
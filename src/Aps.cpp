@@ -45,6 +45,7 @@ ApsStateMachine::ApsStateMachine( ApsStateVariables *variables,
     , m_actions( actions )
     , m_events( events )
     , m_states( states )
+    , m_assigned_count( 0 )
     , m_active_entity_id_count( active_entity_id_count )
     , m_active_connections( active_connections )
 {
@@ -200,14 +201,7 @@ bool ApsStateEvents::onIncomingHttpConnectRequest( const HttpRequest &request )
 
 ssize_t ApsStateEvents::onIncomingTcpAppData( const uint8_t *data, ssize_t len )
 {
-    ssize_t r = 0;
-
-    for ( ssize_t r = 0; r < len; ++r )
-    {
-        m_app_parser.parse( data[r] );
-    }
-
-    return r;
+    return m_app_parser.parse( data, len );
 }
 
 void ApsStateEvents::onTcpConnectionClosed() { getVariables()->m_incomingTcpClosed = true; }
@@ -230,51 +224,58 @@ void ApsStateEvents::onNetAvdeccMessageReceived( const Frame &frame )
 
 void ApsStateEvents::onTimeTick( uint32_t time_in_seconds ) { getVariables()->m_currentTime = time_in_seconds; }
 
-void ApsStateEvents::onAppNop( const AppMessage &msg )
+void ApsStateEvents::onAppNop( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApsStateEvents::onAppEntityIdRequest( const AppMessage &msg )
+void ApsStateEvents::onAppEntityIdRequest( const AppMessageView &msg )
 {
     getVariables()->m_entity_id = msg.getEntityIdRequestEntityId();
     getVariables()->m_assignEntityIdRequest = true;
 
     // TODO: assign proper entity_id
+
+    // One TCP read may hold many messages, handle each before the next
+    getOwner()->run();
 }
 
-void ApsStateEvents::onAppEntityIdResponse( const AppMessage &msg )
+void ApsStateEvents::onAppEntityIdResponse( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApsStateEvents::onAppLinkUp( const AppMessage &msg )
+void ApsStateEvents::onAppLinkUp( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApsStateEvents::onAppLinkDown( const AppMessage &msg )
+void ApsStateEvents::onAppLinkDown( const AppMessageView &msg )
 {
     // Do Nothing
 }
 
-void ApsStateEvents::onAppAvdeccFromAps( const AppMessage &msg )
+void ApsStateEvents::onAppAvdeccFromAps( const AppMessageView &msg )
 {
     // Do Nothing
 }
 
-void ApsStateEvents::onAppAvdeccFromApc( const AppMessage &msg )
+void ApsStateEvents::onAppAvdeccFromApc( const AppMessageView &msg )
 {
+    // The state machine keeps the message until it is sent
     getVariables()->m_out = msg;
     getVariables()->m_apcMsg = true;
+
+    // One TCP read may hold many messages, handle each before the next
+    getOwner()->run();
 }
 
-void ApsStateEvents::onAppVendor( const AppMessage &msg )
+void ApsStateEvents::onAppVendor( const AppMessageView &msg )
 {
     // Do nothing
 }
 
-void ApsStateEvents::onAppUnknown( const AppMessage &msg )
+void ApsStateEvents::onAppUnknown( const AppMessageView &msg )
 {
     // Do nothing
 }
@@ -320,7 +321,7 @@ void ApsStateActions::sendHttpResponse( int requestValid )
 
 void ApsStateActions::sendMsgToApc( const AppMessage &apsMsg )
 {
-    FixedBufferWithSize<1500> msg_as_octets;
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> msg_as_octets;
     if ( apsMsg.store( &msg_as_octets ) )
     {
         getEvents()->sendTcpData( msg_as_octets.getBuf(), msg_as_octets.getLength() );
@@ -0,0 +1,681 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ApsServerLinux.hpp"
+
+#if defined( __linux__ )
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <errno.h>
+
+namespace JDKSAvdeccMCU
+{
+
+ApsServerConnection::ApsServerConnection( ApsServerLinux &server, int fd, std::string const &path )
+    : ApsStateMachine( &m_aps_variables,
+                       &m_aps_actions,
+                       &m_aps_events,
+                       &m_aps_states,
+                       server.m_active_entity_id_count,
+                       server.m_active_connections )
+    , m_server( server )
+    , m_fd( fd )
+    , m_closing( false )
+    , m_flush_pending( false )
+    , m_epoll_events( EPOLLIN | EPOLLRDHUP )
+    , m_index( 0 )
+    , m_has_entity_id( false )
+    , m_match_stamp( 0 )
+    , m_http_parser( &m_http_request, &m_aps_events )
+    , m_aps_events( &m_http_parser, path )
+    , m_tx_pos( 0 )
+    , m_tx_len( 0 )
+{
+    setup();
+
+    // The link is set after the state machine initializes its variables
+    run();
+    setLinkMac( server.m_net.getMACAddress() );
+    onIncomingTcpConnection();
+    run();
+}
+
+ApsServerConnection::~ApsServerConnection()
+{
+    if ( m_fd >= 0 )
+    {
+        ::close( m_fd );
+    }
+}
+
+void ApsServerConnection::sendTcpData( uint8_t const *data, ssize_t len )
+{
+    if ( m_closing || len <= 0 )
+    {
+        return;
+    }
+
+    if ( m_tx_len + size_t( len ) > JDKSAVDECCMCU_APSSERVER_TX_HIGH_WATER && len > JDKSAVDECC_APPDU_HEADER_LEN
+         && data[JDKSAVDECC_APPDU_OFFSET_MESSAGE_TYPE] == JDKSAVDECC_APPDU_MESSAGE_TYPE_AVDECC_FROM_APS
+         && data[JDKSAVDECC_APPDU_OFFSET_PAYLOAD] == JDKSAVDECC_1722A_SUBTYPE_ADP )
+    {
+        // ADP is announced again soon, so it is the first to go
+        ++m_server.m_dropped_count;
+        return;
+    }
+
+    if ( m_tx_len + size_t( len ) > sizeof( m_tx_buf ) )
+    {
+        // The APC is not keeping up
+        ++m_server.m_overflow_count;
+        closeTcpConnection();
+        return;
+    }
+
+    // Copy into the ring, in two parts if it wraps
+    size_t end = ( m_tx_pos + m_tx_len ) % sizeof( m_tx_buf );
+    size_t first = sizeof( m_tx_buf ) - end;
+    if ( first > size_t( len ) )
+    {
+        first = size_t( len );
+    }
+    memcpy( m_tx_buf + end, data, first );
+    memcpy( m_tx_buf, data + first, size_t( len ) - first );
+    m_tx_len += size_t( len );
+
+    if ( !m_flush_pending )
+    {
+        m_flush_pending = true;
+        m_server.m_flush_list.push_back( this );
+    }
+}
+
+void ApsServerConnection::sendAvdeccToL2( Frame const &frame ) { m_server.sendAvdeccToL2( frame ); }
+
+void ApsServerConnection::closeTcpConnection()
+{
+    if ( !m_closing )
+    {
+        ApsStateMachine::closeTcpConnection();
+        m_closing = true;
+    }
+}
+
+Eui64 ApsServerConnection::assignEntityId( Eui48 server_link_mac, Eui48 apc_link_mac, Eui64 requested_entity_id )
+{
+    m_assigned_entity_id = ApsStateMachine::assignEntityId( server_link_mac, apc_link_mac, requested_entity_id );
+    m_has_entity_id = true;
+    m_server.m_filters_dirty = true;
+    return m_assigned_entity_id;
+}
+
+void ApsServerConnection::setFilter( ApsConnectionFilter const &filter )
+{
+    m_filter = filter;
+    m_server.m_filters_dirty = true;
+}
+
+void ApsServerConnection::sendFanout( FixedBuffer const &appdu )
+{
+    // The same as the TransferToApc state does with its own copy
+    sendTcpData( appdu.getBuf(), appdu.getLength() );
+    m_aps_variables.m_nopTimeout = m_aps_variables.m_currentTime + 10;
+}
+
+bool ApsServerConnection::flush()
+{
+    while ( m_tx_len > 0 )
+    {
+        struct iovec iov[2];
+        struct msghdr msg;
+        size_t first = sizeof( m_tx_buf ) - m_tx_pos;
+
+        iov[0].iov_base = m_tx_buf + m_tx_pos;
+        iov[0].iov_len = first < m_tx_len ? first : m_tx_len;
+        iov[1].iov_base = m_tx_buf;
+        iov[1].iov_len = m_tx_len - iov[0].iov_len;
+
+        // Like writev(), but without SIGPIPE
+        memset( &msg, 0, sizeof( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov[1].iov_len > 0 ? 2 : 1;
+
+        ssize_t written = ::sendmsg( m_fd, &msg, MSG_NOSIGNAL );
+        if ( written < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        ++m_server.m_write_count;
+        m_tx_pos = ( m_tx_pos + size_t( written ) ) % sizeof( m_tx_buf );
+        m_tx_len -= size_t( written );
+    }
+    m_tx_pos = 0;
+    return true;
+}
+
+ApsServerLinux::ApsServerLinux( RawSocket &net, std::string const &path, uint16_t max_connections )
+    : m_net( net )
+    , m_path( path )
+    , m_max_connections( max_connections )
+    , m_listen_fd( -1 )
+    , m_epoll_fd( -1 )
+    , m_listen_port( 0 )
+    , m_active_entity_id_count( 0 )
+    , m_rejected_count( 0 )
+    , m_overflow_count( 0 )
+    , m_dropped_count( 0 )
+    , m_write_count( 0 )
+    , m_filtered_count( 0 )
+    , m_filters_dirty( true )
+    , m_match_stamp( 0 )
+    , m_read_buf( JDKSAVDECCMCU_APSSERVER_READ_SIZE )
+{
+}
+
+ApsServerLinux::~ApsServerLinux() { close(); }
+
+bool ApsServerLinux::open( uint16_t tcp_port, char const *bind_address )
+{
+    struct addrinfo hints;
+    struct addrinfo *ai = 0;
+    char port_str[8];
+
+    close();
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    sprintf( port_str, "%u", unsigned( tcp_port ) );
+
+    if ( getaddrinfo( bind_address, port_str, &hints, &ai ) != 0 )
+    {
+        return false;
+    }
+
+    for ( struct addrinfo *p = ai; p && m_listen_fd < 0; p = p->ai_next )
+    {
+        int fd = socket( p->ai_family, p->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, p->ai_protocol );
+        if ( fd >= 0 )
+        {
+            int on = 1;
+            setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) );
+            if ( bind( fd, p->ai_addr, p->ai_addrlen ) == 0 && listen( fd, SOMAXCONN ) == 0 )
+            {
+                m_listen_fd = fd;
+            }
+            else
+            {
+                ::close( fd );
+            }
+        }
+    }
+    freeaddrinfo( ai );
+
+    if ( m_listen_fd >= 0 )
+    {
+        struct sockaddr_storage addr;
+        socklen_t addr_len = sizeof( addr );
+        if ( getsockname( m_listen_fd, (struct sockaddr *)&addr, &addr_len ) == 0 )
+        {
+            m_listen_port = ntohs( addr.ss_family == AF_INET6 ? ( (struct sockaddr_in6 *)&addr )->sin6_port
+                                                              : ( (struct sockaddr_in *)&addr )->sin_port );
+        }
+
+        m_epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+        if ( m_epoll_fd >= 0 )
+        {
+            // The listening socket is tagged with the server, the raw
+            // socket with 0 and connections with themselves
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = this;
+            epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, &ev );
+
+            if ( m_net.getFd() >= 0 )
+            {
+                ev.events = EPOLLIN;
+                ev.data.ptr = 0;
+                epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, m_net.getFd(), &ev );
+            }
+        }
+        else
+        {
+            close();
+        }
+    }
+    return m_listen_fd >= 0;
+}
+
+void ApsServerLinux::close()
+{
+    while ( !m_connections.empty() )
+    {
+        destroy( m_connections.back() );
+    }
+    if ( m_epoll_fd >= 0 )
+    {
+        ::close( m_epoll_fd );
+        m_epoll_fd = -1;
+    }
+    if ( m_listen_fd >= 0 )
+    {
+        ::close( m_listen_fd );
+        m_listen_fd = -1;
+    }
+}
+
+int ApsServerLinux::poll( int timeout_ms )
+{
+    struct epoll_event events[64];
+    int r = -1;
+
+    if ( m_epoll_fd < 0 )
+    {
+        return r;
+    }
+
+    // Without a file descriptor the raw socket is checked on every poll,
+    // so do not sleep for long
+    if ( m_net.getFd() < 0 && timeout_ms > 10 )
+    {
+        timeout_ms = 10;
+    }
+
+    r = epoll_wait( m_epoll_fd, events, 64, timeout_ms );
+    if ( r < 0 )
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for ( int i = 0; i < r; ++i )
+    {
+        if ( events[i].data.ptr == this )
+        {
+            acceptConnections();
+        }
+        else if ( events[i].data.ptr == 0 )
+        {
+            receiveFromL2();
+        }
+        else
+        {
+            handleConnection( static_cast<ApsServerConnection *>( events[i].data.ptr ), events[i].events );
+        }
+    }
+
+    if ( m_net.getFd() < 0 )
+    {
+        receiveFromL2();
+    }
+
+    // Let the state machines see the time, for their NOP timers
+    uint32_t time_in_seconds = uint32_t( m_net.getTimeInMilliseconds() / 1000 );
+    for ( size_t i = 0; i < m_connections.size(); ++i )
+    {
+        m_connections[i]->onTimeTick( time_in_seconds );
+        m_connections[i]->run();
+    }
+
+    flushConnections();
+    closeConnections();
+    return r;
+}
+
+void ApsServerLinux::acceptConnections()
+{
+    for ( ;; )
+    {
+        int fd = accept4( m_listen_fd, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC );
+        if ( fd < 0 )
+        {
+            break;
+        }
+
+        if ( m_connections.size() >= m_max_connections )
+        {
+            ++m_rejected_count;
+            ::close( fd );
+            continue;
+        }
+
+        int on = 1;
+        setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof( on ) );
+
+        ApsServerConnection *connection = new ApsServerConnection( *this, fd, m_path );
+        connection->m_index = uint16_t( m_connections.size() );
+        m_connections.push_back( connection );
+        m_filters_dirty = true;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = connection;
+        epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, fd, &ev );
+    }
+}
+
+void ApsServerLinux::handleConnection( ApsServerConnection *connection, uint32_t events )
+{
+    if ( connection->isClosing() )
+    {
+        return;
+    }
+
+    if ( events & EPOLLOUT )
+    {
+        if ( !connection->flush() )
+        {
+            connection->closeTcpConnection();
+            return;
+        }
+    }
+
+    // A backlogged APC is not read from until it catches up, unless it
+    // has gone away
+    if ( ( ( events & EPOLLIN ) && !connection->isBacklogged() ) || ( events & ( EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) )
+    {
+        ssize_t len = recv( connection->m_fd, &m_read_buf[0], m_read_buf.size(), 0 );
+        if ( len > 0 )
+        {
+            if ( connection->onIncomingTcpData( &m_read_buf[0], len ) < 0 )
+            {
+                connection->closeTcpConnection();
+            }
+            else
+            {
+                connection->run();
+            }
+        }
+        else if ( len == 0 || ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) )
+        {
+            // The APC closed the connection
+            connection->onTcpConnectionClosed();
+            connection->run();
+            connection->closeTcpConnection();
+        }
+    }
+}
+
+void ApsServerLinux::receiveFromL2()
+{
+    while ( m_net.recvFrame( &m_rx_frame ) )
+    {
+        if ( m_rx_frame.getEtherType() != JDKSAVDECC_AVTP_ETHERTYPE
+             || m_rx_frame.getLength() <= JDKSAVDECC_FRAME_HEADER_LEN )
+        {
+            continue;
+        }
+
+        if ( m_filters_dirty )
+        {
+            compileFilters();
+        }
+
+        // Each connection is matched at most once per frame
+        if ( ++m_match_stamp == 0 )
+        {
+            for ( size_t i = 0; i < m_connections.size(); ++i )
+            {
+                m_connections[i]->m_match_stamp = 0;
+            }
+            m_match_stamp = 1;
+        }
+        m_matches.clear();
+
+        bool multicast = ( m_rx_frame.getOctet( JDKSAVDECC_FRAME_HEADER_DA_OFFSET ) & 1 ) != 0;
+        uint16_t const pdu = JDKSAVDECC_FRAME_HEADER_LEN;
+
+        switch ( m_rx_frame.getOctet( pdu ) )
+        {
+        case JDKSAVDECC_1722A_SUBTYPE_ADP:
+            addMatches( m_all_by_subtype[0], multicast );
+            addEntityMatches(
+                m_rx_frame, pdu + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID, ApsConnectionFilter::ADP, multicast );
+            break;
+        case JDKSAVDECC_1722A_SUBTYPE_AECP:
+            addMatches( m_all_by_subtype[1], multicast );
+            addEntityMatches(
+                m_rx_frame, pdu + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID, ApsConnectionFilter::AECP, multicast );
+            addEntityMatches(
+                m_rx_frame, pdu + JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID, ApsConnectionFilter::AECP, multicast );
+            break;
+        case JDKSAVDECC_1722A_SUBTYPE_ACMP:
+            addMatches( m_all_by_subtype[2], multicast );
+            addEntityMatches(
+                m_rx_frame, pdu + JDKSAVDECC_ACMPDU_OFFSET_CONTROLLER_ENTITY_ID, ApsConnectionFilter::ACMP, multicast );
+            addEntityMatches( m_rx_frame, pdu + JDKSAVDECC_ACMPDU_OFFSET_TALKER_ENTITY_ID, ApsConnectionFilter::ACMP, multicast );
+            addEntityMatches(
+                m_rx_frame, pdu + JDKSAVDECC_ACMPDU_OFFSET_LISTENER_ENTITY_ID, ApsConnectionFilter::ACMP, multicast );
+            break;
+        default:
+            addMatches( m_all_by_subtype[3], multicast );
+            break;
+        }
+
+        if ( m_matches.empty() )
+        {
+            ++m_filtered_count;
+            continue;
+        }
+
+        // Make the APPDU once for all of the APCs that want it, straight
+        // from the received frame
+        m_fanout_msg.setAvdeccFromAps( m_rx_frame );
+        if ( m_fanout_msg.store( &m_fanout_buf ) )
+        {
+            for ( size_t i = 0; i < m_matches.size(); ++i )
+            {
+                m_matches[i]->sendFanout( m_fanout_buf );
+            }
+        }
+    }
+}
+
+void ApsServerLinux::compileFilters()
+{
+    for ( size_t j = 0; j < 4; ++j )
+    {
+        m_all_by_subtype[j].clear();
+    }
+    m_by_entity.clear();
+
+    for ( size_t i = 0; i < m_connections.size(); ++i )
+    {
+        ApsServerConnection *connection = m_connections[i];
+        ApsConnectionFilter const &filter = connection->m_filter;
+
+        for ( size_t j = 0; j < 4; ++j )
+        {
+            if ( filter.m_all_subtypes & ( 1 << j ) )
+            {
+                m_all_by_subtype[j].push_back( connection );
+            }
+        }
+
+        if ( filter.m_matched_subtypes != 0 )
+        {
+            FilterEntry entry;
+            entry.m_connection = connection;
+            entry.m_subtypes = filter.m_matched_subtypes;
+
+            if ( connection->m_has_entity_id )
+            {
+                m_by_entity[connection->m_assigned_entity_id].push_back( entry );
+            }
+            for ( uint16_t t = 0; t < filter.m_num_targets; ++t )
+            {
+                m_by_entity[filter.m_targets[t]].push_back( entry );
+            }
+        }
+    }
+    m_filters_dirty = false;
+}
+
+void ApsServerLinux::addMatches( std::vector<ApsServerConnection *> const &connections, bool multicast )
+{
+    for ( size_t i = 0; i < connections.size(); ++i )
+    {
+        addMatch( connections[i], multicast );
+    }
+}
+
+void ApsServerLinux::addMatch( ApsServerConnection *connection, bool multicast )
+{
+    ApsConnectionFilter const &filter = connection->m_filter;
+
+    if ( connection->m_match_stamp != m_match_stamp && connection->isTransferring()
+         && ( multicast ? filter.m_multicast : filter.m_unicast ) )
+    {
+        connection->m_match_stamp = m_match_stamp;
+        m_matches.push_back( connection );
+    }
+}
+
+void ApsServerLinux::addEntityMatches( Frame const &frame, uint16_t offset, uint8_t subtype_bit, bool multicast )
+{
+    if ( m_by_entity.empty() || frame.getLength() < offset + 8 )
+    {
+        return;
+    }
+
+    std::unordered_map<Eui64, std::vector<FilterEntry> >::const_iterator i
+        = m_by_entity.find( Eui64( frame.getBuf() + offset ) );
+    if ( i != m_by_entity.end() )
+    {
+        for ( size_t j = 0; j < i->second.size(); ++j )
+        {
+            if ( i->second[j].m_subtypes & subtype_bit )
+            {
+                addMatch( i->second[j].m_connection, multicast );
+            }
+        }
+    }
+}
+
+void ApsServerLinux::flushConnections()
+{
+    // Everything queued during this pass of the loop goes out in one write
+    // per connection
+    for ( size_t i = 0; i < m_flush_list.size(); ++i )
+    {
+        ApsServerConnection *connection = m_flush_list[i];
+        connection->m_flush_pending = false;
+        if ( !connection->isClosing() && !connection->flush() )
+        {
+            connection->closeTcpConnection();
+        }
+    }
+    m_flush_list.clear();
+
+    for ( size_t i = 0; i < m_connections.size(); ++i )
+    {
+        updateEvents( m_connections[i] );
+    }
+}
+
+void ApsServerLinux::updateEvents( ApsServerConnection *connection )
+{
+    if ( connection->isClosing() )
+    {
+        return;
+    }
+
+    // Only ask to be told about writability while data is waiting, and
+    // about readability while the APC is keeping up
+    uint32_t events = EPOLLRDHUP;
+    if ( connection->m_tx_len > 0 )
+    {
+        events |= EPOLLOUT;
+    }
+    if ( !connection->isBacklogged() )
+    {
+        events |= EPOLLIN;
+    }
+    if ( events != connection->m_epoll_events )
+    {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = connection;
+        epoll_ctl( m_epoll_fd, EPOLL_CTL_MOD, connection->m_fd, &ev );
+        connection->m_epoll_events = events;
+    }
+}
+
+void ApsServerLinux::closeConnections()
+{
+    for ( size_t i = m_connections.size(); i > 0; --i )
+    {
+        if ( m_connections[i - 1]->isClosing() )
+        {
+            destroy( m_connections[i - 1] );
+        }
+    }
+}
+
+void ApsServerLinux::destroy( ApsServerConnection *connection )
+{
+    uint16_t i = connection->m_index;
+
+    if ( m_epoll_fd >= 0 )
+    {
+        epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, connection->m_fd, 0 );
+    }
+    if ( !connection->m_closing )
+    {
+        connection->closeTcpConnection();
+    }
+    if ( connection->m_flush_pending )
+    {
+        m_flush_list.erase( std::find( m_flush_list.begin(), m_flush_list.end(), connection ) );
+    }
+
+    // Whatever was said last, such as an HTTP error response, gets a chance
+    // to go out before the socket is closed
+    connection->flush();
+
+    // Keep the list packed by moving the last connection into its place
+    m_connections[i] = m_connections.back();
+    m_connections[i]->m_index = i;
+    m_connections.pop_back();
+    m_filters_dirty = true;
+    delete connection;
+}
+}
+#endif
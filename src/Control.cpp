@@ -54,6 +54,29 @@ bool Control::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     return false;
 }
 
+uint16_t Control::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 2 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::DESCRIPTOR,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND,
+                                        JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                                        JDKSAVDECC_DESCRIPTOR_CONTROL,
+                                        m_descriptor_index );
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::DESCRIPTOR,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND,
+                                        JDKSAVDECC_AEM_COMMAND_GET_CONTROL,
+                                        JDKSAVDECC_DESCRIPTOR_CONTROL,
+                                        m_descriptor_index );
+    }
+    return r;
+}
+
 uint8_t Control::formControlValueMetaData( Frame &pdu )
 {
     uint8_t status = JDKSAVDECC_AEM_STATUS_ENTITY_MISBEHAVING;
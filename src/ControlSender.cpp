@@ -91,4 +91,14 @@ bool ControlSender::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     (void)frame;
     return false;
 }
+
+uint16_t ControlSender::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 1 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::NONE );
+    }
+    return r;
+}
 }
@@ -0,0 +1,229 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ControlSenderGroup.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+ControlSenderGroup::ControlSenderGroup( ControllerEntity &controller_entity,
+                                        ControlSenderItem *item_storage,
+                                        uint16_t max_items,
+                                        jdksavdecc_timestamp_in_milliseconds update_rate_in_millis,
+                                        jdksavdecc_timestamp_in_milliseconds min_interval_in_millis )
+    : m_controller_entity( controller_entity )
+    , m_num_items( 0 )
+    , m_max_items( max_items )
+    , m_item( item_storage )
+    , m_first_item( 0 )
+    , m_update_rate_in_millis( update_rate_in_millis )
+    , m_min_interval_in_millis( min_interval_in_millis )
+    , m_smoothed_latency_in_millis( 0 )
+    , m_sent_count( 0 )
+{
+}
+
+bool ControlSenderGroup::add( Eui64 const &target_entity_id,
+                              Eui48 const &target_mac_address,
+                              uint16_t target_descriptor_index,
+                              ControlValueHolder *holder )
+{
+    bool r = false;
+    if ( m_num_items < m_max_items )
+    {
+        ControlSenderItem *item = &m_item[m_num_items++];
+        item->m_target_entity_id = target_entity_id;
+        item->m_target_mac_address = target_mac_address;
+        item->m_target_descriptor_index = target_descriptor_index;
+        item->m_holder = holder;
+        item->m_last_send_time = 0;
+        item->m_in_flight = false;
+        item->m_sequence_id = 0;
+        r = true;
+    }
+    return r;
+}
+
+void ControlSenderGroup::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    // Start with the item that had to wait last time, so that one busy
+    // control can not keep the others from being sent
+    for ( uint16_t n = 0; n < m_num_items; ++n )
+    {
+        ControlSenderItem *item = &m_item[( m_first_item + n ) % m_num_items];
+        if ( isDue( item, time_in_millis ) )
+        {
+            // Send everything that is due for the same target back to back.
+            // The ones before this one are not due or they would have been
+            // sent already
+            for ( uint16_t k = n; k < m_num_items; ++k )
+            {
+                uint16_t j = ( m_first_item + k ) % m_num_items;
+                ControlSenderItem *other = &m_item[j];
+                if ( other->m_target_entity_id == item->m_target_entity_id && isDue( other, time_in_millis ) )
+                {
+                    if ( !send( other, time_in_millis ) )
+                    {
+                        // No room to track another command, try again next
+                        // tick
+                        m_first_item = j;
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool ControlSenderGroup::isDue( ControlSenderItem const *item, jdksavdecc_timestamp_in_milliseconds time_in_millis ) const
+{
+    bool r = false;
+    if ( !item->m_in_flight )
+    {
+        if ( item->m_holder->isDirty() )
+        {
+            r = wasTimeOutHit( time_in_millis, item->m_last_send_time, getSendInterval() );
+        }
+        else
+        {
+            r = wasTimeOutHit( time_in_millis, item->m_last_send_time, m_update_rate_in_millis );
+        }
+    }
+    return r;
+}
+
+bool ControlSenderGroup::send( ControlSenderItem *item, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    // Only a tracked command tells when the target has caught up. Without an
+    // in-flight table the entity tracks one command at a time, so wait for
+    // it rather than make it forget the one that it is tracking
+    if ( !m_controller_entity.canSendCommand() )
+    {
+        return false;
+    }
+
+    FrameWithSize<4> pdufragment;
+
+    pdufragment.putDoublet( JDKSAVDECC_DESCRIPTOR_CONTROL );
+    pdufragment.putDoublet( item->m_target_descriptor_index );
+
+    // Bypass the command queue, a queued copy of the value could be stale
+    // by the time that it is sent
+    bool r = m_controller_entity.sendCommand( item->m_target_entity_id,
+                                              item->m_target_mac_address,
+                                              JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                                              true,
+                                              pdufragment.getBuf(),
+                                              pdufragment.getLength(),
+                                              item->m_holder->getBuf(),
+                                              item->m_holder->getLength(),
+                                              this );
+    if ( r )
+    {
+        item->m_holder->clearDirty();
+        item->m_last_send_time = time_in_millis;
+        item->m_in_flight = true;
+        item->m_sequence_id = m_controller_entity.getOutgoingSequenceID();
+        ++m_sent_count;
+    }
+    return r;
+}
+
+ControlSenderItem *ControlSenderGroup::findInFlight( InflightCommand const &cmd )
+{
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        ControlSenderItem *item = &m_item[i];
+        if ( item->m_in_flight && item->m_sequence_id == cmd.m_sequence_id && item->m_target_entity_id == cmd.m_target_entity_id )
+        {
+            return item;
+        }
+    }
+    return 0;
+}
+
+void ControlSenderGroup::inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
+{
+    (void)aem;
+    (void)pdu;
+    ControlSenderItem *item = findInFlight( cmd );
+    if ( item )
+    {
+        item->m_in_flight = false;
+
+        // Smooth the latency the way TCP does, with a gain of 1/8
+        jdksavdecc_timestamp_in_milliseconds now = m_controller_entity.getRawSocket().getTimeInMilliseconds();
+        jdksavdecc_timestamp_in_milliseconds latency = now > cmd.m_sent_time ? now - cmd.m_sent_time : 0;
+        if ( latency > JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS )
+        {
+            latency = JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS;
+        }
+        m_smoothed_latency_in_millis = ( m_smoothed_latency_in_millis * 7 + latency ) / 8;
+    }
+}
+
+void ControlSenderGroup::inflightCommandTimedOut( InflightCommand const &cmd )
+{
+    ControlSenderItem *item = findInFlight( cmd );
+    if ( item )
+    {
+        item->m_in_flight = false;
+
+        // The target is not keeping up, send it half as often
+        m_smoothed_latency_in_millis = getSendInterval() * 2;
+        if ( m_smoothed_latency_in_millis > JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS )
+        {
+            m_smoothed_latency_in_millis = JDKSAVDECCMCU_CONTROLSENDERGROUP_MAX_INTERVAL_MS;
+        }
+
+        // The target may not have the value, so send it again
+        item->m_holder->setDirty();
+    }
+}
+
+bool ControlSenderGroup::receivedPDU( RawSocket *incoming_socket, Frame &frame )
+{
+    (void)incoming_socket;
+    (void)frame;
+    return false;
+}
+
+uint16_t ControlSenderGroup::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 1 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::NONE );
+    }
+    return r;
+}
+}
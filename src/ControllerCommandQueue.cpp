@@ -0,0 +1,248 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ControllerCommandQueue.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+ControllerCommandQueue::ControllerCommandQueue( CommandQueueTarget *target_storage,
+                                                QueuedCommand *command_storage,
+                                                uint16_t max_targets,
+                                                uint16_t max_pending_per_target,
+                                                uint16_t default_window )
+    : m_targets( target_storage )
+    , m_commands( command_storage )
+    , m_max_targets( max_targets )
+    , m_max_pending_per_target( max_pending_per_target )
+    , m_default_window( default_window )
+    , m_dropped_count( 0 )
+{
+    // Target slots are free while their entity id is unset, which is the
+    // state that Eui64's default constructor leaves them in
+}
+
+CommandQueueTarget *ControllerCommandQueue::findTarget( Eui64 const &target_entity_id )
+{
+    CommandQueueTarget *r = 0;
+    for ( uint16_t i = 0; i < m_max_targets; ++i )
+    {
+        // An unset target id would match a free slot
+        if ( m_targets[i].m_target_entity_id.isSet() && m_targets[i].m_target_entity_id == target_entity_id )
+        {
+            r = &m_targets[i];
+            break;
+        }
+    }
+    return r;
+}
+
+CommandQueueTarget const *ControllerCommandQueue::findTarget( Eui64 const &target_entity_id ) const
+{
+    return const_cast<ControllerCommandQueue *>( this )->findTarget( target_entity_id );
+}
+
+CommandQueueTarget *ControllerCommandQueue::findOrAddTarget( Eui64 const &target_entity_id, Eui48 const &target_mac_address )
+{
+    CommandQueueTarget *r = findTarget( target_entity_id );
+
+    // A slot with an unset target id stays free, so it can not be added
+    if ( !r && target_entity_id.isSet() )
+    {
+        // find a free slot
+        for ( uint16_t i = 0; i < m_max_targets; ++i )
+        {
+            if ( m_targets[i].m_target_entity_id.isUnset() )
+            {
+                r = &m_targets[i];
+                r->m_target_entity_id = target_entity_id;
+                r->m_window = m_default_window;
+                r->m_head = 0;
+                r->m_depth = 0;
+                r->m_max_depth = 0;
+                r->m_sent_count = 0;
+                r->m_completed_count = 0;
+                r->m_timed_out_count = 0;
+                r->m_last_round_trip_in_ms = 0;
+                r->m_min_round_trip_in_ms = 0;
+                r->m_max_round_trip_in_ms = 0;
+                r->m_total_round_trip_in_ms = 0;
+                break;
+            }
+        }
+    }
+    if ( r )
+    {
+        // The target may have moved to a new MAC address
+        r->m_target_mac_address = target_mac_address;
+    }
+    return r;
+}
+
+void ControllerCommandQueue::removeTarget( Eui64 const &target_entity_id )
+{
+    CommandQueueTarget *target = findTarget( target_entity_id );
+    if ( target )
+    {
+        target->m_target_entity_id.clear();
+        target->m_depth = 0;
+    }
+}
+
+bool ControllerCommandQueue::setWindow( Eui64 const &target_entity_id, Eui48 const &target_mac_address, uint16_t window )
+{
+    bool r = false;
+    CommandQueueTarget *target = findOrAddTarget( target_entity_id, target_mac_address );
+    if ( target )
+    {
+        target->m_window = window > 0 ? window : 1;
+        r = true;
+    }
+    return r;
+}
+
+bool ControllerCommandQueue::enqueue( Eui64 const &target_entity_id,
+                                      Eui48 const &target_mac_address,
+                                      uint16_t command_type,
+                                      uint8_t const *payload1,
+                                      uint16_t payload_length1,
+                                      uint8_t const *payload2,
+                                      uint16_t payload_length2,
+                                      InflightCommandNotification *notification )
+{
+    bool r = false;
+    CommandQueueTarget *target = findOrAddTarget( target_entity_id, target_mac_address );
+
+    if ( target && target->m_depth < m_max_pending_per_target
+         && uint32_t( payload_length1 ) + payload_length2 <= JDKSAVDECCMCU_COMMAND_QUEUE_MAX_PAYLOAD_LENGTH )
+    {
+        uint16_t target_num = uint16_t( target - m_targets );
+        uint16_t pos = ( target->m_head + target->m_depth ) % m_max_pending_per_target;
+        QueuedCommand *cmd = &m_commands[target_num * m_max_pending_per_target + pos];
+
+        cmd->m_command_type = command_type;
+        cmd->m_notification = notification;
+        cmd->m_payload_length = payload_length1 + payload_length2;
+        if ( payload1 && payload_length1 )
+        {
+            memcpy( cmd->m_payload, payload1, payload_length1 );
+        }
+        if ( payload2 && payload_length2 )
+        {
+            memcpy( cmd->m_payload + payload_length1, payload2, payload_length2 );
+        }
+
+        target->m_depth++;
+        if ( target->m_depth > target->m_max_depth )
+        {
+            target->m_max_depth = target->m_depth;
+        }
+        r = true;
+    }
+    else
+    {
+        m_dropped_count++;
+    }
+    return r;
+}
+
+QueuedCommand *ControllerCommandQueue::front( CommandQueueTarget *target )
+{
+    QueuedCommand *r = 0;
+    if ( target->m_depth > 0 )
+    {
+        uint16_t target_num = uint16_t( target - m_targets );
+        r = &m_commands[target_num * m_max_pending_per_target + target->m_head];
+    }
+    return r;
+}
+
+void ControllerCommandQueue::pop( CommandQueueTarget *target )
+{
+    if ( target->m_depth > 0 )
+    {
+        target->m_head = ( target->m_head + 1 ) % m_max_pending_per_target;
+        target->m_depth--;
+        target->m_sent_count++;
+    }
+}
+
+void ControllerCommandQueue::commandCompleted( InflightCommand const &cmd, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    CommandQueueTarget *target = findTarget( cmd.m_target_entity_id );
+    if ( target )
+    {
+        // The round trip is measured from the last (re)transmission
+        jdksavdecc_timestamp_in_milliseconds rtt = time_in_millis - cmd.m_sent_time;
+
+        if ( target->m_completed_count == 0 || rtt < target->m_min_round_trip_in_ms )
+        {
+            target->m_min_round_trip_in_ms = rtt;
+        }
+        if ( rtt > target->m_max_round_trip_in_ms )
+        {
+            target->m_max_round_trip_in_ms = rtt;
+        }
+        target->m_last_round_trip_in_ms = rtt;
+        target->m_total_round_trip_in_ms += rtt;
+        target->m_completed_count++;
+    }
+}
+
+void ControllerCommandQueue::commandTimedOut( Eui64 const &target_entity_id )
+{
+    CommandQueueTarget *target = findTarget( target_entity_id );
+    if ( target )
+    {
+        target->m_timed_out_count++;
+    }
+}
+
+uint16_t ControllerCommandQueue::getQueueDepth( Eui64 const &target_entity_id ) const
+{
+    CommandQueueTarget const *target = findTarget( target_entity_id );
+    return target ? target->m_depth : 0;
+}
+
+uint32_t ControllerCommandQueue::getTotalQueueDepth() const
+{
+    uint32_t total = 0;
+    for ( uint16_t i = 0; i < m_max_targets; ++i )
+    {
+        if ( m_targets[i].m_target_entity_id.isSet() )
+        {
+            total += m_targets[i].m_depth;
+        }
+    }
+    return total;
+}
+}
@@ -36,6 +36,103 @@
 namespace JDKSAvdeccMCU
 {
 
+void ControllerEntity::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    Entity::tick( time_in_millis );
+
+    // Time outs may have opened up windows
+    drainCommandQueue();
+}
+
+void ControllerEntity::commandTimedOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id )
+{
+    Entity::commandTimedOut( target_entity_id, command_type, sequence_id );
+
+    if ( m_command_queue )
+    {
+        m_command_queue->commandTimedOut( target_entity_id );
+    }
+}
+
+bool ControllerEntity::queueCommand( Eui64 const &target_entity_id,
+                                     Eui48 const &target_mac_address,
+                                     uint16_t aem_command_type,
+                                     uint8_t const *additional_data1,
+                                     uint16_t additional_data_length1,
+                                     uint8_t const *additional_data2,
+                                     uint16_t additional_data_length2,
+                                     InflightCommandNotification *notification )
+{
+    bool r = false;
+    if ( m_command_queue )
+    {
+        r = m_command_queue->enqueue( target_entity_id,
+                                      target_mac_address,
+                                      aem_command_type,
+                                      additional_data1,
+                                      additional_data_length1,
+                                      additional_data2,
+                                      additional_data_length2,
+                                      notification );
+        if ( r )
+        {
+            // Send it now if the target's window is open
+            drainCommandQueue( m_command_queue->findTarget( target_entity_id ) );
+        }
+    }
+    else
+    {
+        r = sendCommand( target_entity_id,
+                         target_mac_address,
+                         aem_command_type,
+                         true,
+                         additional_data1,
+                         additional_data_length1,
+                         additional_data2,
+                         additional_data_length2,
+                         notification );
+    }
+    return r;
+}
+
+void ControllerEntity::drainCommandQueue()
+{
+    if ( m_command_queue )
+    {
+        for ( uint16_t i = 0; i < m_command_queue->getMaxTargets(); ++i )
+        {
+            CommandQueueTarget *target = m_command_queue->getTarget( i );
+            if ( target->m_target_entity_id.isSet() && target->m_depth > 0 )
+            {
+                drainCommandQueue( target );
+            }
+        }
+    }
+}
+
+void ControllerEntity::drainCommandQueue( CommandQueueTarget *target )
+{
+    QueuedCommand *cmd;
+
+    // Without an in-flight table only one command at a time can be tracked,
+    // so the window is effectively 1 for all targets combined
+    while ( canSendCommand() && ( cmd = m_command_queue->front( target ) ) != 0
+            && ( !m_inflight_commands
+                 || m_inflight_commands->getCountForTarget( target->m_target_entity_id ) < target->m_window ) )
+    {
+        sendCommand( target->m_target_entity_id,
+                     target->m_target_mac_address,
+                     cmd->m_command_type,
+                     true,
+                     cmd->m_payload,
+                     cmd->m_payload_length,
+                     0,
+                     0,
+                     cmd->m_notification );
+        m_command_queue->pop( target );
+    }
+}
+
 bool ControllerEntity::receivedPDU( RawSocket *incoming_socket, Frame &frame )
 {
     bool r = false;
@@ -62,6 +159,28 @@ bool ControllerEntity::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     return r;
 }
 
+uint16_t ControllerEntity::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 2 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE );
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_ADDRESS_ACCESS_RESPONSE );
+        uint16_t entity_keys = Entity::getDispatchKeys( keys + r, max_keys - r );
+
+        // Entity also wants the commands and ACMP; when those do not fit ask
+        // for every frame rather than only for the responses
+        r = entity_keys > 0 ? r + entity_keys : 0;
+    }
+    return r;
+}
+
 bool ControllerEntity::receivedAEMResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
 {
     bool r = false;
@@ -73,7 +192,37 @@ bool ControllerEntity::receivedAEMResponse( jdksavdecc_aecpdu_aem const &aem, Fr
     // or is solicited and matches the last request we did send
     bool interesting = unsolicited;
 
-    if ( !unsolicited )
+    // The in-flight command that this response completes, if any
+    InflightCommand completed;
+    bool have_completed = false;
+
+    if ( !unsolicited && m_inflight_commands )
+    {
+        // Find the command by target entity id and sequence id
+        InflightCommand *cmd
+            = m_inflight_commands->find( aem.aecpdu_header.header.target_entity_id, aem.aecpdu_header.sequence_id );
+        if ( cmd && cmd->m_command_type == actual_command_type )
+        {
+            if ( aem.aecpdu_header.header.status == JDKSAVDECC_AEM_STATUS_IN_PROGRESS )
+            {
+                // The target is still working on it, so restart the time out
+                // and keep waiting for the real response
+                cmd->m_sent_time = getRawSocket().getTimeInMilliseconds();
+                r = true;
+            }
+            else
+            {
+                // Yes, then we are interested in this message. Forget about
+                // the command before dispatching so the handlers may send
+                // new commands in its place
+                interesting = true;
+                completed = *cmd;
+                have_completed = true;
+                m_inflight_commands->remove( cmd );
+            }
+        }
+    }
+    else if ( !unsolicited )
     {
         // First, is it from the entity we sent the command to?
         if ( m_last_sent_command_target_entity_id == aem.aecpdu_header.header.target_entity_id )
@@ -86,9 +235,17 @@ bool ControllerEntity::receivedAEMResponse( jdksavdecc_aecpdu_aem const &aem, Fr
                 {
                     // Yes, then we are interested in this message
                     interesting = true;
+
+                    // It completes the one tracked command, so the command
+                    // queue can account for it and send the next
+                    getLastSentCommand( &completed, m_outgoing_sequence_id );
+                    have_completed = true;
+
                     // forget about the sent state by clearing the last send
-                    // command target entity id
+                    // command target entity id and type
                     m_last_sent_command_target_entity_id = Eui64();
+                    m_last_sent_command_type = JDKSAVDECC_AEM_COMMAND_EXPANSION;
+                    m_last_sent_command_notification = 0;
                 }
             }
         }
@@ -141,6 +298,27 @@ bool ControllerEntity::receivedAEMResponse( jdksavdecc_aecpdu_aem const &aem, Fr
         }
     }
 
+    if ( have_completed )
+    {
+        // Tell whoever sent the command that it is done
+        if ( completed.m_notification )
+        {
+            completed.m_notification->inflightCommandCompleted( completed, aem, pdu );
+            r = true;
+        }
+
+        // The target's window has room for the next queued command
+        if ( m_command_queue )
+        {
+            m_command_queue->commandCompleted( completed, getRawSocket().getTimeInMilliseconds() );
+            CommandQueueTarget *target = m_command_queue->findTarget( completed.m_target_entity_id );
+            if ( target )
+            {
+                drainCommandQueue( target );
+            }
+        }
+    }
+
     return r;
 }
 
@@ -225,19 +403,26 @@ bool ControllerEntity::receiveEntityAvailableResponse( jdksavdecc_aecpdu_aem con
     return false;
 }
 
-void ControllerEntity::sendReadDescriptor( const Eui64 &target_entity_id,
+bool ControllerEntity::sendReadDescriptor( const Eui64 &target_entity_id,
                                            const Eui48 &target_mac_address,
                                            uint16_t configuration_index,
                                            uint16_t descriptor_type,
-                                           uint16_t descriptor_index )
+                                           uint16_t descriptor_index,
+                                           InflightCommandNotification *notification )
 {
     uint8_t additional1[8];
     jdksavdecc_uint16_set( configuration_index, additional1, 0 ); // offset 12 in Figure 7.36
     jdksavdecc_uint16_set( 0, additional1, 2 );                   // offset 14 in Figure 7.36
     jdksavdecc_uint16_set( descriptor_type, additional1, 4 );     // offset 16 in Figure 7.36
     jdksavdecc_uint16_set( descriptor_index, additional1, 6 );    // offset 20 in Figure 7.35
-    sendCommand(
-        target_entity_id, target_mac_address, JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR, true, additional1, sizeof( additional1 ) );
+    return queueCommand( target_entity_id,
+                         target_mac_address,
+                         JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR,
+                         additional1,
+                         sizeof( additional1 ),
+                         0,
+                         0,
+                         notification );
 }
 
 bool ControllerEntity::receiveReadDescriptorResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
@@ -329,24 +514,37 @@ bool ControllerEntity::receiveGetNameResponse( jdksavdecc_aecpdu_aem const &aem,
     return false;
 }
 
-void ControllerEntity::sendSetControl( const Eui64 &target_entity_id,
+bool ControllerEntity::sendSetControl( const Eui64 &target_entity_id,
                                        const Eui48 &target_mac_address,
                                        uint16_t target_descriptor_index,
                                        uint8_t *control_value,
                                        uint16_t control_value_len,
-                                       bool track_for_ack )
+                                       bool track_for_ack,
+                                       InflightCommandNotification *notification )
 {
     uint8_t additional1[4];
     jdksavdecc_uint16_set( JDKSAVDECC_DESCRIPTOR_CONTROL, additional1, 0 );
     jdksavdecc_uint16_set( target_descriptor_index, additional1, 2 );
-    sendCommand( target_entity_id,
-                 target_mac_address,
-                 JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
-                 track_for_ack,
-                 additional1,
-                 sizeof( additional1 ),
-                 control_value,
-                 control_value_len );
+    if ( track_for_ack )
+    {
+        return queueCommand( target_entity_id,
+                             target_mac_address,
+                             JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                             additional1,
+                             sizeof( additional1 ),
+                             control_value,
+                             control_value_len,
+                             notification );
+    }
+    // Untracked commands are never held back
+    return sendCommand( target_entity_id,
+                        target_mac_address,
+                        JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                        false,
+                        additional1,
+                        sizeof( additional1 ),
+                        control_value,
+                        control_value_len );
 }
 
 bool ControllerEntity::receiveSetControlResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
@@ -380,15 +578,22 @@ uint8_t ControllerEntity::receiveControlValue( Eui64 const &target_entity_id,
     return JDKSAVDECC_AECP_STATUS_NOT_IMPLEMENTED;
 }
 
-void ControllerEntity::sendGetControl( const Eui64 &target_entity_id,
+bool ControllerEntity::sendGetControl( const Eui64 &target_entity_id,
                                        const Eui48 &target_mac_address,
-                                       uint16_t target_descriptor_index )
+                                       uint16_t target_descriptor_index,
+                                       InflightCommandNotification *notification )
 {
     uint8_t additional1[4];
     jdksavdecc_uint16_set( JDKSAVDECC_DESCRIPTOR_CONTROL, additional1, 0 );
     jdksavdecc_uint16_set( target_descriptor_index, additional1, 2 );
-    sendCommand(
-        target_entity_id, target_mac_address, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, true, additional1, sizeof( additional1 ) );
+    return queueCommand( target_entity_id,
+                         target_mac_address,
+                         JDKSAVDECC_AEM_COMMAND_GET_CONTROL,
+                         additional1,
+                         sizeof( additional1 ),
+                         0,
+                         0,
+                         notification );
 }
 
 bool ControllerEntity::receiveRegisterUnsolicitedNotificationResponse( jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
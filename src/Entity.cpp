@@ -42,7 +42,9 @@ Entity::Entity( ADPManager &adp_manager,
                 EntityState *entity_state,
                 ACMPControllerGroupHandlerBase *acmp_controller_group_handler,
                 ACMPTalkerGroupHandlerBase *acmp_talker_group_handler,
-                ACMPListenerGroupHandlerBase *acmp_listener_group_handler )
+                ACMPListenerGroupHandlerBase *acmp_listener_group_handler,
+                InflightCommands *inflight_commands,
+                UnsolicitedCoalescer *unsolicited_coalescer )
     : m_adp_manager( adp_manager )
     , m_outgoing_sequence_id( 0 )
     , m_acquire_in_progress_time( 0 )
@@ -50,10 +52,15 @@ Entity::Entity( ADPManager &adp_manager,
     , m_registered_controllers( registered_controllers )
     , m_last_sent_command_time( 0 )
     , m_last_sent_command_type( JDKSAVDECC_AEM_COMMAND_EXPANSION )
+    , m_last_sent_command_notification( 0 )
+    , m_inflight_commands( inflight_commands )
+    , m_unsolicited_coalescer( unsolicited_coalescer )
     , m_entity_state( entity_state )
+    , m_num_response_fragments( 0 )
     , m_acmp_controller_group_handler( acmp_controller_group_handler )
     , m_acmp_talker_group_handler( acmp_talker_group_handler )
     , m_acmp_listener_group_handler( acmp_listener_group_handler )
+    , m_timer( this )
 {
     // clear info on sent command state
     m_last_sent_command_target_entity_id.clear();
@@ -83,27 +90,25 @@ void Entity::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
     // TODO: Send acquire in progress every 120 ms while we are
     // m_acquire_in_progress_by_controller_entity_id
 
-    // Check to see if we had a command in flight that timed out
-    if ( cmd != JDKSAVDECC_AEM_COMMAND_EXPANSION
-         && wasTimeOutHit( time_in_millis, m_last_sent_command_time, JDKSAVDECC_AEM_TIMEOUT_IN_MS ) )
+    if ( m_inflight_commands )
     {
+        // Check the table of commands in flight for time outs
+        tickInflightCommands( time_in_millis );
+    }
+    else if ( cmd != JDKSAVDECC_AEM_COMMAND_EXPANSION
+              && wasTimeOutHit( time_in_millis, m_last_sent_command_time, JDKSAVDECC_AEM_TIMEOUT_IN_MS ) )
+    {
+        // We had a command in flight that timed out
+        InflightCommand timed_out;
+        getLastSentCommand( &timed_out, m_outgoing_sequence_id );
         m_last_sent_command_type = JDKSAVDECC_AEM_COMMAND_EXPANSION; // clear knowledge of sent
                                                                      // command
+        m_last_sent_command_notification = 0;
+        handleCommandTimeOut( timed_out.m_target_entity_id, cmd, m_outgoing_sequence_id );
 
-        // Was the command a CONTROLLER_AVAILABLE? if so, handle it here
-        if ( cmd == JDKSAVDECC_AEM_COMMAND_CONTROLLER_AVAILABLE )
-        {
-            // Yes, this means that the old controller goes away and the new one
-            // is approved
-            m_acquired_by_controller_entity_id = m_acquire_in_progress_by_controller_entity_id;
-            // Also clear any lock that may have been there
-            m_locked_by_controller_entity_id = Eui64();
-            // TODO: Formulate and send reply to the new controller
-        }
-        else
+        if ( timed_out.m_notification )
         {
-            // Notify entity info about the timed out command
-            commandTimedOut( m_last_sent_command_target_entity_id, cmd, m_outgoing_sequence_id );
+            timed_out.m_notification->inflightCommandTimedOut( timed_out );
         }
     }
 
@@ -122,6 +127,156 @@ void Entity::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
     {
         m_acmp_listener_group_handler->tick( time_in_millis );
     }
+
+    if ( m_unsolicited_coalescer )
+    {
+        // Send the latest of each held back unsolicited response whose
+        // window has passed
+        UnsolicitedResponse *due;
+        while ( ( due = m_unsolicited_coalescer->getDue( time_in_millis ) ) != 0 )
+        {
+            Frame pdu( time_in_millis, 0, 0 );
+            pdu.wrap( time_in_millis, due->m_pdu, due->m_pdu_length );
+            sendToRegisteredControllers( due->m_internally_generated, pdu, 0, 0 );
+        }
+    }
+
+    scheduleNextTick();
+}
+
+Timer *Entity::getTimer()
+{
+    Timer *r = 0;
+    if ( !m_acmp_controller_group_handler && !m_acmp_talker_group_handler && !m_acmp_listener_group_handler )
+    {
+        r = &m_timer;
+    }
+    return r;
+}
+
+void Entity::scheduleNextTick()
+{
+    bool pending = false;
+    jdksavdecc_timestamp_in_milliseconds next_time = 0;
+
+    if ( isSet( m_locked_by_controller_entity_id ) )
+    {
+        next_time = m_locked_time + JDKSAVDECC_AEM_LOCK_TIMEOUT_MS + 1;
+        pending = true;
+    }
+
+    if ( m_inflight_commands )
+    {
+        for ( uint16_t i = 0; i < m_inflight_commands->getCount(); ++i )
+        {
+            InflightCommand *cmd = m_inflight_commands->getItem( i );
+            jdksavdecc_timestamp_in_milliseconds t = cmd->m_sent_time + cmd->m_timeout_in_ms + 1;
+            if ( !pending || t < next_time )
+            {
+                next_time = t;
+                pending = true;
+            }
+        }
+    }
+    else if ( m_last_sent_command_type != JDKSAVDECC_AEM_COMMAND_EXPANSION )
+    {
+        jdksavdecc_timestamp_in_milliseconds t = m_last_sent_command_time + JDKSAVDECC_AEM_TIMEOUT_IN_MS + 1;
+        if ( !pending || t < next_time )
+        {
+            next_time = t;
+            pending = true;
+        }
+    }
+
+    if ( m_unsolicited_coalescer )
+    {
+        jdksavdecc_timestamp_in_milliseconds t;
+        if ( m_unsolicited_coalescer->getNextDeadline( &t ) && ( !pending || t < next_time ) )
+        {
+            next_time = t;
+            pending = true;
+        }
+    }
+
+    if ( pending )
+    {
+        m_timer.scheduleAt( next_time );
+    }
+    else
+    {
+        m_timer.cancel();
+    }
+}
+
+void Entity::tickInflightCommands( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    uint16_t i = 0;
+    while ( i < m_inflight_commands->getCount() )
+    {
+        InflightCommand *cmd = m_inflight_commands->getItem( i );
+
+        if ( !wasTimeOutHit( time_in_millis, cmd->m_sent_time, cmd->m_timeout_in_ms ) )
+        {
+            ++i;
+        }
+        else if ( cmd->m_retries_left > 0 && cmd->m_pdu_length > 0 )
+        {
+            // Retransmit the stored pdu with the same sequence id
+            Frame pdu( time_in_millis, cmd->m_pdu, cmd->m_pdu_length );
+            pdu.setLength( cmd->m_pdu_length );
+            getRawSocket().sendFrame( pdu );
+            cmd->m_retries_left--;
+            cmd->m_sent_time = time_in_millis;
+            ++i;
+        }
+        else
+        {
+            // Out of retries. Remove it from the table before notifying so
+            // that the notification may send a new command in its place.
+            // The last item is moved into slot i so i is not incremented
+            InflightCommand timed_out = *cmd;
+            m_inflight_commands->remove( cmd );
+
+            handleCommandTimeOut( timed_out.m_target_entity_id, timed_out.m_command_type, timed_out.m_sequence_id );
+
+            if ( timed_out.m_notification )
+            {
+                timed_out.m_notification->inflightCommandTimedOut( timed_out );
+            }
+        }
+    }
+}
+
+void Entity::getLastSentCommand( InflightCommand *cmd, uint16_t sequence_id ) const
+{
+    cmd->m_target_entity_id = m_last_sent_command_target_entity_id;
+    cmd->m_target_mac_address = Eui48();
+    cmd->m_sequence_id = sequence_id;
+    cmd->m_command_type = m_last_sent_command_type;
+    cmd->m_sent_time = m_last_sent_command_time;
+    cmd->m_timeout_in_ms = JDKSAVDECC_AEM_TIMEOUT_IN_MS;
+    cmd->m_retries_left = 0;
+    cmd->m_notification = m_last_sent_command_notification;
+    cmd->m_pdu_length = 0;
+}
+
+void Entity::handleCommandTimeOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id )
+{
+    // Was the command a CONTROLLER_AVAILABLE? if so, handle it here
+    if ( command_type == JDKSAVDECC_AEM_COMMAND_CONTROLLER_AVAILABLE )
+    {
+        // Yes, this means that the old controller goes away and the new one
+        // is approved
+        m_acquired_by_controller_entity_id = m_acquire_in_progress_by_controller_entity_id;
+        // Also clear any lock that may have been there
+        m_locked_by_controller_entity_id = Eui64();
+        // TODO: Formulate and send reply to the new controller
+    }
+    else
+    {
+        // Notify entity info about the timed out command
+        commandTimedOut( target_entity_id, command_type, sequence_id );
+    }
 }
 
 void Entity::commandTimedOut( Eui64 const &target_entity_id, uint16_t command_type, uint16_t sequence_id )
@@ -150,7 +305,19 @@ bool Entity::receivedPDU( RawSocket *incoming_socket, Frame &frame )
         {
             if ( isAEMForTarget( aem, getEntityID() ) )
             {
-                status_code = receivedAEMCommand( incoming_socket, aem, frame );
+                // The response is built in place. A frame lent out by a
+                // receive ring has no room to grow, so work on a copy
+                FrameWithMTU pdu( frame.getTimeInMilliseconds() );
+                if ( frame.getMaxLength() < pdu.getMaxLength() )
+                {
+                    pdu.putBuf( frame.getBuf(), frame.getLength() );
+                    pdu.setPort( frame.getPort() );
+                    status_code = receivedAEMCommand( incoming_socket, aem, pdu );
+                }
+                else
+                {
+                    status_code = receivedAEMCommand( incoming_socket, aem, frame );
+                }
                 r = true;
             }
         }
@@ -166,7 +333,17 @@ bool Entity::receivedPDU( RawSocket *incoming_socket, Frame &frame )
             // Yes, is it a command to read/write data?
             if ( isAAForTarget( aa, getEntityID() ) )
             {
-                status_code = receivedAACommand( incoming_socket, aa, frame );
+                FrameWithMTU pdu( frame.getTimeInMilliseconds() );
+                if ( frame.getMaxLength() < pdu.getMaxLength() )
+                {
+                    pdu.putBuf( frame.getBuf(), frame.getLength() );
+                    pdu.setPort( frame.getPort() );
+                    status_code = receivedAACommand( incoming_socket, aa, pdu );
+                }
+                else
+                {
+                    status_code = receivedAACommand( incoming_socket, aa, frame );
+                }
                 r = true;
             }
         }
@@ -189,6 +366,30 @@ bool Entity::receivedPDU( RawSocket *incoming_socket, Frame &frame )
 
     (void)status_code;
 
+    if ( r )
+    {
+        // The command may have changed the lock state, look again soon
+        m_timer.scheduleNoLaterThan( getRawSocket().getTimeInMilliseconds() );
+    }
+
+    return r;
+}
+
+uint16_t Entity::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 3 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND );
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                        JDKSAVDECC_AVTP_ETHERTYPE,
+                                        JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                        JDKSAVDECC_AECP_MESSAGE_TYPE_ADDRESS_ACCESS_COMMAND );
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::SUBTYPE, JDKSAVDECC_AVTP_ETHERTYPE, JDKSAVDECC_1722A_SUBTYPE_ACMP );
+    }
     return r;
 }
 
@@ -202,6 +403,16 @@ uint8_t Entity::receivedAEMCommand( RawSocket *incoming_socket, jdksavdecc_aecpd
     // commands that change state will set command_is_set_something to true
     bool command_is_set_something = false;
 
+    // The entity state may add payload to the response while handling it
+    m_num_response_fragments = 0;
+
+    // A controller that sends commands has not gone away
+    if ( m_registered_controllers )
+    {
+        m_registered_controllers->refreshController( aem.aecpdu_header.controller_entity_id,
+                                                     getRawSocket().getTimeInMilliseconds() );
+    }
+
     switch ( actual_command_type )
     {
     case JDKSAVDECC_AEM_COMMAND_ACQUIRE_ENTITY:
@@ -304,9 +515,28 @@ uint8_t Entity::receivedAEMCommand( RawSocket *incoming_socket, jdksavdecc_aecpd
     pdu.setOctet( ( pdu.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 2 ) & 0x7 ) + ( response_status << 3 ),
                   JDKSAVDECC_FRAME_HEADER_LEN + 2 );
 
+    // Count the added payload in the control_data_length
+    if ( m_num_response_fragments > 0 )
+    {
+        uint16_t control_data_length = pdu.getLength() - JDKSAVDECC_FRAME_HEADER_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+        for ( uint16_t i = 0; i < m_num_response_fragments; ++i )
+        {
+            control_data_length += m_response_fragment[i].m_length;
+        }
+        pdu.setOctet( ( pdu.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 2 ) & 0xf8 ) + ( ( control_data_length >> 8 ) & 0x7 ),
+                      JDKSAVDECC_FRAME_HEADER_LEN + 2 );
+        pdu.setOctet( uint8_t( control_data_length & 0xff ), JDKSAVDECC_FRAME_HEADER_LEN + 3 );
+    }
+
     // Send the response to either just the requesting controller or it and all
     // registered controllers
-    sendResponses( false, command_is_set_something && response_status == JDKSAVDECC_AECP_STATUS_SUCCESS, response_status, pdu );
+    sendResponseFragments( false,
+                           command_is_set_something && response_status == JDKSAVDECC_AECP_STATUS_SUCCESS,
+                           response_status,
+                           pdu,
+                           m_response_fragment,
+                           m_num_response_fragments );
+    m_num_response_fragments = 0;
 
     return response_status;
 }
@@ -452,21 +682,24 @@ uint8_t Entity::receivedACMPMessage( RawSocket *incoming_socket, const jdksavdec
     return status;
 }
 
-void Entity::sendResponses( bool internally_generated,
-                            bool send_to_registered_controllers,
-                            uint8_t aecp_status_code,
-                            Frame &pdu,
-                            uint8_t const *additional_data1,
-                            uint16_t additional_data_length1,
-                            uint8_t const *additional_data2,
-                            uint16_t additional_data_length2 )
+bool Entity::addResponseFragment( uint8_t const *data, uint16_t length )
 {
-    // buf already contains the requestor's mac address and controller. Capture
-    // the controller entity id
-    Eui64 original_controller_id;
-
-    original_controller_id = Eui64();
+    bool r = false;
+    if ( m_num_response_fragments < JDKSAVDECCMCU_ENTITY_MAX_RESPONSE_FRAGMENTS )
+    {
+        m_response_fragment[m_num_response_fragments++] = FrameFragment( data, length );
+        r = true;
+    }
+    return r;
+}
 
+void Entity::sendResponseFragments( bool internally_generated,
+                                    bool send_to_registered_controllers,
+                                    uint8_t aecp_status_code,
+                                    Frame &pdu,
+                                    FrameFragment const *fragments,
+                                    uint16_t num_fragments )
+{
     pdu.setOctet( ( ( pdu.getOctet( 2 ) & 0xf8 ) | ( aecp_status_code << 3 ) ), 2 );
 
     if ( !internally_generated )
@@ -475,7 +708,7 @@ void Entity::sendResponses( bool internally_generated,
         // request.
 
         // Send the buf to the original
-        getRawSocket().sendReplyFrame( pdu, additional_data1, additional_data_length1, additional_data2, additional_data_length2 );
+        getRawSocket().sendReplyFrameFragments( pdu, fragments, num_fragments );
     }
     else
     {
@@ -484,59 +717,134 @@ void Entity::sendResponses( bool internally_generated,
 
     if ( send_to_registered_controllers )
     {
+        // The registered controllers may be on any of the network ports
+        pdu.setPort( JDKSAVDECCMCU_FRAME_ANY_PORT );
+
         // Mark the message as an unsolicited response
         jdksavdecc_aecpdu_aem_set_command_type( jdksavdecc_aecpdu_aem_get_command_type( pdu.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN )
                                                 | 0x8000,
                                                 pdu.getBuf(),
                                                 JDKSAVDECC_FRAME_HEADER_LEN );
 
-        // Now go through all subscribed entities
-        for ( uint16_t i = 0; i < m_registered_controllers->getControllerCount(); ++i )
+        if ( m_unsolicited_coalescer
+             && !m_unsolicited_coalescer->offer(
+                    pdu, fragments, num_fragments, internally_generated, getRawSocket().getTimeInMilliseconds() ) )
         {
-            RegisteredController const *controller = m_registered_controllers->getController( i );
+            // Held back, tick() sends the latest one when the window has
+            // passed
+            scheduleNextTick();
+        }
+        else
+        {
+            sendToRegisteredControllers( internally_generated, pdu, fragments, num_fragments );
+        }
+    }
+}
 
-            // don't send the original requesting controller a double
-            // response
-            // and skip sending a second message to the acquiring controller even it if also registered explicitely
-            if ( original_controller_id != controller->m_entity_id
-                 && controller->m_entity_id != m_acquired_by_controller_entity_id )
-            {
-                // Set the controller_entity_id in the frame
+void Entity::sendToRegisteredControllers( bool internally_generated,
+                                          Frame const &pdu,
+                                          FrameFragment const *fragments,
+                                          uint16_t num_fragments )
+{
+    uint16_t const head_length = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_LEN;
+    if ( pdu.getLength() < head_length || num_fragments >= JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS )
+    {
+        return;
+    }
 
-                controller->m_entity_id.store( pdu.getBuf(),
-                                               JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID );
+    // The copies only differ in the destination address and the
+    // controller_entity_id, so each copy is just its own header and the
+    // rest of the response is shared by all of them
+    FrameFragment tail[JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS];
+    uint16_t num_tail = 0;
+    tail[num_tail++] = FrameFragment( pdu.getBuf( head_length ), pdu.getLength() - head_length );
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        tail[num_tail++] = fragments[i];
+    }
+
+    FrameWithSize<JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_LEN> head[JDKSAVDECCMCU_ENTITY_UNSOLICITED_BATCH];
+    Frame const *batch[JDKSAVDECCMCU_ENTITY_UNSOLICITED_BATCH];
+    uint16_t num_batch = 0;
+
+    uint16_t num_controllers = 0;
+    if ( m_registered_controllers )
+    {
+        // Don't keep sending to controllers that went away without
+        // deregistering
+        m_registered_controllers->expireControllers( getRawSocket().getTimeInMilliseconds() );
+        num_controllers = m_registered_controllers->getControllerCount();
+    }
+    bool send_to_acquirer = internally_generated && m_acquired_by_controller_entity_id.isSet();
+
+    // Go through all subscribed entities, and the acquiring controller last
+    for ( uint16_t i = 0; i <= num_controllers; ++i )
+    {
+        Eui64 controller_entity_id;
+        Eui48 controller_mac_address;
 
-                // Set the destination mac address
-                pdu.setDA( controller->m_mac_address );
+        if ( i < num_controllers )
+        {
+            RegisteredController const *controller = m_registered_controllers->getController( i );
 
-                // Send the frame to that controller
-                getRawSocket().sendFrame(
-                    pdu, additional_data1, additional_data_length1, additional_data2, additional_data_length2 );
+            // skip sending a second message to the acquiring controller even
+            // it if also registered explicitely
+            if ( controller->m_entity_id == m_acquired_by_controller_entity_id )
+            {
+                continue;
             }
+            controller_entity_id = controller->m_entity_id;
+            controller_mac_address = controller->m_mac_address;
         }
-
-        // If the message is internally generated, also send it to the controller that acquired the entity
-        if ( internally_generated && m_acquired_by_controller_entity_id.isSet() )
+        else if ( send_to_acquirer )
+        {
+            // If the message is internally generated, also send it to the
+            // controller that acquired the entity
+            controller_entity_id = m_acquired_by_controller_entity_id;
+            controller_mac_address = m_acquired_by_controller_mac_address;
+        }
+        else
         {
-            m_acquired_by_controller_entity_id.store(
-                pdu.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID );
-            pdu.setDA( m_acquired_by_controller_mac_address );
+            break;
+        }
 
-            // Send the frame to that controller
-            getRawSocket().sendFrame( pdu, additional_data1, additional_data_length1, additional_data2, additional_data_length2 );
+        // Make this controller's header
+        Frame &h = head[num_batch];
+        h.setLength( 0 );
+        h.putBuf( pdu.getBuf(), head_length );
+        h.setTimeInMilliseconds( pdu.getTimeInMilliseconds() );
+        h.setPort( pdu.getPort() );
+        controller_entity_id.store( h.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID );
+        h.setDA( controller_mac_address );
+        batch[num_batch++] = &h;
+
+        if ( num_batch == JDKSAVDECCMCU_ENTITY_UNSOLICITED_BATCH )
+        {
+            getRawSocket().sendFrameFragmentsBatch( batch, num_batch, tail, num_tail );
+            num_batch = 0;
         }
     }
+
+    if ( num_batch > 0 )
+    {
+        getRawSocket().sendFrameFragmentsBatch( batch, num_batch, tail, num_tail );
+    }
 }
 
-void Entity::sendCommand( Eui64 const &target_entity_id,
-                          Eui48 const &target_mac_address,
-                          uint16_t aem_command_type,
-                          bool track_for_ack,
-                          uint8_t const *additional_data1,
-                          uint16_t additional_data_length1,
-                          uint8_t const *additional_data2,
-                          uint16_t additional_data_length2 )
+bool Entity::sendCommandFragments( Eui64 const &target_entity_id,
+                                   Eui48 const &target_mac_address,
+                                   uint16_t aem_command_type,
+                                   bool track_for_ack,
+                                   FrameFragment const *fragments,
+                                   uint16_t num_fragments,
+                                   InflightCommandNotification *notification )
 {
+    // With an in-flight table, a tracked command is only sent if there is
+    // room to track it
+    if ( track_for_ack && m_inflight_commands && m_inflight_commands->isFull() )
+    {
+        return false;
+    }
 
     // Make a temp pdu buffer just long enough to contain:
     // ethernet frame DA,SA,Ethertype, AVTP Common Control Header, AVDECC AEM
@@ -545,8 +853,11 @@ void Entity::sendCommand( Eui64 const &target_entity_id,
         0, target_mac_address, getRawSocket().getMACAddress(), JDKSAVDECC_AVTP_ETHERTYPE );
 
     // control_data_length field is N + value_length
-    uint16_t control_data_length = JDKSAVDECC_AECPDU_AEM_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN + additional_data_length1
-                                   + additional_data_length2;
+    uint16_t control_data_length = JDKSAVDECC_AECPDU_AEM_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        control_data_length += fragments[i].m_data ? fragments[i].m_length : 0;
+    }
 
     // AECPDU common control header
     pdu.putOctet( JDKSAVDECC_1722A_SUBTYPE_AECP );                   // cd=1, subtype=0x7b (AECP)
@@ -562,30 +873,57 @@ void Entity::sendCommand( Eui64 const &target_entity_id,
 
     // increment outoging sequence id before sending it, so when we receive a
     // response we know what sequence id to expect
-    // there are no inflight messages here
     ++m_outgoing_sequence_id;
     pdu.putDoublet( m_outgoing_sequence_id );
     pdu.putDoublet( aem_command_type );
 
-    // Send the header appended to any additional data
-    getRawSocket().sendFrame( pdu, additional_data1, additional_data_length1, additional_data2, additional_data_length2 );
+    // Send the header followed by the fragments
+    getRawSocket().sendFrameFragments( pdu, fragments, num_fragments );
 
     if ( track_for_ack )
     {
-        // Keep track of when we sent this message and who we sent it to so we
-        // can
-        // manage time outs
-        m_last_sent_command_time = getRawSocket().getTimeInMilliseconds();
-        m_last_sent_command_type = aem_command_type;
-        m_last_sent_command_target_entity_id = target_entity_id;
+        jdksavdecc_timestamp_in_milliseconds now = getRawSocket().getTimeInMilliseconds();
+
+        if ( m_inflight_commands )
+        {
+            // Keep the command in the table, keyed by target entity id and
+            // sequence id, with a copy of the pdu for retransmission
+            InflightCommand *cmd = m_inflight_commands->add(
+                target_entity_id, target_mac_address, m_outgoing_sequence_id, aem_command_type, now, notification );
+            m_inflight_commands->storePdu( cmd, pdu, fragments, num_fragments );
+
+            // Make sure that the time out is noticed
+            m_timer.scheduleNoLaterThan( now + cmd->m_timeout_in_ms + 1 );
+        }
+        else
+        {
+            // Only one command is tracked, so a response to the one that this
+            // replaces will not be matched
+            InflightCommand replaced;
+            replaced.m_notification = 0;
+            if ( m_last_sent_command_type != JDKSAVDECC_AEM_COMMAND_EXPANSION )
+            {
+                getLastSentCommand( &replaced, m_outgoing_sequence_id - 1 );
+            }
+
+            // Keep track of when we sent this message and who we sent it to
+            // so we can manage time outs
+            m_last_sent_command_time = now;
+            m_last_sent_command_type = aem_command_type;
+            m_last_sent_command_target_entity_id = target_entity_id;
+            m_last_sent_command_notification = notification;
+            m_timer.scheduleNoLaterThan( now + JDKSAVDECC_AEM_TIMEOUT_IN_MS + 1 );
+
+            if ( replaced.m_notification )
+            {
+                replaced.m_notification->inflightCommandTimedOut( replaced );
+            }
+        }
     }
+    return true;
 }
 
-void Entity::sendUnsolicitedResponses( uint16_t aem_command_type,
-                                       uint8_t const *additional_data1,
-                                       uint16_t additional_data_length1,
-                                       uint8_t const *additional_data2,
-                                       uint16_t additional_data_length2 )
+void Entity::sendUnsolicitedResponseFragments( uint16_t aem_command_type, FrameFragment const *fragments, uint16_t num_fragments )
 {
 
     // Make a temp pdu buffer just long enough to contain:
@@ -595,8 +933,11 @@ void Entity::sendUnsolicitedResponses( uint16_t aem_command_type,
         0, getRawSocket().getMACAddress(), getRawSocket().getMACAddress(), JDKSAVDECC_AVTP_ETHERTYPE );
 
     // control_data_length field is N + value_length
-    uint16_t control_data_length = JDKSAVDECC_AECPDU_AEM_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN + additional_data_length1
-                                   + additional_data_length2;
+    uint16_t control_data_length = JDKSAVDECC_AECPDU_AEM_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        control_data_length += fragments[i].m_data ? fragments[i].m_length : 0;
+    }
 
     // AECPDU common control header
 
@@ -626,14 +967,7 @@ void Entity::sendUnsolicitedResponses( uint16_t aem_command_type,
     pdu.putDoublet( m_outgoing_sequence_id );
     pdu.putDoublet( aem_command_type );
 
-    sendResponses( true,
-                   true,
-                   JDKSAVDECC_AECP_STATUS_SUCCESS,
-                   pdu,
-                   additional_data1,
-                   additional_data_length1,
-                   additional_data2,
-                   additional_data_length2 );
+    sendResponseFragments( true, true, JDKSAVDECC_AECP_STATUS_SUCCESS, pdu, fragments, num_fragments );
 }
 
 uint8_t Entity::receiveAcquireEntityCommand( jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
@@ -765,6 +1099,8 @@ uint8_t Entity::receiveRegisterUnsolicitedNotificationCommand( jdksavdecc_aecpdu
     bool registered = m_registered_controllers->addController( aem.aecpdu_header.controller_entity_id, pdu.getSA() );
     if ( registered )
     {
+        m_registered_controllers->refreshController( aem.aecpdu_header.controller_entity_id,
+                                                     getRawSocket().getTimeInMilliseconds() );
         status = JDKSAVDECC_AECP_STATUS_SUCCESS;
     }
     return status;
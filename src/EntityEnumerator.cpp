@@ -0,0 +1,547 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/EntityEnumerator.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+bool DescriptorStore::add( uint8_t const *descriptor, uint16_t descriptor_length )
+{
+    bool r = false;
+    if ( m_length + 2 + descriptor_length <= m_max_length )
+    {
+        jdksavdecc_uint16_set( descriptor_length, m_buf, m_length );
+        memcpy( m_buf + m_length + 2, descriptor, descriptor_length );
+        m_length += 2 + descriptor_length;
+        m_count++;
+        r = true;
+    }
+    return r;
+}
+
+uint8_t const *DescriptorStore::find( uint16_t descriptor_type, uint16_t descriptor_index, uint16_t *descriptor_length ) const
+{
+    uint8_t const *r = 0;
+    uint32_t pos = 0;
+    uint16_t len = 0;
+    uint8_t const *p;
+    while ( ( p = getNext( &pos, &len ) ) != 0 )
+    {
+        if ( len >= 4 && jdksavdecc_uint16_get( p, 0 ) == descriptor_type && jdksavdecc_uint16_get( p, 2 ) == descriptor_index )
+        {
+            *descriptor_length = len;
+            r = p;
+            break;
+        }
+    }
+    return r;
+}
+
+uint8_t const *DescriptorStore::getNext( uint32_t *pos, uint16_t *descriptor_length ) const
+{
+    uint8_t const *r = 0;
+    if ( *pos + 2 <= m_length )
+    {
+        *descriptor_length = jdksavdecc_uint16_get( m_buf, *pos );
+        r = m_buf + *pos + 2;
+        *pos += 2 + *descriptor_length;
+    }
+    return r;
+}
+
+EntityEnumerator::EntityEnumerator( ControllerEntity &controller_entity,
+                                    EnumeratedEntity *entity_storage,
+                                    uint8_t *store_storage,
+                                    uint16_t max_entities,
+                                    uint32_t store_length_per_entity,
+                                    uint16_t max_outstanding_per_entity,
+                                    uint8_t max_attempts )
+    : m_controller_entity( controller_entity )
+    , m_entities( entity_storage )
+    , m_store_storage( store_storage )
+    , m_max_entities( max_entities )
+    , m_store_length_per_entity( store_length_per_entity )
+    , m_max_outstanding_per_entity( max_outstanding_per_entity )
+    , m_max_attempts( max_attempts )
+{
+    // Entity slots are free while their entity id is unset, which is the
+    // state that Eui64's default constructor leaves them in
+}
+
+bool EntityEnumerator::enumerate( Eui64 const &entity_id, Eui48 const &mac_address )
+{
+    bool r = false;
+    EnumeratedEntity *entity = findEntity( entity_id );
+
+    if ( entity && entity->m_outstanding > 0 )
+    {
+        // Responses to the commands of the last walk would be taken for
+        // the new one's, so wait for them before starting again
+        entity->m_mac_address = mac_address;
+        entity->m_restart_pending = true;
+        r = true;
+    }
+    else
+    {
+        if ( !entity )
+        {
+            // find a free slot
+            for ( uint16_t i = 0; i < m_max_entities; ++i )
+            {
+                if ( m_entities[i].m_entity_id.isUnset() )
+                {
+                    entity = &m_entities[i];
+                    entity->m_store.setStorage( m_store_storage + i * m_store_length_per_entity, m_store_length_per_entity );
+                    break;
+                }
+            }
+        }
+
+        if ( entity )
+        {
+            entity->m_entity_id = entity_id;
+            entity->m_mac_address = mac_address;
+            entity->m_outstanding = 0;
+            r = start( entity );
+        }
+    }
+    return r;
+}
+
+bool EntityEnumerator::start( EnumeratedEntity *entity )
+{
+    jdksavdecc_timestamp_in_milliseconds now = m_controller_entity.getRawSocket().getTimeInMilliseconds();
+
+    entity->m_state = EnumeratedEntity::READING_ENTITY;
+    entity->m_configuration_index = 0;
+    entity->m_counts_pos = 0;
+    entity->m_next_index = 0;
+    entity->m_restart_pending = false;
+    entity->m_missing_count = 0;
+    entity->m_retry_count = 0;
+    entity->m_start_time = now;
+    entity->m_end_time = now;
+    entity->m_store.clear();
+
+    // The walk starts at the ENTITY descriptor
+    bool r = sendRead( entity, JDKSAVDECC_DESCRIPTOR_ENTITY, 0 );
+    if ( !r )
+    {
+        entity->m_entity_id.clear();
+    }
+    return r;
+}
+
+bool EntityEnumerator::commandFinished( EnumeratedEntity *entity )
+{
+    bool r = false;
+    if ( entity->m_outstanding > 0 )
+    {
+        entity->m_outstanding--;
+        if ( entity->m_restart_pending )
+        {
+            // The command was from the last walk
+            if ( entity->m_outstanding == 0 )
+            {
+                start( entity );
+            }
+        }
+        else
+        {
+            r = !entity->isDone();
+        }
+    }
+    return r;
+}
+
+void EntityEnumerator::forget( Eui64 const &entity_id )
+{
+    EnumeratedEntity *entity = findEntity( entity_id );
+    if ( entity )
+    {
+        // Responses to outstanding commands will no longer find it
+        entity->m_entity_id.clear();
+    }
+}
+
+EnumeratedEntity *EntityEnumerator::findEntity( Eui64 const &entity_id )
+{
+    EnumeratedEntity *r = 0;
+    for ( uint16_t i = 0; i < m_max_entities; ++i )
+    {
+        if ( m_entities[i].m_entity_id == entity_id )
+        {
+            r = &m_entities[i];
+            break;
+        }
+    }
+    return r;
+}
+
+void EntityEnumerator::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    (void)time_in_millis;
+
+    // Retry anything that could not be sent because the queues were full
+    for ( uint16_t i = 0; i < m_max_entities; ++i )
+    {
+        EnumeratedEntity *entity = &m_entities[i];
+        if ( entity->m_entity_id.isSet() && !entity->isDone() && !entity->m_restart_pending )
+        {
+            issue( entity );
+            checkDone( entity );
+        }
+    }
+}
+
+bool EntityEnumerator::receivedPDU( RawSocket *incoming_socket, Frame &frame )
+{
+    (void)incoming_socket;
+    (void)frame;
+    return false;
+}
+
+uint16_t EntityEnumerator::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    uint16_t r = 0;
+    if ( max_keys >= 1 )
+    {
+        keys[r++] = HandlerDispatchKey( HandlerDispatchKey::NONE );
+    }
+    return r;
+}
+
+void EntityEnumerator::inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu )
+{
+    EnumeratedEntity *entity = findEntity( cmd.m_target_entity_id );
+
+    if ( entity && cmd.m_command_type == JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR && commandFinished( entity ) )
+    {
+        // The descriptor that was asked for
+        uint16_t descriptor_type
+            = jdksavdecc_aem_command_read_descriptor_get_descriptor_type( cmd.m_pdu, JDKSAVDECC_FRAME_HEADER_LEN );
+        uint16_t descriptor_index
+            = jdksavdecc_aem_command_read_descriptor_get_descriptor_index( cmd.m_pdu, JDKSAVDECC_FRAME_HEADER_LEN );
+
+        // The descriptor in the response runs to the end of the control data
+        uint32_t descriptor_pos = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR_RESPONSE_OFFSET_DESCRIPTOR;
+        uint32_t descriptor_end
+            = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_LEN + aem.aecpdu_header.header.control_data_length;
+
+        // Remove it from the retry list if it was being retried
+        for ( uint16_t i = 0; i < entity->m_retry_count; ++i )
+        {
+            if ( entity->m_retry[i].m_descriptor_type == descriptor_type
+                 && entity->m_retry[i].m_descriptor_index == descriptor_index )
+            {
+                entity->m_retry[i] = entity->m_retry[--entity->m_retry_count];
+                break;
+            }
+        }
+
+        if ( aem.aecpdu_header.header.status == JDKSAVDECC_AEM_STATUS_SUCCESS && descriptor_end <= pdu.getLength()
+             && descriptor_end >= descriptor_pos + 4 )
+        {
+            descriptorReceived( entity, pdu.getBuf( descriptor_pos ), uint16_t( descriptor_end - descriptor_pos ) );
+        }
+        else
+        {
+            // The entity answered, so asking again will not help
+            descriptorFailed( entity, descriptor_type, descriptor_index, false );
+        }
+
+        issue( entity );
+        checkDone( entity );
+    }
+}
+
+void EntityEnumerator::inflightCommandTimedOut( InflightCommand const &cmd )
+{
+    EnumeratedEntity *entity = findEntity( cmd.m_target_entity_id );
+
+    if ( entity && cmd.m_command_type == JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR && commandFinished( entity ) )
+    {
+        uint16_t descriptor_type
+            = jdksavdecc_aem_command_read_descriptor_get_descriptor_type( cmd.m_pdu, JDKSAVDECC_FRAME_HEADER_LEN );
+        uint16_t descriptor_index
+            = jdksavdecc_aem_command_read_descriptor_get_descriptor_index( cmd.m_pdu, JDKSAVDECC_FRAME_HEADER_LEN );
+
+        descriptorFailed( entity, descriptor_type, descriptor_index, true );
+
+        issue( entity );
+        checkDone( entity );
+    }
+}
+
+void EntityEnumerator::enumerationCompleted( EnumeratedEntity const &entity )
+{
+    (void)entity;
+}
+
+void EntityEnumerator::issue( EnumeratedEntity *entity )
+{
+    bool sent = true;
+    while ( sent && !entity->isDone() && entity->m_outstanding < m_max_outstanding_per_entity )
+    {
+        sent = false;
+
+        // Descriptors to read again go first
+        for ( uint16_t i = 0; i < entity->m_retry_count; ++i )
+        {
+            EnumeratorRetry &retry = entity->m_retry[i];
+            if ( !retry.m_in_flight )
+            {
+                sent = sendRead( entity, retry.m_descriptor_type, retry.m_descriptor_index );
+                retry.m_in_flight = sent;
+                break;
+            }
+        }
+
+        // Then the next descriptor of the walk
+        if ( !sent && entity->m_state == EnumeratedEntity::READING_DESCRIPTORS )
+        {
+            uint16_t counts_pos = entity->m_counts_pos;
+            uint16_t next_index = entity->m_next_index;
+            uint16_t descriptor_type;
+            uint16_t descriptor_index;
+
+            if ( nextDescriptor( entity, &descriptor_type, &descriptor_index ) )
+            {
+                sent = sendRead( entity, descriptor_type, descriptor_index );
+                if ( !sent )
+                {
+                    // The queue is full; try this one again on the next tick
+                    entity->m_counts_pos = counts_pos;
+                    entity->m_next_index = next_index;
+                }
+            }
+        }
+    }
+}
+
+bool EntityEnumerator::sendRead( EnumeratedEntity *entity, uint16_t descriptor_type, uint16_t descriptor_index )
+{
+    bool r = m_controller_entity.sendReadDescriptor(
+        entity->m_entity_id, entity->m_mac_address, entity->m_configuration_index, descriptor_type, descriptor_index, this );
+    if ( r )
+    {
+        entity->m_outstanding++;
+    }
+    return r;
+}
+
+bool EntityEnumerator::nextDescriptor( EnumeratedEntity *entity, uint16_t *descriptor_type, uint16_t *descriptor_index )
+{
+    bool r = false;
+    uint16_t config_length = 0;
+    uint8_t const *config
+        = entity->m_store.find( JDKSAVDECC_DESCRIPTOR_CONFIGURATION, entity->m_configuration_index, &config_length );
+
+    if ( config && config_length >= JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN )
+    {
+        uint16_t counts_count = jdksavdecc_descriptor_configuration_get_descriptor_counts_count( config, 0 );
+        uint16_t counts_offset = jdksavdecc_descriptor_configuration_get_descriptor_counts_offset( config, 0 );
+
+        while ( !r && entity->m_counts_pos < counts_count )
+        {
+            uint32_t pair_pos = counts_offset + entity->m_counts_pos * 4;
+            if ( pair_pos + 4 > config_length )
+            {
+                // truncated descriptor_counts
+                entity->m_counts_pos = counts_count;
+                break;
+            }
+
+            uint16_t type = jdksavdecc_uint16_get( config, pair_pos );
+            uint16_t count = jdksavdecc_uint16_get( config, pair_pos + 2 );
+
+            if ( entity->m_next_index < count && type != JDKSAVDECC_DESCRIPTOR_ENTITY
+                 && type != JDKSAVDECC_DESCRIPTOR_CONFIGURATION )
+            {
+                *descriptor_type = type;
+                *descriptor_index = entity->m_next_index++;
+                r = true;
+            }
+            else
+            {
+                entity->m_counts_pos++;
+                entity->m_next_index = 0;
+            }
+        }
+    }
+    return r;
+}
+
+void EntityEnumerator::descriptorReceived( EnumeratedEntity *entity, uint8_t const *descriptor, uint16_t descriptor_length )
+{
+    uint16_t descriptor_type = jdksavdecc_uint16_get( descriptor, 0 );
+
+    if ( !entity->m_store.add( descriptor, descriptor_length ) )
+    {
+        // No room to keep it
+        entity->m_missing_count++;
+        if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_CONFIGURATION )
+        {
+            entity->m_state = EnumeratedEntity::FAILED;
+        }
+    }
+    else if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_ENTITY && entity->m_state == EnumeratedEntity::READING_ENTITY )
+    {
+        jdksavdecc_descriptor_entity entity_descriptor;
+        if ( jdksavdecc_descriptor_entity_read( &entity_descriptor, descriptor, 0, descriptor_length ) > 0 )
+        {
+            // Next read the current configuration
+            entity->m_configuration_index = entity_descriptor.current_configuration;
+            entity->m_state = EnumeratedEntity::READING_CONFIGURATION;
+            if ( !sendRead( entity, JDKSAVDECC_DESCRIPTOR_CONFIGURATION, entity->m_configuration_index ) )
+            {
+                descriptorFailed( entity, JDKSAVDECC_DESCRIPTOR_CONFIGURATION, entity->m_configuration_index, true );
+            }
+        }
+        else
+        {
+            entity->m_state = EnumeratedEntity::FAILED;
+        }
+    }
+    else if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_CONFIGURATION && entity->m_state == EnumeratedEntity::READING_CONFIGURATION )
+    {
+        jdksavdecc_descriptor_configuration configuration_descriptor;
+        if ( jdksavdecc_descriptor_configuration_read( &configuration_descriptor, descriptor, 0, descriptor_length ) > 0 )
+        {
+            // Now read everything that the configuration lists
+            entity->m_state = EnumeratedEntity::READING_DESCRIPTORS;
+            entity->m_counts_pos = 0;
+            entity->m_next_index = 0;
+        }
+        else
+        {
+            entity->m_state = EnumeratedEntity::FAILED;
+        }
+    }
+}
+
+void EntityEnumerator::descriptorFailed( EnumeratedEntity *entity,
+                                         uint16_t descriptor_type,
+                                         uint16_t descriptor_index,
+                                         bool can_retry )
+{
+    bool retrying = false;
+
+    if ( can_retry )
+    {
+        // Is it already being retried?
+        EnumeratorRetry *retry = 0;
+        for ( uint16_t i = 0; i < entity->m_retry_count; ++i )
+        {
+            if ( entity->m_retry[i].m_descriptor_type == descriptor_type
+                 && entity->m_retry[i].m_descriptor_index == descriptor_index )
+            {
+                retry = &entity->m_retry[i];
+                break;
+            }
+        }
+
+        if ( !retry && entity->m_retry_count < JDKSAVDECCMCU_ENTITY_ENUMERATOR_MAX_RETRIES )
+        {
+            retry = &entity->m_retry[entity->m_retry_count++];
+            retry->m_descriptor_type = descriptor_type;
+            retry->m_descriptor_index = descriptor_index;
+            retry->m_attempts = 1;
+        }
+
+        if ( retry )
+        {
+            if ( retry->m_attempts < m_max_attempts )
+            {
+                retry->m_attempts++;
+                retry->m_in_flight = false;
+                retrying = true;
+            }
+            else
+            {
+                // Give up on it
+                *retry = entity->m_retry[--entity->m_retry_count];
+            }
+        }
+    }
+
+    if ( !retrying )
+    {
+        if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_ENTITY || descriptor_type == JDKSAVDECC_DESCRIPTOR_CONFIGURATION )
+        {
+            // The walk can not continue without these
+            entity->m_state = EnumeratedEntity::FAILED;
+        }
+        else
+        {
+            entity->m_missing_count++;
+        }
+    }
+}
+
+void EntityEnumerator::checkDone( EnumeratedEntity *entity )
+{
+    bool done = false;
+
+    if ( entity->m_state == EnumeratedEntity::FAILED )
+    {
+        done = true;
+    }
+    else if ( entity->m_state == EnumeratedEntity::READING_DESCRIPTORS && entity->m_outstanding == 0
+              && entity->m_retry_count == 0 )
+    {
+        // Nothing outstanding and nothing to retry, so if the walk has no
+        // more descriptors then it is complete
+        uint16_t descriptor_type;
+        uint16_t descriptor_index;
+        uint16_t counts_pos = entity->m_counts_pos;
+        uint16_t next_index = entity->m_next_index;
+        if ( !nextDescriptor( entity, &descriptor_type, &descriptor_index ) )
+        {
+            entity->m_state = EnumeratedEntity::COMPLETED;
+            done = true;
+        }
+        else
+        {
+            entity->m_counts_pos = counts_pos;
+            entity->m_next_index = next_index;
+        }
+    }
+
+    if ( done )
+    {
+        entity->m_end_time = m_controller_entity.getRawSocket().getTimeInMilliseconds();
+        enumerationCompleted( *entity );
+    }
+}
+}
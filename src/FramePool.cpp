@@ -0,0 +1,236 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/FramePool.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+FrameRef::FrameRef( FrameRef const &other ) : m_pool( other.m_pool ), m_slot( other.m_slot )
+{
+    if ( m_slot )
+    {
+        ++m_slot->m_use_count;
+    }
+}
+
+FrameRef &FrameRef::operator=( FrameRef const &other )
+{
+    if ( m_slot != other.m_slot )
+    {
+        reset();
+        m_pool = other.m_pool;
+        m_slot = other.m_slot;
+        if ( m_slot )
+        {
+            ++m_slot->m_use_count;
+        }
+    }
+    return *this;
+}
+
+FrameRef &FrameRef::operator=( FrameRef &&other )
+{
+    if ( this != &other )
+    {
+        reset();
+        m_pool = other.m_pool;
+        m_slot = other.m_slot;
+        other.m_pool = 0;
+        other.m_slot = 0;
+    }
+    return *this;
+}
+
+void FrameRef::reset()
+{
+    if ( m_slot )
+    {
+        m_pool->release( m_slot );
+        m_pool = 0;
+        m_slot = 0;
+    }
+}
+
+FramePool::FramePool( FramePoolSlot *slots, uint32_t num_slots )
+    : m_slots( slots )
+    , m_num_slots( num_slots )
+    , m_free_head( 0 )
+    , m_available( 0 )
+    , m_low_water( 0 )
+    , m_failure_count( 0 )
+{
+}
+
+void FramePool::initialize()
+{
+    // Chain all of the slots into the free list in order
+    for ( uint32_t i = 0; i < m_num_slots; ++i )
+    {
+        m_slots[i].m_use_count = 0;
+        m_slots[i].m_next_free = ( i + 1 < m_num_slots ) ? i + 2 : 0;
+    }
+    m_free_head = m_num_slots > 0 ? 1 : 0;
+    m_available = m_num_slots;
+    m_low_water = m_num_slots;
+}
+
+FrameRef FramePool::allocate( jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    FramePoolSlot *slot = pop();
+    if ( !slot )
+    {
+        ++m_failure_count;
+        return FrameRef();
+    }
+    return adopt( slot, time_in_ms );
+}
+
+FramePoolSlot *FramePool::pop()
+{
+    FramePoolSlot *slot = 0;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    uint64_t head = m_free_head.load( std::memory_order_acquire );
+    while ( static_cast<uint32_t>( head ) != 0 )
+    {
+        FramePoolSlot *first = &m_slots[static_cast<uint32_t>( head ) - 1];
+        uint64_t next = ( ( head >> 32 ) + 1 ) << 32 | first->m_next_free.load( std::memory_order_relaxed );
+        if ( m_free_head.compare_exchange_weak( head, next, std::memory_order_acq_rel, std::memory_order_acquire ) )
+        {
+            slot = first;
+            break;
+        }
+    }
+#else
+    if ( m_free_head != 0 )
+    {
+        slot = &m_slots[m_free_head - 1];
+        m_free_head = slot->m_next_free;
+    }
+#endif
+    if ( slot )
+    {
+        uint32_t available = --m_available;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+        // Another thread may lower it at the same time, so only replace a
+        // higher value
+        uint32_t low_water = m_low_water.load( std::memory_order_relaxed );
+        while ( available < low_water
+                && !m_low_water.compare_exchange_weak( low_water, available, std::memory_order_relaxed ) )
+        {
+        }
+#else
+        if ( available < m_low_water )
+        {
+            m_low_water = available;
+        }
+#endif
+    }
+    return slot;
+}
+
+void FramePool::push( FramePoolSlot *slot )
+{
+    uint32_t index = static_cast<uint32_t>( slot - m_slots ) + 1;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    uint64_t head = m_free_head.load( std::memory_order_relaxed );
+    uint64_t next;
+    do
+    {
+        slot->m_next_free.store( static_cast<uint32_t>( head ), std::memory_order_relaxed );
+        next = ( ( head >> 32 ) + 1 ) << 32 | index;
+    } while ( !m_free_head.compare_exchange_weak( head, next, std::memory_order_release, std::memory_order_relaxed ) );
+#else
+    slot->m_next_free = m_free_head;
+    m_free_head = index;
+#endif
+    ++m_available;
+}
+
+FrameRef FramePool::adopt( FramePoolSlot *slot, jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    slot->m_use_count = 1;
+    slot->m_frame.clear();
+    slot->m_frame.setTimeInMilliseconds( time_in_ms );
+    slot->m_frame.setPort( JDKSAVDECCMCU_FRAME_ANY_PORT );
+    return FrameRef( this, slot );
+}
+
+void FramePool::release( FramePoolSlot *slot )
+{
+    if ( --slot->m_use_count == 0 )
+    {
+        push( slot );
+    }
+}
+
+FramePoolCache::FramePoolCache( FramePool *pool, FramePoolSlot **storage, uint16_t max_slots )
+    : m_pool( pool ), m_slot( storage ), m_max_slots( max_slots ), m_count( 0 )
+{
+}
+
+FramePoolCache::~FramePoolCache() { flush(); }
+
+FrameRef FramePoolCache::allocate( jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    if ( m_count > 0 )
+    {
+        return m_pool->adopt( m_slot[--m_count], time_in_ms );
+    }
+    return m_pool->allocate( time_in_ms );
+}
+
+void FramePoolCache::recycle( FrameRef &ref )
+{
+    // Only the last handle can keep the frame, and no other thread can be
+    // copying a handle that does not exist
+    if ( ref.m_pool == m_pool && m_count < m_max_slots && ref.isUnique() )
+    {
+        ref.m_slot->m_use_count = 0;
+        m_slot[m_count++] = ref.m_slot;
+        ref.m_pool = 0;
+        ref.m_slot = 0;
+    }
+    else
+    {
+        ref.reset();
+    }
+}
+
+void FramePoolCache::flush()
+{
+    while ( m_count > 0 )
+    {
+        m_pool->push( m_slot[--m_count] );
+    }
+}
+}
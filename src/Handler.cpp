@@ -36,6 +36,73 @@
 namespace JDKSAvdeccMCU
 {
 
+HandlerDispatchKey HandlerDispatchKey::fromFrame( Frame const &frame )
+{
+    uint16_t length = frame.getLength();
+    HandlerDispatchKey key;
+
+    if ( length >= JDKSAVDECC_FRAME_HEADER_LEN )
+    {
+        key.m_level = ETHERTYPE;
+        key.m_ethertype = frame.getEtherType();
+
+        if ( key.m_ethertype == JDKSAVDECC_AVTP_ETHERTYPE && length >= JDKSAVDECC_FRAME_HEADER_LEN + 2 )
+        {
+            uint8_t const *p = frame.getPayload();
+            key.m_level = MESSAGE_TYPE;
+            key.m_subtype = p[0];
+            key.m_message_type = p[1] & 0x0f;
+
+            if ( key.m_subtype == JDKSAVDECC_1722A_SUBTYPE_AECP
+                 && ( key.m_message_type == JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND
+                      || key.m_message_type == JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE )
+                 && length >= JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN )
+            {
+                key.m_level = COMMAND_TYPE;
+                key.m_command_type = jdksavdecc_aecpdu_aem_get_command_type( p, 0 ) & 0x7fff;
+
+                // Find the descriptor addressed by the commands that have one
+                // in a fixed place
+                uint16_t descriptor_pos = 0;
+                switch ( key.m_command_type )
+                {
+                case JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR:
+                    descriptor_pos = JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR_COMMAND_OFFSET_DESCRIPTOR_TYPE;
+                    break;
+                case JDKSAVDECC_AEM_COMMAND_SET_CONTROL:
+                case JDKSAVDECC_AEM_COMMAND_GET_CONTROL:
+                case JDKSAVDECC_AEM_COMMAND_SET_NAME:
+                case JDKSAVDECC_AEM_COMMAND_GET_NAME:
+                    descriptor_pos = JDKSAVDECC_AECPDU_AEM_LEN;
+                    break;
+                }
+
+                if ( descriptor_pos && length >= JDKSAVDECC_FRAME_HEADER_LEN + descriptor_pos + 4 )
+                {
+                    key.m_level = DESCRIPTOR;
+                    key.m_descriptor_type = jdksavdecc_uint16_get( p, descriptor_pos );
+                    key.m_descriptor_index = jdksavdecc_uint16_get( p, descriptor_pos + 2 );
+                }
+            }
+        }
+    }
+    return key;
+}
+
+uint32_t HandlerDispatchKey::hash() const
+{
+    // FNV-1a over the significant fields
+    uint32_t h = 2166136261UL;
+    h = ( h ^ m_level ) * 16777619UL;
+    h = ( h ^ m_ethertype ) * 16777619UL;
+    h = ( h ^ m_subtype ) * 16777619UL;
+    h = ( h ^ m_message_type ) * 16777619UL;
+    h = ( h ^ m_command_type ) * 16777619UL;
+    h = ( h ^ m_descriptor_type ) * 16777619UL;
+    h = ( h ^ m_descriptor_index ) * 16777619UL;
+    return h;
+}
+
 Handler::~Handler() {}
 
 void Handler::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) { (void)time_in_millis; }
@@ -46,5 +113,14 @@ bool Handler::receivedPDU( RawSocket *incoming_socket, Frame &frame )
     return false;
 }
 
+uint16_t Handler::getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const
+{
+    (void)keys;
+    (void)max_keys;
+    return 0;
+}
+
+Timer *Handler::getTimer() { return 0; }
+
 void Handler::addToHandlerGroup( HandlerGroup &group ) { group.add( this ); }
 }
@@ -36,40 +36,448 @@ namespace JDKSAvdeccMCU
 {
 
 HandlerGroup::HandlerGroup( Frame *frame, Handler **item_storage, uint16_t max_items )
-    : m_num_items( 0 ), m_max_items( max_items ), m_item( item_storage ), m_rx_count( 0 ), m_handled_count( 0 ), m_frame( frame )
+    : m_num_items( 0 )
+    , m_max_items( max_items )
+    , m_item( item_storage )
+    , m_rx_count( 0 )
+    , m_handled_count( 0 )
+    , m_frame( frame )
+    , m_ring_frame( 0, 0, 0 )
+    , m_num_wildcards( 0 )
+    , m_wildcard( 0 )
+    , m_num_dispatch_entries( 0 )
+    , m_max_dispatch_entries( 0 )
+    , m_dispatch( 0 )
+    , m_dispatch_levels( 0 )
+    , m_invocation_count( 0 )
+    , m_linear_invocation_count( 0 )
+    , m_num_rawsockets( 0 )
+    , m_num_unwaitable_rawsockets( 0 )
+    , m_waited( false )
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    , m_epoll_fd( -1 )
+#endif
+    , m_frames_pending( false )
+    , m_last_batch( 0 )
+    , m_largest_batch( 0 )
+    , m_loop_count( 0 )
+    , m_idle_time_in_ms( 0 )
+    , m_busy_time_in_ms( 0 )
+    , m_last_loop_latency_in_ms( 0 )
+    , m_max_loop_latency_in_ms( 0 )
+    , m_timer_wheel( 0 )
+    , m_handler_tick_count( 0 )
 {
 }
 
+HandlerGroup::HandlerGroup( Frame *frame,
+                            Handler **item_storage,
+                            uint16_t max_items,
+                            uint16_t *wildcard_storage,
+                            HandlerDispatchEntry *dispatch_storage,
+                            uint16_t max_dispatch_entries )
+    : m_num_items( 0 )
+    , m_max_items( max_items )
+    , m_item( item_storage )
+    , m_rx_count( 0 )
+    , m_handled_count( 0 )
+    , m_frame( frame )
+    , m_ring_frame( 0, 0, 0 )
+    , m_num_wildcards( 0 )
+    , m_wildcard( wildcard_storage )
+    , m_num_dispatch_entries( 0 )
+    , m_max_dispatch_entries( max_dispatch_entries )
+    , m_dispatch( dispatch_storage )
+    , m_dispatch_levels( 0 )
+    , m_invocation_count( 0 )
+    , m_linear_invocation_count( 0 )
+    , m_num_rawsockets( 0 )
+    , m_num_unwaitable_rawsockets( 0 )
+    , m_waited( false )
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    , m_epoll_fd( -1 )
+#endif
+    , m_frames_pending( false )
+    , m_last_batch( 0 )
+    , m_largest_batch( 0 )
+    , m_loop_count( 0 )
+    , m_idle_time_in_ms( 0 )
+    , m_busy_time_in_ms( 0 )
+    , m_last_loop_latency_in_ms( 0 )
+    , m_max_loop_latency_in_ms( 0 )
+    , m_timer_wheel( 0 )
+    , m_handler_tick_count( 0 )
+{
+}
+
+HandlerGroup::~HandlerGroup()
+{
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    if ( m_epoll_fd >= 0 )
+    {
+        ::close( m_epoll_fd );
+    }
+#endif
+}
+
 bool HandlerGroup::add( Handler *v )
 {
     bool r = false;
     if ( m_num_items < m_max_items )
     {
+        uint16_t item_pos = m_num_items;
         m_item[m_num_items++] = v;
         r = true;
+
+        Timer *timer = v->getTimer();
+        if ( m_timer_wheel && timer )
+        {
+            m_timer_wheel->attach( timer );
+        }
+
+        if ( m_wildcard )
+        {
+            HandlerDispatchKey keys[JDKSAVDECCMCU_HANDLER_MAX_DISPATCH_KEYS];
+            uint16_t num_keys = v->getDispatchKeys( keys, JDKSAVDECCMCU_HANDLER_MAX_DISPATCH_KEYS );
+
+            // Always leave at least one empty slot so that probing terminates
+            if ( num_keys > 0 && m_num_dispatch_entries + num_keys < m_max_dispatch_entries )
+            {
+                for ( uint16_t i = 0; i < num_keys; ++i )
+                {
+                    // Keys at level NONE ask for no frames at all
+                    if ( keys[i].m_level != HandlerDispatchKey::NONE )
+                    {
+                        insertDispatchKey( keys[i], item_pos );
+                    }
+                }
+            }
+            else
+            {
+                m_wildcard[m_num_wildcards++] = item_pos;
+            }
+        }
+    }
+    return r;
+}
+
+void HandlerGroup::insertDispatchKey( HandlerDispatchKey const &key, uint16_t item_pos )
+{
+    // Linear probing with no removals keeps handlers sharing a key in the
+    // order that they were added
+    uint16_t slot = static_cast<uint16_t>( key.hash() % m_max_dispatch_entries );
+    while ( !m_dispatch[slot].isEmpty() )
+    {
+        slot = static_cast<uint16_t>( ( slot + 1 ) % m_max_dispatch_entries );
+    }
+    m_dispatch[slot].m_key = key;
+    m_dispatch[slot].m_item_pos = item_pos;
+    m_num_dispatch_entries++;
+    m_dispatch_levels |= static_cast<uint8_t>( 1 << key.m_level );
+}
+
+uint16_t HandlerGroup::dispatchToKey( HandlerDispatchKey const &key, RawSocket *incoming_socket, Frame &frame )
+{
+    uint16_t slot = static_cast<uint16_t>( key.hash() % m_max_dispatch_entries );
+    while ( !m_dispatch[slot].isEmpty() )
+    {
+        if ( m_dispatch[slot].m_key == key )
+        {
+            uint16_t item_pos = m_dispatch[slot].m_item_pos;
+            m_invocation_count++;
+            if ( m_item[item_pos]->receivedPDU( incoming_socket, frame ) )
+            {
+                return item_pos;
+            }
+        }
+        slot = static_cast<uint16_t>( ( slot + 1 ) % m_max_dispatch_entries );
+    }
+    return 0xffff;
+}
+
+bool HandlerGroup::addRawSocket( RawSocket *s )
+{
+    bool r = false;
+    if ( m_num_rawsockets < JDKSAVDECCMCU_MAX_RAWSOCKETS )
+    {
+        uint16_t pos = m_num_rawsockets++;
+        m_rawsocket[pos] = s;
+        m_rawsocket_ready[pos] = false;
+        s->setHandlerGroup( this );
+        r = true;
+
+        int fd = s->getFd();
+        if ( fd < 0 )
+        {
+            ++m_num_unwaitable_rawsockets;
+        }
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+        else
+        {
+            if ( m_epoll_fd < 0 )
+            {
+                m_epoll_fd = ::epoll_create1( EPOLL_CLOEXEC );
+            }
+            epoll_event ev;
+            memset( &ev, 0, sizeof( ev ) );
+            ev.events = EPOLLIN;
+            ev.data.u32 = pos;
+            if ( m_epoll_fd < 0 || ::epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, fd, &ev ) < 0 )
+            {
+                // Fall back to reading it on every loop
+                ++m_num_unwaitable_rawsockets;
+            }
+        }
+#endif
     }
     return r;
 }
 
-/// Send Tick() messages to all encapsulated Handlers
-/// and poll incoming network for PDU's and dispatch them
+void HandlerGroup::setTimerWheel( TimerWheel *wheel )
+{
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        Timer *timer = m_item[i]->getTimer();
+        if ( timer )
+        {
+            if ( wheel )
+            {
+                wheel->attach( timer );
+            }
+            else if ( m_timer_wheel )
+            {
+                m_timer_wheel->detach( timer );
+            }
+        }
+    }
+    m_timer_wheel = wheel;
+}
+
+void HandlerGroup::clearLoopStatistics()
+{
+    m_last_batch = 0;
+    m_largest_batch = 0;
+    m_loop_count = 0;
+    m_idle_time_in_ms = 0;
+    m_busy_time_in_ms = 0;
+    m_last_loop_latency_in_ms = 0;
+    m_max_loop_latency_in_ms = 0;
+}
+
+uint16_t HandlerGroup::pollRawSockets( uint16_t max_frames_per_socket )
+{
+    uint16_t count = 0;
+    m_frames_pending = false;
+
+    for ( uint16_t i = 0; i < m_num_rawsockets; ++i )
+    {
+        RawSocket *s = m_rawsocket[i];
+        uint16_t n = 0;
+
+        // After a wait, skip the ports that are known to have nothing
+        if ( m_waited && !m_rawsocket_ready[i] && s->getFd() >= 0 )
+        {
+            continue;
+        }
+
+        while ( n < max_frames_per_socket )
+        {
+            // Sockets with a receive ring hand out their frames in place
+            if ( s->acquireFrame( &m_ring_frame ) )
+            {
+                ++n;
+                if ( m_ring_frame.getLength() > 0 )
+                {
+                    receivedPDU( s, m_ring_frame );
+                }
+                s->releaseFrame( &m_ring_frame );
+            }
+            else if ( s->recvFrame( m_frame ) )
+            {
+                ++n;
+                if ( m_frame->getLength() > 0 )
+                {
+                    receivedPDU( s, *m_frame );
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+        // A full batch means that more may be waiting
+        if ( n == max_frames_per_socket )
+        {
+            m_frames_pending = true;
+        }
+        count += n;
+    }
+
+    m_waited = false;
+    m_last_batch = count;
+    if ( count > m_largest_batch )
+    {
+        m_largest_batch = count;
+    }
+    return count;
+}
+
+/// Poll incoming network for PDU's and dispatch them,
+/// then send Tick() messages to all encapsulated Handlers
 void HandlerGroup::tick( jdksavdecc_timestamp_in_milliseconds time_in_millis )
 {
-    // TODO:
+    pollRawSockets();
+
+    if ( m_timer_wheel )
+    {
+        // Only the handlers whose deadlines expired
+        m_handler_tick_count += m_timer_wheel->advance( time_in_millis );
+    }
+
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        if ( !m_timer_wheel || !m_item[i]->getTimer() )
+        {
+            m_item[i]->tick( time_in_millis );
+            ++m_handler_tick_count;
+        }
+    }
+
+    // Send anything that the handlers queued up
+    for ( uint16_t i = 0; i < m_num_rawsockets; ++i )
+    {
+        m_rawsocket[i]->flush();
+    }
 }
 
-/// Send ReceivedPDU message to each handler until one returns true.
+void HandlerGroup::waitForFrames( int32_t timeout_ms )
+{
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    if ( m_epoll_fd >= 0 )
+    {
+        epoll_event events[JDKSAVDECCMCU_MAX_RAWSOCKETS];
+        int n;
+
+        if ( m_num_unwaitable_rawsockets > 0 )
+        {
+            timeout_ms = 0;
+        }
+        do
+        {
+            n = ::epoll_wait( m_epoll_fd, events, JDKSAVDECCMCU_MAX_RAWSOCKETS, timeout_ms );
+        } while ( n < 0 && errno == EINTR );
+
+        for ( uint16_t i = 0; i < m_num_rawsockets; ++i )
+        {
+            m_rawsocket_ready[i] = false;
+        }
+        for ( int i = 0; i < n; ++i )
+        {
+            m_rawsocket_ready[events[i].data.u32] = true;
+        }
+        m_waited = n >= 0;
+        return;
+    }
+#endif
+    waitForRawSockets( m_rawsocket, m_num_rawsockets, timeout_ms );
+}
+
+bool HandlerGroup::run( int32_t timeout_ms )
+{
+    bool r = false;
+    if ( m_num_rawsockets > 0 )
+    {
+        RawSocket *clock = m_rawsocket[0];
+
+        jdksavdecc_timestamp_in_milliseconds wait_start = clock->getTimeInMilliseconds();
+
+        // Don't wait past the next deadline, or at all if the last batch
+        // left frames behind
+        if ( m_frames_pending )
+        {
+            timeout_ms = 0;
+        }
+        else if ( m_timer_wheel )
+        {
+            timeout_ms = m_timer_wheel->getTimeUntilNextDeadline( wait_start, timeout_ms );
+        }
+        waitForFrames( timeout_ms );
+
+        jdksavdecc_timestamp_in_milliseconds wake_time = clock->getTimeInMilliseconds();
+
+        tick( wake_time );
+
+        jdksavdecc_timestamp_in_milliseconds done_time = clock->getTimeInMilliseconds();
+
+        m_last_loop_latency_in_ms = static_cast<uint32_t>( done_time - wake_time );
+        if ( m_last_loop_latency_in_ms > m_max_loop_latency_in_ms )
+        {
+            m_max_loop_latency_in_ms = m_last_loop_latency_in_ms;
+        }
+        m_idle_time_in_ms += static_cast<uint32_t>( wake_time - wait_start );
+        m_busy_time_in_ms += m_last_loop_latency_in_ms;
+        ++m_loop_count;
+        r = true;
+    }
+    return r;
+}
+
+/// Send ReceivedPDU message to the handlers that want it until one returns
+/// true.
 bool HandlerGroup::receivedPDU( RawSocket *incoming_socket, Frame &frame )
 {
     bool r = false;
-    for ( uint16_t i = 0; i < m_num_items; ++i )
+    uint16_t accepted_pos = 0xffff;
+
+    m_rx_count++;
+
+    if ( !m_wildcard )
+    {
+        for ( uint16_t i = 0; i < m_num_items; ++i )
+        {
+            m_invocation_count++;
+            if ( m_item[i]->receivedPDU( incoming_socket, frame ) )
+            {
+                accepted_pos = i;
+                break;
+            }
+        }
+    }
+    else
     {
-        if ( m_item[i]->receivedPDU( incoming_socket, frame ) )
+        if ( m_num_dispatch_entries > 0 )
+        {
+            HandlerDispatchKey key = HandlerDispatchKey::fromFrame( frame );
+
+            for ( uint8_t level = key.m_level; level > HandlerDispatchKey::NONE && accepted_pos == 0xffff; --level )
+            {
+                if ( m_dispatch_levels & ( 1 << level ) )
+                {
+                    accepted_pos = dispatchToKey( key.truncate( level ), incoming_socket, frame );
+                }
+            }
+        }
+
+        for ( uint16_t i = 0; i < m_num_wildcards && accepted_pos == 0xffff; ++i )
         {
-            r = true;
-            break;
+            m_invocation_count++;
+            if ( m_item[m_wildcard[i]]->receivedPDU( incoming_socket, frame ) )
+            {
+                accepted_pos = m_wildcard[i];
+            }
         }
     }
+
+    if ( accepted_pos != 0xffff )
+    {
+        r = true;
+        m_handled_count++;
+        m_linear_invocation_count += accepted_pos + 1;
+    }
+    else
+    {
+        m_linear_invocation_count += m_num_items;
+    }
     return r;
 }
 }
@@ -0,0 +1,144 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/InflightCommands.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+InflightCommands::InflightCommands( InflightCommand *item_storage,
+                                    uint16_t max_items,
+                                    jdksavdecc_timestamp_in_milliseconds timeout_in_ms,
+                                    uint8_t retries )
+    : m_num_items( 0 ), m_max_items( max_items ), m_item( item_storage ), m_timeout_in_ms( timeout_in_ms ), m_retries( retries )
+{
+}
+
+uint16_t InflightCommands::getCountForTarget( Eui64 const &target_entity_id ) const
+{
+    uint16_t count = 0;
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        if ( m_item[i].m_target_entity_id == target_entity_id )
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+InflightCommand *InflightCommands::add( Eui64 const &target_entity_id,
+                                        Eui48 const &target_mac_address,
+                                        uint16_t sequence_id,
+                                        uint16_t command_type,
+                                        jdksavdecc_timestamp_in_milliseconds sent_time,
+                                        InflightCommandNotification *notification )
+{
+    InflightCommand *cmd = 0;
+    if ( m_num_items < m_max_items )
+    {
+        cmd = &m_item[m_num_items++];
+        cmd->m_target_entity_id = target_entity_id;
+        cmd->m_target_mac_address = target_mac_address;
+        cmd->m_sequence_id = sequence_id;
+        cmd->m_command_type = command_type;
+        cmd->m_sent_time = sent_time;
+        cmd->m_timeout_in_ms = m_timeout_in_ms;
+        cmd->m_retries_left = 0;
+        cmd->m_notification = notification;
+        cmd->m_pdu_length = 0;
+    }
+    return cmd;
+}
+
+bool InflightCommands::storePdu( InflightCommand *cmd, FixedBuffer const &header, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    uint32_t total = header.getLength();
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        total += fragments[i].m_data ? fragments[i].m_length : 0;
+    }
+    if ( total <= JDKSAVDECCMCU_INFLIGHT_COMMAND_MAX_PDU_LENGTH )
+    {
+        uint8_t *p = cmd->m_pdu;
+        memcpy( p, header.getBuf(), header.getLength() );
+        p += header.getLength();
+        for ( uint16_t i = 0; i < num_fragments; ++i )
+        {
+            if ( fragments[i].m_data && fragments[i].m_length )
+            {
+                memcpy( p, fragments[i].m_data, fragments[i].m_length );
+                p += fragments[i].m_length;
+            }
+        }
+        cmd->m_pdu_length = uint16_t( total );
+        cmd->m_retries_left = m_retries;
+        r = true;
+    }
+    else
+    {
+        // Too big to keep, so it can not be retried
+        cmd->m_pdu_length = 0;
+        cmd->m_retries_left = 0;
+    }
+    return r;
+}
+
+InflightCommand *InflightCommands::find( Eui64 const &target_entity_id, uint16_t sequence_id )
+{
+    InflightCommand *r = 0;
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        if ( m_item[i].m_sequence_id == sequence_id && m_item[i].m_target_entity_id == target_entity_id )
+        {
+            r = &m_item[i];
+            break;
+        }
+    }
+    return r;
+}
+
+void InflightCommands::remove( InflightCommand *cmd )
+{
+    uint16_t i = uint16_t( cmd - m_item );
+    if ( i < m_num_items )
+    {
+        // move the last one in the list into this slot
+        if ( i != m_num_items - 1 )
+        {
+            m_item[i] = m_item[m_num_items - 1];
+        }
+        m_num_items--;
+    }
+}
+}
@@ -34,4 +34,121 @@
 
 namespace JDKSAvdeccMCU
 {
+
+/// Copy the frame and all of the fragments into one frame
+static bool gatherFrame( Frame &gathered, Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = gathered.canPut( frame.getLength() );
+    if ( r )
+    {
+        gathered.putBuf( frame.getBuf(), frame.getLength() );
+        for ( uint16_t i = 0; i < num_fragments && r; ++i )
+        {
+            r = gathered.canPut( fragments[i].m_length );
+            if ( r && fragments[i].m_data )
+            {
+                gathered.putBuf( fragments[i].m_data, fragments[i].m_length );
+            }
+        }
+    }
+    return r;
+}
+
+bool RawSocket::sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    if ( num_fragments <= 2 )
+    {
+        r = sendFrame( frame,
+                       num_fragments > 0 ? fragments[0].m_data : 0,
+                       num_fragments > 0 ? fragments[0].m_length : 0,
+                       num_fragments > 1 ? fragments[1].m_data : 0,
+                       num_fragments > 1 ? fragments[1].m_length : 0 );
+    }
+    else
+    {
+        FrameWithMTU gathered( frame.getTimeInMilliseconds() );
+        if ( gatherFrame( gathered, frame, fragments, num_fragments ) )
+        {
+            r = sendFrame( gathered );
+        }
+    }
+    return r;
+}
+
+bool RawSocket::sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    if ( num_fragments <= 2 )
+    {
+        r = sendReplyFrame( frame,
+                            num_fragments > 0 ? fragments[0].m_data : 0,
+                            num_fragments > 0 ? fragments[0].m_length : 0,
+                            num_fragments > 1 ? fragments[1].m_data : 0,
+                            num_fragments > 1 ? fragments[1].m_length : 0 );
+    }
+    else
+    {
+        FrameWithMTU gathered( frame.getTimeInMilliseconds() );
+        if ( gatherFrame( gathered, frame, fragments, num_fragments ) )
+        {
+            r = sendReplyFrame( gathered );
+        }
+    }
+    return r;
+}
+
+bool RawSocket::sendFrameFragmentsBatch( Frame const *const *frames,
+                                         uint16_t num_frames,
+                                         FrameFragment const *fragments,
+                                         uint16_t num_fragments )
+{
+    bool r = true;
+    for ( uint16_t i = 0; i < num_frames; ++i )
+    {
+        r &= sendFrameFragments( *frames[i], fragments, num_fragments );
+    }
+    return r;
+}
+
+bool waitForRawSockets( RawSocket *const *sockets, uint16_t num_sockets, int32_t timeout_ms )
+{
+    bool r = true;
+#if JDKSAVDECCMCU_ENABLE_POLL
+    pollfd fds[JDKSAVDECCMCU_MAX_RAWSOCKETS];
+    nfds_t num_fds = 0;
+
+    for ( uint16_t i = 0; i < num_sockets && num_fds < JDKSAVDECCMCU_MAX_RAWSOCKETS; ++i )
+    {
+        int fd = sockets[i]->getFd();
+        if ( fd < 0 )
+        {
+            // Can't wait on this one, it must be polled
+            timeout_ms = 0;
+        }
+        else
+        {
+            fds[num_fds].fd = fd;
+            fds[num_fds].events = POLLIN;
+            fds[num_fds].revents = 0;
+            ++num_fds;
+        }
+    }
+
+    if ( num_fds > 0 && timeout_ms != 0 )
+    {
+        int e;
+        do
+        {
+            e = ::poll( fds, num_fds, timeout_ms );
+        } while ( e < 0 && errno == EINTR );
+        r = e > 0;
+    }
+#else
+    (void)sockets;
+    (void)num_sockets;
+    (void)timeout_ms;
+#endif
+    return r;
+}
 }
@@ -0,0 +1,611 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketLinux.hpp"
+
+#if defined( __linux__ ) && JDKSAVDECCMCU_ENABLE_RAWSOCKETLINUX
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+
+namespace JDKSAvdeccMCU
+{
+
+static void rawsocket_linux_initialize()
+{
+    static bool initted = false;
+    if ( !initted )
+    {
+        struct sigaction act;
+        act.sa_handler = SIG_IGN;
+        sigemptyset( &act.sa_mask );
+        act.sa_flags = 0;
+        sigaction( SIGPIPE, &act, NULL );
+        initted = true;
+    }
+}
+
+RawSocketLinux::RawSocketLinux( const char *device, uint16_t ethertype, const Eui48 &multicast_to_join, uint16_t batch_size )
+    : m_fd( -1 )
+    , m_device( device )
+    , m_interface_id( 0 )
+    , m_default_dest_mac_address( multicast_to_join )
+    , m_ethertype( ethertype )
+    , m_handler_group( 0 )
+    , m_num_multicast( 0 )
+    , m_batch_size( batch_size )
+    , m_rx_count( 0 )
+    , m_rx_pos( 0 )
+    , m_tx_batching( false )
+    , m_tx_count( 0 )
+    , m_rx_syscall_count( 0 )
+    , m_rx_frame_count( 0 )
+    , m_tx_syscall_count( 0 )
+    , m_tx_frame_count( 0 )
+    , m_tx_dropped_count( 0 )
+{
+    rawsocket_linux_initialize();
+
+    if ( m_batch_size < 1 )
+    {
+        m_batch_size = 1;
+    }
+    if ( m_batch_size > JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH )
+    {
+        m_batch_size = JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH;
+    }
+    m_rx_buffers.resize( m_batch_size * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH );
+    m_rx_lengths.resize( m_batch_size );
+    m_tx_buffers.resize( m_batch_size * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH );
+    m_tx_lengths.resize( m_batch_size );
+
+    if ( device == 0 )
+    {
+        return;
+    }
+
+    // Protocol 0 receives nothing until the filter is in place and the
+    // socket is bound
+    m_fd = ::socket( AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if ( m_fd < 0 )
+    {
+        return;
+    }
+
+    struct ifreq ifr;
+    ::memset( &ifr, 0, sizeof( ifr ) );
+    ::strncpy( ifr.ifr_name, device, sizeof( ifr.ifr_name ) - 1 );
+    if ( ::ioctl( m_fd, SIOCGIFINDEX, &ifr ) < 0 )
+    {
+        ::close( m_fd );
+        m_fd = -1;
+        return;
+    }
+    m_interface_id = ifr.ifr_ifindex;
+
+    if ( ::ioctl( m_fd, SIOCGIFHWADDR, &ifr ) < 0 )
+    {
+        ::close( m_fd );
+        m_fd = -1;
+        return;
+    }
+    m_mac_address = Eui48( (uint8_t const *)ifr.ifr_hwaddr.sa_data );
+
+    if ( !attachFilter() )
+    {
+        ::close( m_fd );
+        m_fd = -1;
+        return;
+    }
+
+    struct sockaddr_ll saddr;
+    ::memset( &saddr, 0, sizeof( saddr ) );
+    saddr.sll_family = AF_PACKET;
+    saddr.sll_ifindex = m_interface_id;
+    saddr.sll_protocol = htons( m_ethertype );
+    if ( ::bind( m_fd, (struct sockaddr *)&saddr, sizeof( saddr ) ) < 0 )
+    {
+        ::close( m_fd );
+        m_fd = -1;
+        return;
+    }
+
+    if ( multicast_to_join.isSet() )
+    {
+        joinMulticast( multicast_to_join );
+    }
+}
+
+RawSocketLinux::~RawSocketLinux()
+{
+    if ( m_fd >= 0 )
+    {
+        flush();
+        ::close( m_fd );
+        m_fd = -1;
+    }
+}
+
+bool RawSocketLinux::attachFilter()
+{
+    // Accept the ethertype when the destination is our own MAC address or
+    // one of the joined multicast addresses:
+    //
+    //   ldh [12]       jeq #ethertype else drop
+    //   ld  [0]        jeq #da_high   else next address
+    //   ldh [4]        jeq #da_low    then accept
+    //   ...
+    //   drop: ret #0   accept: ret #0xffff
+    struct sock_filter code[2 + 4 * ( 1 + JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_MULTICAST ) + 2];
+    uint16_t num_addresses = 1 + m_num_multicast;
+    uint16_t n = 0;
+
+    code[n++] = ( struct sock_filter )BPF_STMT( BPF_LD | BPF_H | BPF_ABS, 12 );
+    code[n++] = ( struct sock_filter )BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, m_ethertype, 0, static_cast<uint8_t>( 4 * num_addresses ) );
+
+    for ( uint16_t i = 0; i < num_addresses; ++i )
+    {
+        Eui48 const &a = i == 0 ? m_mac_address : m_multicast[i - 1];
+        uint32_t high = ( uint32_t( a.value[0] ) << 24 ) | ( uint32_t( a.value[1] ) << 16 ) | ( uint32_t( a.value[2] ) << 8 )
+                        | a.value[3];
+        uint32_t low = ( uint32_t( a.value[4] ) << 8 ) | a.value[5];
+        uint8_t to_accept = static_cast<uint8_t>( 4 * ( num_addresses - i ) - 3 );
+
+        code[n++] = ( struct sock_filter )BPF_STMT( BPF_LD | BPF_W | BPF_ABS, 0 );
+        code[n++] = ( struct sock_filter )BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, high, 0, 2 );
+        code[n++] = ( struct sock_filter )BPF_STMT( BPF_LD | BPF_H | BPF_ABS, 4 );
+        code[n++] = ( struct sock_filter )BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, low, to_accept, 0 );
+    }
+
+    code[n++] = ( struct sock_filter )BPF_STMT( BPF_RET | BPF_K, 0 );
+    code[n++] = ( struct sock_filter )BPF_STMT( BPF_RET | BPF_K, 0xffff );
+
+    struct sock_fprog prog;
+    prog.len = n;
+    prog.filter = code;
+    return ::setsockopt( m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof( prog ) ) == 0;
+}
+
+bool RawSocketLinux::fillReceiveBatch()
+{
+    int n = 0;
+    m_rx_count = 0;
+    m_rx_pos = 0;
+
+    if ( m_batch_size == 1 )
+    {
+        // One frame per system call
+        ssize_t len;
+        do
+        {
+            len = ::recv( m_fd, &m_rx_buffers[0], JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH, MSG_DONTWAIT );
+        } while ( len < 0 && errno == EINTR );
+
+        if ( len >= 0 )
+        {
+            m_rx_lengths[0] = static_cast<uint16_t>( len );
+            n = 1;
+        }
+    }
+    else
+    {
+        struct mmsghdr msgs[JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH];
+        struct iovec iov[JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH];
+
+        ::memset( msgs, 0, sizeof( msgs[0] ) * m_batch_size );
+        for ( uint16_t i = 0; i < m_batch_size; ++i )
+        {
+            iov[i].iov_base = &m_rx_buffers[i * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH];
+            iov[i].iov_len = JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        do
+        {
+            n = ::recvmmsg( m_fd, msgs, m_batch_size, MSG_DONTWAIT, 0 );
+        } while ( n < 0 && errno == EINTR );
+
+        for ( int i = 0; i < n; ++i )
+        {
+            m_rx_lengths[i] = static_cast<uint16_t>( msgs[i].msg_len );
+        }
+    }
+
+    if ( n > 0 )
+    {
+        m_rx_count = static_cast<uint16_t>( n );
+        ++m_rx_syscall_count;
+        m_rx_frame_count += n;
+    }
+    return n > 0;
+}
+
+bool RawSocketLinux::recvFrame( Frame *frame )
+{
+    bool r = false;
+
+    if ( m_fd >= 0 && ( m_rx_pos < m_rx_count || fillReceiveBatch() ) )
+    {
+        uint16_t len = m_rx_lengths[m_rx_pos];
+        if ( len > frame->getMaxLength() )
+        {
+            len = frame->getMaxLength();
+        }
+        ::memcpy( frame->getBuf(), &m_rx_buffers[m_rx_pos * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH], len );
+        frame->setLength( len );
+        ++m_rx_pos;
+        r = true;
+    }
+    return r;
+}
+
+void RawSocketLinux::composeHeader( uint8_t *header, Frame const &frame )
+{
+    ::memcpy( header, frame.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN );
+
+    struct ethhdr *eh = (struct ethhdr *)header;
+
+    // If dest address is not set in the frame we want to send, then fill in
+    // the default destination address
+    if ( eh->h_dest[0] == 0 && eh->h_dest[1] == 0 && eh->h_dest[2] == 0 && eh->h_dest[3] == 0 && eh->h_dest[4] == 0
+         && eh->h_dest[5] == 0 )
+    {
+        ::memcpy( &eh->h_dest[0], &m_default_dest_mac_address.value[0], ETH_ALEN );
+    }
+
+    // Set the src address of the frame to match our real ethernet MAC
+    // address
+    ::memcpy( &eh->h_source[0], &m_mac_address.value[0], ETH_ALEN );
+
+    eh->h_proto = htons( m_ethertype );
+}
+
+uint16_t RawSocketLinux::composeFrame( uint8_t *buffer, Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    uint32_t buffer_length = frame.getLength();
+
+    if ( buffer_length < JDKSAVDECC_FRAME_HEADER_LEN )
+    {
+        return 0;
+    }
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        buffer_length += fragments[i].m_data ? fragments[i].m_length : 0;
+    }
+    if ( buffer_length > JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH )
+    {
+        return 0;
+    }
+
+    /// Fill it in with our data concatenated
+    composeHeader( buffer, frame );
+    uint8_t *p = buffer + JDKSAVDECC_FRAME_HEADER_LEN;
+    ::memcpy( p, frame.getBuf( JDKSAVDECC_FRAME_HEADER_LEN ), frame.getLength() - JDKSAVDECC_FRAME_HEADER_LEN );
+    p += frame.getLength() - JDKSAVDECC_FRAME_HEADER_LEN;
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        if ( fragments[i].m_data && fragments[i].m_length > 0 )
+        {
+            ::memcpy( p, fragments[i].m_data, fragments[i].m_length );
+            p += fragments[i].m_length;
+        }
+    }
+
+    // pad the buffer with zeros to fill in the minimum payload size
+    if ( buffer_length < JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH )
+    {
+        ::memset( &buffer[buffer_length], 0, JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH - buffer_length );
+        buffer_length = JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH;
+    }
+    return static_cast<uint16_t>( buffer_length );
+}
+
+bool RawSocketLinux::sendFrame( const Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketLinux::sendReplyFrame( Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendReplyFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketLinux::sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+
+    if ( m_fd < 0 || frame.getLength() < JDKSAVDECC_FRAME_HEADER_LEN || num_fragments > JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS )
+    {
+        return false;
+    }
+
+    if ( m_tx_batching )
+    {
+        // The batch outlives the caller's buffers, so it needs a copy
+        if ( m_tx_count >= m_batch_size )
+        {
+            flush();
+        }
+
+        uint8_t *buffer = &m_tx_buffers[m_tx_count * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH];
+        uint16_t buffer_length = composeFrame( buffer, frame, fragments, num_fragments );
+
+        if ( buffer_length > 0 )
+        {
+            m_tx_lengths[m_tx_count++] = buffer_length;
+            r = true;
+            if ( m_tx_count >= m_batch_size )
+            {
+                r = flush();
+            }
+        }
+    }
+    else
+    {
+        // Header, frame payload, fragments and padding each go in their own
+        // iovec, straight from where they are
+        static const uint8_t padding[JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH] = {0};
+        uint8_t header[JDKSAVDECC_FRAME_HEADER_LEN];
+        struct iovec iov[JDKSAVDECCMCU_RAWSOCKET_MAX_FRAGMENTS + 3];
+        int num_iov = 0;
+        uint32_t total = frame.getLength();
+
+        composeHeader( header, frame );
+        iov[num_iov].iov_base = header;
+        iov[num_iov++].iov_len = JDKSAVDECC_FRAME_HEADER_LEN;
+
+        if ( frame.getLength() > JDKSAVDECC_FRAME_HEADER_LEN )
+        {
+            iov[num_iov].iov_base = const_cast<uint8_t *>( frame.getBuf( JDKSAVDECC_FRAME_HEADER_LEN ) );
+            iov[num_iov++].iov_len = frame.getLength() - JDKSAVDECC_FRAME_HEADER_LEN;
+        }
+        for ( uint16_t i = 0; i < num_fragments; ++i )
+        {
+            if ( fragments[i].m_data && fragments[i].m_length > 0 )
+            {
+                iov[num_iov].iov_base = const_cast<uint8_t *>( fragments[i].m_data );
+                iov[num_iov++].iov_len = fragments[i].m_length;
+                total += fragments[i].m_length;
+            }
+        }
+        if ( total > JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH )
+        {
+            return false;
+        }
+        if ( total < JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH )
+        {
+            iov[num_iov].iov_base = const_cast<uint8_t *>( padding );
+            iov[num_iov++].iov_len = JDKSAVDECCMCU_RAWSOCKET_MIN_FRAME_LENGTH - total;
+        }
+
+        struct msghdr msg;
+        ::memset( &msg, 0, sizeof( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = num_iov;
+
+        ssize_t len;
+        do
+        {
+            len = ::sendmsg( m_fd, &msg, 0 );
+        } while ( len < 0 && errno == EINTR );
+
+        if ( len < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ) )
+        {
+            // The device queue is full, give it a moment once
+            pollfd pfd;
+            pfd.fd = m_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            ::poll( &pfd, 1, 10 );
+            len = ::sendmsg( m_fd, &msg, 0 );
+        }
+
+        ++m_tx_syscall_count;
+        if ( len >= 0 )
+        {
+            ++m_tx_frame_count;
+            r = true;
+        }
+        else
+        {
+            ++m_tx_dropped_count;
+        }
+    }
+    return r;
+}
+
+bool RawSocketLinux::sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    // set the destination address to what the source was, making sure that
+    // it is not a multicast
+    Eui48 sa = frame.getSA();
+    sa.value[0] &= 0xfe;
+    frame.setDA( sa );
+
+    return sendFrameFragments( frame, fragments, num_fragments );
+}
+
+bool RawSocketLinux::sendFrameFragmentsBatch( Frame const *const *frames,
+                                              uint16_t num_frames,
+                                              FrameFragment const *fragments,
+                                              uint16_t num_fragments )
+{
+    bool r = m_fd >= 0;
+
+    // Each frame is composed into the transmit batch, which goes out in as
+    // few calls as it takes
+    for ( uint16_t i = 0; i < num_frames && r; ++i )
+    {
+        if ( m_tx_count >= m_batch_size )
+        {
+            r = flush();
+        }
+
+        uint8_t *buffer = &m_tx_buffers[m_tx_count * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH];
+        uint16_t buffer_length = composeFrame( buffer, *frames[i], fragments, num_fragments );
+
+        if ( buffer_length > 0 )
+        {
+            m_tx_lengths[m_tx_count++] = buffer_length;
+        }
+        else
+        {
+            ++m_tx_dropped_count;
+            r = false;
+        }
+    }
+
+    if ( !m_tx_batching && m_tx_count > 0 )
+    {
+        r &= flush();
+    }
+    return r;
+}
+
+bool RawSocketLinux::flush()
+{
+    bool r = true;
+    uint16_t pos = 0;
+    bool waited = false;
+
+    while ( m_fd >= 0 && pos < m_tx_count )
+    {
+        int n;
+
+        if ( m_tx_count - pos == 1 )
+        {
+            ssize_t len;
+            do
+            {
+                len = ::send( m_fd, &m_tx_buffers[pos * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH], m_tx_lengths[pos], 0 );
+            } while ( len < 0 && errno == EINTR );
+            n = len < 0 ? -1 : 1;
+        }
+        else
+        {
+            struct mmsghdr msgs[JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH];
+            struct iovec iov[JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH];
+            uint16_t count = m_tx_count - pos;
+
+            ::memset( msgs, 0, sizeof( msgs[0] ) * count );
+            for ( uint16_t i = 0; i < count; ++i )
+            {
+                iov[i].iov_base = &m_tx_buffers[( pos + i ) * JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_FRAME_LENGTH];
+                iov[i].iov_len = m_tx_lengths[pos + i];
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            do
+            {
+                n = ::sendmmsg( m_fd, msgs, count, 0 );
+            } while ( n < 0 && errno == EINTR );
+        }
+        ++m_tx_syscall_count;
+
+        if ( n > 0 )
+        {
+            pos += n;
+            m_tx_frame_count += n;
+        }
+        else if ( !waited && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ) )
+        {
+            // The device queue is full, give it a moment once
+            pollfd pfd;
+            pfd.fd = m_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            ::poll( &pfd, 1, 10 );
+            waited = true;
+        }
+        else
+        {
+            m_tx_dropped_count += m_tx_count - pos;
+            r = false;
+            break;
+        }
+    }
+    m_tx_count = 0;
+    return r;
+}
+
+void RawSocketLinux::setTransmitBatching( bool enable )
+{
+    if ( !enable )
+    {
+        flush();
+    }
+    m_tx_batching = enable;
+}
+
+bool RawSocketLinux::joinMulticast( const Eui48 &multicast_mac )
+{
+    bool r = false;
+
+    if ( m_fd >= 0 )
+    {
+        struct packet_mreq mreq;
+        ::memset( &mreq, 0, sizeof( mreq ) );
+        mreq.mr_ifindex = m_interface_id;
+        mreq.mr_type = PACKET_MR_MULTICAST;
+        mreq.mr_alen = ETH_ALEN;
+        ::memcpy( mreq.mr_address, multicast_mac.value, ETH_ALEN );
+
+        if ( ::setsockopt( m_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof( mreq ) ) == 0 )
+        {
+            r = true;
+            bool known = false;
+            for ( uint16_t i = 0; i < m_num_multicast; ++i )
+            {
+                if ( m_multicast[i] == multicast_mac )
+                {
+                    known = true;
+                }
+            }
+            if ( !known && m_num_multicast < JDKSAVDECCMCU_RAWSOCKETLINUX_MAX_MULTICAST )
+            {
+                m_multicast[m_num_multicast++] = multicast_mac;
+                r = attachFilter();
+            }
+        }
+    }
+    return r;
+}
+}
+#endif
@@ -0,0 +1,199 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketLinuxRing.hpp"
+
+#if defined( __linux__ ) && JDKSAVDECCMCU_ENABLE_RAWSOCKETLINUX
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <linux/if_packet.h>
+
+namespace JDKSAvdeccMCU
+{
+
+RawSocketLinuxRing::RawSocketLinuxRing(
+    const char *device, uint16_t ethertype, const Eui48 &multicast_to_join, uint32_t block_size, uint32_t block_count )
+    : RawSocketLinux( device, ethertype, multicast_to_join )
+    , m_ring( 0 )
+    , m_ring_size( 0 )
+    , m_block_size( block_size )
+    , m_block_count( block_count )
+    , m_block_pos( 0 )
+    , m_frames_left_in_block( 0 )
+    , m_packet( 0 )
+    , m_block_time( 0 )
+    , m_rx_block_count( 0 )
+{
+    if ( m_fd < 0 )
+    {
+        return;
+    }
+
+    int version = TPACKET_V3;
+    if ( ::setsockopt( m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof( version ) ) < 0 )
+    {
+        return;
+    }
+
+    struct tpacket_req3 req;
+    ::memset( &req, 0, sizeof( req ) );
+    req.tp_block_size = m_block_size;
+    req.tp_block_nr = m_block_count;
+    req.tp_frame_size = 2048;
+    req.tp_frame_nr = ( m_block_size / req.tp_frame_size ) * m_block_count;
+    req.tp_retire_blk_tov = JDKSAVDECCMCU_RAWSOCKETLINUXRING_BLOCK_TIMEOUT;
+    if ( ::setsockopt( m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof( req ) ) < 0 )
+    {
+        return;
+    }
+
+    m_ring_size = m_block_size * m_block_count;
+    void *ring = ::mmap( 0, m_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+    if ( ring == MAP_FAILED )
+    {
+        // Tear the ring down again so that recv() keeps working
+        ::memset( &req, 0, sizeof( req ) );
+        ::setsockopt( m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof( req ) );
+        m_ring_size = 0;
+        return;
+    }
+    m_ring = static_cast<uint8_t *>( ring );
+}
+
+RawSocketLinuxRing::~RawSocketLinuxRing()
+{
+    if ( m_ring )
+    {
+        ::munmap( m_ring, m_ring_size );
+        m_ring = 0;
+    }
+}
+
+bool RawSocketLinuxRing::openBlock()
+{
+    struct tpacket_block_desc *block
+        = reinterpret_cast<struct tpacket_block_desc *>( m_ring + m_block_pos * m_block_size );
+
+    if ( ( block->hdr.bh1.block_status & TP_STATUS_USER ) == 0 )
+    {
+        return false;
+    }
+    // Read the frames only after seeing the status
+    __sync_synchronize();
+
+    m_frames_left_in_block = block->hdr.bh1.num_pkts;
+    m_packet = reinterpret_cast<uint8_t *>( block ) + block->hdr.bh1.offset_to_first_pkt;
+    m_block_time = getTimeInMilliseconds();
+    ++m_rx_block_count;
+
+    if ( m_frames_left_in_block == 0 )
+    {
+        closeBlock();
+        return false;
+    }
+    return true;
+}
+
+void RawSocketLinuxRing::closeBlock()
+{
+    struct tpacket_block_desc *block
+        = reinterpret_cast<struct tpacket_block_desc *>( m_ring + m_block_pos * m_block_size );
+
+    // Finish with the frames before giving the block back
+    __sync_synchronize();
+    block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+    m_frames_left_in_block = 0;
+    m_packet = 0;
+    m_block_pos = ( m_block_pos + 1 ) % m_block_count;
+}
+
+bool RawSocketLinuxRing::acquireFrame( Frame *frame )
+{
+    bool r = false;
+
+    if ( m_ring && ( m_frames_left_in_block > 0 || openBlock() ) )
+    {
+        struct tpacket3_hdr *hdr = reinterpret_cast<struct tpacket3_hdr *>( m_packet );
+        frame->wrap( m_block_time, m_packet + hdr->tp_mac, static_cast<uint16_t>( hdr->tp_snaplen ) );
+        r = true;
+    }
+    return r;
+}
+
+void RawSocketLinuxRing::releaseFrame( Frame *frame )
+{
+    (void)frame;
+
+    if ( m_frames_left_in_block > 0 )
+    {
+        struct tpacket3_hdr *hdr = reinterpret_cast<struct tpacket3_hdr *>( m_packet );
+
+        ++m_rx_frame_count;
+        if ( --m_frames_left_in_block == 0 )
+        {
+            closeBlock();
+        }
+        else
+        {
+            m_packet += hdr->tp_next_offset;
+        }
+    }
+}
+
+bool RawSocketLinuxRing::recvFrame( Frame *frame )
+{
+    if ( !m_ring )
+    {
+        return RawSocketLinux::recvFrame( frame );
+    }
+
+    bool r = false;
+    Frame view( 0, 0, 0 );
+
+    if ( acquireFrame( &view ) )
+    {
+        uint16_t len = view.getLength();
+        if ( len > frame->getMaxLength() )
+        {
+            len = frame->getMaxLength();
+        }
+        ::memcpy( frame->getBuf(), view.getBuf(), len );
+        frame->setLength( len );
+        frame->setTimeInMilliseconds( view.getTimeInMilliseconds() );
+        releaseFrame( &view );
+        r = true;
+    }
+    return r;
+}
+}
+#endif
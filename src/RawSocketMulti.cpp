@@ -0,0 +1,266 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketMulti.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+RawSocketMulti::RawSocketMulti()
+    : m_num_ports( 0 )
+    , m_next_port( 0 )
+    , m_acquired_port( JDKSAVDECCMCU_FRAME_ANY_PORT )
+    , m_num_unwaitable_ports( 0 )
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    , m_epoll_fd( -1 )
+#endif
+{
+}
+
+RawSocketMulti::~RawSocketMulti()
+{
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    if ( m_epoll_fd >= 0 )
+    {
+        ::close( m_epoll_fd );
+    }
+#endif
+}
+
+bool RawSocketMulti::addPort( RawSocket *port )
+{
+    bool r = false;
+    if ( m_num_ports < JDKSAVDECCMCU_MAX_RAWSOCKETS )
+    {
+        int fd = port->getFd();
+        bool waitable = false;
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+        if ( fd >= 0 )
+        {
+            if ( m_epoll_fd < 0 )
+            {
+                m_epoll_fd = ::epoll_create1( EPOLL_CLOEXEC );
+            }
+            epoll_event ev;
+            ::memset( &ev, 0, sizeof( ev ) );
+            ev.events = EPOLLIN;
+            ev.data.u32 = m_num_ports;
+            waitable = m_epoll_fd >= 0 && ::epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, fd, &ev ) == 0;
+        }
+#else
+        (void)fd;
+#endif
+        if ( !waitable )
+        {
+            ++m_num_unwaitable_ports;
+        }
+        m_port[m_num_ports++] = port;
+        r = true;
+    }
+    return r;
+}
+
+Eui48 const &RawSocketMulti::getPortMACAddress( uint16_t port ) const
+{
+    static Eui48 const none;
+    return port < m_num_ports ? m_port[port]->getMACAddress() : none;
+}
+
+void RawSocketMulti::setHandlerGroup( HandlerGroup *handler_group )
+{
+    for ( uint16_t i = 0; i < m_num_ports; ++i )
+    {
+        m_port[i]->setHandlerGroup( handler_group );
+    }
+}
+
+jdksavdecc_timestamp_in_milliseconds RawSocketMulti::getTimeInMilliseconds() const
+{
+    return m_num_ports > 0 ? m_port[0]->getTimeInMilliseconds() : 0;
+}
+
+bool RawSocketMulti::recvFrame( Frame *frame )
+{
+    for ( uint16_t i = 0; i < m_num_ports; ++i )
+    {
+        uint16_t port = ( m_next_port + i ) % m_num_ports;
+        if ( m_port[port]->recvFrame( frame ) )
+        {
+            frame->setPort( port );
+            m_next_port = ( port + 1 ) % m_num_ports;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RawSocketMulti::acquireFrame( Frame *frame )
+{
+    for ( uint16_t i = 0; i < m_num_ports; ++i )
+    {
+        uint16_t port = ( m_next_port + i ) % m_num_ports;
+        if ( m_port[port]->acquireFrame( frame ) )
+        {
+            frame->setPort( port );
+            m_acquired_port = port;
+            m_next_port = ( port + 1 ) % m_num_ports;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RawSocketMulti::releaseFrame( Frame *frame )
+{
+    if ( m_acquired_port < m_num_ports )
+    {
+        m_port[m_acquired_port]->releaseFrame( frame );
+        m_acquired_port = JDKSAVDECCMCU_FRAME_ANY_PORT;
+    }
+}
+
+bool RawSocketMulti::sendFrame( const Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketMulti::sendReplyFrame( Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendReplyFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketMulti::sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    uint16_t port = frame.getPort();
+
+    if ( port < m_num_ports )
+    {
+        r = m_port[port]->sendFrameFragments( frame, fragments, num_fragments );
+    }
+    else if ( port == JDKSAVDECCMCU_FRAME_ANY_PORT && m_num_ports > 0 )
+    {
+        // Not tied to a port, so it goes out of all of them
+        r = true;
+        for ( uint16_t i = 0; i < m_num_ports; ++i )
+        {
+            r &= m_port[i]->sendFrameFragments( frame, fragments, num_fragments );
+        }
+    }
+    return r;
+}
+
+bool RawSocketMulti::sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    uint16_t port = frame.getPort();
+
+    // A reply goes back the way that the frame came in
+    if ( port < m_num_ports )
+    {
+        r = m_port[port]->sendReplyFrameFragments( frame, fragments, num_fragments );
+    }
+    return r;
+}
+
+bool RawSocketMulti::sendFrameFragmentsBatch( Frame const *const *frames,
+                                              uint16_t num_frames,
+                                              FrameFragment const *fragments,
+                                              uint16_t num_fragments )
+{
+    if ( num_frames == 0 )
+    {
+        return true;
+    }
+
+    // The batch can only be passed on whole when all of it goes the same way
+    uint16_t port = frames[0]->getPort();
+    for ( uint16_t i = 1; i < num_frames; ++i )
+    {
+        if ( frames[i]->getPort() != port )
+        {
+            return RawSocket::sendFrameFragmentsBatch( frames, num_frames, fragments, num_fragments );
+        }
+    }
+
+    bool r = false;
+    if ( port < m_num_ports )
+    {
+        r = m_port[port]->sendFrameFragmentsBatch( frames, num_frames, fragments, num_fragments );
+    }
+    else if ( port == JDKSAVDECCMCU_FRAME_ANY_PORT && m_num_ports > 0 )
+    {
+        r = true;
+        for ( uint16_t i = 0; i < m_num_ports; ++i )
+        {
+            r &= m_port[i]->sendFrameFragmentsBatch( frames, num_frames, fragments, num_fragments );
+        }
+    }
+    return r;
+}
+
+bool RawSocketMulti::joinMulticast( const Eui48 &multicast_mac )
+{
+    bool r = m_num_ports > 0;
+    for ( uint16_t i = 0; i < m_num_ports; ++i )
+    {
+        r &= m_port[i]->joinMulticast( multicast_mac );
+    }
+    return r;
+}
+
+Eui48 const &RawSocketMulti::getMACAddress() const { return getPortMACAddress( 0 ); }
+
+int RawSocketMulti::getFd() const
+{
+#if JDKSAVDECCMCU_ENABLE_EPOLL
+    // The epoll set is readable when any of the ports is
+    if ( m_num_unwaitable_ports == 0 )
+    {
+        return m_epoll_fd;
+    }
+#endif
+    return -1;
+}
+
+bool RawSocketMulti::flush()
+{
+    bool r = true;
+    for ( uint16_t i = 0; i < m_num_ports; ++i )
+    {
+        r &= m_port[i]->flush();
+    }
+    return r;
+}
+}
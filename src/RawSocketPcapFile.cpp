@@ -93,38 +93,51 @@ bool RawSocketPcapFile::recvFrame( Frame *frame )
 
 bool RawSocketPcapFile::sendFrame( const Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
 {
-    Eui48 da = frame.getDA();
-    Eui48 sa = m_my_mac;
-    if ( isUnset( da ) )
-    {
-        da = m_default_dest_mac;
-    }
-    PcapFilePacket packet;
-    packet.reserve( frame.getLength() + len1 + len2 - JDKSAVDECC_FRAME_HEADER_LEN );
-    for ( size_t i = JDKSAVDECC_FRAME_HEADER_LEN; i < frame.getLength(); ++i )
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketPcapFile::sendReplyFrame( Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendReplyFrameFragments( frame, fragments, 2 );
+}
+
+/// The payload of the frame followed by all of the fragments
+static void gatherPayload( PcapFilePacket &packet, Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    size_t total = frame.getPayloadLength();
+    for ( uint16_t i = 0; i < num_fragments; ++i )
     {
-        packet.push_back( frame.getOctet( i ) );
+        total += fragments[i].m_data ? fragments[i].m_length : 0;
     }
-    if ( data1 )
+    packet.reserve( total );
+    packet.insert( packet.end(), frame.getBuf() + JDKSAVDECC_FRAME_HEADER_LEN, frame.getBuf() + frame.getLength() );
+    for ( uint16_t i = 0; i < num_fragments; ++i )
     {
-        for ( size_t i = 0; i < len1; ++i )
+        if ( fragments[i].m_data )
         {
-            packet.push_back( data1[i] );
+            packet.insert( packet.end(), fragments[i].m_data, fragments[i].m_data + fragments[i].m_length );
         }
     }
-    if ( data2 )
+}
+
+bool RawSocketPcapFile::sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    Eui48 da = frame.getDA();
+    Eui48 sa = m_my_mac;
+    if ( isUnset( da ) )
     {
-        for ( size_t i = 0; i < len1; ++i )
-        {
-            packet.push_back( data2[i] );
-        }
+        da = m_default_dest_mac;
     }
+    m_packet.clear();
+    gatherPayload( m_packet, frame, fragments, num_fragments );
 
-    m_pcap_file_writer.WritePacket( m_current_time * 1000, da.value, sa.value, m_ethertype, packet );
+    m_pcap_file_writer.WritePacket( m_current_time * 1000, da.value, sa.value, m_ethertype, m_packet );
     return true;
 }
 
-bool RawSocketPcapFile::sendReplyFrame( Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+bool RawSocketPcapFile::sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments )
 {
     Eui48 da = frame.getSA();
     Eui48 sa = m_my_mac;
@@ -133,28 +146,10 @@ bool RawSocketPcapFile::sendReplyFrame( Frame &frame, const uint8_t *data1, uint
         // squash multicast
         da.value[0] &= 0xfe;
     }
-    PcapFilePacket packet;
-    packet.resize( frame.getLength() + len1 + len2 - JDKSAVDECC_FRAME_HEADER_LEN );
-    for ( size_t i = JDKSAVDECC_FRAME_HEADER_LEN; i < frame.getLength(); ++i )
-    {
-        packet.push_back( frame.getOctet( i ) );
-    }
-    if ( data1 )
-    {
-        for ( size_t i = 0; i < len1; ++i )
-        {
-            packet.push_back( data1[i] );
-        }
-    }
-    if ( data2 )
-    {
-        for ( size_t i = 0; i < len1; ++i )
-        {
-            packet.push_back( data2[i] );
-        }
-    }
+    m_packet.clear();
+    gatherPayload( m_packet, frame, fragments, num_fragments );
 
-    m_pcap_file_writer.WritePacket( m_current_time * 1000, da.value, sa.value, m_ethertype, packet );
+    m_pcap_file_writer.WritePacket( m_current_time * 1000, da.value, sa.value, m_ethertype, m_packet );
     return true;
 }
 
@@ -171,7 +166,7 @@ bool RawSocketPcapFile::readNextIncomingFrame()
 {
     bool r = false;
     uint64_t timestamp_in_microseconds = 0;
-    PcapFilePacket frame_data;
+    PcapFilePacket &frame_data = m_packet;
     // try read the pcap file
     if ( m_pcap_file_reader.ReadPacket( &timestamp_in_microseconds, frame_data ) )
     {
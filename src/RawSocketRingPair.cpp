@@ -0,0 +1,284 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketRingPair.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+namespace JDKSAvdeccMCU
+{
+
+/// Open a pipe whose ends never block and are not inherited
+static bool openWakePipe( int fds[2] )
+{
+    bool r = false;
+    if ( ::pipe( fds ) == 0 )
+    {
+        r = true;
+        for ( int i = 0; i < 2; ++i )
+        {
+            int flags = ::fcntl( fds[i], F_GETFL );
+            if ( flags < 0 || ::fcntl( fds[i], F_SETFL, flags | O_NONBLOCK ) < 0
+                 || ::fcntl( fds[i], F_SETFD, FD_CLOEXEC ) < 0 )
+            {
+                r = false;
+            }
+        }
+        if ( !r )
+        {
+            ::close( fds[0] );
+            ::close( fds[1] );
+        }
+    }
+    if ( !r )
+    {
+        fds[0] = -1;
+        fds[1] = -1;
+    }
+    return r;
+}
+
+RawSocketRingPair::RawSocketRingPair( FrameRing *rx_ring, FrameRing *tx_ring )
+    : m_rx_ring( rx_ring )
+    , m_tx_ring( tx_ring )
+    , m_rx_unsignalled( 0 )
+    , m_tx_pending( false )
+    , m_rx_frame_count( 0 )
+    , m_rx_dropped_count( 0 )
+    , m_rx_backpressure_count( 0 )
+    , m_tx_frame_count( 0 )
+    , m_tx_dropped_count( 0 )
+    , m_tx_error_count( 0 )
+{
+    openWakePipe( m_rx_wake );
+    openWakePipe( m_tx_wake );
+}
+
+RawSocketRingPair::~RawSocketRingPair()
+{
+    for ( int i = 0; i < 2; ++i )
+    {
+        if ( m_rx_wake[i] >= 0 )
+        {
+            ::close( m_rx_wake[i] );
+        }
+        if ( m_tx_wake[i] >= 0 )
+        {
+            ::close( m_tx_wake[i] );
+        }
+    }
+}
+
+bool RawSocketRingPair::recvFrame( Frame *frame )
+{
+    bool r = false;
+    Frame borrowed( 0, 0, 0 );
+    if ( acquireFrame( &borrowed ) )
+    {
+        frame->clear();
+        frame->putBuf( borrowed.getBuf(), borrowed.getLength() );
+        frame->setTimeInMilliseconds( borrowed.getTimeInMilliseconds() );
+        frame->setPort( borrowed.getPort() );
+        releaseFrame( &borrowed );
+        r = true;
+    }
+    return r;
+}
+
+bool RawSocketRingPair::acquireFrame( Frame *frame )
+{
+    Frame *slot = m_rx_ring->getReadSlot();
+    if ( !slot )
+    {
+        // Empty the wake pipe before looking again, so that a frame that
+        // arrives after this still leaves the pipe readable
+        drain( m_rx_wake[0] );
+        slot = m_rx_ring->getReadSlot();
+    }
+    if ( slot )
+    {
+        frame->wrap( slot->getTimeInMilliseconds(), slot->getBuf(), slot->getLength() );
+        frame->setPort( slot->getPort() );
+    }
+    return slot != 0;
+}
+
+void RawSocketRingPair::releaseFrame( Frame *frame )
+{
+    (void)frame;
+    m_rx_ring->commitRead();
+}
+
+bool RawSocketRingPair::sendFrame( const Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketRingPair::sendReplyFrame( Frame &frame, const uint8_t *data1, uint16_t len1, const uint8_t *data2, uint16_t len2 )
+{
+    FrameFragment fragments[2] = {FrameFragment( data1, len1 ), FrameFragment( data2, len2 )};
+    return sendReplyFrameFragments( frame, fragments, 2 );
+}
+
+bool RawSocketRingPair::sendFrameFragments( Frame const &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    bool r = false;
+    Frame *slot = m_tx_ring->getWriteSlot();
+    if ( slot )
+    {
+        slot->clear();
+        r = slot->canPut( frame.getLength() );
+        if ( r )
+        {
+            slot->putBuf( frame.getBuf(), frame.getLength() );
+        }
+        for ( uint16_t i = 0; i < num_fragments && r; ++i )
+        {
+            r = slot->canPut( fragments[i].m_length );
+            if ( r && fragments[i].m_data )
+            {
+                slot->putBuf( fragments[i].m_data, fragments[i].m_length );
+            }
+        }
+        if ( r )
+        {
+            slot->setTimeInMilliseconds( frame.getTimeInMilliseconds() );
+            slot->setPort( frame.getPort() );
+            m_tx_ring->commitWrite();
+            m_tx_pending = true;
+        }
+    }
+    if ( !r )
+    {
+        m_tx_dropped_count.fetch_add( 1, std::memory_order_relaxed );
+    }
+    return r;
+}
+
+bool RawSocketRingPair::sendReplyFrameFragments( Frame &frame, FrameFragment const *fragments, uint16_t num_fragments )
+{
+    // set the destination address to what the source was, making sure that
+    // it is not a multicast
+    Eui48 sa = frame.getSA();
+    sa.value[0] &= 0xfe;
+    frame.setDA( sa );
+
+    return sendFrameFragments( frame, fragments, num_fragments );
+}
+
+bool RawSocketRingPair::flush()
+{
+    if ( m_tx_pending )
+    {
+        m_tx_pending = false;
+        wake( m_tx_wake[1] );
+    }
+    return true;
+}
+
+bool RawSocketRingPair::deliver( Frame const &frame )
+{
+    bool r = false;
+    Frame *slot = getReceiveSlot();
+    if ( slot )
+    {
+        slot->clear();
+        r = slot->canPut( frame.getLength() );
+        if ( r )
+        {
+            slot->putBuf( frame.getBuf(), frame.getLength() );
+            slot->setTimeInMilliseconds( frame.getTimeInMilliseconds() );
+            slot->setPort( frame.getPort() );
+            commitReceived();
+        }
+    }
+    if ( !r )
+    {
+        countDropped( 1 );
+    }
+    return r;
+}
+
+void RawSocketRingPair::countDropped( uint32_t dropped )
+{
+    m_rx_dropped_count.fetch_add( dropped, std::memory_order_relaxed );
+    m_rx_backpressure_count.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void RawSocketRingPair::signalReceived()
+{
+    if ( m_rx_unsignalled > 0 )
+    {
+        m_rx_frame_count.fetch_add( m_rx_unsignalled, std::memory_order_relaxed );
+        m_rx_unsignalled = 0;
+        wake( m_rx_wake[1] );
+    }
+}
+
+uint32_t RawSocketRingPair::sendQueued( RawSocket *net )
+{
+    uint32_t count = 0;
+    Frame *slot;
+    while ( ( slot = m_tx_ring->getReadSlot() ) != 0 )
+    {
+        if ( !net->sendFrame( *slot ) )
+        {
+            m_tx_error_count.fetch_add( 1, std::memory_order_relaxed );
+        }
+        m_tx_ring->commitRead();
+        ++count;
+    }
+    if ( count > 0 )
+    {
+        m_tx_frame_count.fetch_add( count, std::memory_order_relaxed );
+    }
+    return count;
+}
+
+void RawSocketRingPair::wake( int fd )
+{
+    uint8_t b = 0;
+    // A full pipe is already readable, so a failed write loses nothing
+    ssize_t e = ::write( fd, &b, 1 );
+    (void)e;
+}
+
+void RawSocketRingPair::drain( int fd )
+{
+    uint8_t buf[64];
+    while ( ::read( fd, buf, sizeof( buf ) ) > 0 )
+    {
+    }
+}
+}
+#endif
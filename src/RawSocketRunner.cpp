@@ -35,4 +35,24 @@
 
 namespace JDKSAvdeccMCU
 {
+
+bool SimpleRawSocketRunner::run( int timeout_ms )
+{
+    bool r = false;
+    if ( m_the_socket )
+    {
+        r = true;
+        if ( waitForRawSockets( &m_the_socket, 1, timeout_ms ) )
+        {
+            for ( uint16_t n = 0; n < JDKSAVDECCMCU_HANDLERGROUP_MAX_BATCH && m_the_socket->recvFrame( &m_frame ); ++n )
+            {
+                if ( m_notification_target && m_frame.getLength() > 0 )
+                {
+                    m_notification_target->frameReceived( m_the_socket, m_frame );
+                }
+            }
+        }
+    }
+    return r;
+}
 }
@@ -0,0 +1,171 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/RawSocketThreaded.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+namespace JDKSAvdeccMCU
+{
+
+RawSocketThreaded::RawSocketThreaded( RawSocket *inner, FrameRing *rx_ring, FrameRing *tx_ring )
+    : RawSocketRingPair( rx_ring, tx_ring ), m_inner( inner ), m_running( false )
+{
+}
+
+RawSocketThreaded::~RawSocketThreaded() { stop(); }
+
+bool RawSocketThreaded::start()
+{
+    bool r = false;
+    if ( !isRunning() && isValid() )
+    {
+        m_running.store( true, std::memory_order_release );
+        m_thread = std::thread( &RawSocketThreaded::run, this );
+        r = true;
+    }
+    return r;
+}
+
+void RawSocketThreaded::stop()
+{
+    if ( m_thread.joinable() )
+    {
+        m_running.store( false, std::memory_order_release );
+        wakeSender();
+        m_thread.join();
+    }
+}
+
+void RawSocketThreaded::setHandlerGroup( HandlerGroup *handler_group ) { m_inner->setHandlerGroup( handler_group ); }
+
+jdksavdecc_timestamp_in_milliseconds RawSocketThreaded::getTimeInMilliseconds() const { return m_inner->getTimeInMilliseconds(); }
+
+bool RawSocketThreaded::joinMulticast( const Eui48 &multicast_mac ) { return m_inner->joinMulticast( multicast_mac ); }
+
+Eui48 const &RawSocketThreaded::getMACAddress() const { return m_inner->getMACAddress(); }
+
+uint16_t RawSocketThreaded::getPortCount() const { return m_inner->getPortCount(); }
+
+Eui48 const &RawSocketThreaded::getPortMACAddress( uint16_t port ) const { return m_inner->getPortMACAddress( port ); }
+
+void RawSocketThreaded::run()
+{
+    pollfd fds[2];
+    nfds_t num_fds = 0;
+    int inner_fd = m_inner->getFd();
+    int timeout_ms = -1;
+
+    fds[num_fds].fd = getTxFd();
+    fds[num_fds].events = POLLIN;
+    ++num_fds;
+    if ( inner_fd >= 0 )
+    {
+        fds[num_fds].fd = inner_fd;
+        fds[num_fds].events = POLLIN;
+        ++num_fds;
+    }
+    else
+    {
+        timeout_ms = JDKSAVDECCMCU_RAWSOCKETTHREADED_POLL_INTERVAL_MS;
+    }
+
+    while ( m_running.load( std::memory_order_acquire ) )
+    {
+        uint32_t sent = sendQueued( m_inner );
+        if ( sent > 0 )
+        {
+            m_inner->flush();
+        }
+        uint32_t received = receiveAvailable();
+
+        if ( sent == 0 && received == 0 )
+        {
+            fds[0].revents = 0;
+            fds[num_fds - 1].revents = 0;
+            if ( ::poll( fds, num_fds, timeout_ms ) > 0 && ( fds[0].revents & POLLIN ) )
+            {
+                clearTxFd();
+            }
+        }
+    }
+
+    // Send what the protocol thread queued before it stopped us
+    if ( sendQueued( m_inner ) > 0 )
+    {
+        m_inner->flush();
+    }
+}
+
+uint32_t RawSocketThreaded::receiveAvailable()
+{
+    uint32_t dropped = 0;
+    uint32_t count = 0;
+
+    // Read at most one ring's worth before looking at the TX ring again
+    while ( count < m_rx_ring->getCapacity() )
+    {
+        Frame *slot = getReceiveSlot();
+        if ( slot )
+        {
+            slot->clear();
+            slot->setPort( JDKSAVDECCMCU_FRAME_ANY_PORT );
+            if ( !m_inner->recvFrame( slot ) )
+            {
+                break;
+            }
+            slot->setTimeInMilliseconds( m_inner->getTimeInMilliseconds() );
+            commitReceived();
+        }
+        else
+        {
+            // The protocol thread is behind; the oldest frames are the ones
+            // it is working on, so the new one is dropped
+            m_rx_scratch.clear();
+            if ( !m_inner->recvFrame( &m_rx_scratch ) )
+            {
+                break;
+            }
+            ++dropped;
+        }
+        ++count;
+    }
+
+    signalReceived();
+    if ( dropped > 0 )
+    {
+        countDropped( dropped );
+    }
+    return count;
+}
+}
+#endif
@@ -0,0 +1,298 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/ShardedEntityHost.hpp"
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+
+namespace JDKSAvdeccMCU
+{
+
+EntityShard::EntityShard( HandlerGroup *group, FrameRing *rx_ring, FrameRing *tx_ring )
+    : RawSocketRingPair( rx_ring, tx_ring )
+    , m_group( group )
+    , m_net( 0 )
+    , m_entity_count( 0 )
+    , m_running( false )
+    , m_loop_count( 0 )
+    , m_busy_time_in_ms( 0 )
+    , m_idle_time_in_ms( 0 )
+    , m_max_loop_latency_in_ms( 0 )
+{
+}
+
+EntityShard::~EntityShard() { stop(); }
+
+bool EntityShard::start()
+{
+    bool r = false;
+    if ( !isRunning() && isValid() && m_net )
+    {
+        m_running.store( true, std::memory_order_release );
+        m_thread = std::thread( &EntityShard::run, this );
+        r = true;
+    }
+    return r;
+}
+
+void EntityShard::stop()
+{
+    if ( m_thread.joinable() )
+    {
+        m_running.store( false, std::memory_order_release );
+        wakeReceiver();
+        m_thread.join();
+    }
+}
+
+void EntityShard::setHandlerGroup( HandlerGroup *handler_group ) { (void)handler_group; }
+
+jdksavdecc_timestamp_in_milliseconds EntityShard::getTimeInMilliseconds() const
+{
+    return m_net ? m_net->getTimeInMilliseconds() : 0;
+}
+
+bool EntityShard::joinMulticast( const Eui48 &multicast_mac ) { return m_net && m_net->joinMulticast( multicast_mac ); }
+
+Eui48 const &EntityShard::getMACAddress() const
+{
+    static Eui48 const none;
+    return m_net ? m_net->getMACAddress() : none;
+}
+
+uint16_t EntityShard::getPortCount() const { return m_net ? m_net->getPortCount() : 1; }
+
+Eui48 const &EntityShard::getPortMACAddress( uint16_t port ) const
+{
+    return m_net ? m_net->getPortMACAddress( port ) : getMACAddress();
+}
+
+void EntityShard::run()
+{
+    while ( m_running.load( std::memory_order_acquire ) )
+    {
+        m_group->run( JDKSAVDECCMCU_ENTITYSHARD_RUN_TIMEOUT_MS );
+
+        m_loop_count.store( m_group->getLoopCount(), std::memory_order_relaxed );
+        m_busy_time_in_ms.store( m_group->getBusyTimeInMilliseconds(), std::memory_order_relaxed );
+        m_idle_time_in_ms.store( m_group->getIdleTimeInMilliseconds(), std::memory_order_relaxed );
+        m_max_loop_latency_in_ms.store( m_group->getMaxLoopLatencyInMilliseconds(), std::memory_order_relaxed );
+    }
+}
+
+ShardedEntityHost::ShardedEntityHost( RawSocket *net )
+    : m_net( net ), m_num_shards( 0 ), m_ring_frame( 0, 0, 0 ), m_unicast_count( 0 ), m_multicast_count( 0 )
+{
+}
+
+ShardedEntityHost::~ShardedEntityHost() { stop(); }
+
+bool ShardedEntityHost::addShard( EntityShard *shard )
+{
+    bool r = false;
+    if ( m_num_shards < JDKSAVDECCMCU_MAX_ENTITY_SHARDS )
+    {
+        shard->setNetwork( m_net );
+        m_shard[m_num_shards++] = shard;
+        r = true;
+    }
+    return r;
+}
+
+uint16_t ShardedEntityHost::getShardIndex( Eui64 const &entity_id ) const
+{
+    uint16_t r = 0;
+    if ( m_num_shards > 1 )
+    {
+        // Entity ID's are often handed out in sequence, so use the hash that
+        // mixes all of the bits before taking the remainder
+        r = static_cast<uint16_t>( ( entity_id.hash() >> 32 ) % m_num_shards );
+    }
+    return r;
+}
+
+EntityShard *ShardedEntityHost::assignEntity( Eui64 const &entity_id )
+{
+    EntityShard *r = 0;
+    if ( m_num_shards > 0 )
+    {
+        r = m_shard[getShardIndex( entity_id )];
+        r->countEntity();
+    }
+    return r;
+}
+
+bool ShardedEntityHost::start()
+{
+    bool r = m_num_shards > 0;
+    for ( uint16_t i = 0; i < m_num_shards; ++i )
+    {
+        r &= m_shard[i]->start();
+    }
+    return r;
+}
+
+void ShardedEntityHost::stop()
+{
+    for ( uint16_t i = 0; i < m_num_shards; ++i )
+    {
+        m_shard[i]->stop();
+    }
+}
+
+void ShardedEntityHost::route( Frame const &frame )
+{
+    uint16_t length = frame.getLength();
+
+    if ( frame.getEtherType() == JDKSAVDECC_AVTP_ETHERTYPE && length >= JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_LEN
+         && frame.getOctet( JDKSAVDECC_FRAME_HEADER_LEN ) == JDKSAVDECC_1722A_SUBTYPE_AECP )
+    {
+        // Commands are for the target entity and responses are for the
+        // controller that sent the command
+        uint8_t message_type = frame.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 1 ) & 0x0f;
+        uint16_t id_pos = ( message_type & 1 ) ? JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID
+                                               : JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID;
+        Eui64 id( frame.getBuf( JDKSAVDECC_FRAME_HEADER_LEN + id_pos ) );
+
+        m_shard[getShardIndex( id )]->deliver( frame );
+        ++m_unicast_count;
+    }
+    else
+    {
+        for ( uint16_t i = 0; i < m_num_shards; ++i )
+        {
+            m_shard[i]->deliver( frame );
+        }
+        ++m_multicast_count;
+    }
+}
+
+uint16_t ShardedEntityHost::pollNetwork( uint16_t max_frames )
+{
+    uint16_t count = 0;
+
+    if ( m_num_shards > 0 )
+    {
+        while ( count < max_frames )
+        {
+            if ( m_net->acquireFrame( &m_ring_frame ) )
+            {
+                route( m_ring_frame );
+                m_net->releaseFrame( &m_ring_frame );
+            }
+            else if ( m_net->recvFrame( &m_frame ) )
+            {
+                m_frame.setTimeInMilliseconds( m_net->getTimeInMilliseconds() );
+                route( m_frame );
+            }
+            else
+            {
+                break;
+            }
+            ++count;
+        }
+
+        // One wake up per shard for the whole batch
+        for ( uint16_t i = 0; i < m_num_shards; ++i )
+        {
+            m_shard[i]->signalReceived();
+        }
+    }
+    return count;
+}
+
+uint32_t ShardedEntityHost::sendQueued()
+{
+    uint32_t count = 0;
+    for ( uint16_t i = 0; i < m_num_shards; ++i )
+    {
+        count += m_shard[i]->sendQueued( m_net );
+    }
+    if ( count > 0 )
+    {
+        m_net->flush();
+    }
+    return count;
+}
+
+bool ShardedEntityHost::run( int32_t timeout_ms )
+{
+    bool r = false;
+    if ( m_num_shards > 0 )
+    {
+        pollfd fds[JDKSAVDECCMCU_MAX_ENTITY_SHARDS + 1];
+        nfds_t num_fds = 0;
+
+        for ( uint16_t i = 0; i < m_num_shards; ++i )
+        {
+            fds[num_fds].fd = m_shard[i]->getTxFd();
+            fds[num_fds].events = POLLIN;
+            fds[num_fds].revents = 0;
+            ++num_fds;
+        }
+
+        int net_fd = m_net->getFd();
+        if ( net_fd >= 0 )
+        {
+            fds[num_fds].fd = net_fd;
+            fds[num_fds].events = POLLIN;
+            fds[num_fds].revents = 0;
+            ++num_fds;
+        }
+        else
+        {
+            // Can't wait on the network, it must be polled
+            timeout_ms = 0;
+        }
+
+        int e;
+        do
+        {
+            e = ::poll( fds, num_fds, timeout_ms );
+        } while ( e < 0 && errno == EINTR );
+
+        for ( uint16_t i = 0; i < m_num_shards; ++i )
+        {
+            if ( fds[i].revents & POLLIN )
+            {
+                m_shard[i]->clearTxFd();
+            }
+        }
+
+        pollNetwork();
+        sendQueued();
+        r = true;
+    }
+    return r;
+}
+}
+#endif
@@ -0,0 +1,343 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/TimerWheel.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+Timer::~Timer()
+{
+    if ( m_wheel )
+    {
+        m_wheel->detach( this );
+    }
+}
+
+bool Timer::scheduleAt( jdksavdecc_timestamp_in_milliseconds deadline )
+{
+    bool r = false;
+    if ( m_wheel )
+    {
+        m_wheel->schedule( this, deadline );
+        r = true;
+    }
+    return r;
+}
+
+bool Timer::scheduleNoLaterThan( jdksavdecc_timestamp_in_milliseconds deadline )
+{
+    bool r = false;
+    if ( m_wheel )
+    {
+        if ( !isScheduled() || deadline < m_deadline )
+        {
+            m_wheel->schedule( this, deadline );
+        }
+        r = true;
+    }
+    return r;
+}
+
+void Timer::cancel()
+{
+    if ( m_wheel )
+    {
+        m_wheel->cancel( this );
+    }
+}
+
+TimerWheel::TimerWheel() : m_due( 0 ), m_current_time( 0 ), m_started( false ), m_scheduled_count( 0 ), m_expired_count( 0 )
+{
+    for ( uint8_t level = 0; level < JDKSAVDECCMCU_TIMERWHEEL_LEVELS; ++level )
+    {
+        for ( uint16_t slot = 0; slot < JDKSAVDECCMCU_TIMERWHEEL_SLOTS; ++slot )
+        {
+            m_slot[level][slot] = 0;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    while ( m_due )
+    {
+        detach( m_due );
+    }
+    for ( uint8_t level = 0; level < JDKSAVDECCMCU_TIMERWHEEL_LEVELS; ++level )
+    {
+        for ( uint16_t slot = 0; slot < JDKSAVDECCMCU_TIMERWHEEL_SLOTS; ++slot )
+        {
+            while ( m_slot[level][slot] )
+            {
+                detach( m_slot[level][slot] );
+            }
+        }
+    }
+}
+
+void TimerWheel::attach( Timer *t )
+{
+    if ( t->m_wheel && t->m_wheel != this )
+    {
+        t->m_wheel->detach( t );
+    }
+    t->m_wheel = this;
+    if ( t->m_list )
+    {
+        unlink( t );
+    }
+    // Newly attached timers are ticked right away so that their owners can
+    // schedule themselves
+    t->m_deadline = m_current_time;
+    link( &m_due, t );
+}
+
+void TimerWheel::detach( Timer *t )
+{
+    cancel( t );
+    t->m_wheel = 0;
+}
+
+void TimerWheel::schedule( Timer *t, jdksavdecc_timestamp_in_milliseconds deadline )
+{
+    if ( t->m_list )
+    {
+        unlink( t );
+    }
+    t->m_deadline = deadline;
+    insert( t );
+}
+
+void TimerWheel::cancel( Timer *t )
+{
+    if ( t->m_list )
+    {
+        unlink( t );
+    }
+}
+
+void TimerWheel::insert( Timer *t, bool cascading )
+{
+    if ( cascading && t->m_deadline <= m_current_time )
+    {
+        // Coming down to the slot that is about to be expired
+        link( &m_slot[0][m_current_time & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 )], t );
+    }
+    else if ( !m_started || t->m_deadline <= m_current_time )
+    {
+        // Before the wheel has a time everything is due
+        link( &m_due, t );
+    }
+    else
+    {
+        jdksavdecc_timestamp_in_milliseconds delta = t->m_deadline - m_current_time;
+        uint8_t level = 0;
+        uint16_t slot = 0;
+
+        while ( level < JDKSAVDECCMCU_TIMERWHEEL_LEVELS
+                && delta >= ( jdksavdecc_timestamp_in_milliseconds( 1 ) << ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * ( level + 1 ) ) ) )
+        {
+            ++level;
+        }
+
+        if ( level < JDKSAVDECCMCU_TIMERWHEEL_LEVELS )
+        {
+            slot = ( t->m_deadline >> ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * level ) ) & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 );
+        }
+        else
+        {
+            // Too far away. Park it in the top level slot that is cascaded
+            // last, it will be placed again from there
+            level = JDKSAVDECCMCU_TIMERWHEEL_LEVELS - 1;
+            slot = ( m_current_time >> ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * level ) ) & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 );
+        }
+        link( &m_slot[level][slot], t );
+    }
+}
+
+void TimerWheel::link( Timer **list, Timer *t )
+{
+    t->m_list = list;
+    t->m_prev = 0;
+    t->m_next = *list;
+    if ( *list )
+    {
+        ( *list )->m_prev = t;
+    }
+    *list = t;
+    ++m_scheduled_count;
+}
+
+void TimerWheel::unlink( Timer *t )
+{
+    if ( t->m_prev )
+    {
+        t->m_prev->m_next = t->m_next;
+    }
+    else
+    {
+        *t->m_list = t->m_next;
+    }
+    if ( t->m_next )
+    {
+        t->m_next->m_prev = t->m_prev;
+    }
+    t->m_next = 0;
+    t->m_prev = 0;
+    t->m_list = 0;
+    --m_scheduled_count;
+}
+
+void TimerWheel::cascade( uint8_t level )
+{
+    uint16_t slot = ( m_current_time >> ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * level ) ) & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 );
+
+    if ( slot == 0 && level + 1 < JDKSAVDECCMCU_TIMERWHEEL_LEVELS )
+    {
+        cascade( level + 1 );
+    }
+
+    Timer *t = m_slot[level][slot];
+    while ( t )
+    {
+        Timer *next = t->m_next;
+        unlink( t );
+        insert( t, true );
+        t = next;
+    }
+}
+
+uint16_t TimerWheel::expireList( Timer **list, jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    uint16_t count = 0;
+
+    // Move the list aside so that owners that schedule themselves again
+    // from tick() are not expired twice
+    Timer *expiring = *list;
+    *list = 0;
+    for ( Timer *t = expiring; t; t = t->m_next )
+    {
+        t->m_list = &expiring;
+    }
+
+    while ( expiring )
+    {
+        Timer *t = expiring;
+        unlink( t );
+        ++count;
+        ++m_expired_count;
+        if ( t->m_owner )
+        {
+            t->m_owner->tick( time_in_millis );
+        }
+    }
+    return count;
+}
+
+uint16_t TimerWheel::advance( jdksavdecc_timestamp_in_milliseconds time_in_millis )
+{
+    uint16_t count = 0;
+
+    if ( !m_started )
+    {
+        m_current_time = time_in_millis;
+        m_started = true;
+    }
+
+    count += expireList( &m_due, time_in_millis );
+
+    while ( m_current_time < time_in_millis )
+    {
+        if ( m_scheduled_count == 0 )
+        {
+            // Nothing on the wheel, skip straight to now
+            m_current_time = time_in_millis;
+            break;
+        }
+
+        ++m_current_time;
+        uint16_t slot = m_current_time & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 );
+        if ( slot == 0 && JDKSAVDECCMCU_TIMERWHEEL_LEVELS > 1 )
+        {
+            cascade( 1 );
+        }
+        count += expireList( &m_slot[0][slot], time_in_millis );
+    }
+    return count;
+}
+
+int32_t TimerWheel::getTimeUntilNextDeadline( jdksavdecc_timestamp_in_milliseconds time_in_millis, int32_t max_wait ) const
+{
+    jdksavdecc_timestamp_in_milliseconds next = 0;
+    bool found = false;
+
+    if ( m_due || !m_started )
+    {
+        return m_scheduled_count > 0 ? 0 : max_wait;
+    }
+
+    for ( uint8_t level = 0; level < JDKSAVDECCMCU_TIMERWHEEL_LEVELS; ++level )
+    {
+        // The lowest level holds exact deadlines, the others must be woken
+        // for when their slot is cascaded down
+        jdksavdecc_timestamp_in_milliseconds base = m_current_time >> ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * level );
+        for ( uint16_t k = 1; k <= JDKSAVDECCMCU_TIMERWHEEL_SLOTS; ++k )
+        {
+            if ( m_slot[level][( base + k ) & ( JDKSAVDECCMCU_TIMERWHEEL_SLOTS - 1 )] )
+            {
+                jdksavdecc_timestamp_in_milliseconds t = ( base + k ) << ( JDKSAVDECCMCU_TIMERWHEEL_SLOT_BITS * level );
+                if ( !found || t < next )
+                {
+                    next = t;
+                    found = true;
+                }
+                break;
+            }
+        }
+    }
+
+    int32_t r = max_wait;
+    if ( found )
+    {
+        if ( next <= time_in_millis )
+        {
+            r = 0;
+        }
+        else if ( next - time_in_millis < static_cast<jdksavdecc_timestamp_in_milliseconds>( max_wait ) )
+        {
+            r = static_cast<int32_t>( next - time_in_millis );
+        }
+    }
+    return r;
+}
+}
@@ -0,0 +1,194 @@
+/*
+ Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ 3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "JDKSAvdeccMCU/World.hpp"
+#include "JDKSAvdeccMCU/UnsolicitedCoalescer.hpp"
+
+namespace JDKSAvdeccMCU
+{
+
+UnsolicitedCoalescer::UnsolicitedCoalescer( UnsolicitedResponse *item_storage,
+                                            uint16_t max_items,
+                                            jdksavdecc_timestamp_in_milliseconds window_in_ms )
+    : m_num_items( 0 ), m_max_items( max_items ), m_item( item_storage ), m_window_in_ms( window_in_ms ), m_replaced_count( 0 )
+{
+}
+
+bool UnsolicitedCoalescer::offer( Frame const &pdu,
+                                  FrameFragment const *fragments,
+                                  uint16_t num_fragments,
+                                  bool internally_generated,
+                                  jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    if ( m_window_in_ms == 0 )
+    {
+        return true;
+    }
+
+    // Put the whole response together to find out what it is about
+    FrameWithSize<JDKSAVDECCMCU_UNSOLICITED_MAX_PDU_LENGTH> whole;
+    if ( !whole.canPut( pdu.getLength() ) )
+    {
+        return true;
+    }
+    whole.putBuf( pdu.getBuf(), pdu.getLength() );
+    for ( uint16_t i = 0; i < num_fragments; ++i )
+    {
+        if ( fragments[i].m_data && fragments[i].m_length )
+        {
+            if ( !whole.canPut( fragments[i].m_length ) )
+            {
+                return true;
+            }
+            whole.putBuf( fragments[i].m_data, fragments[i].m_length );
+        }
+    }
+
+    // Only responses about one descriptor can stand in for each other
+    HandlerDispatchKey key = HandlerDispatchKey::fromFrame( whole );
+    if ( key.m_level != HandlerDispatchKey::DESCRIPTOR )
+    {
+        return true;
+    }
+
+    // The descriptor alone does not say which name or configuration a
+    // response is about
+    uint32_t addressed = 0;
+    uint8_t const *p = whole.getPayload();
+    switch ( key.m_command_type )
+    {
+    case JDKSAVDECC_AEM_COMMAND_SET_NAME:
+    case JDKSAVDECC_AEM_COMMAND_GET_NAME:
+        if ( whole.getLength() < JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_SET_NAME_RESPONSE_OFFSET_NAME )
+        {
+            return true;
+        }
+        addressed = ( static_cast<uint32_t>( jdksavdecc_aem_command_set_name_response_get_name_index( p, 0 ) ) << 16 )
+                    | jdksavdecc_aem_command_set_name_response_get_configuration_index( p, 0 );
+        break;
+    case JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR:
+        addressed = jdksavdecc_aem_command_read_descriptor_response_get_configuration_index( p, 0 );
+        break;
+    }
+
+    bool r = true;
+    UnsolicitedResponse *item = findOrAdd( key, addressed, time_in_ms );
+    if ( item && ( item->m_pending || time_in_ms - item->m_sent_time < m_window_in_ms ) )
+    {
+        // Too soon, keep it and send it when the window has passed
+        if ( item->m_pending )
+        {
+            ++m_replaced_count;
+        }
+        memcpy( item->m_pdu, whole.getBuf(), whole.getLength() );
+        item->m_pdu_length = whole.getLength();
+        item->m_internally_generated = internally_generated;
+        item->m_pending = true;
+        r = false;
+    }
+    else if ( item )
+    {
+        item->m_sent_time = time_in_ms;
+    }
+    return r;
+}
+
+UnsolicitedResponse *UnsolicitedCoalescer::findOrAdd( HandlerDispatchKey const &key,
+                                                      uint32_t addressed,
+                                                      jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    UnsolicitedResponse *reusable = 0;
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        UnsolicitedResponse *item = &m_item[i];
+        if ( item->m_key == key && item->m_addressed == addressed )
+        {
+            return item;
+        }
+        if ( !reusable && !item->m_pending && time_in_ms - item->m_sent_time >= m_window_in_ms )
+        {
+            // Nothing is held back and its window has passed, so forgetting
+            // it changes nothing
+            reusable = item;
+        }
+    }
+
+    if ( m_num_items < m_max_items )
+    {
+        reusable = &m_item[m_num_items++];
+    }
+    if ( reusable )
+    {
+        reusable->m_key = key;
+        reusable->m_addressed = addressed;
+        reusable->m_pending = false;
+        reusable->m_pdu_length = 0;
+
+        // Its first response goes out straight away
+        reusable->m_sent_time = time_in_ms - m_window_in_ms;
+    }
+    return reusable;
+}
+
+UnsolicitedResponse *UnsolicitedCoalescer::getDue( jdksavdecc_timestamp_in_milliseconds time_in_ms )
+{
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        UnsolicitedResponse *item = &m_item[i];
+        if ( item->m_pending && time_in_ms - item->m_sent_time >= m_window_in_ms )
+        {
+            item->m_pending = false;
+            item->m_sent_time = time_in_ms;
+            return item;
+        }
+    }
+    return 0;
+}
+
+bool UnsolicitedCoalescer::getNextDeadline( jdksavdecc_timestamp_in_milliseconds *deadline ) const
+{
+    bool r = false;
+    for ( uint16_t i = 0; i < m_num_items; ++i )
+    {
+        UnsolicitedResponse const *item = &m_item[i];
+        if ( item->m_pending )
+        {
+            jdksavdecc_timestamp_in_milliseconds t = item->m_sent_time + m_window_in_ms;
+            if ( !r || t < *deadline )
+            {
+                *deadline = t;
+                r = true;
+            }
+        }
+    }
+    return r;
+}
+}
@@ -0,0 +1,236 @@
+/*
+  Copyright (c) 2014, J.D. Koftinoff Software, Ltd.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   3. Neither the name of J.D. Koftinoff Software, Ltd. nor the names of its
+      contributors may be used to endorse or promote products derived from
+      this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// Helpers shared by the tests, one test program per feature
+
+#include "JDKSAvdeccMCU.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+/// A RawSocket that keeps the last sent frames in memory
+class TestRawSocket : public RawSocket
+{
+  public:
+    TestRawSocket() : m_time( 1000 ), m_sent_count( 0 ), m_mac( 0x70b3d5edc000ULL ), m_rx_count( 0 ), m_rx_pos( 0 ) {}
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override { (void)handler_group; }
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override { return m_time; }
+
+    virtual bool recvFrame( Frame *frame ) override
+    {
+        bool r = false;
+        if ( m_rx_pos < m_rx_count )
+        {
+            FrameWithMTU &f = m_rx[m_rx_pos++ % 16];
+            frame->clear();
+            frame->putBuf( f.getBuf(), f.getLength() );
+            r = true;
+        }
+        return r;
+    }
+
+    /// Queue a frame for recvFrame() to return
+    void addIncoming( Frame const &frame )
+    {
+        FrameWithMTU &f = m_rx[m_rx_count++ % 16];
+        f.clear();
+        f.putBuf( frame.getBuf(), frame.getLength() );
+    }
+
+    virtual bool sendFrame( Frame const &frame, uint8_t const *data1, uint16_t len1, uint8_t const *data2, uint16_t len2 ) override
+    {
+        FrameWithMTU &f = m_sent[m_sent_count % 16];
+        f.clear();
+        f.putBuf( frame.getBuf(), frame.getLength() );
+        if ( data1 )
+        {
+            f.putBuf( data1, len1 );
+        }
+        if ( data2 )
+        {
+            f.putBuf( data2, len2 );
+        }
+        ++m_sent_count;
+        return true;
+    }
+
+    virtual bool sendReplyFrame( Frame &frame, uint8_t const *data1, uint16_t len1, uint8_t const *data2, uint16_t len2 ) override
+    {
+        return sendFrame( frame, data1, len1, data2, len2 );
+    }
+
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override
+    {
+        (void)multicast_mac;
+        return true;
+    }
+
+    virtual Eui48 const &getMACAddress() const override { return m_mac; }
+
+    /// Turn the n'th sent command into a response with the given status
+    void makeResponse( uint32_t n, Frame &response, uint8_t status )
+    {
+        FrameWithMTU &f = m_sent[n % 16];
+        response.clear();
+        response.putBuf( f.getBuf(), f.getLength() );
+        response.setOctet( JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+        response.setOctet( ( response.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 2 ) & 0x7 ) | ( status << 3 ),
+                           JDKSAVDECC_FRAME_HEADER_LEN + 2 );
+    }
+
+    jdksavdecc_timestamp_in_milliseconds m_time;
+    uint32_t m_sent_count;
+    Eui48 m_mac;
+    FrameWithMTU m_sent[16];
+    uint32_t m_rx_count;
+    uint32_t m_rx_pos;
+    FrameWithMTU m_rx[16];
+};
+
+/// A Handler that asks for one dispatch key and counts the PDU's it is offered
+class KeyedHandler : public Handler
+{
+  public:
+    KeyedHandler( HandlerDispatchKey key, bool wildcard, bool accept )
+        : m_key( key ), m_wildcard( wildcard ), m_accept( accept ), m_offered( 0 ), m_ticks( 0 )
+    {
+    }
+
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override
+    {
+        (void)time_in_millis;
+        ++m_ticks;
+    }
+
+    virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override
+    {
+        (void)incoming_socket;
+        (void)frame;
+        ++m_offered;
+        return m_accept;
+    }
+
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override
+    {
+        uint16_t r = 0;
+        if ( !m_wildcard && max_keys > 0 )
+        {
+            keys[r++] = m_key;
+        }
+        return r;
+    }
+
+    HandlerDispatchKey m_key;
+    bool m_wildcard;
+    bool m_accept;
+    int m_offered;
+    int m_ticks;
+};
+
+/// Build an AEM command frame addressed to a descriptor
+inline void makeAEMCommand( Frame &frame, uint16_t command_type, uint16_t descriptor_type, uint16_t descriptor_index )
+{
+    frame.clear();
+    frame.putZeros( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN + 8 );
+    frame.setEtherType( JDKSAVDECC_AVTP_ETHERTYPE );
+    frame.setOctet( JDKSAVDECC_1722A_SUBTYPE_AECP, JDKSAVDECC_FRAME_HEADER_LEN );
+    frame.setOctet( JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    frame.setDoublet( command_type, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_OFFSET_COMMAND_TYPE );
+    frame.setDoublet( descriptor_type, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN );
+    frame.setDoublet( descriptor_index, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN + 2 );
+}
+
+/// A RawSocket that lends out its queued frames in place
+class TestRingRawSocket : public TestRawSocket
+{
+  public:
+    TestRingRawSocket() : m_acquired( 0 ), m_released( 0 ) {}
+
+    virtual bool acquireFrame( Frame *frame ) override
+    {
+        bool r = false;
+        if ( m_rx_pos < m_rx_count && m_acquired == m_released )
+        {
+            FrameWithMTU &f = m_rx[m_rx_pos % 16];
+            frame->wrap( m_time, f.getBuf(), f.getLength() );
+            ++m_acquired;
+            r = true;
+        }
+        return r;
+    }
+
+    virtual void releaseFrame( Frame *frame ) override
+    {
+        (void)frame;
+        ++m_rx_pos;
+        ++m_released;
+    }
+
+    int m_acquired;
+    int m_released;
+};
+
+/// An EntityState that answers GET_CONTROL with a value that it does not
+/// copy into the response
+class FragmentEntityState : public EntityState
+{
+  public:
+    FragmentEntityState() : m_entity( 0 )
+    {
+        for ( uint8_t i = 0; i < sizeof( m_value ); ++i )
+        {
+            m_value[i] = 0xa0 + i;
+        }
+    }
+
+    virtual uint8_t receiveGetControlCommand( Frame &pdu, uint16_t descriptor_index ) override
+    {
+        (void)pdu;
+        (void)descriptor_index;
+        m_entity->addResponseFragment( m_value, sizeof( m_value ) );
+        return JDKSAVDECC_AEM_STATUS_SUCCESS;
+    }
+
+    Entity *m_entity;
+    uint8_t m_value[6];
+};
@@ -0,0 +1,42 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_acquired_frames()
+{
+    TestRingRawSocket net;
+    FrameWithMTU rx;
+    FrameWithMTU pdu;
+    HandlerGroupWithSize<4> group( &rx );
+    KeyedHandler commands( HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                               JDKSAVDECC_AVTP_ETHERTYPE,
+                                               JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                               JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND ),
+                           false,
+                           true );
+
+    CHECK( group.add( &commands ) );
+    CHECK( group.addRawSocket( &net ) );
+
+    for ( uint16_t i = 0; i < 2; ++i )
+    {
+        makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, i );
+        net.addIncoming( pdu );
+    }
+
+    // Each frame is dispatched where it lies and released afterwards
+    CHECK( group.pollRawSockets() == 2 );
+    CHECK( commands.m_offered == 2 );
+    CHECK( net.m_acquired == 2 && net.m_released == 2 );
+    CHECK( rx.getLength() == 0 );
+    CHECK( group.getRxCount() == 2 && group.getHandledCount() == 2 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_acquired_frames();
+    return r;
+}
@@ -0,0 +1,116 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+class TestDiscoveryEvents : public ADPDiscoveryEvents
+{
+  public:
+    TestDiscoveryEvents() : m_discovered( 0 ), m_changed( 0 ), m_changes( 0 ), m_departed( 0 ), m_timed_out( 0 ) {}
+
+    virtual void entityDiscovered( ADPDiscovery *discovery, DiscoveredEntity const &entity ) override
+    {
+        (void)discovery;
+        (void)entity;
+        ++m_discovered;
+    }
+
+    virtual void entityChanged( ADPDiscovery *discovery, DiscoveredEntity const &entity, uint16_t changes ) override
+    {
+        (void)discovery;
+        (void)entity;
+        ++m_changed;
+        m_changes = changes;
+    }
+
+    virtual void entityGone( ADPDiscovery *discovery, DiscoveredEntity const &entity, bool departed ) override
+    {
+        (void)discovery;
+        (void)entity;
+        ++( departed ? m_departed : m_timed_out );
+    }
+
+    int m_discovered;
+    int m_changed;
+    uint16_t m_changes;
+    int m_departed;
+    int m_timed_out;
+};
+
+int test_adp_discovery()
+{
+    TestRawSocket net;
+    TestRawSocket remote_net;
+    TestDiscoveryEvents events;
+    ADPCoreInfo info( Eui64( 0x70b3d5fffe000000ULL ), 0, 0, 10 );
+    ADPDiscoveryWithSize<2> discovery( net, Eui64( 0x70b3d5fffe000007ULL ), info, &events );
+    Eui64 a_id( 0x70b3d5fffe000a00ULL );
+    Eui64 b_id( 0x70b3d5fffe000b00ULL );
+    ADPManager a( remote_net, a_id, info );
+    ADPManager b( remote_net, b_id, info );
+    ADPManager c( remote_net, Eui64( 0x70b3d5fffe000c00ULL ), info );
+
+    // Our own advertisements are not discovered
+    discovery.sendADP();
+    discovery.receivedPDU( &net, net.m_sent[0] );
+    CHECK( discovery.getCount() == 0 );
+
+    a.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[0] );
+    CHECK( events.m_discovered == 1 && discovery.getCount() == 1 );
+    CHECK( discovery.find( a_id ) && discovery.find( a_id )->m_valid_time_in_seconds == 10 );
+    CHECK( discovery.getEntity( 0 ).m_mac_address == remote_net.m_mac );
+
+    // Counting up and hearing the same message twice are not changes
+    a.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[1] );
+    discovery.receivedPDU( &net, remote_net.m_sent[1] );
+    CHECK( events.m_changed == 0 && discovery.find( a_id )->m_available_index == 1 );
+
+    a.setGPTPGrandMasterID( Eui64( 0x70b3d5fffe000100ULL ) );
+    a.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[2] );
+    CHECK( events.m_changed == 1 && events.m_changes == ADPDiscovery::CHANGED_GRANDMASTER );
+
+    // A rebooted entity starts its available_index again
+    ADPManager rebooted( remote_net, a_id, info );
+    rebooted.setGPTPGrandMasterID( Eui64( 0x70b3d5fffe000100ULL ) );
+    rebooted.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[3] );
+    CHECK( events.m_changed == 2 && events.m_changes == ADPDiscovery::CHANGED_AVAILABLE_INDEX );
+
+    // The third entity does not fit
+    b.sendADP();
+    c.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[4] );
+    discovery.receivedPDU( &net, remote_net.m_sent[5] );
+    CHECK( events.m_discovered == 2 && discovery.getCount() == 2 && discovery.getDroppedCount() == 1 );
+
+    FrameWithMTU departing;
+    departing.putBuf( remote_net.m_sent[4].getBuf(), remote_net.m_sent[4].getLength() );
+    departing.setOctet( JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_DEPARTING, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    discovery.receivedPDU( &net, departing );
+    CHECK( events.m_departed == 1 && discovery.getCount() == 1 && !discovery.find( b_id ) );
+
+    // The remaining entity times out valid_time after it was last heard
+    discovery.receivedPDU( &net, remote_net.m_sent[5] );
+    CHECK( events.m_discovered == 3 && discovery.getCount() == 2 );
+    discovery.tick( net.m_time );
+    net.m_time += 5000;
+    c.sendADP();
+    discovery.receivedPDU( &net, remote_net.m_sent[6] );
+    net.m_time += 5000;
+    discovery.tick( net.m_time );
+    CHECK( events.m_timed_out == 1 && !discovery.find( a_id ) && discovery.getCount() == 1 );
+    net.m_time += 5000;
+    discovery.tick( net.m_time );
+    CHECK( events.m_timed_out == 2 && discovery.getCount() == 0 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_adp_discovery();
+    return r;
+}
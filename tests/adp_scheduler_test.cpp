@@ -0,0 +1,100 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_adp_scheduler()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPScheduler scheduler( 100, 5 );
+    ADPManager *entities[50];
+    uint32_t most_in_a_step = 0;
+    uint32_t last_count = 0;
+
+    for ( uint16_t i = 0; i < 50; ++i )
+    {
+        entities[i] = new ADPManager( net, Eui64( 0x70b3d5fffe001000ULL + i ), info );
+        entities[i]->setScheduler( &scheduler );
+    }
+
+    // The first announcements are spread over 1/5 of valid_time and never
+    // come faster than the token bucket allows
+    for ( uint32_t step = 0; step < 1300; ++step )
+    {
+        for ( uint16_t i = 0; i < 50; ++i )
+        {
+            entities[i]->tick( net.m_time );
+        }
+        if ( net.m_sent_count - last_count > most_in_a_step )
+        {
+            most_in_a_step = net.m_sent_count - last_count;
+        }
+        last_count = net.m_sent_count;
+        if ( step == 0 )
+        {
+            CHECK( net.m_sent_count < 5 );
+        }
+        net.m_time += 10;
+    }
+    CHECK( most_in_a_step <= 5 );
+    for ( uint16_t i = 0; i < 50; ++i )
+    {
+        CHECK( entities[i]->getAvailableIndex() == 1 );
+    }
+
+    // Responses to ENTITY_DISCOVER are spread out too
+    FrameWithSize<JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_LEN> discover;
+    discover.putBuf( net.m_sent[0].getBuf(), net.m_sent[0].getLength() );
+    discover.setOctet( JDKSAVDECC_ADP_MESSAGE_TYPE_ENTITY_DISCOVER, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    discover.setEUI64( Eui64( static_cast<uint64_t>( 0 ) ), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID );
+    last_count = net.m_sent_count;
+    for ( uint16_t i = 0; i < 50; ++i )
+    {
+        entities[i]->receivedPDU( &net, discover );
+        entities[i]->tick( net.m_time );
+    }
+    CHECK( net.m_sent_count - last_count < 5 );
+    for ( uint32_t step = 0; step < 1300; ++step )
+    {
+        net.m_time += 10;
+        for ( uint16_t i = 0; i < 50; ++i )
+        {
+            entities[i]->tick( net.m_time );
+        }
+    }
+    for ( uint16_t i = 0; i < 50; ++i )
+    {
+        CHECK( entities[i]->getAvailableIndex() == 2 );
+        delete entities[i];
+    }
+    return 0;
+}
+
+int test_adp_scheduler_extra_ports()
+{
+    // Ports above the last bucket are each charged to it
+    uint16_t const num_ports = JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS + 2;
+    ADPScheduler scheduler( 100, 5 );
+    CHECK( scheduler.acquire( num_ports, 1000 ) );
+    CHECK( !scheduler.acquire( num_ports, 1000 ) );
+    CHECK( scheduler.getDeferredCount() == 1 );
+
+    // Two tokens are left in the last bucket
+    CHECK( scheduler.acquire( JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS, 1000 ) );
+    CHECK( scheduler.acquire( JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS, 1000 ) );
+    CHECK( !scheduler.acquire( JDKSAVDECCMCU_ADPSCHEDULER_MAX_PORTS, 1000 ) );
+
+    // The last bucket earns the three tokens back in 30ms
+    CHECK( !scheduler.acquire( num_ports, 1020 ) );
+    CHECK( scheduler.acquire( num_ports, 1030 ) );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_adp_scheduler();
+    r |= test_adp_scheduler_extra_ports();
+    return r;
+}
@@ -0,0 +1,38 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_adp_template()
+{
+    TestRawSocket net;
+    ADPCoreInfo info( Eui64( 0x70b3d5fffe000000ULL ), 0x8, 0, 10 );
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000008ULL ), info );
+    uint16_t pos = JDKSAVDECC_FRAME_HEADER_LEN;
+
+    adp.sendADP();
+    adp.setGPTPGrandMasterID( Eui64( 0x70b3d5fffe000100ULL ) );
+    adp.sendADP();
+    CHECK( net.m_sent_count == 2 && net.m_sent[1].getLength() == JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_LEN );
+    CHECK( jdksavdecc_adpdu_get_available_index( net.m_sent[0].getBuf(), pos ) == 0 );
+    CHECK( jdksavdecc_adpdu_get_available_index( net.m_sent[1].getBuf(), pos ) == 1 );
+    CHECK( Eui64( jdksavdecc_adpdu_get_gptp_grandmaster_id( net.m_sent[1].getBuf(), pos ) ) == Eui64( 0x70b3d5fffe000100ULL ) );
+    CHECK( jdksavdecc_adpdu_get_entity_capabilities( net.m_sent[1].getBuf(), pos ) == 0x8 );
+
+    // Changes to the ADPCoreInfo are sent once the template is invalidated
+    info.m_entity_capabilities = 0x9;
+    adp.sendADP();
+    CHECK( jdksavdecc_adpdu_get_entity_capabilities( net.m_sent[2].getBuf(), pos ) == 0x8 );
+    adp.invalidateADPTemplate();
+    adp.sendADP();
+    CHECK( jdksavdecc_adpdu_get_entity_capabilities( net.m_sent[3].getBuf(), pos ) == 0x9 );
+    CHECK( jdksavdecc_adpdu_get_available_index( net.m_sent[3].getBuf(), pos ) == 3 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_adp_template();
+    return r;
+}
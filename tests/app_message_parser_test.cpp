@@ -0,0 +1,199 @@
+#include "JDKSAvdeccMCU.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+/// An AppMessageHandler that keeps a copy of every message it is given
+class RecordingHandler : public AppMessageHandler
+{
+  public:
+    RecordingHandler() : m_count( 0 ) {}
+
+    virtual void onAppNop( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppEntityIdRequest( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppEntityIdResponse( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppLinkUp( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppLinkDown( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppAvdeccFromApc( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppVendor( AppMessageView const &msg ) override { record( msg ); }
+    virtual void onAppUnknown( AppMessageView const &msg ) override { record( msg ); }
+
+    void record( AppMessageView const &msg )
+    {
+        if ( m_count < 16 )
+        {
+            m_msgs[m_count] = msg;
+        }
+        ++m_count;
+    }
+
+    int m_count;
+    AppMessage m_msgs[16];
+};
+
+/// An AppMessageHandler that only looks at the views it is given
+class ViewHandler : public AppMessageHandler
+{
+  public:
+    ViewHandler() : m_count( 0 ), m_payload( 0 ) {}
+
+    virtual void onAppNop( AppMessageView const & ) override {}
+    virtual void onAppEntityIdRequest( AppMessageView const & ) override {}
+    virtual void onAppEntityIdResponse( AppMessageView const & ) override {}
+    virtual void onAppLinkUp( AppMessageView const & ) override {}
+    virtual void onAppLinkDown( AppMessageView const & ) override {}
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg ) override
+    {
+        ++m_count;
+        m_payload = msg.getPayload();
+        m_kept = msg;
+    }
+    virtual void onAppAvdeccFromApc( AppMessageView const & ) override {}
+    virtual void onAppVendor( AppMessageView const & ) override {}
+    virtual void onAppUnknown( AppMessageView const & ) override {}
+
+    int m_count;
+    uint8_t const *m_payload;
+    AppMessage m_kept;
+};
+
+static bool sameMessage( AppMessage const &a, AppMessage const &b )
+{
+    return a.getMessageType() == b.getMessageType() && a.getAddress() == b.getAddress()
+           && a.getPayloadLength() == b.getPayloadLength() && memcmp( a.getPayload(), b.getPayload(), a.getPayloadLength() ) == 0;
+}
+
+/// Append the stored form of msg to the stream
+static void append( FixedBuffer &stream, AppMessage const &msg )
+{
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> buf;
+    msg.store( &buf );
+    stream.putBuf( buf );
+}
+
+int test_chunked_parse()
+{
+    AppMessage msgs[6];
+    FrameWithMTU frame( 0, Eui48( 0x91e0f0010000ULL ), Eui48( 0x70b3d5edc000ULL ), JDKSAVDECC_AVTP_ETHERTYPE );
+    FixedBufferWithSize<8> vendor_payload;
+    FixedBufferWithSize<4096> stream;
+
+    for ( uint16_t i = 0; i < 300; ++i )
+    {
+        frame.putOctet( uint8_t( i ) );
+    }
+    vendor_payload.putQuadlet( 0x12345678 );
+
+    msgs[0].setNOP();
+    msgs[1].setEntityIdRequest( Eui48( 0x70b3d5edc000ULL ), Eui64( 0x70b3d5fffe000001ULL ) );
+    msgs[2].setAvdeccFromApc( frame );
+    msgs[3].setLinkUp( Eui48( 0x70b3d5edc001ULL ) );
+    msgs[4].setVendor( Eui48( 0x70b3d5000001ULL ), vendor_payload );
+    msgs[5].setAvdeccFromAps( frame );
+    for ( int i = 0; i < 6; ++i )
+    {
+        append( stream, msgs[i] );
+    }
+
+    // Every way of cutting the stream gives the same messages as parsing it
+    // one octet at a time
+    for ( ssize_t chunk = 1; chunk <= stream.getLength(); ++chunk )
+    {
+        RecordingHandler handler;
+        AppMessageParser parser( handler );
+        for ( ssize_t pos = 0; pos < stream.getLength(); pos += chunk )
+        {
+            ssize_t n = stream.getLength() - pos < chunk ? stream.getLength() - pos : chunk;
+            CHECK( parser.parse( stream.getBuf() + pos, n ) == n );
+        }
+        CHECK( handler.m_count == 6 );
+        for ( int i = 0; i < 6; ++i )
+        {
+            CHECK( sameMessage( handler.m_msgs[i], msgs[i] ) );
+        }
+    }
+
+    RecordingHandler octet_handler;
+    AppMessageParser octet_parser( octet_handler );
+    for ( uint16_t pos = 0; pos < stream.getLength(); ++pos )
+    {
+        CHECK( octet_parser.parse( stream.getOctet( pos ) ) == 0 );
+    }
+    CHECK( octet_handler.m_count == 6 );
+    for ( int i = 0; i < 6; ++i )
+    {
+        CHECK( sameMessage( octet_handler.m_msgs[i], msgs[i] ) );
+    }
+    return 0;
+}
+
+int test_parse_error()
+{
+    RecordingHandler handler;
+    AppMessageParser parser( handler );
+    FixedBufferWithSize<64> stream;
+    AppMessage nop;
+
+    append( stream, nop );
+    stream.putOctet( 0x7f );
+    stream.putZeros( JDKSAVDECC_APPDU_HEADER_LEN - 1 );
+    append( stream, nop );
+
+    CHECK( parser.parse( stream.getBuf(), stream.getLength() ) == -1 );
+    CHECK( handler.m_count == 1 && parser.getErrorCount() == 1 );
+    return 0;
+}
+
+int test_view()
+{
+    ViewHandler handler;
+    AppMessageParser parser( handler );
+    FrameWithMTU frame( 0, Eui48( 0x91e0f0010000ULL ), Eui48( 0x70b3d5edc000ULL ), JDKSAVDECC_AVTP_ETHERTYPE );
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> stream;
+
+    frame.putOctet( JDKSAVDECC_1722A_SUBTYPE_ADP );
+    frame.putZeros( 67 );
+
+    // A view of a frame stores the same APPDU as an AppMessage does
+    AppMessage msg;
+    AppMessageView view;
+    msg.setAvdeccFromAps( frame );
+    view.setAvdeccFromAps( frame );
+    CHECK( view.getPayload() == frame.getPayload() );
+    CHECK( view.store( &stream ) );
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> expected;
+    msg.store( &expected );
+    CHECK( stream.getLength() == expected.getLength() );
+    CHECK( memcmp( stream.getBuf(), expected.getBuf(), stream.getLength() ) == 0 );
+
+    // A whole message is dispatched as a view of the buffer it was read into
+    CHECK( parser.parse( stream.getBuf(), stream.getLength() ) == stream.getLength() );
+    CHECK( handler.m_count == 1 );
+    CHECK( handler.m_payload == stream.getBuf() + JDKSAVDECC_APPDU_HEADER_LEN );
+
+    // and the materialized copy outlives the buffer
+    stream.setOctet( 0, JDKSAVDECC_APPDU_HEADER_LEN );
+    CHECK( handler.m_kept.getPayload() != handler.m_payload );
+    CHECK( handler.m_kept.getPayloadLength() == 68 && handler.m_kept.getPayload()[0] == JDKSAVDECC_1722A_SUBTYPE_ADP );
+    CHECK( handler.m_kept.getAddress() == Eui48( 0x70b3d5edc000ULL ) );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_chunked_parse();
+    r |= test_parse_error();
+    r |= test_view();
+    return r;
+}
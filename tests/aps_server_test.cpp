@@ -0,0 +1,349 @@
+#include "JDKSAvdeccMCU.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+#if defined( __linux__ )
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/// A RawSocket with frames queued in memory
+class QueueRawSocket : public RawSocket
+{
+  public:
+    QueueRawSocket() : m_mac( 0x70b3d5edc000ULL ), m_rx_count( 0 ), m_rx_pos( 0 ), m_sent_count( 0 ) {}
+
+    virtual void setHandlerGroup( HandlerGroup *handler_group ) override { (void)handler_group; }
+
+    virtual jdksavdecc_timestamp_in_milliseconds getTimeInMilliseconds() const override { return 1000; }
+
+    virtual bool recvFrame( Frame *frame ) override
+    {
+        bool r = false;
+        if ( m_rx_pos < m_rx_count )
+        {
+            FrameWithMTU &f = m_rx[m_rx_pos++ % 4];
+            frame->clear();
+            frame->putBuf( f.getBuf(), f.getLength() );
+            r = true;
+        }
+        return r;
+    }
+
+    void addIncoming( Frame const &frame )
+    {
+        FrameWithMTU &f = m_rx[m_rx_count++ % 4];
+        f.clear();
+        f.putBuf( frame.getBuf(), frame.getLength() );
+    }
+
+    virtual bool sendFrame( Frame const &frame, uint8_t const *data1, uint16_t len1, uint8_t const *data2, uint16_t len2 ) override
+    {
+        (void)data1;
+        (void)len1;
+        (void)data2;
+        (void)len2;
+        m_sent.clear();
+        m_sent.putBuf( frame.getBuf(), frame.getLength() );
+        ++m_sent_count;
+        return true;
+    }
+
+    virtual bool sendReplyFrame( Frame &frame, uint8_t const *data1, uint16_t len1, uint8_t const *data2, uint16_t len2 ) override
+    {
+        return sendFrame( frame, data1, len1, data2, len2 );
+    }
+
+    virtual bool joinMulticast( const Eui48 &multicast_mac ) override
+    {
+        (void)multicast_mac;
+        return true;
+    }
+
+    virtual Eui48 const &getMACAddress() const override { return m_mac; }
+
+    Eui48 m_mac;
+    uint32_t m_rx_count;
+    uint32_t m_rx_pos;
+    FrameWithMTU m_rx[4];
+    uint32_t m_sent_count;
+    FrameWithMTU m_sent;
+};
+
+/// Collects the messages that an APC receives
+class ApcRecorder : public AppMessageHandler
+{
+  public:
+    ApcRecorder() : m_link_up( 0 ), m_avdecc( 0 ) {}
+
+    virtual void onAppNop( AppMessageView const & ) override {}
+    virtual void onAppEntityIdRequest( AppMessageView const & ) override {}
+    virtual void onAppEntityIdResponse( AppMessageView const & ) override {}
+    virtual void onAppLinkUp( AppMessageView const & ) override { ++m_link_up; }
+    virtual void onAppLinkDown( AppMessageView const & ) override {}
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg ) override
+    {
+        ++m_avdecc;
+        m_last = msg;
+    }
+    virtual void onAppAvdeccFromApc( AppMessageView const & ) override {}
+    virtual void onAppVendor( AppMessageView const & ) override {}
+    virtual void onAppUnknown( AppMessageView const & ) override {}
+
+    int m_link_up;
+    int m_avdecc;
+    AppMessage m_last;
+};
+
+/// A blocking APC connection to the server on the loopback interface
+class TestApc
+{
+  public:
+    TestApc() : m_fd( -1 ), m_parser( m_recorder ), m_in_http( true ) {}
+
+    ~TestApc()
+    {
+        if ( m_fd >= 0 )
+        {
+            close( m_fd );
+        }
+    }
+
+    bool connectTo( uint16_t port )
+    {
+        struct sockaddr_in addr;
+        memset( &addr, 0, sizeof( addr ) );
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons( port );
+        addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        m_fd = socket( AF_INET, SOCK_STREAM, 0 );
+        return m_fd >= 0 && connect( m_fd, (struct sockaddr *)&addr, sizeof( addr ) ) == 0;
+    }
+
+    void sendString( char const *s ) { send( m_fd, s, strlen( s ), 0 ); }
+
+    void sendMsg( AppMessage const &msg )
+    {
+        FixedBufferWithSize<AppMessageParser::max_appdu_message_size> buf;
+        msg.store( &buf );
+        send( m_fd, buf.getBuf(), buf.getLength(), 0 );
+    }
+
+    /// Read whatever has arrived, skipping the HTTP response
+    void receive()
+    {
+        uint8_t buf[4096];
+        ssize_t len = recv( m_fd, buf, sizeof( buf ), MSG_DONTWAIT );
+        ssize_t pos = 0;
+        while ( m_in_http && pos + 3 < len )
+        {
+            if ( memcmp( buf + pos, "\r\n\r\n", 4 ) == 0 )
+            {
+                m_in_http = false;
+                pos += 4;
+                break;
+            }
+            ++pos;
+        }
+        if ( !m_in_http && len > pos )
+        {
+            m_parser.parse( buf + pos, len - pos );
+        }
+    }
+
+    int m_fd;
+    ApcRecorder m_recorder;
+    AppMessageParser m_parser;
+    bool m_in_http;
+};
+
+static void pollFor( ApsServerLinux &server, TestApc *apcs, int num_apcs )
+{
+    for ( int i = 0; i < 20; ++i )
+    {
+        server.poll( 5 );
+        for ( int k = 0; k < num_apcs; ++k )
+        {
+            apcs[k].receive();
+        }
+    }
+}
+
+int test_aps_server()
+{
+    QueueRawSocket net;
+    ApsServerLinux server( net, "/", 2 );
+    TestApc apcs[3];
+
+    if ( !server.open( 0, "127.0.0.1" ) )
+    {
+        std::cerr << "loopback TCP is not available, skipping" << std::endl;
+        return 0;
+    }
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        CHECK( apcs[i].connectTo( server.getListenPort() ) );
+    }
+    apcs[0].sendString( "CONNECT / HTTP/1.1\r\n\r\n" );
+    apcs[1].sendString( "CONNECT / HTTP/1.1\r\n\r\n" );
+    pollFor( server, apcs, 2 );
+
+    // The third APC is turned away
+    CHECK( server.getConnectionCount() == 2 && server.getRejectedCount() == 1 );
+    CHECK( apcs[0].m_recorder.m_link_up == 1 && apcs[1].m_recorder.m_link_up == 1 );
+
+    // Frames from the network go to every APC
+    FrameWithMTU frame( 0, Eui48( 0x91e0f0010000ULL ), Eui48( 0x70b3d5edc100ULL ), JDKSAVDECC_AVTP_ETHERTYPE );
+    frame.putOctet( JDKSAVDECC_SUBTYPE_ADP | 0x80 );
+    frame.putZeros( 67 );
+    net.addIncoming( frame );
+    pollFor( server, apcs, 2 );
+    CHECK( apcs[0].m_recorder.m_avdecc == 1 && apcs[1].m_recorder.m_avdecc == 1 );
+    CHECK( apcs[0].m_recorder.m_last.getPayloadLength() == 68 );
+
+    // Frames from any APC go to the network, even several in one write
+    AppMessage msg;
+    FixedBufferWithSize<2 * AppMessageParser::max_appdu_message_size> two;
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> buf;
+    msg.setAvdeccFromApc( frame );
+    msg.store( &buf );
+    two.putBuf( buf );
+    two.putBuf( buf );
+    send( apcs[1].m_fd, two.getBuf(), two.getLength(), 0 );
+    pollFor( server, apcs, 2 );
+    CHECK( net.m_sent_count == 2 );
+    CHECK( net.m_sent.getSA() == net.m_mac && net.m_sent.getLength() == frame.getLength() );
+
+    // A closed APC goes away
+    close( apcs[0].m_fd );
+    apcs[0].m_fd = -1;
+    pollFor( server, apcs + 1, 1 );
+    CHECK( server.getConnectionCount() == 1 );
+    return 0;
+}
+
+static void addControlFrame( QueueRawSocket &net, Eui48 const &da, uint8_t subtype, Eui64 const &target, Eui64 const &controller )
+{
+    FrameWithMTU frame( 0, da, Eui48( 0x70b3d5edc100ULL ), JDKSAVDECC_AVTP_ETHERTYPE );
+    frame.putOctet( subtype );
+    frame.putZeros( 3 );
+    frame.putEUI64( target );
+    frame.putEUI64( controller );
+    frame.putZeros( 40 );
+    net.addIncoming( frame );
+}
+
+int test_aps_server_filter()
+{
+    QueueRawSocket net;
+    ApsServerLinux server( net, "/", 2 );
+    TestApc apcs[2];
+    Eui48 const multicast( 0x91e0f0010000ULL );
+    Eui48 const unicast( 0x70b3d5edc000ULL );
+    Eui64 const wanted( 0x70b3d5fffe000001ULL );
+    Eui64 const other( 0x70b3d5fffe000002ULL );
+
+    if ( !server.open( 0, "127.0.0.1" ) )
+    {
+        std::cerr << "loopback TCP is not available, skipping" << std::endl;
+        return 0;
+    }
+
+    for ( int i = 0; i < 2; ++i )
+    {
+        CHECK( apcs[i].connectTo( server.getListenPort() ) );
+        apcs[i].sendString( "CONNECT / HTTP/1.1\r\n\r\n" );
+    }
+    pollFor( server, apcs, 2 );
+    CHECK( server.getConnectionCount() == 2 );
+
+    // The second APC only wants all ADP, and AECP about one entity
+    ApsConnectionFilter filter;
+    filter.m_all_subtypes = ApsConnectionFilter::ADP;
+    filter.m_matched_subtypes = ApsConnectionFilter::AECP;
+    CHECK( filter.addTarget( wanted ) );
+    server.getConnection( 1 )->setFilter( filter );
+
+    addControlFrame( net, multicast, JDKSAVDECC_1722A_SUBTYPE_ADP, other, Eui64() );
+    addControlFrame( net, unicast, JDKSAVDECC_1722A_SUBTYPE_AECP, wanted, other );
+    addControlFrame( net, unicast, JDKSAVDECC_1722A_SUBTYPE_AECP, other, other );
+    addControlFrame( net, multicast, JDKSAVDECC_1722A_SUBTYPE_ACMP, wanted, wanted );
+    pollFor( server, apcs, 2 );
+    CHECK( apcs[0].m_recorder.m_avdecc == 4 );
+    CHECK( apcs[1].m_recorder.m_avdecc == 2 );
+    CHECK( server.getFilteredCount() == 0 );
+
+    // AECP responses to the APC's controller are matched too
+    addControlFrame( net, unicast, JDKSAVDECC_1722A_SUBTYPE_AECP, other, wanted );
+    pollFor( server, apcs, 2 );
+    CHECK( apcs[0].m_recorder.m_avdecc == 5 && apcs[1].m_recorder.m_avdecc == 3 );
+
+    // Multicast can be turned off, and a frame nobody wants is counted
+    filter.m_multicast = false;
+    server.getConnection( 1 )->setFilter( filter );
+    server.getConnection( 0 )->setFilter( filter );
+    addControlFrame( net, multicast, JDKSAVDECC_1722A_SUBTYPE_ADP, other, Eui64() );
+    pollFor( server, apcs, 2 );
+    CHECK( apcs[0].m_recorder.m_avdecc == 5 && apcs[1].m_recorder.m_avdecc == 3 );
+    CHECK( server.getFilteredCount() == 1 );
+    return 0;
+}
+
+int test_aps_server_coalesce()
+{
+    QueueRawSocket net;
+    ApsServerLinux server( net, "/", 2 );
+    TestApc apcs[2];
+
+    if ( !server.open( 0, "127.0.0.1" ) )
+    {
+        std::cerr << "loopback TCP is not available, skipping" << std::endl;
+        return 0;
+    }
+
+    for ( int i = 0; i < 2; ++i )
+    {
+        CHECK( apcs[i].connectTo( server.getListenPort() ) );
+        apcs[i].sendString( "CONNECT / HTTP/1.1\r\n\r\n" );
+    }
+    pollFor( server, apcs, 2 );
+    CHECK( server.getConnectionCount() == 2 );
+
+    // Four frames received in one pass of the loop take one write per APC
+    uint32_t writes = server.getWriteCount();
+    for ( int i = 0; i < 4; ++i )
+    {
+        addControlFrame( net, Eui48( 0x91e0f0010000ULL ), JDKSAVDECC_1722A_SUBTYPE_ADP, Eui64( 0x70b3d5fffe000001ULL ), Eui64() );
+    }
+    server.poll( 0 );
+    CHECK( server.getWriteCount() == writes + 2 );
+    CHECK( server.getConnection( 0 )->getTxPending() == 0 && server.getConnection( 1 )->getTxPending() == 0 );
+
+    pollFor( server, apcs, 2 );
+    CHECK( apcs[0].m_recorder.m_avdecc == 4 && apcs[1].m_recorder.m_avdecc == 4 );
+    CHECK( server.getDroppedCount() == 0 );
+    return 0;
+}
+#endif
+
+int main()
+{
+    int r = 0;
+#if defined( __linux__ )
+    r |= test_aps_server();
+    r |= test_aps_server_filter();
+    r |= test_aps_server_coalesce();
+#endif
+    return r;
+}
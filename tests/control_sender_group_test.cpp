@@ -0,0 +1,132 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_control_sender_group()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000005ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    InflightCommandsWithSize<4> inflight( 250, 1 );
+    ControllerEntity controller( adp, &registered, 0, &inflight );
+    ControlSenderGroupWithSize<3> senders( controller, 1000, 10 );
+    ControlValueHolderWithStorage<uint16_t, 1> knob;
+    ControlValueHolderWithStorage<uint16_t, 1> other_knob;
+    ControlValueHolderWithStorage<uint16_t, 1> button;
+    Eui64 target_a( 0x70b3d5fffe100000ULL );
+    Eui64 target_b( 0x70b3d5fffe100001ULL );
+
+    CHECK( senders.add( target_a, Eui48( 0x70b3d5100000ULL ), 0, &knob ) );
+    CHECK( senders.add( target_b, Eui48( 0x70b3d5100001ULL ), 2, &button ) );
+    CHECK( senders.add( target_a, Eui48( 0x70b3d5100000ULL ), 1, &other_knob ) );
+    CHECK( !senders.add( target_a, Eui48( 0x70b3d5100000ULL ), 3, &knob ) );
+
+    // The controls for one target are sent back to back
+    senders.tick( net.m_time );
+    CHECK( net.m_sent_count == 3 );
+    uint16_t const index_pos = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN + 2;
+    CHECK( net.m_sent[0].getDoublet( index_pos ) == 0 );
+    CHECK( net.m_sent[1].getDoublet( index_pos ) == 1 );
+    CHECK( net.m_sent[2].getDoublet( index_pos ) == 2 );
+
+    // While the knob's command waits for its response, spinning it sends
+    // nothing
+    for ( uint16_t v = 1; v <= 5; ++v )
+    {
+        knob.setValueDoublet( v );
+        net.m_time += 5;
+        senders.tick( net.m_time );
+    }
+    CHECK( net.m_sent_count == 3 );
+
+    // The response arrives 25ms after the command, then only the newest value
+    // is sent
+    FrameWithMTU response;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( senders.getSmoothedLatency() == 25 / 8 );
+    CHECK( senders.getSendInterval() == 10 );
+    senders.tick( net.m_time );
+    CHECK( net.m_sent_count == 4 );
+    FrameWithMTU &sent = net.m_sent[3];
+    CHECK( sent.getDoublet( index_pos ) == 0 );
+    CHECK( sent.getDoublet( sent.getLength() - 2 ) == 5 );
+
+    // Commands that time out slow the sender down, and are sent again
+    net.m_time += 300;
+    controller.tick( net.m_time );
+    net.m_time += 300;
+    controller.tick( net.m_time );
+    CHECK( senders.getSendInterval() > 10 );
+    CHECK( knob.isDirty() );
+    return 0;
+}
+
+int test_control_sender_group_without_inflight()
+{
+    // Configured like the KnobsAndButtons example, without an in-flight table
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000005ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    ControllerEntity controller( adp, &registered, 0 );
+    ControlSenderGroupWithSize<2> senders( controller, 1000 );
+    ControlValueHolderWithStorage<uint16_t, 1> knobs;
+    ControlValueHolderWithStorage<uint16_t, 1> buttons;
+    Eui64 target( 0x70b3d5fffe100000ULL );
+
+    CHECK( senders.add( target, Eui48( 0x70b3d5100000ULL ), 0, &knobs ) );
+    CHECK( senders.add( target, Eui48( 0x70b3d5100000ULL ), 1, &buttons ) );
+
+    // The entity tracks one command, so the buttons wait for the knobs
+    senders.tick( net.m_time );
+    CHECK( net.m_sent_count == 1 );
+    CHECK( !controller.canSendCommand() );
+
+    for ( uint16_t v = 1; v <= 5; ++v )
+    {
+        knobs.setValueDoublet( v );
+        net.m_time += 4;
+        senders.tick( net.m_time );
+    }
+    CHECK( net.m_sent_count == 1 );
+
+    // The response paces the sender and lets the buttons go
+    FrameWithMTU response;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( senders.getSmoothedLatency() == 20 / 8 );
+    senders.tick( net.m_time );
+    CHECK( net.m_sent_count == 2 );
+    uint16_t const index_pos = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN + 2;
+    CHECK( net.m_sent[1].getDoublet( index_pos ) == 1 );
+
+    // Then only the newest knob value is sent
+    net.makeResponse( 1, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    net.m_time += senders.getSendInterval();
+    senders.tick( net.m_time );
+    CHECK( net.m_sent_count == 3 );
+    FrameWithMTU &sent = net.m_sent[2];
+    CHECK( sent.getDoublet( index_pos ) == 0 );
+    CHECK( sent.getDoublet( sent.getLength() - 2 ) == 5 );
+
+    // A time out slows the sender down and sends the value again
+    jdksavdecc_timestamp_in_milliseconds interval = senders.getSendInterval();
+    net.m_time += JDKSAVDECC_AEM_TIMEOUT_IN_MS + 1;
+    controller.tick( net.m_time );
+    CHECK( senders.getSendInterval() > interval );
+    CHECK( knobs.isDirty() );
+    CHECK( controller.canSendCommand() );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_control_sender_group();
+    r |= test_control_sender_group_without_inflight();
+    return r;
+}
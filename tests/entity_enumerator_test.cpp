@@ -0,0 +1,183 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+/// Answer a READ_DESCRIPTOR command the way a small entity would
+void makeReadDescriptorResponse( Frame const &command, Frame &response )
+{
+    uint16_t descriptor_type = jdksavdecc_aem_command_read_descriptor_get_descriptor_type( command.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN );
+    uint16_t descriptor_index
+        = jdksavdecc_aem_command_read_descriptor_get_descriptor_index( command.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN );
+    uint16_t header_length = JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR_RESPONSE_OFFSET_DESCRIPTOR;
+    uint16_t descriptor_length = 8;
+
+    response.clear();
+    response.putBuf( command.getBuf(), header_length );
+    response.putZeros( JDKSAVDECC_DESCRIPTOR_ENTITY_LEN );
+    uint8_t *descriptor = response.getBuf( header_length );
+    jdksavdecc_uint16_set( descriptor_type, descriptor, 0 );
+    jdksavdecc_uint16_set( descriptor_index, descriptor, 2 );
+
+    if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_ENTITY )
+    {
+        descriptor_length = JDKSAVDECC_DESCRIPTOR_ENTITY_LEN;
+        jdksavdecc_uint16_set( 1, descriptor, JDKSAVDECC_DESCRIPTOR_ENTITY_OFFSET_CONFIGURATIONS_COUNT );
+        jdksavdecc_uint16_set( 0, descriptor, JDKSAVDECC_DESCRIPTOR_ENTITY_OFFSET_CURRENT_CONFIGURATION );
+    }
+    else if ( descriptor_type == JDKSAVDECC_DESCRIPTOR_CONFIGURATION )
+    {
+        // 2 AUDIO_UNIT and 3 STREAM_INPUT descriptors
+        descriptor_length = JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN + 8;
+        jdksavdecc_uint16_set( 2, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_OFFSET_DESCRIPTOR_COUNTS_COUNT );
+        jdksavdecc_uint16_set(
+            JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_OFFSET_DESCRIPTOR_COUNTS_OFFSET );
+        jdksavdecc_uint16_set( JDKSAVDECC_DESCRIPTOR_AUDIO_UNIT, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN + 0 );
+        jdksavdecc_uint16_set( 2, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN + 2 );
+        jdksavdecc_uint16_set( JDKSAVDECC_DESCRIPTOR_STREAM_INPUT, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN + 4 );
+        jdksavdecc_uint16_set( 3, descriptor, JDKSAVDECC_DESCRIPTOR_CONFIGURATION_LEN + 6 );
+    }
+    response.setLength( header_length + descriptor_length );
+
+    uint16_t control_data_length = response.getLength() - JDKSAVDECC_FRAME_HEADER_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+    response.setOctet( JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    response.setOctet( ( control_data_length >> 8 ) & 0x7, JDKSAVDECC_FRAME_HEADER_LEN + 2 );
+    response.setOctet( control_data_length & 0xff, JDKSAVDECC_FRAME_HEADER_LEN + 3 );
+}
+
+class TestEnumerator : public EntityEnumeratorWithSize<2, 2048>
+{
+  public:
+    TestEnumerator( ControllerEntity &controller ) : EntityEnumeratorWithSize<2, 2048>( controller, 4, 3 ), m_completed( 0 ) {}
+
+    virtual void enumerationCompleted( EnumeratedEntity const &entity ) override
+    {
+        (void)entity;
+        ++m_completed;
+    }
+
+    int m_completed;
+};
+
+int test_entity_enumerator()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    InflightCommandsWithSize<8> inflight( 250, 0 );
+    ControllerCommandQueueWithSize<2, 8> queue( 2 );
+    ControllerEntity controller( adp, &registered, 0, &inflight, &queue );
+    TestEnumerator enumerator( controller );
+
+    Eui64 target( 0x70b3d5fffe100000ULL );
+    CHECK( enumerator.enumerate( target, Eui48( 0x70b3d5100000ULL ) ) );
+
+    // Answer every command as it is sent, except the first request for
+    // STREAM_INPUT 1 which is lost
+    uint32_t answered = 0;
+    bool dropped = false;
+    for ( int step = 0; step < 100 && enumerator.m_completed == 0; ++step )
+    {
+        while ( answered < net.m_sent_count )
+        {
+            Frame &command = net.m_sent[answered++ % 16];
+            if ( !dropped
+                 && jdksavdecc_aem_command_read_descriptor_get_descriptor_type( command.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN )
+                    == JDKSAVDECC_DESCRIPTOR_STREAM_INPUT
+                 && jdksavdecc_aem_command_read_descriptor_get_descriptor_index( command.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN ) == 1 )
+            {
+                dropped = true;
+                continue;
+            }
+            FrameWithMTU response;
+            net.m_time += 1;
+            makeReadDescriptorResponse( command, response );
+            controller.receivedPDU( &net, response );
+        }
+        net.m_time += 100;
+        controller.tick( net.m_time );
+        enumerator.tick( net.m_time );
+    }
+
+    EnumeratedEntity *entity = enumerator.findEntity( target );
+    CHECK( enumerator.m_completed == 1 );
+    CHECK( dropped );
+    CHECK( entity && entity->m_state == EnumeratedEntity::COMPLETED );
+    CHECK( entity->m_missing_count == 0 );
+    CHECK( entity->m_store.getCount() == 7 );
+    CHECK( entity->getEnumerationTime() > 250 );
+
+    uint16_t length = 0;
+    CHECK( entity->m_store.find( JDKSAVDECC_DESCRIPTOR_STREAM_INPUT, 1, &length ) != 0 && length == 8 );
+    CHECK( entity->m_store.find( JDKSAVDECC_DESCRIPTOR_ENTITY, 0, &length ) != 0
+           && length == JDKSAVDECC_DESCRIPTOR_ENTITY_LEN );
+    CHECK( entity->m_store.find( JDKSAVDECC_DESCRIPTOR_AUDIO_UNIT, 2, &length ) == 0 );
+
+    return 0;
+}
+
+int test_entity_enumerator_again()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    InflightCommandsWithSize<8> inflight( 250, 0 );
+    ControllerEntity controller( adp, &registered, 0, &inflight );
+    TestEnumerator enumerator( controller );
+
+    Eui64 target( 0x70b3d5fffe100000ULL );
+    CHECK( enumerator.enumerate( target, Eui48( 0x70b3d5100000ULL ) ) );
+
+    // Answer the ENTITY and CONFIGURATION descriptors so that the walk has
+    // a full pipeline of commands in flight
+    FrameWithMTU response;
+    uint32_t answered = 0;
+    while ( answered < 2 )
+    {
+        makeReadDescriptorResponse( net.m_sent[answered++ % 16], response );
+        controller.receivedPDU( &net, response );
+    }
+    EnumeratedEntity *entity = enumerator.findEntity( target );
+    CHECK( entity && entity->m_outstanding == 4 );
+
+    // Enumerate again while they are in flight, and let one of them time out
+    CHECK( enumerator.enumerate( target, Eui48( 0x70b3d5100000ULL ) ) );
+    uint32_t first_pass_sent = net.m_sent_count;
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        makeReadDescriptorResponse( net.m_sent[answered++ % 16], response );
+        controller.receivedPDU( &net, response );
+    }
+    CHECK( net.m_sent_count == first_pass_sent );
+    ++answered;
+    net.m_time += 300;
+    controller.tick( net.m_time );
+    CHECK( entity->m_outstanding == 1 && !entity->m_restart_pending );
+    CHECK( entity->m_store.getCount() == 0 );
+
+    // The second walk runs to the end
+    for ( int step = 0; step < 100 && enumerator.m_completed == 0; ++step )
+    {
+        while ( answered < net.m_sent_count )
+        {
+            makeReadDescriptorResponse( net.m_sent[answered++ % 16], response );
+            controller.receivedPDU( &net, response );
+        }
+        enumerator.tick( net.m_time );
+    }
+    CHECK( enumerator.m_completed == 1 );
+    CHECK( entity->m_state == EnumeratedEntity::COMPLETED );
+    CHECK( entity->m_outstanding == 0 );
+    CHECK( entity->m_store.getCount() == 7 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_entity_enumerator();
+    r |= test_entity_enumerator_again();
+    return r;
+}
@@ -0,0 +1,116 @@
+#include "JDKSAvdeccMCU.hpp"
+
+#include <unordered_set>
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+int test_compare_and_hash()
+{
+    Eui64 a( 0x70b3d5fffe000001ULL );
+    Eui64 b( 0x70b3d5fffe000001ULL );
+    Eui64 c( 0x70b3d5fffe000002ULL );
+    CHECK( a == b && !( a != b ) );
+    CHECK( a != c && !( a == c ) );
+    CHECK( a < c && c > a );
+    CHECK( a.hash() == b.hash() && a.hash() != c.hash() );
+
+    // Every octet takes part, including the ones past the first four
+    Eui48 m( 0x70b3d5edc000ULL );
+    for ( int i = 0; i < 6; ++i )
+    {
+        Eui48 n( m );
+        n.value[i] ^= 1;
+        CHECK( m != n && !( m == n ) );
+    }
+    CHECK( m == Eui48( 0x70b3d5edc000ULL ) );
+
+    // The hash is stable across platforms
+    CHECK( euiHash( 0 ) == 0 );
+    CHECK( euiHash( 1 ) == 0xb456bcfc34c2cb2cULL );
+
+    std::unordered_set<Eui64> set;
+    set.insert( a );
+    set.insert( b );
+    set.insert( c );
+    CHECK( set.size() == 2 );
+    return 0;
+}
+
+int test_flat_map()
+{
+    EuiFlatMap<Eui64, uint32_t, 100> map;
+    CHECK( ( EuiFlatMap<Eui64, uint32_t, 100>::IndexSize == 256 ) );
+
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        bool inserted = false;
+        uint32_t *v = map.insert( Eui64( 0x70b3d5fffe000000ULL + i ), &inserted );
+        CHECK( v && inserted );
+        *v = i;
+    }
+    CHECK( map.isFull() );
+    CHECK( map.insert( Eui64( 0x70b3d5fffe001000ULL ) ) == 0 );
+
+    bool inserted = true;
+    CHECK( map.insert( Eui64( 0x70b3d5fffe000005ULL ), &inserted ) && !inserted );
+
+    // Erase every third one, the rest can still be found
+    for ( uint32_t i = 0; i < 100; i += 3 )
+    {
+        CHECK( map.erase( Eui64( 0x70b3d5fffe000000ULL + i ) ) );
+    }
+    CHECK( !map.erase( Eui64( 0x70b3d5fffe000000ULL ) ) );
+    CHECK( map.getCount() == 66 );
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        uint32_t const *v = map.find( Eui64( 0x70b3d5fffe000000ULL + i ) );
+        CHECK( ( v != 0 ) == ( i % 3 != 0 ) );
+        CHECK( !v || *v == i );
+    }
+
+    // Keys and values stay together when items move
+    for ( uint16_t i = 0; i < map.getCount(); ++i )
+    {
+        CHECK( map.getKey( i ).convertToUint64() - 0x70b3d5fffe000000ULL == map.getValue( i ) );
+    }
+
+    // Erase while iterating backwards
+    for ( uint16_t i = map.getCount(); i > 0; --i )
+    {
+        if ( map.getValue( i - 1 ) & 1 )
+        {
+            map.eraseAt( i - 1 );
+        }
+    }
+    for ( uint32_t i = 0; i < 100; ++i )
+    {
+        CHECK( ( map.find( Eui64( 0x70b3d5fffe000000ULL + i ) ) != 0 ) == ( i % 3 != 0 && ( i & 1 ) == 0 ) );
+    }
+
+    map.clear();
+    CHECK( map.getCount() == 0 && !map.find( Eui64( 0x70b3d5fffe000001ULL ) ) );
+
+    EuiFlatMap<Eui48, uint16_t, 4> macs;
+    *macs.insert( Eui48( 0x70b3d5edc000ULL ) ) = 7;
+    CHECK( macs.find( Eui48( 0x70b3d5edc000ULL ) ) && *macs.find( Eui48( 0x70b3d5edc000ULL ) ) == 7 );
+    CHECK( !macs.find( Eui48( 0x70b3d5edc001ULL ) ) );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_compare_and_hash();
+    r |= test_flat_map();
+    return r;
+}
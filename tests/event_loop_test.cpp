@@ -0,0 +1,50 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_event_loop()
+{
+    TestRawSocket net;
+    FrameWithMTU rx;
+    FrameWithMTU pdu;
+    HandlerGroupWithSize<4> group( &rx );
+    KeyedHandler commands( HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                               JDKSAVDECC_AVTP_ETHERTYPE,
+                                               JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                               JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND ),
+                           false,
+                           true );
+    KeyedHandler tick_only( HandlerDispatchKey( HandlerDispatchKey::NONE ), false, true );
+
+    CHECK( group.add( &commands ) );
+    CHECK( group.add( &tick_only ) );
+    CHECK( !group.run( 0 ) );
+    CHECK( group.addRawSocket( &net ) );
+
+    for ( uint16_t i = 0; i < 3; ++i )
+    {
+        makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, i );
+        net.addIncoming( pdu );
+    }
+
+    // The whole batch is dispatched before the handlers are ticked once
+    CHECK( group.run( 0 ) );
+    CHECK( commands.m_offered == 3 );
+    CHECK( commands.m_ticks == 1 && tick_only.m_ticks == 1 );
+    CHECK( group.getLastBatchSize() == 3 );
+    CHECK( group.getRxCount() == 3 && group.getHandledCount() == 3 );
+
+    CHECK( group.run( 0 ) );
+    CHECK( commands.m_offered == 3 && commands.m_ticks == 2 );
+    CHECK( group.getLastBatchSize() == 0 && group.getLargestBatchSize() == 3 );
+    CHECK( group.getLoopCount() == 2 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_event_loop();
+    return r;
+}
@@ -0,0 +1,143 @@
+#include "JDKSAvdeccMCU.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+static FramePoolWithSize<4> small_pool;
+
+int test_allocate_and_share()
+{
+    FramePool &pool = small_pool;
+    CHECK( pool.getCapacity() == 4 && pool.getAvailableCount() == 4 );
+
+    {
+        FrameRef a = pool.allocate( 1234 );
+        CHECK( a.isValid() && a.isUnique() );
+        CHECK( a->getLength() == 0 && a->getTimeInMilliseconds() == 1234 );
+        CHECK( a->getMaxLength() == FrameWithMTU().getMaxLength() );
+        CHECK( ( reinterpret_cast<uintptr_t>( a.get() ) % JDKSAVDECCMCU_CACHE_LINE_SIZE ) == 0 );
+        a->putOctet( 0x5a );
+
+        // A copy shares the frame instead of copying it
+        FrameRef b = a;
+        CHECK( b.get() == a.get() && a.getUseCount() == 2 );
+        CHECK( pool.getAvailableCount() == 3 );
+
+        a.reset();
+        CHECK( !a.isValid() && b.isUnique() && b->getOctet( 0 ) == 0x5a );
+        CHECK( pool.getAvailableCount() == 3 );
+    }
+    CHECK( pool.getAvailableCount() == 4 );
+
+    // Running out gives an invalid handle
+    FrameRef held[4];
+    for ( int i = 0; i < 4; ++i )
+    {
+        held[i] = pool.allocate();
+        CHECK( held[i].isValid() );
+    }
+    CHECK( !pool.allocate().isValid() );
+    CHECK( pool.getFailureCount() == 1 && pool.getLowWaterMark() == 0 );
+
+    FrameRef moved( std::move( held[0] ) );
+    CHECK( !held[0].isValid() && moved.isUnique() );
+    moved.reset();
+    CHECK( pool.allocate().isValid() );
+    for ( int i = 1; i < 4; ++i )
+    {
+        held[i].reset();
+    }
+    CHECK( pool.getAvailableCount() == 4 );
+    return 0;
+}
+
+int test_cache()
+{
+    FramePool &pool = small_pool;
+    {
+        FramePoolCacheWithSize<2> cache( &pool );
+        FrameRef a = cache.allocate();
+        FrameRef b = cache.allocate();
+        Frame *first = a.get();
+        CHECK( pool.getAvailableCount() == 2 );
+
+        // The last handle stays in the cache, a shared one does not
+        FrameRef shared = b;
+        cache.recycle( a );
+        cache.recycle( b );
+        CHECK( !a.isValid() && !b.isValid() && shared.isUnique() );
+        CHECK( cache.getCount() == 1 && pool.getAvailableCount() == 2 );
+
+        FrameRef c = cache.allocate( 99 );
+        CHECK( c.get() == first && c.isUnique() && c->getTimeInMilliseconds() == 99 );
+        CHECK( cache.getCount() == 0 );
+        cache.recycle( c );
+    }
+    // The cache gives its frames back when it goes away
+    CHECK( pool.getAvailableCount() == 4 );
+    return 0;
+}
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+static FramePoolWithSize<64> shared_pool;
+
+/// Allocate, share and release frames as fast as possible
+static void churn( int count )
+{
+    FrameRef held[8];
+    for ( int i = 0; i < count; ++i )
+    {
+        FrameRef &ref = held[i % 8];
+        ref = shared_pool.allocate();
+        if ( ref.isValid() )
+        {
+            FrameRef copy = ref;
+            copy->putOctet( static_cast<uint8_t>( i ) );
+        }
+    }
+}
+
+int test_threads()
+{
+    std::thread t1( churn, 100000 );
+    std::thread t2( churn, 100000 );
+    churn( 100000 );
+    t1.join();
+    t2.join();
+
+    // Every frame came back exactly once
+    CHECK( shared_pool.getAvailableCount() == 64 );
+    FrameRef all[64];
+    for ( int i = 0; i < 64; ++i )
+    {
+        all[i] = shared_pool.allocate();
+        CHECK( all[i].isValid() );
+        for ( int j = 0; j < i; ++j )
+        {
+            CHECK( all[j].get() != all[i].get() );
+        }
+    }
+    CHECK( !shared_pool.allocate().isValid() );
+    return 0;
+}
+#endif
+
+int main()
+{
+    int r = 0;
+    r |= test_allocate_and_share();
+    r |= test_cache();
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    r |= test_threads();
+#endif
+    return r;
+}
@@ -0,0 +1,127 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_handler_dispatch()
+{
+    TestRawSocket net;
+    FrameWithMTU rx;
+    HandlerGroupWithSize<8> group( &rx );
+
+    KeyedHandler adp( HandlerDispatchKey( HandlerDispatchKey::SUBTYPE, JDKSAVDECC_AVTP_ETHERTYPE, JDKSAVDECC_1722A_SUBTYPE_ADP ),
+                      false,
+                      true );
+    KeyedHandler tick_only( HandlerDispatchKey( HandlerDispatchKey::NONE ), false, true );
+    KeyedHandler control3( HandlerDispatchKey( HandlerDispatchKey::DESCRIPTOR,
+                                               JDKSAVDECC_AVTP_ETHERTYPE,
+                                               JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                               JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND,
+                                               JDKSAVDECC_AEM_COMMAND_SET_CONTROL,
+                                               JDKSAVDECC_DESCRIPTOR_CONTROL,
+                                               3 ),
+                           false,
+                           true );
+    KeyedHandler commands( HandlerDispatchKey( HandlerDispatchKey::MESSAGE_TYPE,
+                                               JDKSAVDECC_AVTP_ETHERTYPE,
+                                               JDKSAVDECC_1722A_SUBTYPE_AECP,
+                                               JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_COMMAND ),
+                           false,
+                           true );
+    KeyedHandler wildcard( HandlerDispatchKey(), true, false );
+
+    CHECK( group.add( &adp ) );
+    CHECK( group.add( &tick_only ) );
+    CHECK( group.add( &control3 ) );
+    CHECK( group.add( &commands ) );
+    CHECK( group.add( &wildcard ) );
+    CHECK( group.getWildcardCount() == 1 );
+
+    // The descriptor specific handler gets its own SET_CONTROL only
+    makeAEMCommand( rx, JDKSAVDECC_AEM_COMMAND_SET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 3 );
+    CHECK( group.receivedPDU( &net, rx ) );
+    CHECK( control3.m_offered == 1 && commands.m_offered == 0 && adp.m_offered == 0 );
+
+    // Other controls fall back to the less specific key
+    makeAEMCommand( rx, JDKSAVDECC_AEM_COMMAND_SET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 4 );
+    CHECK( group.receivedPDU( &net, rx ) );
+    CHECK( control3.m_offered == 1 && commands.m_offered == 1 );
+
+    // Responses match nothing specific and only reach the wildcard
+    makeAEMCommand( rx, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 3 );
+    rx.setOctet( JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    CHECK( !group.receivedPDU( &net, rx ) );
+    CHECK( wildcard.m_offered == 1 && commands.m_offered == 1 );
+    CHECK( tick_only.m_offered == 0 );
+
+    CHECK( group.getRxCount() == 3 );
+    CHECK( group.getHandledCount() == 2 );
+    CHECK( group.getInvocationCount() == 3 );
+    CHECK( group.getLinearInvocationCount() == 3 + 4 + 5 );
+    CHECK( group.getSavedInvocationCount() == 9 );
+    return 0;
+}
+
+/// Offers a handler fewer dispatch key slots, as a small target would, and
+/// counts the PDU's that reach it
+class FewKeysHandler : public Handler
+{
+  public:
+    FewKeysHandler( Handler &inner, uint16_t max_keys ) : m_inner( inner ), m_max_keys( max_keys ), m_offered( 0 ) {}
+
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override { m_inner.tick( time_in_millis ); }
+
+    virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override
+    {
+        ++m_offered;
+        return m_inner.receivedPDU( incoming_socket, frame );
+    }
+
+    virtual uint16_t getDispatchKeys( HandlerDispatchKey *keys, uint16_t max_keys ) const override
+    {
+        return m_inner.getDispatchKeys( keys, max_keys < m_max_keys ? max_keys : m_max_keys );
+    }
+
+    Handler &m_inner;
+    uint16_t m_max_keys;
+    int m_offered;
+};
+
+int test_controller_entity_few_keys()
+{
+    TestRawSocket net;
+    FrameWithMTU rx;
+    HandlerGroupWithSize<8> group( &rx );
+    ADPCoreInfo info;
+    Eui64 entity_id( 0x70b3d5fffe000001ULL );
+    ADPManager adp( net, entity_id, info );
+    RegisteredControllersStorage<1> registered;
+    ControllerEntity controller( adp, &registered, 0 );
+
+    // With room for every key it asks for the responses plus what Entity wants
+    HandlerDispatchKey keys[8];
+    CHECK( controller.getDispatchKeys( keys, 8 ) == 5 );
+    CHECK( keys[2].m_level == HandlerDispatchKey::MESSAGE_TYPE );
+
+    // Only the responses would fit in 4, so it falls back to every frame
+    CHECK( controller.getDispatchKeys( keys, 4 ) == 0 );
+
+    FewKeysHandler few( controller, 4 );
+    CHECK( group.add( &few ) );
+    CHECK( group.getWildcardCount() == 1 );
+
+    // AEM commands are still offered to it
+    makeAEMCommand( rx, JDKSAVDECC_AEM_COMMAND_ENTITY_AVAILABLE, 0, 0 );
+    jdksavdecc_common_control_header_set_stream_id( entity_id, rx.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN );
+    group.receivedPDU( &net, rx );
+    CHECK( few.m_offered == 1 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_handler_dispatch();
+    r |= test_controller_entity_few_keys();
+    return r;
+}
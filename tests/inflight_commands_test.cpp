@@ -0,0 +1,230 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+class TestNotification : public InflightCommandNotification
+{
+  public:
+    TestNotification() : m_completed( 0 ), m_timed_out( 0 ) {}
+
+    virtual void inflightCommandCompleted( InflightCommand const &cmd, jdksavdecc_aecpdu_aem const &aem, Frame &pdu ) override
+    {
+        (void)cmd;
+        (void)aem;
+        (void)pdu;
+        ++m_completed;
+    }
+
+    virtual void inflightCommandTimedOut( InflightCommand const &cmd ) override
+    {
+        (void)cmd;
+        ++m_timed_out;
+    }
+
+    int m_completed;
+    int m_timed_out;
+};
+
+int test_pipelined_commands()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    InflightCommandsWithSize<4> inflight( 250, 1 );
+    ControllerEntity controller( adp, &registered, 0, &inflight );
+    TestNotification notification;
+
+    // Send three commands to three different targets without waiting
+    for ( uint64_t t = 0; t < 3; ++t )
+    {
+        CHECK( controller.canSendCommand() );
+        CHECK( controller.sendCommand( Eui64( 0x70b3d5fffe100000ULL + t ),
+                                       Eui48( 0x70b3d5100000ULL + t ),
+                                       JDKSAVDECC_AEM_COMMAND_GET_CONFIGURATION,
+                                       true,
+                                       0,
+                                       0,
+                                       0,
+                                       0,
+                                       &notification ) );
+    }
+    CHECK( inflight.getCount() == 3 );
+    CHECK( inflight.getCountForTarget( Eui64( 0x70b3d5fffe100001ULL ) ) == 1 );
+
+    // A fourth fills the table, a fifth is refused
+    CHECK( controller.sendCommand( Eui64( 0x70b3d5fffe100003ULL ), Eui48( 0x70b3d5100003ULL ), JDKSAVDECC_AEM_COMMAND_GET_CONFIGURATION ) );
+    CHECK( !controller.canSendCommand() );
+    CHECK( !controller.sendCommand(
+        Eui64( 0x70b3d5fffe100004ULL ), Eui48( 0x70b3d5100004ULL ), JDKSAVDECC_AEM_COMMAND_GET_CONFIGURATION ) );
+    CHECK( net.m_sent_count == 4 );
+
+    // Answer the second command first
+    FrameWithMTU response;
+    net.makeResponse( 1, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( notification.m_completed == 1 );
+    CHECK( inflight.getCount() == 3 );
+    CHECK( inflight.find( Eui64( 0x70b3d5fffe100001ULL ), 2 ) == 0 );
+
+    // A duplicate response is ignored
+    controller.receivedPDU( &net, response );
+    CHECK( notification.m_completed == 1 );
+
+    // IN_PROGRESS for the first command restarts its timer
+    net.m_time += 200;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_IN_PROGRESS );
+    controller.receivedPDU( &net, response );
+    CHECK( notification.m_completed == 1 );
+    CHECK( inflight.getCount() == 3 );
+
+    // The other two time out once and are retransmitted with the same sequence id
+    net.m_time += 100;
+    controller.tick( net.m_time );
+    CHECK( net.m_sent_count == 6 );
+    CHECK( inflight.getCount() == 3 );
+    CHECK( jdksavdecc_aecpdu_common_get_sequence_id( net.m_sent[5].getBuf(), JDKSAVDECC_FRAME_HEADER_LEN ) == 3
+           || jdksavdecc_aecpdu_common_get_sequence_id( net.m_sent[5].getBuf(), JDKSAVDECC_FRAME_HEADER_LEN ) == 4 );
+
+    // Answer the retransmitted third command
+    net.makeResponse( 2, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( notification.m_completed == 2 );
+
+    // The first one is retransmitted after its restarted timer expires, and
+    // then everything that is left times out
+    net.m_time += 200;
+    controller.tick( net.m_time );
+    CHECK( net.m_sent_count == 7 );
+    net.m_time += 300;
+    controller.tick( net.m_time );
+    CHECK( inflight.getCount() == 0 );
+    CHECK( notification.m_timed_out == 1 );
+    CHECK( controller.canSendCommand() );
+
+    return 0;
+}
+
+int test_single_command()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    ControllerEntity controller( adp, &registered, 0 );
+
+    // Without an inflight table only one command is tracked at a time
+    CHECK( controller.canSendCommand() );
+    controller.sendGetConfiguration( Eui64( 0x70b3d5fffe100000ULL ), Eui48( 0x70b3d5100000ULL ) );
+    CHECK( !controller.canSendCommand() );
+
+    FrameWithMTU response;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( controller.canSendCommand() );
+
+    return 0;
+}
+
+int test_command_queue()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    InflightCommandsWithSize<8> inflight( 250, 0 );
+    ControllerCommandQueueWithSize<4, 8> queue( 1 );
+    ControllerEntity controller( adp, &registered, 0, &inflight, &queue );
+    TestNotification notification;
+
+    Eui64 target_a( 0x70b3d5fffe100000ULL );
+    Eui64 target_b( 0x70b3d5fffe100001ULL );
+
+    // Target A processes one command at a time, target B two
+    CHECK( queue.setWindow( target_b, Eui48( 0x70b3d5100001ULL ), 2 ) );
+    for ( uint16_t i = 0; i < 3; ++i )
+    {
+        CHECK( controller.sendReadDescriptor( target_a, Eui48( 0x70b3d5100000ULL ), 0, JDKSAVDECC_DESCRIPTOR_AUDIO_UNIT, i, &notification ) );
+        CHECK( controller.sendGetControl( target_b, Eui48( 0x70b3d5100001ULL ), i, &notification ) );
+    }
+    CHECK( net.m_sent_count == 3 );
+    CHECK( inflight.getCountForTarget( target_a ) == 1 );
+    CHECK( inflight.getCountForTarget( target_b ) == 2 );
+    CHECK( queue.getQueueDepth( target_a ) == 2 );
+    CHECK( queue.getQueueDepth( target_b ) == 1 );
+    CHECK( queue.getTotalQueueDepth() == 3 );
+
+    // A response from A releases the next command to A only
+    FrameWithMTU response;
+    net.m_time += 10;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( notification.m_completed == 1 );
+    CHECK( net.m_sent_count == 4 );
+    CHECK( jdksavdecc_aecpdu_aem_get_command_type( net.m_sent[3].getBuf(), JDKSAVDECC_FRAME_HEADER_LEN )
+           == JDKSAVDECC_AEM_COMMAND_READ_DESCRIPTOR );
+    CHECK( queue.getQueueDepth( target_a ) == 1 );
+
+    CommandQueueTarget const *stats = queue.findTarget( target_a );
+    CHECK( stats && stats->m_completed_count == 1 && stats->m_last_round_trip_in_ms == 10 );
+    CHECK( stats->m_max_depth == 2 );
+
+    // Time outs also open the windows
+    net.m_time += 300;
+    controller.tick( net.m_time );
+    CHECK( notification.m_timed_out == 3 );
+    CHECK( net.m_sent_count == 6 );
+    CHECK( queue.getTotalQueueDepth() == 0 );
+    CHECK( queue.findTarget( target_b )->m_timed_out_count == 2 );
+
+    return 0;
+}
+
+int test_command_queue_without_inflight()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000001ULL ), info );
+    RegisteredControllersStorage<1> registered;
+    ControllerCommandQueueWithSize<2, 8> queue( 1 );
+    ControllerEntity controller( adp, &registered, 0, 0, &queue );
+    Eui64 target( 0x70b3d5fffe100000ULL );
+
+    // Only one command can be tracked, the others wait in the queue
+    for ( uint16_t i = 0; i < 3; ++i )
+    {
+        CHECK( controller.sendGetControl( target, Eui48( 0x70b3d5100000ULL ), i ) );
+    }
+    CHECK( net.m_sent_count == 1 );
+    CHECK( queue.getQueueDepth( target ) == 2 );
+
+    // The response sends the next command straight away
+    FrameWithMTU response;
+    net.m_time += 7;
+    net.makeResponse( 0, response, JDKSAVDECC_AEM_STATUS_SUCCESS );
+    controller.receivedPDU( &net, response );
+    CHECK( net.m_sent_count == 2 );
+    CHECK( queue.getQueueDepth( target ) == 1 );
+    CHECK( net.m_sent[1].getDoublet( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_LEN + 2 ) == 1 );
+
+    CommandQueueTarget const *stats = queue.findTarget( target );
+    CHECK( stats && stats->m_completed_count == 1 && stats->m_last_round_trip_in_ms == 7 );
+
+    // Free slots are not found or filled by an unset target id
+    CHECK( queue.findTarget( Eui64() ) == 0 );
+    CHECK( !queue.enqueue( Eui64(), Eui48( 0x70b3d5100000ULL ), JDKSAVDECC_AEM_COMMAND_GET_CONFIGURATION, 0, 0 ) );
+    CHECK( queue.findTarget( Eui64() ) == 0 );
+    CHECK( queue.getTotalQueueDepth() == 1 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_pipelined_commands();
+    r |= test_single_command();
+    r |= test_command_queue();
+    r |= test_command_queue_without_inflight();
+    return r;
+}
@@ -0,0 +1,53 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_multi_port()
+{
+    TestRawSocket port0;
+    TestRawSocket port1;
+    port1.m_mac = Eui48( 0x70b3d5edc001ULL );
+    RawSocketMulti net;
+    CHECK( net.addPort( &port0 ) );
+    CHECK( net.addPort( &port1 ) );
+    CHECK( net.getPortCount() == 2 );
+
+    ADPCoreInfo info;
+    Eui64 entity_id( 0x70b3d5fffe000003ULL );
+    ADPManager adp( net, entity_id, info );
+    RegisteredControllersStorage<1> registered;
+    FragmentEntityState state;
+    Entity entity( adp, &registered, &state );
+    state.m_entity = &entity;
+    FrameWithMTU rx;
+    FrameWithMTU pdu;
+    HandlerGroupWithSize<4> group( &rx );
+
+    CHECK( group.add( &adp ) );
+    CHECK( group.add( &entity ) );
+    CHECK( group.addRawSocket( &net ) );
+
+    // Each port advertises with its own MAC address and interface_index
+    adp.sendADP();
+    CHECK( port0.m_sent_count == 1 && port1.m_sent_count == 1 );
+    CHECK( port0.m_sent[0].getSA() == port0.m_mac && port1.m_sent[0].getSA() == port1.m_mac );
+    CHECK( port0.m_sent[0].getDoublet( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_OFFSET_INTERFACE_INDEX ) == 0 );
+    CHECK( port1.m_sent[0].getDoublet( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_ADPDU_OFFSET_INTERFACE_INDEX ) == 1 );
+
+    // A command that arrives on the second port is answered there only
+    makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 0 );
+    entity_id.store( pdu.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID );
+    port1.addIncoming( pdu );
+    CHECK( group.pollRawSockets() == 1 );
+    CHECK( rx.getPort() == 1 );
+    CHECK( port0.m_sent_count == 1 && port1.m_sent_count == 2 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_multi_port();
+    return r;
+}
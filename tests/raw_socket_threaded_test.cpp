@@ -0,0 +1,61 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+int test_threaded_rings()
+{
+    TestRawSocket inner;
+    RawSocketThreadedWithSize<4, 4> net( &inner );
+    FrameWithMTU rx;
+    FrameWithMTU pdu;
+    HandlerGroupWithSize<4> group( &rx );
+
+    CHECK( group.addRawSocket( &net ) );
+
+    makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 0 );
+    for ( int i = 0; i < 12; ++i )
+    {
+        inner.addIncoming( pdu );
+    }
+
+    // Nobody takes frames out of the ring yet, so all but the first four
+    // are dropped by the IO thread
+    CHECK( net.start() );
+    for ( int i = 0; i < 1000 && net.getRxFrameCount() + net.getRxDroppedCount() < 12; ++i )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    CHECK( net.getRxFrameCount() == 4 );
+    CHECK( net.getRxDroppedCount() == 8 );
+    CHECK( net.getRxBackpressureCount() == 2 );
+    CHECK( net.getRxHighWaterMark() == 4 );
+
+    uint32_t received = 0;
+    uint32_t n;
+    while ( ( n = group.pollRawSockets() ) > 0 )
+    {
+        received += n;
+    }
+    CHECK( received == 4 );
+
+    // Sent frames reach the wrapped socket once the IO thread has them
+    CHECK( net.sendFrame( pdu ) );
+    CHECK( net.flush() );
+    net.stop();
+    CHECK( inner.m_sent_count == 1 );
+    CHECK( net.getTxFrameCount() == 1 );
+    CHECK( net.getTxDroppedCount() == 0 );
+    return 0;
+}
+#endif
+
+int main()
+{
+    int r = 0;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    r |= test_threaded_rings();
+#endif
+    return r;
+}
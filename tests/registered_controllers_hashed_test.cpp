@@ -0,0 +1,91 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_registered_controllers_hashed()
+{
+    RegisteredControllersHashed<40> registered( 1000 );
+
+    for ( uint16_t i = 0; i < 40; ++i )
+    {
+        CHECK( registered.addController( Eui64( 0x70b3d5fffe000100ULL + i ), Eui48( 0x70b3d5edc100ULL + i ) ) );
+    }
+    CHECK( registered.addController( Eui64( 0x70b3d5fffe000100ULL ), Eui48( 0x70b3d5edc100ULL ) ) );
+    CHECK( !registered.addController( Eui64( 0x70b3d5fffe000200ULL ), Eui48( 0x70b3d5edc200ULL ) ) );
+    CHECK( registered.getControllerCount() == 40 );
+
+    // Removing leaves everything else findable and the array dense
+    for ( uint16_t i = 0; i < 40; i += 2 )
+    {
+        registered.removeController( Eui64( 0x70b3d5fffe000100ULL + i ) );
+    }
+    CHECK( registered.getControllerCount() == 20 );
+    for ( uint16_t i = 0; i < 40; ++i )
+    {
+        CHECK( registered.findController( Eui64( 0x70b3d5fffe000100ULL + i ) ) == ( ( i & 1 ) == 1 ) );
+    }
+    for ( uint16_t i = 0; i < registered.getControllerCount(); ++i )
+    {
+        RegisteredController const *c = registered.getController( i );
+        CHECK( ( c->m_entity_id.convertToUint64() & 1 ) == 1 );
+        CHECK( c->m_mac_address == Eui48( 0x70b3d5edc100ULL + ( c->m_entity_id.convertToUint64() & 0xff ) ) );
+    }
+
+    // Controllers that are not heard from are forgotten
+    for ( uint16_t i = 1; i < 20; i += 2 )
+    {
+        registered.refreshController( Eui64( 0x70b3d5fffe000100ULL + i ), 500 );
+    }
+    registered.expireControllers( 1200 );
+    CHECK( registered.getControllerCount() == 10 );
+    for ( uint16_t i = 0; i < 40; ++i )
+    {
+        CHECK( registered.findController( Eui64( 0x70b3d5fffe000100ULL + i ) ) == ( ( i & 1 ) == 1 && i < 20 ) );
+    }
+
+    // An entity stops sending unsolicited responses to a silent controller
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000006ULL ), info );
+    RegisteredControllersHashed<4> entity_registered( 100 );
+    Entity entity( adp, &entity_registered, 0 );
+    entity_registered.expireControllers( net.m_time );
+    CHECK( entity_registered.addController( Eui64( 0x70b3d5fffe000100ULL ), Eui48( 0x70b3d5edc100ULL ) ) );
+    CHECK( entity_registered.addController( Eui64( 0x70b3d5fffe000101ULL ), Eui48( 0x70b3d5edc101ULL ) ) );
+    net.m_time += 150;
+    entity_registered.refreshController( Eui64( 0x70b3d5fffe000101ULL ), net.m_time );
+    uint8_t value = 1;
+    entity.sendSetControlUnsolicitedResponse( 0, &value, 1 );
+    CHECK( net.m_sent_count == 1 );
+    CHECK( net.m_sent[0].getDA() == Eui48( 0x70b3d5edc101ULL ) );
+    return 0;
+}
+
+int test_registered_controllers_kept_by_default()
+{
+    // A controller that registers and then only listens is not forgotten
+    TestRawSocket net;
+    ADPCoreInfo info;
+    ADPManager adp( net, Eui64( 0x70b3d5fffe000006ULL ), info );
+    RegisteredControllersHashed<4> registered;
+    Entity entity( adp, &registered, 0 );
+    CHECK( registered.getTimeout() == 0 );
+    CHECK( registered.addController( Eui64( 0x70b3d5fffe000100ULL ), Eui48( 0x70b3d5edc100ULL ) ) );
+
+    net.m_time += 10 * 62000;
+    uint8_t value = 1;
+    entity.sendSetControlUnsolicitedResponse( 0, &value, 1 );
+    CHECK( registered.getControllerCount() == 1 );
+    CHECK( net.m_sent_count == 1 );
+    CHECK( net.m_sent[0].getDA() == Eui48( 0x70b3d5edc100ULL ) );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_registered_controllers_hashed();
+    r |= test_registered_controllers_kept_by_default();
+    return r;
+}
@@ -0,0 +1,47 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_response_fragments()
+{
+    TestRingRawSocket net;
+    ADPCoreInfo info;
+    Eui64 entity_id( 0x70b3d5fffe000002ULL );
+    ADPManager adp( net, entity_id, info );
+    RegisteredControllersStorage<1> registered;
+    FragmentEntityState state;
+    Entity entity( adp, &registered, &state );
+    state.m_entity = &entity;
+    FrameWithMTU rx;
+    FrameWithMTU pdu;
+    HandlerGroupWithSize<4> group( &rx );
+
+    CHECK( group.add( &entity ) );
+    CHECK( group.addRawSocket( &net ) );
+
+    makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 0 );
+    entity_id.store( pdu.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID );
+    uint16_t control_data_length = pdu.getLength() - JDKSAVDECC_FRAME_HEADER_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+    pdu.setOctet( control_data_length & 0xff, JDKSAVDECC_FRAME_HEADER_LEN + 3 );
+    net.addIncoming( pdu );
+
+    // The command arrives in place, the response is sent with the value
+    // following it
+    CHECK( group.pollRawSockets() == 1 );
+    CHECK( net.m_released == 1 );
+    CHECK( net.m_sent_count == 1 );
+    FrameWithMTU &sent = net.m_sent[0];
+    CHECK( sent.getLength() == pdu.getLength() + sizeof( state.m_value ) );
+    CHECK( memcmp( sent.getBuf( pdu.getLength() ), state.m_value, sizeof( state.m_value ) ) == 0 );
+    CHECK( sent.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 3 ) == control_data_length + sizeof( state.m_value ) );
+    CHECK( ( sent.getOctet( JDKSAVDECC_FRAME_HEADER_LEN + 2 ) >> 3 ) == JDKSAVDECC_AEM_STATUS_SUCCESS );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_response_fragments();
+    return r;
+}
@@ -0,0 +1,95 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#if JDKSAVDECCMCU_ENABLE_THREADS
+int test_sharded_entities()
+{
+    TestRawSocket net;
+    ShardedEntityHost host( &net );
+    EntityShardWithSize<4, 16, 16> shard0;
+    EntityShardWithSize<4, 16, 16> shard1;
+    CHECK( host.addShard( &shard0 ) );
+    CHECK( host.addShard( &shard1 ) );
+
+    // One entity on each shard
+    uint64_t next_id = 0x70b3d5fffe000010ULL;
+    while ( host.getShardIndex( Eui64( next_id ) ) != 0 )
+    {
+        ++next_id;
+    }
+    Eui64 id0( next_id );
+    while ( host.getShardIndex( Eui64( next_id ) ) != 1 )
+    {
+        ++next_id;
+    }
+    Eui64 id1( next_id );
+    CHECK( host.assignEntity( id0 ) == &shard0 );
+    CHECK( host.assignEntity( id1 ) == &shard1 );
+    CHECK( shard0.getEntityCount() == 1 && shard1.getEntityCount() == 1 );
+
+    ADPCoreInfo info;
+    ADPManager adp0( shard0, id0, info );
+    ADPManager adp1( shard1, id1, info );
+    RegisteredControllersStorage<1> registered0;
+    RegisteredControllersStorage<1> registered1;
+    FragmentEntityState state0;
+    FragmentEntityState state1;
+    Entity entity0( adp0, &registered0, &state0 );
+    Entity entity1( adp1, &registered1, &state1 );
+    state0.m_entity = &entity0;
+    state1.m_entity = &entity1;
+    CHECK( shard0.add( &adp0 ) && shard0.add( &entity0 ) );
+    CHECK( shard1.add( &adp1 ) && shard1.add( &entity1 ) );
+
+    // A command for the second entity goes to its shard only, anything else
+    // goes to both
+    FrameWithMTU pdu;
+    makeAEMCommand( pdu, JDKSAVDECC_AEM_COMMAND_GET_CONTROL, JDKSAVDECC_DESCRIPTOR_CONTROL, 0 );
+    id1.store( pdu.getBuf(), JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID );
+    uint16_t control_data_length = pdu.getLength() - JDKSAVDECC_FRAME_HEADER_LEN - JDKSAVDECC_COMMON_CONTROL_HEADER_LEN;
+    pdu.setOctet( control_data_length & 0xff, JDKSAVDECC_FRAME_HEADER_LEN + 3 );
+    net.addIncoming( pdu );
+    FrameWithMTU other( 0, Eui48( 0x91e0f0010000ULL ), net.m_mac, 0x88b5 );
+    other.putZeros( 46 );
+    net.addIncoming( other );
+
+    CHECK( host.start() );
+    bool responded = false;
+    uint32_t seen = 0;
+    for ( int i = 0; i < 1000 && !responded; ++i )
+    {
+        // The test socket can't be waited on, so give the shards time
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        host.run( 1 );
+        for ( ; seen < net.m_sent_count; ++seen )
+        {
+            FrameWithMTU &sent = net.m_sent[seen % 16];
+            if ( sent.getOctet( JDKSAVDECC_FRAME_HEADER_LEN ) == JDKSAVDECC_1722A_SUBTYPE_AECP )
+            {
+                CHECK( Eui64( sent.getBuf( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_COMMON_CONTROL_HEADER_OFFSET_STREAM_ID ) )
+                       == id1 );
+                responded = true;
+            }
+        }
+    }
+    host.stop();
+
+    CHECK( responded );
+    CHECK( host.getUnicastCount() == 1 && host.getMulticastCount() == 1 );
+    CHECK( shard0.getRxFrameCount() == 1 && shard1.getRxFrameCount() == 2 );
+    CHECK( shard0.getRxDroppedCount() == 0 && shard1.getRxDroppedCount() == 0 );
+    CHECK( shard1.getLoopCount() > 0 );
+    return 0;
+}
+#endif
+
+int main()
+{
+    int r = 0;
+#if JDKSAVDECCMCU_ENABLE_THREADS
+    r |= test_sharded_entities();
+#endif
+    return r;
+}
@@ -0,0 +1,136 @@
+#include "JDKSAvdeccMCU.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+#define CHECK( cond )                                                                                                          \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        if ( !( cond ) )                                                                                                       \
+        {                                                                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl;                                 \
+            return 1;                                                                                                          \
+        }                                                                                                                      \
+    } while ( 0 )
+
+/// A Handler that is ticked by its Timer and records when
+class TimedHandler : public Handler
+{
+  public:
+    TimedHandler() : m_timer( this ), m_ticks( 0 ), m_last_tick( 0 ), m_period( 0 ) {}
+
+    virtual void tick( jdksavdecc_timestamp_in_milliseconds time_in_millis ) override
+    {
+        ++m_ticks;
+        m_last_tick = time_in_millis;
+        if ( m_period )
+        {
+            m_timer.scheduleAt( time_in_millis + m_period );
+        }
+    }
+
+    virtual Timer *getTimer() override { return &m_timer; }
+
+    Timer m_timer;
+    int m_ticks;
+    jdksavdecc_timestamp_in_milliseconds m_last_tick;
+    jdksavdecc_timestamp_in_milliseconds m_period;
+};
+
+/// Step the wheel one millisecond at a time
+static void advanceTo( TimerWheel &wheel, jdksavdecc_timestamp_in_milliseconds &now, jdksavdecc_timestamp_in_milliseconds to )
+{
+    while ( now < to )
+    {
+        ++now;
+        wheel.advance( now );
+    }
+}
+
+int test_deadlines()
+{
+    TimerWheel wheel;
+    TimedHandler near;
+    TimedHandler far;
+    TimedHandler very_far;
+    jdksavdecc_timestamp_in_milliseconds now = 100000;
+
+    // Not attached: scheduling does nothing
+    CHECK( !near.m_timer.scheduleAt( now + 10 ) );
+
+    wheel.attach( &near.m_timer );
+    wheel.attach( &far.m_timer );
+    wheel.attach( &very_far.m_timer );
+
+    // Attaching makes them due right away
+    CHECK( wheel.getTimeUntilNextDeadline( now, 1000 ) == 0 );
+    CHECK( wheel.advance( now ) == 3 );
+    CHECK( near.m_ticks == 1 && far.m_ticks == 1 && very_far.m_ticks == 1 );
+    CHECK( wheel.getScheduledCount() == 0 );
+    CHECK( wheel.getTimeUntilNextDeadline( now, 1000 ) == 1000 );
+
+    CHECK( near.m_timer.scheduleAt( now + 10 ) );
+    CHECK( far.m_timer.scheduleAt( now + 5000 ) );
+    CHECK( very_far.m_timer.scheduleAt( now + 20000000 ) );
+    CHECK( wheel.getTimeUntilNextDeadline( now, 1000 ) == 10 );
+
+    advanceTo( wheel, now, now + 9 );
+    CHECK( near.m_ticks == 1 );
+    advanceTo( wheel, now, now + 1 );
+    CHECK( near.m_ticks == 2 && near.m_last_tick == 100010 );
+
+    // A far deadline is only a cascade point until it gets close
+    CHECK( wheel.getTimeUntilNextDeadline( now, 100000 ) <= 5000 - 10 );
+    advanceTo( wheel, now, 104999 );
+    CHECK( far.m_ticks == 1 );
+    advanceTo( wheel, now, 105000 );
+    CHECK( far.m_ticks == 2 && far.m_last_tick == 105000 );
+
+    // Earlier schedules win with scheduleNoLaterThan
+    CHECK( near.m_timer.scheduleAt( now + 100 ) );
+    CHECK( near.m_timer.scheduleNoLaterThan( now + 200 ) );
+    CHECK( near.m_timer.getDeadline() == now + 100 );
+    CHECK( near.m_timer.scheduleNoLaterThan( now + 50 ) );
+    CHECK( near.m_timer.getDeadline() == now + 50 );
+    near.m_timer.cancel();
+    advanceTo( wheel, now, now + 1000 );
+    CHECK( near.m_ticks == 2 );
+
+    // Jumping straight to the deadline of the very far one
+    wheel.advance( 20100000 );
+    CHECK( very_far.m_ticks == 2 && very_far.m_last_tick == 20100000 );
+    CHECK( wheel.getScheduledCount() == 0 );
+    return 0;
+}
+
+int test_periodic_in_group()
+{
+    FrameWithMTU rx;
+    HandlerGroupWithSize<4> group( &rx );
+    TimerWheel wheel;
+    TimedHandler periodic;
+    TimedHandler idle;
+
+    periodic.m_period = 100;
+    CHECK( group.add( &periodic ) );
+    CHECK( group.add( &idle ) );
+    group.setTimerWheel( &wheel );
+
+    for ( jdksavdecc_timestamp_in_milliseconds now = 1000; now <= 2000; ++now )
+    {
+        group.tick( now );
+    }
+
+    // Ticked once when attached, then every 100ms, instead of 1001 times
+    CHECK( periodic.m_ticks == 11 );
+    CHECK( idle.m_ticks == 1 );
+    CHECK( group.getHandlerTickCount() == 12 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_deadlines();
+    r |= test_periodic_in_group();
+    return r;
+}
@@ -0,0 +1,112 @@
+#include "JDKSAvdeccMCU.hpp"
+#include "TestSupport.hpp"
+
+using namespace JDKSAvdeccMCU;
+
+int test_unsolicited_coalescing()
+{
+    TestRawSocket net;
+    ADPCoreInfo info;
+    Eui64 entity_id( 0x70b3d5fffe000004ULL );
+    ADPManager adp( net, entity_id, info );
+    RegisteredControllersStorage<4> registered;
+    UnsolicitedCoalescerWithSize<4> coalescer( 20 );
+    Entity entity( adp, &registered, 0, 0, 0, 0, 0, &coalescer );
+
+    for ( uint16_t i = 0; i < 3; ++i )
+    {
+        CHECK( registered.addController( Eui64( 0x70b3d5fffe000100ULL + i ), Eui48( 0x70b3d5edc100ULL + i ) ) );
+    }
+    CHECK( registered.getControllerCount() == 3 );
+
+    // The first change goes to every registered controller at once
+    uint8_t value = 1;
+    entity.sendSetControlUnsolicitedResponse( 5, &value, 1 );
+    CHECK( net.m_sent_count == 3 );
+    for ( uint16_t i = 0; i < 3; ++i )
+    {
+        FrameWithMTU &sent = net.m_sent[i];
+        CHECK( sent.getDA() == Eui48( 0x70b3d5edc100ULL + i ) );
+        CHECK( sent.getEUI64( JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_COMMON_OFFSET_CONTROLLER_ENTITY_ID )
+               == Eui64( 0x70b3d5fffe000100ULL + i ) );
+        CHECK( sent.getOctet( sent.getLength() - 1 ) == 1 );
+    }
+
+    // Changes within the window are held back, only the latest is kept
+    value = 2;
+    entity.sendSetControlUnsolicitedResponse( 5, &value, 1 );
+    value = 3;
+    entity.sendSetControlUnsolicitedResponse( 5, &value, 1 );
+    CHECK( net.m_sent_count == 3 );
+    CHECK( coalescer.getReplacedCount() == 1 );
+
+    // Another control is not held back by the first one
+    value = 9;
+    entity.sendSetControlUnsolicitedResponse( 6, &value, 1 );
+    CHECK( net.m_sent_count == 6 );
+
+    entity.tick( net.m_time + 10 );
+    CHECK( net.m_sent_count == 6 );
+
+    // When the window has passed the latest value is sent to everyone
+    net.m_time += 20;
+    entity.tick( net.m_time );
+    CHECK( net.m_sent_count == 9 );
+    for ( uint16_t i = 6; i < 9; ++i )
+    {
+        FrameWithMTU &sent = net.m_sent[i];
+        CHECK( sent.getDA() == Eui48( 0x70b3d5edc100ULL + i - 6 ) );
+        CHECK( sent.getOctet( sent.getLength() - 1 ) == 3 );
+    }
+    return 0;
+}
+
+/// Build an unsolicited SET_NAME response about one name of a descriptor
+static void makeSetNameResponse( Frame &frame, uint16_t name_index, uint16_t configuration_index )
+{
+    makeAEMCommand( frame, JDKSAVDECC_AEM_COMMAND_SET_NAME, JDKSAVDECC_DESCRIPTOR_AUDIO_UNIT, 0 );
+    frame.setOctet( JDKSAVDECC_AECP_MESSAGE_TYPE_AEM_RESPONSE, JDKSAVDECC_FRAME_HEADER_LEN + 1 );
+    frame.setDoublet( 0x8000 | JDKSAVDECC_AEM_COMMAND_SET_NAME,
+                      JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AECPDU_AEM_OFFSET_COMMAND_TYPE );
+    frame.setDoublet( name_index, JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_SET_NAME_RESPONSE_OFFSET_NAME_INDEX );
+    frame.setDoublet( configuration_index,
+                      JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_SET_NAME_RESPONSE_OFFSET_CONFIGURATION_INDEX );
+}
+
+int test_unsolicited_set_name()
+{
+    UnsolicitedCoalescerWithSize<4> coalescer( 20 );
+    FrameWithMTU pdu;
+    jdksavdecc_timestamp_in_milliseconds now = 1000;
+
+    // Different names of one descriptor do not stand in for each other
+    makeSetNameResponse( pdu, 0, 0 );
+    CHECK( coalescer.offer( pdu, 0, 0, true, now ) );
+    makeSetNameResponse( pdu, 1, 0 );
+    CHECK( coalescer.offer( pdu, 0, 0, true, now ) );
+    makeSetNameResponse( pdu, 0, 1 );
+    CHECK( coalescer.offer( pdu, 0, 0, true, now ) );
+    CHECK( coalescer.getCount() == 3 );
+
+    // Within the window each one holds back only its own name
+    makeSetNameResponse( pdu, 0, 0 );
+    CHECK( !coalescer.offer( pdu, 0, 0, true, now + 1 ) );
+    makeSetNameResponse( pdu, 1, 0 );
+    CHECK( !coalescer.offer( pdu, 0, 0, true, now + 2 ) );
+    CHECK( coalescer.getReplacedCount() == 0 );
+
+    UnsolicitedResponse *due = coalescer.getDue( now + 20 );
+    CHECK( due && due->m_pdu[JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_SET_NAME_RESPONSE_OFFSET_NAME_INDEX + 1] == 0 );
+    due = coalescer.getDue( now + 20 );
+    CHECK( due && due->m_pdu[JDKSAVDECC_FRAME_HEADER_LEN + JDKSAVDECC_AEM_COMMAND_SET_NAME_RESPONSE_OFFSET_NAME_INDEX + 1] == 1 );
+    CHECK( coalescer.getDue( now + 20 ) == 0 );
+    return 0;
+}
+
+int main()
+{
+    int r = 0;
+    r |= test_unsolicited_coalescing();
+    r |= test_unsolicited_set_name();
+    return r;
+}
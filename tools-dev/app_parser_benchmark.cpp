@@ -0,0 +1,97 @@
+#include "JDKSAvdeccMCU.hpp"
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+using namespace JDKSAvdeccMCU;
+
+/// The number of times that the stream is parsed by each benchmark
+static const int pass_count = 20;
+
+/// Counts the messages and payload octets so that nothing is optimized away
+class CountingHandler : public AppMessageHandler
+{
+  public:
+    CountingHandler() : m_count( 0 ), m_octets( 0 ) {}
+
+    virtual void onAppNop( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppEntityIdRequest( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppEntityIdResponse( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppLinkUp( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppLinkDown( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppAvdeccFromAps( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppAvdeccFromApc( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppVendor( AppMessageView const &msg ) override { count( msg ); }
+    virtual void onAppUnknown( AppMessageView const &msg ) override { count( msg ); }
+
+    void count( AppMessageView const &msg )
+    {
+        ++m_count;
+        m_octets += msg.getPayload()[msg.getPayloadLength() - 1];
+    }
+
+    uint64_t m_count;
+    uint64_t m_octets;
+};
+
+/// Parse the stream pass_count times, 'read_size' octets at a time, or
+/// one octet at a time with the original parser if read_size is 0
+static void benchmark( const char *name, std::vector<uint8_t> const &stream, size_t read_size )
+{
+    CountingHandler handler;
+    AppMessageParser parser( handler );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for ( int pass = 0; pass < pass_count; ++pass )
+    {
+        if ( read_size == 0 )
+        {
+            for ( size_t pos = 0; pos < stream.size(); ++pos )
+            {
+                parser.parse( stream[pos] );
+            }
+        }
+        else
+        {
+            for ( size_t pos = 0; pos < stream.size(); pos += read_size )
+            {
+                size_t n = stream.size() - pos < read_size ? stream.size() - pos : read_size;
+                parser.parse( &stream[pos], ssize_t( n ) );
+            }
+        }
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>( end - start ).count();
+    double mbytes = double( stream.size() ) * pass_count / ( 1024.0 * 1024.0 );
+    printf( "%-40s %10.1f MB/s (%llu messages)\n", name, mbytes / seconds, (unsigned long long)handler.m_count );
+}
+
+int main()
+{
+    // AVDECC_FROM_APS messages of the sizes seen when forwarding ADP, AECP
+    // and ACMP traffic
+    static const uint16_t sizes[] = {68, 82, 60, 300, 44, 140, 1000};
+    std::vector<uint8_t> stream;
+    FixedBufferWithSize<AppMessageParser::max_appdu_message_size> buf;
+
+    for ( int i = 0; stream.size() < 8 * 1024 * 1024; ++i )
+    {
+        FrameWithMTU frame( 0, Eui48( 0x91e0f0010000ULL ), Eui48( 0x70b3d5edc000ULL + i % 64 ), JDKSAVDECC_AVTP_ETHERTYPE );
+        frame.putZeros( sizes[i % ( sizeof( sizes ) / sizeof( sizes[0] ) )] - 1 );
+        frame.putOctet( 1 );
+
+        AppMessage msg;
+        msg.setAvdeccFromAps( frame );
+        msg.store( &buf );
+        stream.insert( stream.end(), buf.getBuf(), buf.getBuf() + buf.getLength() );
+    }
+
+    printf( "Parsing %u octets %d times\n", unsigned( stream.size() ), pass_count );
+    benchmark( "octet at a time", stream, 0 );
+    benchmark( "bulk, 1448 octet reads", stream, 1448 );
+    benchmark( "bulk, 16384 octet reads", stream, 16384 );
+    benchmark( "bulk, 65536 octet reads", stream, 65536 );
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "JDKSAvdeccMCU.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+
+using namespace JDKSAvdeccMCU;
+
+/// The number of entities in the tables, like a large install
+static const uint16_t table_size = 1024;
+
+/// The number of lookups that each benchmark does
+static const uint32_t lookup_count = 2000000;
+
+/// Keeps the compiler from optimizing the lookups away
+static volatile uint64_t sink;
+
+/// Run 'op' lookup_count times and print the time it took per lookup
+template <typename Op>
+static void benchmark( const char *name, Op op )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t found = 0;
+    for ( uint32_t i = 0; i < lookup_count; ++i )
+    {
+        found += op( i );
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    sink = found;
+
+    double ns = std::chrono::duration<double, std::nano>( end - start ).count();
+    printf( "%-40s %8.2f ns/lookup (%llu found)\n", name, ns / lookup_count, (unsigned long long)found );
+}
+
+int main()
+{
+    // Entity ID's handed out in sequence under one OUI, and queries for
+    // the ones that are there and as many that are not
+    static Eui64 keys[table_size];
+    static Eui64 queries[table_size * 2];
+    for ( uint16_t i = 0; i < table_size; ++i )
+    {
+        keys[i] = Eui64( 0x70b3d5fffe000000ULL + i * 7 );
+    }
+    srand( 1 );
+    for ( uint16_t i = 0; i < table_size * 2; ++i )
+    {
+        queries[i] = Eui64( 0x70b3d5fffe000000ULL + ( rand() % ( table_size * 2 ) ) * 7 );
+    }
+
+    static EuiFlatMap<Eui64, uint16_t, table_size> flat;
+    std::map<Eui64, uint16_t> tree;
+    std::unordered_map<Eui64, uint16_t> hashed;
+    for ( uint16_t i = 0; i < table_size; ++i )
+    {
+        *flat.insert( keys[i] ) = i;
+        tree[keys[i]] = i;
+        hashed[keys[i]] = i;
+    }
+
+    printf( "Equality of two Eui64's\n" );
+    benchmark( "jdksavdecc_eui64_compare", []( uint32_t i )
+               {
+                   return jdksavdecc_eui64_compare( &keys[i % table_size], &queries[i % ( table_size * 2 )] ) == 0;
+               } );
+    benchmark( "euiEqual", []( uint32_t i )
+               {
+                   return euiEqual( keys[i % table_size], queries[i % ( table_size * 2 )] );
+               } );
+
+    printf( "\nFinding one of %u entities\n", (unsigned)table_size );
+    benchmark( "linear search, jdksavdecc_eui64_compare", []( uint32_t i )
+               {
+                   Eui64 const &q = queries[i % ( table_size * 2 )];
+                   for ( uint16_t k = 0; k < table_size; ++k )
+                   {
+                       if ( jdksavdecc_eui64_compare( &keys[k], &q ) == 0 )
+                       {
+                           return true;
+                       }
+                   }
+                   return false;
+               } );
+    benchmark( "linear search, euiEqual", []( uint32_t i )
+               {
+                   Eui64 const &q = queries[i % ( table_size * 2 )];
+                   for ( uint16_t k = 0; k < table_size; ++k )
+                   {
+                       if ( euiEqual( keys[k], q ) )
+                       {
+                           return true;
+                       }
+                   }
+                   return false;
+               } );
+    benchmark( "std::map", [&tree]( uint32_t i )
+               {
+                   return tree.find( queries[i % ( table_size * 2 )] ) != tree.end();
+               } );
+    benchmark( "std::unordered_map", [&hashed]( uint32_t i )
+               {
+                   return hashed.find( queries[i % ( table_size * 2 )] ) != hashed.end();
+               } );
+    benchmark( "EuiFlatMap", []( uint32_t i )
+               {
+                   return flat.find( queries[i % ( table_size * 2 )] ) != 0;
+               } );
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "JDKSAvdeccMCU.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+
+using namespace JDKSAvdeccMCU;
+
+#if defined( __linux__ ) && JDKSAVDECCMCU_ENABLE_RAWSOCKETLINUX
+
+/// Counts the frames that the HandlerGroup dispatches and touches every
+/// octet of them, like a monitoring handler would
+class FrameCounter : public Handler
+{
+  public:
+    FrameCounter() : m_count( 0 ), m_checksum( 0 ), m_last( 0 ) {}
+
+    virtual bool receivedPDU( RawSocket *incoming_socket, Frame &frame ) override
+    {
+        (void)incoming_socket;
+        uint8_t const *p = frame.getBuf();
+        for ( uint16_t i = 0; i < frame.getLength(); ++i )
+        {
+            m_checksum += p[i];
+        }
+        m_last = getTimeInMilliseconds();
+        if ( m_count++ == 0 )
+        {
+            m_first = m_last;
+        }
+        return true;
+    }
+
+    uint32_t m_count;
+    uint32_t m_checksum;
+    jdksavdecc_timestamp_in_milliseconds m_first;
+    jdksavdecc_timestamp_in_milliseconds m_last;
+};
+
+/// Blast 'count' ADP sized frames from tx_if to the ADP multicast address and
+/// measure how many of them a HandlerGroup on rx_if dispatches and how long
+/// it took, using the given batch size on both sides and optionally the
+/// receive ring
+static void benchmark( const char *tx_if, const char *rx_if, uint32_t count, uint16_t batch_size, bool ring )
+{
+    RawSocketLinux tx( tx_if, JDKSAVDECC_AVTP_ETHERTYPE, Eui48(), batch_size );
+    RawSocketLinux *rx = ring ? new RawSocketLinuxRing( rx_if )
+                              : new RawSocketLinux(
+                                    rx_if, JDKSAVDECC_AVTP_ETHERTYPE, Eui48( JDKSAVDECC_MULTICAST_ADP_ACMP_MAC ), batch_size );
+
+    if ( !tx.isOpen() || !rx->isOpen() || ( ring && !static_cast<RawSocketLinuxRing *>( rx )->hasRing() ) )
+    {
+        fprintf( stderr, "Unable to open %s or %s\n", tx_if, rx_if );
+        delete rx;
+        return;
+    }
+
+    int rcvbuf = 8 * 1024 * 1024;
+    setsockopt( rx->getFd(), SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof( rcvbuf ) );
+
+    tx.setTransmitBatching( batch_size > 1 );
+
+    std::atomic<bool> done( false );
+    FrameCounter counter;
+
+    std::thread receiver( [&]()
+                          {
+                              FrameWithMTU frame( 0 );
+                              HandlerGroupWithSize<1> handlers( &frame );
+                              handlers.add( &counter );
+                              handlers.addRawSocket( rx );
+                              jdksavdecc_timestamp_in_milliseconds idle_since = getTimeInMilliseconds();
+                              while ( counter.m_count < count )
+                              {
+                                  if ( handlers.pollRawSockets() > 0 )
+                                  {
+                                      idle_since = getTimeInMilliseconds();
+                                  }
+                                  else
+                                  {
+                                      pollfd pfd;
+                                      pfd.fd = rx->getFd();
+                                      pfd.events = POLLIN;
+                                      pfd.revents = 0;
+                                      ::poll( &pfd, 1, 10 );
+                                      if ( done && getTimeInMilliseconds() - idle_since > 500 )
+                                      {
+                                          break;
+                                      }
+                                  }
+                              }
+                          } );
+
+    FrameWithMTU frame( 0, Eui48( JDKSAVDECC_MULTICAST_ADP_ACMP_MAC ), tx.getMACAddress(), JDKSAVDECC_AVTP_ETHERTYPE );
+    frame.putOctet( JDKSAVDECC_1722A_SUBTYPE_ADP );
+    frame.putZeros( JDKSAVDECC_ADPDU_LEN - 1 );
+
+    jdksavdecc_timestamp_in_milliseconds tx_start = getTimeInMilliseconds();
+    for ( uint32_t i = 0; i < count; ++i )
+    {
+        frame.setQuadlet( i, JDKSAVDECC_FRAME_HEADER_LEN + 4 );
+        tx.sendFrame( frame );
+    }
+    tx.flush();
+    jdksavdecc_timestamp_in_milliseconds tx_end = getTimeInMilliseconds();
+    done = true;
+    receiver.join();
+
+    double tx_secs = ( tx_end - tx_start ) / 1000.0;
+    double rx_secs = ( counter.m_last - counter.m_first ) / 1000.0;
+    printf( "%s batch %2u: tx %u frames in %llu ms (%.0f frames/s, %llu syscalls, %llu dropped)\n",
+            ring ? "ring" : "copy",
+            (unsigned)batch_size,
+            (unsigned)tx.getTxFrameCount(),
+            (unsigned long long)( tx_end - tx_start ),
+            tx_secs > 0 ? tx.getTxFrameCount() / tx_secs : 0.0,
+            (unsigned long long)tx.getTxSyscallCount(),
+            (unsigned long long)tx.getTxDroppedCount() );
+    printf( "               rx %u frames in %llu ms (%.0f frames/s, %llu syscalls, %llu blocks)\n",
+            (unsigned)counter.m_count,
+            (unsigned long long)( counter.m_last - counter.m_first ),
+            rx_secs > 0 ? counter.m_count / rx_secs : 0.0,
+            (unsigned long long)rx->getRxSyscallCount(),
+            (unsigned long long)( ring ? static_cast<RawSocketLinuxRing *>( rx )->getRxBlockCount() : 0 ) );
+    delete rx;
+}
+
+int main( int argc, char **argv )
+{
+    if ( argc < 3 )
+    {
+        fprintf( stderr, "usage: %s <tx-if> <rx-if> [count]\n", argv[0] );
+        return 1;
+    }
+    uint32_t count = argc > 3 ? (uint32_t)atol( argv[3] ) : 1000000;
+
+    benchmark( argv[1], argv[2], count, 1, false );
+    benchmark( argv[1], argv[2], count, JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH, false );
+    benchmark( argv[1], argv[2], count, JDKSAVDECCMCU_RAWSOCKETLINUX_BATCH, true );
+    return 0;
+}
+
+#else
+
+int main()
+{
+    fprintf( stderr, "RawSocketLinux is not available on this platform\n" );
+    return 1;
+}
+
+#endif